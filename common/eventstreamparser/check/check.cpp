@@ -0,0 +1,156 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Checks the EventStreamParser against the text/event-stream rules of the HTML living standard.
+// Exits with 1 if any check fails.
+
+#include "eventstreamparser.h"
+
+#include <QDebug>
+#include <QStringList>
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+    if (!condition) {
+        s_failures++;
+    }
+}
+
+static QList<EventStreamParser::Event> parseChunks(EventStreamParser &parser, const QList<QByteArray> &chunks)
+{
+    QList<EventStreamParser::Event> events;
+    foreach (const QByteArray &chunk, chunks) {
+        events.append(parser.parse(chunk));
+    }
+    return events;
+}
+
+// "type|data|id" of each event, separated by ";" and with line feeds shown as "\n"
+static QString describe(const QList<EventStreamParser::Event> &events)
+{
+    QStringList descriptions;
+    foreach (const EventStreamParser::Event &event, events) {
+        descriptions.append(QString::fromUtf8(event.type + "|" + event.data + "|" + event.id).replace("\n", "\\n"));
+    }
+    return descriptions.join(";");
+}
+
+static void checkEvents(const QString &description, const QList<QByteArray> &chunks, const QString &expected)
+{
+    EventStreamParser parser;
+    QString result = describe(parseChunks(parser, chunks));
+    check(result == expected, description + (result == expected ? QString() : " (got \"" + result + "\", expected \"" + expected + "\")"));
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
+    checkEvents("single event", {"event: status\ndata: hello\nid: 1\n\n"}, "status|hello|1");
+    checkEvents("default event type", {"data: hello\n\n"}, "message|hello|");
+    checkEvents("no event before the terminating empty line", {"data: hello\n"}, "");
+    checkEvents("CRLF line endings", {"data: a\r\ndata: b\r\n\r\n"}, "message|a\\nb|");
+    checkEvents("CR line endings", {"data: a\rdata: b\r\r"}, "message|a\\nb|");
+
+    // A CRLF split across two chunks is one line break, not an empty line dispatching "a" alone
+    checkEvents("CRLF split across chunks", {"data: a\r", "\ndata: b\r\n\r\n"}, "message|a\\nb|");
+    checkEvents("CRLF split before the empty line", {"data: a\r\n\r", "\ndata: b\r\n\r\n"}, "message|a|;message|b|");
+    checkEvents("line split across chunks", {"da", "ta: hel", "lo\n", "\n"}, "message|hello|");
+
+    checkEvents("multi-line data", {"data: first\ndata: second\ndata\n\n"}, "message|first\\nsecond\\n|");
+    checkEvents("value without leading space", {"data:no space\ndata:  two spaces\n\n"}, "message|no space\\n two spaces|");
+
+    checkEvents("byte order mark", {"\xEF\xBB\xBF" "data: bom\n\n"}, "message|bom|");
+    checkEvents("byte order mark split across chunks", {"\xEF\xBB", "\xBF" "data: bom\n\n"}, "message|bom|");
+    checkEvents("byte order mark only stripped at the start", {"data: 1\n\n", "\xEF\xBB\xBF" "data: 2\n\n"}, "message|1|");
+
+    checkEvents("comments are ignored", {": keep-alive\n\n:\ndata: x\n\n"}, "message|x|");
+    checkEvents("event with no data is not dispatched", {"event: ping\nid: 7\n\n"}, "");
+    checkEvents("event type does not leak into the next event", {"event: ping\n\ndata: x\n\n"}, "message|x|");
+    checkEvents("unknown fields are ignored", {"foo: bar\ndata: x\n\n"}, "message|x|");
+
+    {
+        EventStreamParser parser;
+        QList<EventStreamParser::Event> events = parseChunks(parser, {"id: 42\ndata: a\n\n", QByteArray("id: 4") + '\0' + "3\ndata: b\n\n"});
+        check(describe(events) == "message|a|42;message|b|42" && parser.lastEventId() == "42", "id containing NUL is ignored");
+
+        parseChunks(parser, {"id\ndata: c\n\n"});
+        check(parser.lastEventId().isEmpty(), "empty id resets the last event id");
+    }
+
+    {
+        EventStreamParser parser;
+        check(parser.retryInterval() == -1, "no retry interval by default");
+        parseChunks(parser, {"retry: 3000\n\n"});
+        check(parser.retryInterval() == 3000, "retry interval");
+        parseChunks(parser, {"retry: 12a\nretry: -5\nretry:\n\n"});
+        check(parser.retryInterval() == 3000, "invalid retry values are ignored");
+    }
+
+    {
+        // Feeding a stream byte by byte gives the same events as one chunk
+        QByteArray stream = "\xEF\xBB\xBF" ": hi\r\nevent: update\r\nid: 1\r\ndata: [1,\r\ndata: 2]\r\n\r\nretry: 500\nid: 2\ndata: x\r\r";
+        EventStreamParser parser;
+        QList<QByteArray> bytes;
+        for (int i = 0; i < stream.size(); i++) {
+            bytes.append(stream.mid(i, 1));
+        }
+        QString byteByByte = describe(parseChunks(parser, bytes));
+        EventStreamParser reference;
+        check(byteByByte == describe(parseChunks(reference, {stream})) && byteByByte == "update|[1,\\n2]|1;message|x|2", "byte by byte feeding");
+    }
+
+    {
+        EventStreamParser parser;
+        parser.setMaxEventSize(16);
+        QList<EventStreamParser::Event> events = parseChunks(parser, {"data: " + QByteArray(32, 'a')});
+        check(events.isEmpty() && parser.overflowed(), "overlong line without line break overflows");
+        events = parseChunks(parser, {"\n\ndata: ok\n\n"});
+        check(events.isEmpty() && parser.overflowed(), "data is ignored after an overflow");
+        parser.reset();
+        events = parseChunks(parser, {"data: ok\n\n"});
+        check(describe(events) == "message|ok|" && !parser.overflowed(), "reset recovers from an overflow");
+
+        parser.reset();
+        events = parseChunks(parser, {"data: 0123456789\ndata: 0123456789\n\n"});
+        check(events.isEmpty() && parser.overflowed(), "data of one event exceeding the limit overflows");
+    }
+
+    if (s_failures > 0) {
+        qWarning() << s_failures << "checks failed";
+        return 1;
+    }
+    qInfo() << "All checks passed";
+    return 0;
+}
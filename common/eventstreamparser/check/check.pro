@@ -0,0 +1,8 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT -= gui
+
+include(../eventstreamparser.pri)
+
+SOURCES += check.cpp
@@ -0,0 +1,199 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "eventstreamparser.h"
+
+static const QByteArray byteOrderMark("\xEF\xBB\xBF");
+
+EventStreamParser::EventStreamParser()
+{
+
+}
+
+QList<EventStreamParser::Event> EventStreamParser::parse(const QByteArray &chunk)
+{
+    QList<Event> events;
+    if (m_overflowed)
+        return events;
+
+    // Only the bytes appended by this chunk need to be scanned for line breaks
+    int scanFrom = m_buffer.size();
+    m_buffer.append(chunk);
+
+    if (!m_bomChecked) {
+        if (byteOrderMark.startsWith(m_buffer))
+            return events; // Wait until we know if this is a BOM
+        if (m_buffer.startsWith(byteOrderMark))
+            m_buffer.remove(0, byteOrderMark.size());
+        m_bomChecked = true;
+        scanFrom = 0;
+    }
+
+    int lineStart = 0;
+    if (m_skipLineFeed && !m_buffer.isEmpty()) {
+        // The previous chunk ended with a CR, a following LF belongs to the same line break
+        if (m_buffer.at(0) == '\n')
+            lineStart = 1;
+        m_skipLineFeed = false;
+        scanFrom = lineStart;
+    }
+
+    for (int i = scanFrom; i < m_buffer.size(); i++) {
+        char c = m_buffer.at(i);
+        if (c != '\n' && c != '\r')
+            continue;
+
+        processLine(m_buffer.mid(lineStart, i - lineStart), &events);
+        if (m_overflowed)
+            return events;
+
+        if (c == '\r') {
+            if (i + 1 == m_buffer.size()) {
+                m_skipLineFeed = true;
+            } else if (m_buffer.at(i + 1) == '\n') {
+                i++;
+            }
+        }
+        lineStart = i + 1;
+    }
+    m_buffer.remove(0, lineStart);
+
+    if (m_buffer.size() > m_maxEventSize)
+        setOverflowed();
+
+    return events;
+}
+
+void EventStreamParser::reset()
+{
+    m_buffer.clear();
+    m_bomChecked = false;
+    m_skipLineFeed = false;
+    m_eventType.clear();
+    m_data.clear();
+    m_overflowed = false;
+}
+
+QByteArray EventStreamParser::lastEventId() const
+{
+    return m_lastEventId;
+}
+
+int EventStreamParser::retryInterval() const
+{
+    return m_retryInterval;
+}
+
+void EventStreamParser::setMaxEventSize(int maxEventSize)
+{
+    m_maxEventSize = maxEventSize;
+}
+
+bool EventStreamParser::overflowed() const
+{
+    return m_overflowed;
+}
+
+void EventStreamParser::processLine(const QByteArray &line, QList<Event> *events)
+{
+    if (line.isEmpty()) {
+        dispatchEvent(events);
+        return;
+    }
+
+    if (line.startsWith(':'))
+        return; // Comment
+
+    QByteArray field;
+    QByteArray value;
+    int colon = line.indexOf(':');
+    if (colon < 0) {
+        field = line;
+    } else {
+        field = line.left(colon);
+        value = line.mid(colon + 1);
+        if (value.startsWith(' '))
+            value.remove(0, 1);
+    }
+
+    if (field == "event") {
+        m_eventType = value;
+    } else if (field == "data") {
+        if (m_data.size() + value.size() >= m_maxEventSize) {
+            setOverflowed();
+            return;
+        }
+        m_data.append(value);
+        m_data.append('\n');
+    } else if (field == "id") {
+        if (!value.contains('\0'))
+            m_lastEventId = value;
+    } else if (field == "retry") {
+        if (value.isEmpty())
+            return;
+        for (char c : value) {
+            if (c < '0' || c > '9')
+                return;
+        }
+        bool ok = false;
+        int retry = value.toInt(&ok);
+        if (ok)
+            m_retryInterval = retry;
+    }
+    // Other fields are ignored
+}
+
+void EventStreamParser::setOverflowed()
+{
+    m_overflowed = true;
+    m_buffer.clear();
+    m_eventType.clear();
+    m_data.clear();
+}
+
+void EventStreamParser::dispatchEvent(QList<Event> *events)
+{
+    if (m_data.isEmpty()) {
+        m_eventType.clear();
+        return;
+    }
+
+    // Remove the trailing line feed of the last data line
+    m_data.chop(1);
+
+    Event event;
+    event.type = m_eventType.isEmpty() ? QByteArray("message") : m_eventType;
+    event.data = m_data;
+    event.id = m_lastEventId;
+    events->append(event);
+
+    m_eventType.clear();
+    m_data.clear();
+}
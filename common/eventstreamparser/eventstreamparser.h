@@ -0,0 +1,84 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef EVENTSTREAMPARSER_H
+#define EVENTSTREAMPARSER_H
+
+#include <QByteArray>
+#include <QList>
+
+// Incremental parser for the text/event-stream format (Server-Sent Events)
+// as specified in the HTML living standard. Data can be fed in arbitrary
+// chunks as it arrives from the network, partial lines are kept until the
+// rest of the line has been received.
+class EventStreamParser
+{
+public:
+    struct Event {
+        QByteArray type;
+        QByteArray data;
+        QByteArray id;
+    };
+
+    EventStreamParser();
+
+    QList<Event> parse(const QByteArray &chunk);
+
+    // Drops any partially received event, e.g. when the stream reconnects.
+    // The last event id and the retry interval are kept.
+    void reset();
+
+    QByteArray lastEventId() const;
+    int retryInterval() const; // Reconnection time in ms requested by the server, -1 if not set
+
+    // Limits the size of a partially received line and of the data of one event. Once exceeded,
+    // the partial event is dropped and all further data is ignored until reset(), the stream
+    // should be reconnected in that case.
+    void setMaxEventSize(int maxEventSize);
+    bool overflowed() const;
+
+private:
+    QByteArray m_buffer;
+    int m_maxEventSize = 1024 * 1024;
+    bool m_overflowed = false;
+    bool m_bomChecked = false;
+    bool m_skipLineFeed = false;
+
+    QByteArray m_eventType;
+    QByteArray m_data;
+    QByteArray m_lastEventId;
+    int m_retryInterval = -1;
+
+    void processLine(const QByteArray &line, QList<Event> *events);
+    void setOverflowed();
+    void dispatchEvent(QList<Event> *events);
+};
+
+#endif // EVENTSTREAMPARSER_H
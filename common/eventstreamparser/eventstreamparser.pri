@@ -0,0 +1,9 @@
+# Server-Sent Events parser shared by the plugins consuming text/event-stream APIs
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/eventstreamparser.cpp \
+
+HEADERS += \
+    $$PWD/eventstreamparser.h \
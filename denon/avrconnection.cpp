@@ -44,22 +44,20 @@ AvrConnection::AvrConnection(const QHostAddress &hostAddress, const int &port, Q
     // Note: error signal will be interpreted as function, not as signal in C++11
     connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onError(QAbstractSocket::SocketError)));
 
-   m_commandTimer = new QTimer(this);
-   m_commandTimer->start(50); // 50ms is the minimum request interval specified
-
-   connect(m_commandTimer, &QTimer::timeout, this, [this] {
-       if (!m_commandBuffer.isEmpty()) {
-           QPair<QUuid, QByteArray> command =  m_commandBuffer.takeFirst();
-           if (m_socket->write(command.second) == -1) {
-               emit commandExecuted(command.first, false);
-               qCWarning(dcDenon()) << "Could not execute command" << command.second;
-           } else {
-               emit commandExecuted(command.first, true);
-           }
-       } else {
-           m_commandTimer->stop();
-       }
-   });
+    // 50ms is the minimum request interval specified
+    m_pacingTimer = new QTimer(this);
+    m_pacingTimer->setSingleShot(true);
+    m_pacingTimer->setInterval(50);
+    connect(m_pacingTimer, &QTimer::timeout, this, &AvrConnection::sendNextCommand);
+
+    // The receiver responds within 200ms, give it some slack
+    m_responseTimer = new QTimer(this);
+    m_responseTimer->setSingleShot(true);
+    m_responseTimer->setInterval(500);
+    connect(m_responseTimer, &QTimer::timeout, this, [this] {
+        qCWarning(dcDenon()) << "No response received for command" << m_pendingCommand.message;
+        finishPendingCommand(false);
+    });
 }
 
 AvrConnection::~AvrConnection()
@@ -145,13 +143,126 @@ QUuid AvrConnection::getPlayBackInfo()
 
 QUuid AvrConnection::sendCommand(const QByteArray &message)
 {
-   QUuid commandId = QUuid::createUuid();
+    QUuid commandId = QUuid::createUuid();
 
-   if (!m_commandTimer->isActive())
-       m_commandTimer->start(50);
+    Command command;
+    command.ids.append(commandId);
+    command.message = message;
 
-   m_commandBuffer.append(QPair<QUuid, QByteArray>(commandId, message));
-   return commandId;
+    // The receiver echoes the new state for everything but the network player controls
+    if (!message.startsWith("NS9")) {
+        if (message.startsWith("PSTONE CTRL") || message.startsWith("PSBAS") || message.startsWith("PSTRE")) {
+            command.responsePrefix = message.left(message.startsWith("PSTONE") ? 11 : 5);
+        } else {
+            command.responsePrefix = message.left(2);
+        }
+    }
+
+    // Queries and absolute values can be merged with a queued command of the same kind,
+    // relative changes (e.g. volume up) and player controls need to be sent one by one.
+    if (message.endsWith("?\r") || message == "NSE\r") {
+        command.coalesceKey = message;
+    } else if (!message.startsWith("NS9") && !message.startsWith("MVUP") && !message.startsWith("MVDOWN")) {
+        command.coalesceKey = command.responsePrefix;
+    }
+
+    if (!command.coalesceKey.isEmpty()) {
+        for (int i = 0; i < m_commandQueue.count(); i++) {
+            if (m_commandQueue.at(i).coalesceKey != command.coalesceKey)
+                continue;
+
+            // Merging in place would move the command ahead of relative changes (e.g. MVUP after MV)
+            // queued in the meantime. In that case replace the queued command and send it last.
+            bool changedLater = false;
+            for (int j = i + 1; j < m_commandQueue.count(); j++) {
+                if (m_commandQueue.at(j).responsePrefix == command.responsePrefix) {
+                    changedLater = true;
+                    break;
+                }
+            }
+
+            if (!changedLater) {
+                qCDebug(dcDenon()) << "Merging command" << message.trimmed() << "into queued" << m_commandQueue.at(i).message.trimmed();
+                m_commandQueue[i].message = message;
+                m_commandQueue[i].ids.append(commandId);
+                return commandId;
+            }
+
+            qCDebug(dcDenon()) << "Replacing queued command" << m_commandQueue.at(i).message.trimmed() << "with" << message.trimmed();
+            command.ids = m_commandQueue.takeAt(i).ids + command.ids;
+            break;
+        }
+    }
+
+    m_commandQueue.append(command);
+
+    // Don't send it right away, the caller needs the id first
+    QTimer::singleShot(0, this, &AvrConnection::sendNextCommand);
+    return commandId;
+}
+
+void AvrConnection::sendNextCommand()
+{
+    if (m_commandPending || m_pacingTimer->isActive() || m_commandQueue.isEmpty())
+        return;
+
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        qCWarning(dcDenon()) << "Not connected, cannot execute commands";
+        failAllCommands();
+        return;
+    }
+
+    m_pendingCommand = m_commandQueue.takeFirst();
+    m_commandPending = true;
+    m_pacingTimer->start();
+
+    if (m_socket->write(m_pendingCommand.message) == -1) {
+        qCWarning(dcDenon()) << "Could not execute command" << m_pendingCommand.message;
+        finishPendingCommand(false);
+        return;
+    }
+
+    if (m_pendingCommand.responsePrefix.isEmpty()) {
+        finishPendingCommand(true);
+        return;
+    }
+    m_responseTimer->start();
+}
+
+void AvrConnection::finishPendingCommand(bool success)
+{
+    if (!m_commandPending)
+        return;
+
+    m_responseTimer->stop();
+    m_commandPending = false;
+    Command command = m_pendingCommand;
+    m_pendingCommand = Command();
+
+    foreach (const QUuid &commandId, command.ids) {
+        emit commandExecuted(commandId, success);
+    }
+
+    // The pacing timer picks up the next one once the minimum interval passed
+    sendNextCommand();
+}
+
+void AvrConnection::failAllCommands()
+{
+    QList<Command> commands = m_commandQueue;
+    m_commandQueue.clear();
+    if (m_commandPending) {
+        commands.prepend(m_pendingCommand);
+        m_pendingCommand = Command();
+        m_commandPending = false;
+        m_responseTimer->stop();
+    }
+
+    foreach (const Command &command, commands) {
+        foreach (const QUuid &commandId, command.ids) {
+            emit commandExecuted(commandId, false);
+        }
+    }
 }
 
 QUuid AvrConnection::setChannel(const QByteArray &channel)
@@ -319,6 +430,8 @@ void AvrConnection::onConnected()
 void AvrConnection::onDisconnected()
 {
     qCDebug(dcDenon) << "disconnected from" << hostAddress().toString() << port();
+    m_receiveBuffer.clear();
+    failAllCommands();
     emit connectionStatusChanged(false);
 }
 
@@ -330,112 +443,128 @@ void AvrConnection::onError(QAbstractSocket::SocketError socketError)
 
 void AvrConnection::readData()
 {
-    QString data = QString(m_socket->readAll());
+    m_receiveBuffer.append(m_socket->readAll());
 
-    QStringList lines = data.split('\r');
-    foreach (QString line, lines) {
-        if(line.isEmpty())
+    // Responses are terminated by \r, keep incomplete ones until the rest arrives
+    int index = m_receiveBuffer.indexOf('\r');
+    while (index >= 0) {
+        QByteArray line = m_receiveBuffer.left(index);
+        m_receiveBuffer.remove(0, index + 1);
+        index = m_receiveBuffer.indexOf('\r');
+        if (line.isEmpty())
             continue;
 
-        qCDebug(dcDenon) << "Data received" << line;
-        if (line.contains("MV") && !data.contains("MAX")){
-            int index = data.indexOf("MV");
-            int volume = data.mid(index+2, 2).toInt();
-            emit volumeChanged(volume);
-
-        } else if (line.left(2).contains("SI")) {
-            QByteArray cmd;
-            if (data.contains("TUNER")) {
-                cmd = "TUNER";
-            } else if (data.contains("DVD")) {
-                cmd = "DVD";
-            } else if (data.contains("BD")) {
-                cmd = "BD";
-            } else if (data.contains("TV")) {
-                cmd = "TV";
-            } else if (data.contains("SAT/CBL")) {
-                cmd = "SAT/CBL";
-            } else if (data.contains("MPLAY")) {
-                cmd = "MPLAY";
-            } else if (data.contains("GAME")) {
-                cmd = "GAME";
-            } else if (data.contains("AUX1")) {
-                cmd = "AUX1";
-            } else if (data.contains("NET")) {
-                cmd = "NET";
-            } else if (data.contains("PANDORA")) {
-                cmd = "PANDORA";
-            } else if (data.contains("SIRIUSXM")) {
-                cmd = "SIRIUSXM";
-            } else if (data.contains("SPOTIFY")) {
-                cmd = "SPOTIFY";
-            } else if (data.contains("FLICKR")) {
-                cmd = "FLICKR";
-            } else if (data.contains("FAVORITES")) {
-                cmd = "FAVORITES";
-            } else if (data.contains("IRADIO")) {
-                cmd = "IRADIO";
-            } else if (data.contains("SERVER")) {
-                cmd = "SERVER";
-            } else if (data.contains("USB/IPOD")) {
-                cmd = "USB/IPOD";
-            } else if (data.contains("IPD")) {
-                cmd = "IPD";
-            } else if (data.contains("IRP")) {
-                cmd = "IRP";
-            } else if (data.contains("FVP")) {
-                cmd = "FVP";
-            }
-            emit channelChanged(cmd);
-        } else if (data.contains("PWON")) {
-            emit powerChanged(true);
-        } else if (data.contains("PWSTANDBY")) {
-            emit powerChanged(false);
-        } else if (data.contains("MUON")) {
-            emit muteChanged(true);
-        } else if (data.contains("MUOFF")) {
-            emit muteChanged(false);
-        } else if (data.left(2).contains("MS")) {
-            QString surroundMode = data.remove(0, 2).trimmed();
-            qCDebug(dcDenon()) << "Surround mode changed" << surroundMode;
-            emit surroundModeChanged(surroundMode);
-
-        } else if (data.left(4).contains("NSE0")) {
-            QString nowPlaying = QString(data).remove(0, 4).trimmed();
-            qCDebug(dcDenon()) << "Playbackstatus" << nowPlaying;
-            if (nowPlaying.contains("Now Playing")) {
-                emit playBackModeChanged(PlayBackMode::PlayBackModePlaying);
-            } else {
-                emit playBackModeChanged(PlayBackMode::PlayBackModeStopped);
-            }
-        } else if (data.left(4).contains("NSE1")) {
-            QString song = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Song" << song;
-            emit songChanged(song);
-        } else if (data.left(4).contains("NSE2")) {
-            QString artist = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Artist" << artist;
-            emit artistChanged(artist);
-        } else if (data.left(4).contains("NSE4")) {
-            QString album = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Album" << album;
-            emit albumChanged(album);
-        } else if (data.contains("PSTONE CTRL ON")) {
-            qCDebug(dcDenon()) << "Tone control is on";
-            emit toneControlEnabledChanged(true);
-        } else if (data.contains("PSTONE CTRL OFF")) {
-            qCDebug(dcDenon()) << "Tone control is off";
-            emit toneControlEnabledChanged(false);
-        } else if (data.contains("PSBAS")) {
-            int index = data.indexOf("PSBAS");
-            int bass = data.mid(index+6, 2).toInt() - 50;
-            qCDebug(dcDenon()) << "Bass level" << bass;
-            emit bassLevelChanged(bass);
-        } else if (data.contains("PSTRE")) {
-            int index = data.indexOf("PSTRE");
-            int treble = data.mid(index+6, 2).toInt() - 50;
-            qCDebug(dcDenon()) << "Treble level" << treble;
-            emit trebleLevelChanged(treble);
+        processLine(QString(line));
+
+        // The echo of the new state confirms the pending command
+        if (m_commandPending && line.startsWith(m_pendingCommand.responsePrefix)) {
+            finishPendingCommand(true);
+        }
+    }
+}
+
+void AvrConnection::processLine(const QString &line)
+{
+    QString data = line;
+    qCDebug(dcDenon) << "Data received" << line;
+
+    if (line.contains("MV") && !data.contains("MAX")){
+        int index = data.indexOf("MV");
+        int volume = data.mid(index+2, 2).toInt();
+        emit volumeChanged(volume);
+
+    } else if (line.left(2).contains("SI")) {
+        QByteArray cmd;
+        if (data.contains("TUNER")) {
+            cmd = "TUNER";
+        } else if (data.contains("DVD")) {
+            cmd = "DVD";
+        } else if (data.contains("BD")) {
+            cmd = "BD";
+        } else if (data.contains("TV")) {
+            cmd = "TV";
+        } else if (data.contains("SAT/CBL")) {
+            cmd = "SAT/CBL";
+        } else if (data.contains("MPLAY")) {
+            cmd = "MPLAY";
+        } else if (data.contains("GAME")) {
+            cmd = "GAME";
+        } else if (data.contains("AUX1")) {
+            cmd = "AUX1";
+        } else if (data.contains("NET")) {
+            cmd = "NET";
+        } else if (data.contains("PANDORA")) {
+            cmd = "PANDORA";
+        } else if (data.contains("SIRIUSXM")) {
+            cmd = "SIRIUSXM";
+        } else if (data.contains("SPOTIFY")) {
+            cmd = "SPOTIFY";
+        } else if (data.contains("FLICKR")) {
+            cmd = "FLICKR";
+        } else if (data.contains("FAVORITES")) {
+            cmd = "FAVORITES";
+        } else if (data.contains("IRADIO")) {
+            cmd = "IRADIO";
+        } else if (data.contains("SERVER")) {
+            cmd = "SERVER";
+        } else if (data.contains("USB/IPOD")) {
+            cmd = "USB/IPOD";
+        } else if (data.contains("IPD")) {
+            cmd = "IPD";
+        } else if (data.contains("IRP")) {
+            cmd = "IRP";
+        } else if (data.contains("FVP")) {
+            cmd = "FVP";
+        }
+        emit channelChanged(cmd);
+    } else if (data.contains("PWON")) {
+        emit powerChanged(true);
+    } else if (data.contains("PWSTANDBY")) {
+        emit powerChanged(false);
+    } else if (data.contains("MUON")) {
+        emit muteChanged(true);
+    } else if (data.contains("MUOFF")) {
+        emit muteChanged(false);
+    } else if (data.left(2).contains("MS")) {
+        QString surroundMode = data.remove(0, 2).trimmed();
+        qCDebug(dcDenon()) << "Surround mode changed" << surroundMode;
+        emit surroundModeChanged(surroundMode);
+
+    } else if (data.left(4).contains("NSE0")) {
+        QString nowPlaying = QString(data).remove(0, 4).trimmed();
+        qCDebug(dcDenon()) << "Playbackstatus" << nowPlaying;
+        if (nowPlaying.contains("Now Playing")) {
+            emit playBackModeChanged(PlayBackMode::PlayBackModePlaying);
+        } else {
+            emit playBackModeChanged(PlayBackMode::PlayBackModeStopped);
         }
+    } else if (data.left(4).contains("NSE1")) {
+        QString song = QString(data).remove(0, 5).trimmed();
+        qCDebug(dcDenon()) << "Song" << song;
+        emit songChanged(song);
+    } else if (data.left(4).contains("NSE2")) {
+        QString artist = QString(data).remove(0, 5).trimmed();
+        qCDebug(dcDenon()) << "Artist" << artist;
+        emit artistChanged(artist);
+    } else if (data.left(4).contains("NSE4")) {
+        QString album = QString(data).remove(0, 5).trimmed();
+        qCDebug(dcDenon()) << "Album" << album;
+        emit albumChanged(album);
+    } else if (data.contains("PSTONE CTRL ON")) {
+        qCDebug(dcDenon()) << "Tone control is on";
+        emit toneControlEnabledChanged(true);
+    } else if (data.contains("PSTONE CTRL OFF")) {
+        qCDebug(dcDenon()) << "Tone control is off";
+        emit toneControlEnabledChanged(false);
+    } else if (data.contains("PSBAS")) {
+        int index = data.indexOf("PSBAS");
+        int bass = data.mid(index+6, 2).toInt() - 50;
+        qCDebug(dcDenon()) << "Bass level" << bass;
+        emit bassLevelChanged(bass);
+    } else if (data.contains("PSTRE")) {
+        int index = data.indexOf("PSTRE");
+        int treble = data.mid(index+6, 2).toInt() - 50;
+        qCDebug(dcDenon()) << "Treble level" << treble;
+        emit trebleLevelChanged(treble);
     }
 }
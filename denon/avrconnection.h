@@ -96,19 +96,36 @@ public:
     QUuid increaseVolume();
     QUuid decreaseVolume();
 private:
-    QTimer *m_commandTimer = nullptr;
+    // A queued command. Commands setting the same value are merged into one, the
+    // last value wins and all their ids are reported once the receiver responded.
+    struct Command {
+        QList<QUuid> ids;
+        QByteArray message;
+        QByteArray coalesceKey;
+        QByteArray responsePrefix;
+    };
+
+    QTimer *m_pacingTimer = nullptr;
+    QTimer *m_responseTimer = nullptr;
     QTcpSocket *m_socket = nullptr;
     QHostAddress m_hostAddress;
     int m_port;
-    QList<QPair<QUuid, QByteArray>> m_commandBuffer;
+    QList<Command> m_commandQueue;
+    Command m_pendingCommand;
+    bool m_commandPending = false;
+    QByteArray m_receiveBuffer;
 
     QUuid sendCommand(const QByteArray &message);
+    void finishPendingCommand(bool success);
+    void failAllCommands();
+    void processLine(const QString &line);
 
 private slots:
     void onConnected();
     void onDisconnected();
     void onError(QAbstractSocket::SocketError socketError);
     void readData();
+    void sendNextCommand();
 
 signals:
     void socketErrorOccured(QAbstractSocket::SocketError socketError);
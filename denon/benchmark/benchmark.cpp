@@ -0,0 +1,597 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Replays a HEOS CLI stream (port 1255) against the response handling of the plugin, comparing the
+// former readLine() parsing with the startsWith/contains command chain to the buffered line parser
+// with the command handler table. Both sides count the signals they would emit and the values they
+// carry, the results have to match.
+//
+// events-6players.txt holds the events and responses of 6 players, four of them playing, in the
+// format sent by a speaker. A stream captured with e.g. "nc <speaker> 1255" after sending
+// "heos://system/register_for_change_events?enable=on" can be passed as argument instead.
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QUrlQuery>
+#include <QVariantMap>
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+// Stand-in for the signals of Heos
+struct Sink {
+    QMap<QString, int> counts;
+    qint64 checksum = 0;
+
+    void emitted(const QString &signal, int id, int value = 0)
+    {
+        counts[signal]++;
+        checksum = checksum * 31 + id + value;
+    }
+};
+
+static int parsePlayerState(const QString &state)
+{
+    if (state.contains("play")) {
+        return 1;
+    } else if (state.contains("pause")) {
+        return 2;
+    }
+    return 0;
+}
+
+static int parseRepeatMode(const QString &repeatMode)
+{
+    if (repeatMode.contains("on_all")) {
+        return 1;
+    } else if (repeatMode.contains("on_one")) {
+        return 2;
+    }
+    return 0;
+}
+
+// Former Heos::readData(): every line is converted into a variant map, the message is always
+// parsed and the command is matched by family and then by substring.
+static void processChain(QIODevice *device, Sink &sink)
+{
+    QByteArray data;
+    QJsonParseError error;
+
+    while (device->canReadLine()) {
+        data = device->readLine();
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            return;
+        }
+        QVariantMap dataMap = jsonDoc.toVariant().toMap();
+        if (!dataMap.contains("heos"))
+            continue;
+
+        QString command = dataMap.value("heos").toMap().value("command").toString();
+        QUrlQuery message(dataMap.value("heos").toMap().value("message").toString());
+        bool success = false;
+        if (dataMap.value("heos").toMap().contains("result")) {
+            success = dataMap.value("heos").toMap().value("result").toString().contains("success");
+        }
+        Q_UNUSED(success)
+
+        if (command.startsWith("system")) {
+            if (command.contains("register_for_change_events")) {
+                sink.emitted("systemEventsEnabled", !message.queryItemValue("enabled").contains("off"));
+            } else if (command.contains("check_account")) {
+                sink.emitted("userChanged", message.hasQueryItem("signed_in"));
+            } else if (command.contains("sign_in")) {
+            } else if (command.contains("sign_out")) {
+            } else if (command.contains("heart_beat")) {
+            } else if (command.contains("reboot")) {
+            } else if (command.contains("prettify_json_response")) {
+            } else {
+                sink.emitted("unhandled", 0);
+            }
+        } else if (command.startsWith("player")) {
+            int playerId = 0;
+            if (message.hasQueryItem("pid")) {
+                playerId = message.queryItemValue("pid").toInt();
+            }
+
+            if (command.contains("get_players")) {
+                sink.emitted("playersRecieved", dataMap.value("payload").toList().count());
+            } else if (command.contains("get_player_info")) {
+                sink.emitted("playerInfoRecieved", dataMap.value("payload").toMap().value("pid").toInt());
+            } else if (command.contains("get_now_playing_media")) {
+                QVariantMap payload = dataMap.value("payload").toMap();
+                QString artist = payload.value("artist").toString();
+                QString song = payload.value("song").toString();
+                QString artwork = payload.value("image_url").toString();
+                QString album = payload.value("album").toString();
+                QString sourceId = payload.value("sid").toString();
+                sink.emitted("nowPlayingMediaStatusReceived", playerId, artist.size() + song.size() + artwork.size() + album.size() + sourceId.toInt());
+            } else if (command.contains("get_play_state") || command.contains("set_play_state")) {
+                if (message.hasQueryItem("state")) {
+                    sink.emitted("playerPlayStateReceived", playerId, parsePlayerState(message.queryItemValue("state")));
+                }
+            } else if (command.contains("get_volume") || command.contains("set_volume")) {
+                if (message.hasQueryItem("level")) {
+                    sink.emitted("playerVolumeReceived", playerId, message.queryItemValue("level").toInt());
+                }
+            } else if (command.contains("get_mute") || command.contains("set_mute")) {
+                if (message.hasQueryItem("state")) {
+                    sink.emitted("playerMuteStatusReceived", playerId, message.queryItemValue("state").contains("on"));
+                }
+            } else if (command.contains("get_play_mode") || command.contains("set_play_mode")) {
+                if (message.hasQueryItem("shuffle") && message.hasQueryItem("repeat")) {
+                    sink.emitted("playerShuffleModeReceived", playerId, message.queryItemValue("shuffle").contains("on"));
+                    sink.emitted("playerRepeatModeReceived", playerId, parseRepeatMode(message.queryItemValue("repeat")));
+                }
+            } else if (command.contains("check_update")) {
+                sink.emitted("playerUpdateAvailable", playerId);
+            } else {
+                sink.emitted("unhandled", 0);
+            }
+        } else if (command.startsWith("group")) {
+            int groupId = message.queryItemValue("gid").toInt();
+            if (command.contains("get_volume") || command.contains("set_volume")) {
+                if (message.hasQueryItem("level")) {
+                    sink.emitted("groupVolumeReceived", groupId, message.queryItemValue("level").toInt());
+                }
+            } else if (command.contains("get_mute") || command.contains("set_mute")) {
+                if (message.hasQueryItem("state")) {
+                    sink.emitted("playerMuteStatusReceived", groupId, message.queryItemValue("state").contains("on"));
+                }
+            } else {
+                sink.emitted("unhandled", 0);
+            }
+        } else if (command.startsWith("event")) {
+            if (command.contains("sources_changed")) {
+                sink.emitted("sourcesChanged", 0);
+            } else if (command.contains("players_changed")) {
+                sink.emitted("playersChanged", 0);
+            } else if (command.contains("groups_changed")) {
+                sink.emitted("groupsChanged", 0);
+            } else if (command.contains("player_state_changed")) {
+                if (message.hasQueryItem("pid") && message.hasQueryItem("state")) {
+                    sink.emitted("playerPlayStateReceived", message.queryItemValue("pid").toInt(), parsePlayerState(message.queryItemValue("state")));
+                }
+            } else if (command.contains("player_now_playing_changed")) {
+                if (message.hasQueryItem("pid")) {
+                    sink.emitted("playerNowPlayingChanged", message.queryItemValue("pid").toInt());
+                }
+            } else if (command.contains("player_now_playing_progress")) {
+                if (message.hasQueryItem("pid")) {
+                    int playerId = message.queryItemValue("pid").toInt();
+                    int currentPosition = message.queryItemValue("cur_pos").toInt();
+                    int duration = message.queryItemValue("duration").toInt();
+                    sink.emitted("playerNowPlayingProgressReceived", playerId, currentPosition + duration);
+                }
+            } else if (command.contains("player_playback_error")) {
+                if (message.hasQueryItem("pid")) {
+                    sink.emitted("playerPlaybackErrorReceived", message.queryItemValue("pid").toInt(), message.queryItemValue("error").size());
+                }
+            } else if (command.contains("player_queue_changed")) {
+                if (message.hasQueryItem("pid")) {
+                    sink.emitted("playerQueueChanged", message.queryItemValue("pid").toInt());
+                }
+            } else if (command.contains("player_volume_changed")) {
+                if (message.hasQueryItem("pid")) {
+                    int playerId = message.queryItemValue("pid").toInt();
+                    if (message.hasQueryItem("level")) {
+                        sink.emitted("playerVolumeReceived", playerId, message.queryItemValue("level").toInt());
+                    }
+                    if (message.hasQueryItem("mute")) {
+                        sink.emitted("playerMuteStatusReceived", playerId, message.queryItemValue("mute").contains("on"));
+                    }
+                }
+            } else if (command.contains("repeat_mode_changed")) {
+                if (message.hasQueryItem("pid") && message.hasQueryItem("repeat")) {
+                    sink.emitted("playerRepeatModeReceived", message.queryItemValue("pid").toInt(), parseRepeatMode(message.queryItemValue("repeat")));
+                }
+            } else if (command.contains("shuffle_mode_changed")) {
+                if (message.hasQueryItem("pid") && message.hasQueryItem("shuffle")) {
+                    sink.emitted("playerShuffleModeReceived", message.queryItemValue("pid").toInt(), message.queryItemValue("shuffle").contains("on"));
+                }
+            } else if (command.contains("group_volume_changed")) {
+                if (message.hasQueryItem("gid")) {
+                    int groupId = message.queryItemValue("gid").toInt();
+                    if (message.hasQueryItem("level")) {
+                        sink.emitted("groupVolumeReceived", groupId, message.queryItemValue("level").toInt());
+                    }
+                    if (message.hasQueryItem("mute")) {
+                        sink.emitted("groupMuteStatusReceived", groupId, message.queryItemValue("mute").contains("on"));
+                    }
+                }
+            } else if (command.contains("user_changed")) {
+                sink.emitted("userChanged", message.hasQueryItem("signed_in"));
+            } else {
+                sink.emitted("unhandled", 0);
+            }
+        } else {
+            sink.emitted("unhandled", 0);
+        }
+    }
+}
+
+// Current Heos::readData() and Heos::processResponse(): the socket data is buffered, complete lines
+// are looked up in the command handler table and the message is only parsed on demand.
+class TableDispatcher
+{
+public:
+    explicit TableDispatcher(Sink &sink) : m_sink(sink)
+    {
+        m_handlers.insert("system/register_for_change_events", &TableDispatcher::onRegisterForChangeEventsResponse);
+        m_handlers.insert("system/check_account", &TableDispatcher::onUserResponse);
+        m_handlers.insert("system/sign_in", nullptr);
+        m_handlers.insert("system/sign_out", nullptr);
+        m_handlers.insert("system/heart_beat", nullptr);
+        m_handlers.insert("system/reboot", nullptr);
+        m_handlers.insert("system/prettify_json_response", nullptr);
+        m_handlers.insert("player/get_players", &TableDispatcher::onGetPlayersResponse);
+        m_handlers.insert("player/get_player_info", &TableDispatcher::onGetPlayerInfoResponse);
+        m_handlers.insert("player/get_now_playing_media", &TableDispatcher::onGetNowPlayingMediaResponse);
+        m_handlers.insert("player/get_play_state", &TableDispatcher::onPlayerPlayStateResponse);
+        m_handlers.insert("player/set_play_state", &TableDispatcher::onPlayerPlayStateResponse);
+        m_handlers.insert("player/get_volume", &TableDispatcher::onPlayerVolumeResponse);
+        m_handlers.insert("player/set_volume", &TableDispatcher::onPlayerVolumeResponse);
+        m_handlers.insert("player/get_mute", &TableDispatcher::onPlayerMuteResponse);
+        m_handlers.insert("player/set_mute", &TableDispatcher::onPlayerMuteResponse);
+        m_handlers.insert("player/get_play_mode", &TableDispatcher::onPlayerPlayModeResponse);
+        m_handlers.insert("player/set_play_mode", &TableDispatcher::onPlayerPlayModeResponse);
+        m_handlers.insert("player/check_update", &TableDispatcher::onCheckUpdateResponse);
+        m_handlers.insert("group/get_volume", &TableDispatcher::onGroupVolumeResponse);
+        m_handlers.insert("group/set_volume", &TableDispatcher::onGroupVolumeResponse);
+        m_handlers.insert("group/get_mute", &TableDispatcher::onGroupMuteResponse);
+        m_handlers.insert("group/set_mute", &TableDispatcher::onGroupMuteResponse);
+        m_handlers.insert("event/sources_changed", &TableDispatcher::onSourcesChangedEvent);
+        m_handlers.insert("event/players_changed", &TableDispatcher::onPlayersChangedEvent);
+        m_handlers.insert("event/groups_changed", &TableDispatcher::onGroupsChangedEvent);
+        m_handlers.insert("event/player_state_changed", &TableDispatcher::onPlayerStateChangedEvent);
+        m_handlers.insert("event/player_now_playing_changed", &TableDispatcher::onPlayerNowPlayingChangedEvent);
+        m_handlers.insert("event/player_now_playing_progress", &TableDispatcher::onPlayerNowPlayingProgressEvent);
+        m_handlers.insert("event/player_playback_error", &TableDispatcher::onPlayerPlaybackErrorEvent);
+        m_handlers.insert("event/player_queue_changed", &TableDispatcher::onPlayerQueueChangedEvent);
+        m_handlers.insert("event/player_volume_changed", &TableDispatcher::onPlayerVolumeChangedEvent);
+        m_handlers.insert("event/repeat_mode_changed", &TableDispatcher::onRepeatModeChangedEvent);
+        m_handlers.insert("event/shuffle_mode_changed", &TableDispatcher::onShuffleModeChangedEvent);
+        m_handlers.insert("event/group_volume_changed", &TableDispatcher::onGroupVolumeChangedEvent);
+        m_handlers.insert("event/user_changed", &TableDispatcher::onUserResponse);
+    }
+
+    void readData(const QByteArray &data)
+    {
+        m_receiveBuffer.append(data);
+
+        int index = m_receiveBuffer.indexOf('\n');
+        while (index >= 0) {
+            QByteArray line = m_receiveBuffer.left(index).trimmed();
+            m_receiveBuffer.remove(0, index + 1);
+            if (!line.isEmpty()) {
+                processResponse(line);
+            }
+            index = m_receiveBuffer.indexOf('\n');
+        }
+    }
+
+private:
+    class Response
+    {
+    public:
+        explicit Response(const QJsonObject &object) : m_object(object) { }
+
+        QString command;
+        QString rawMessage;
+        bool success = false;
+
+        const QUrlQuery &message() const {
+            if (!m_messageParsed) {
+                m_message = QUrlQuery(rawMessage);
+                m_messageParsed = true;
+            }
+            return m_message;
+        }
+        QVariant payload() const { return m_object.value("payload").toVariant(); }
+
+    private:
+        QJsonObject m_object;
+        mutable QUrlQuery m_message;
+        mutable bool m_messageParsed = false;
+    };
+    typedef void (TableDispatcher::*ResponseHandler)(const Response &response);
+
+    void processResponse(const QByteArray &data)
+    {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError)
+            return;
+
+        QJsonObject heosObject = jsonDoc.object().value("heos").toObject();
+        if (heosObject.isEmpty())
+            return;
+
+        Response response(jsonDoc.object());
+        response.command = heosObject.value("command").toString().trimmed();
+        response.rawMessage = heosObject.value("message").toString();
+        if (heosObject.contains("result")) {
+            response.success = heosObject.value("result").toString().contains("success");
+        }
+
+        if (!m_handlers.contains(response.command)) {
+            m_sink.emitted("unhandled", 0);
+            return;
+        }
+
+        ResponseHandler handler = m_handlers.value(response.command);
+        if (handler) {
+            (this->*handler)(response);
+        }
+    }
+
+    void onRegisterForChangeEventsResponse(const Response &response)
+    {
+        m_sink.emitted("systemEventsEnabled", !response.message().queryItemValue("enabled").contains("off"));
+    }
+
+    void onUserResponse(const Response &response)
+    {
+        m_sink.emitted("userChanged", response.message().hasQueryItem("signed_in"));
+    }
+
+    void onGetPlayersResponse(const Response &response)
+    {
+        m_sink.emitted("playersRecieved", response.payload().toList().count());
+    }
+
+    void onGetPlayerInfoResponse(const Response &response)
+    {
+        m_sink.emitted("playerInfoRecieved", response.payload().toMap().value("pid").toInt());
+    }
+
+    void onGetNowPlayingMediaResponse(const Response &response)
+    {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        QVariantMap payload = response.payload().toMap();
+        QString artist = payload.value("artist").toString();
+        QString song = payload.value("song").toString();
+        QString artwork = payload.value("image_url").toString();
+        QString album = payload.value("album").toString();
+        QString sourceId = payload.value("sid").toString();
+        m_sink.emitted("nowPlayingMediaStatusReceived", playerId, artist.size() + song.size() + artwork.size() + album.size() + sourceId.toInt());
+    }
+
+    void onPlayerPlayStateResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("state")) {
+            m_sink.emitted("playerPlayStateReceived", response.message().queryItemValue("pid").toInt(), parsePlayerState(response.message().queryItemValue("state")));
+        }
+    }
+
+    void onPlayerVolumeResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("level")) {
+            m_sink.emitted("playerVolumeReceived", response.message().queryItemValue("pid").toInt(), response.message().queryItemValue("level").toInt());
+        }
+    }
+
+    void onPlayerMuteResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("state")) {
+            m_sink.emitted("playerMuteStatusReceived", response.message().queryItemValue("pid").toInt(), response.message().queryItemValue("state").contains("on"));
+        }
+    }
+
+    void onPlayerPlayModeResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("shuffle") && response.message().hasQueryItem("repeat")) {
+            int playerId = response.message().queryItemValue("pid").toInt();
+            m_sink.emitted("playerShuffleModeReceived", playerId, response.message().queryItemValue("shuffle").contains("on"));
+            m_sink.emitted("playerRepeatModeReceived", playerId, parseRepeatMode(response.message().queryItemValue("repeat")));
+        }
+    }
+
+    void onCheckUpdateResponse(const Response &response)
+    {
+        m_sink.emitted("playerUpdateAvailable", response.message().queryItemValue("pid").toInt());
+    }
+
+    void onGroupVolumeResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("level")) {
+            m_sink.emitted("groupVolumeReceived", response.message().queryItemValue("gid").toInt(), response.message().queryItemValue("level").toInt());
+        }
+    }
+
+    void onGroupMuteResponse(const Response &response)
+    {
+        if (response.message().hasQueryItem("state")) {
+            m_sink.emitted("playerMuteStatusReceived", response.message().queryItemValue("gid").toInt(), response.message().queryItemValue("state").contains("on"));
+        }
+    }
+
+    void onSourcesChangedEvent(const Response &) { m_sink.emitted("sourcesChanged", 0); }
+    void onPlayersChangedEvent(const Response &) { m_sink.emitted("playersChanged", 0); }
+    void onGroupsChangedEvent(const Response &) { m_sink.emitted("groupsChanged", 0); }
+
+    void onPlayerStateChangedEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("state")) {
+            m_sink.emitted("playerPlayStateReceived", response.message().queryItemValue("pid").toInt(), parsePlayerState(response.message().queryItemValue("state")));
+        }
+    }
+
+    void onPlayerNowPlayingChangedEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid")) {
+            m_sink.emitted("playerNowPlayingChanged", response.message().queryItemValue("pid").toInt());
+        }
+    }
+
+    void onPlayerNowPlayingProgressEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid")) {
+            int playerId = response.message().queryItemValue("pid").toInt();
+            int currentPosition = response.message().queryItemValue("cur_pos").toInt();
+            int duration = response.message().queryItemValue("duration").toInt();
+            m_sink.emitted("playerNowPlayingProgressReceived", playerId, currentPosition + duration);
+        }
+    }
+
+    void onPlayerPlaybackErrorEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid")) {
+            m_sink.emitted("playerPlaybackErrorReceived", response.message().queryItemValue("pid").toInt(), response.message().queryItemValue("error").size());
+        }
+    }
+
+    void onPlayerQueueChangedEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid")) {
+            m_sink.emitted("playerQueueChanged", response.message().queryItemValue("pid").toInt());
+        }
+    }
+
+    void onPlayerVolumeChangedEvent(const Response &response)
+    {
+        const QUrlQuery &message = response.message();
+        if (message.hasQueryItem("pid")) {
+            int playerId = message.queryItemValue("pid").toInt();
+            if (message.hasQueryItem("level")) {
+                m_sink.emitted("playerVolumeReceived", playerId, message.queryItemValue("level").toInt());
+            }
+            if (message.hasQueryItem("mute")) {
+                m_sink.emitted("playerMuteStatusReceived", playerId, message.queryItemValue("mute").contains("on"));
+            }
+        }
+    }
+
+    void onRepeatModeChangedEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("repeat")) {
+            m_sink.emitted("playerRepeatModeReceived", response.message().queryItemValue("pid").toInt(), parseRepeatMode(response.message().queryItemValue("repeat")));
+        }
+    }
+
+    void onShuffleModeChangedEvent(const Response &response)
+    {
+        if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("shuffle")) {
+            m_sink.emitted("playerShuffleModeReceived", response.message().queryItemValue("pid").toInt(), response.message().queryItemValue("shuffle").contains("on"));
+        }
+    }
+
+    void onGroupVolumeChangedEvent(const Response &response)
+    {
+        const QUrlQuery &message = response.message();
+        if (message.hasQueryItem("gid")) {
+            int groupId = message.queryItemValue("gid").toInt();
+            if (message.hasQueryItem("level")) {
+                m_sink.emitted("groupVolumeReceived", groupId, message.queryItemValue("level").toInt());
+            }
+            if (message.hasQueryItem("mute")) {
+                m_sink.emitted("groupMuteStatusReceived", groupId, message.queryItemValue("mute").contains("on"));
+            }
+        }
+    }
+
+    Sink &m_sink;
+    QByteArray m_receiveBuffer;
+    QHash<QString, ResponseHandler> m_handlers;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QString fileName = QString(SAMPLE_DIR) + "/events-6players.txt";
+    if (application.arguments().count() > 1)
+        fileName = application.arguments().at(1);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open" << fileName << file.errorString();
+        return 1;
+    }
+    QByteArray stream = file.readAll();
+    int lines = stream.count('\n');
+    if (lines == 0) {
+        qWarning() << fileName << "does not contain any lines";
+        return 1;
+    }
+
+    // Replay about 100000 lines, the speaker delivers them in TCP segments
+    const int repetitions = qMax(1, 100000 / lines);
+    const int segmentSize = 1460;
+    qInfo().noquote() << "Replaying" << lines << "lines of" << fileName << repetitions << "times";
+
+    Sink chainSink;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < repetitions; i++) {
+        QBuffer buffer(&stream);
+        buffer.open(QIODevice::ReadOnly);
+        processChain(&buffer, chainSink);
+    }
+    qint64 chainTime = timer.nsecsElapsed();
+
+    Sink tableSink;
+    TableDispatcher dispatcher(tableSink);
+    timer.restart();
+    for (int i = 0; i < repetitions; i++) {
+        for (int offset = 0; offset < stream.size(); offset += segmentSize) {
+            dispatcher.readData(stream.mid(offset, segmentSize));
+        }
+    }
+    qint64 tableTime = timer.nsecsElapsed();
+
+    qint64 total = static_cast<qint64>(lines) * repetitions;
+    qInfo().noquote() << QString("command chain:   %1 us/line, %2 lines/s").arg(chainTime / 1000.0 / total, 0, 'f', 3).arg(total * 1000000000.0 / chainTime, 0, 'f', 0);
+    qInfo().noquote() << QString("handler table:   %1 us/line, %2 lines/s").arg(tableTime / 1000.0 / total, 0, 'f', 3).arg(total * 1000000000.0 / tableTime, 0, 'f', 0);
+    qInfo().noquote() << QString("speedup:         %1x").arg(static_cast<double>(chainTime) / tableTime, 0, 'f', 2);
+
+    foreach (const QString &signal, chainSink.counts.keys()) {
+        qInfo().noquote() << QString("  %1: %2").arg(signal, -34).arg(chainSink.counts.value(signal) / repetitions);
+    }
+
+    check(chainSink.counts == tableSink.counts, "Both dispatchers emit the same signals");
+    check(chainSink.checksum == tableSink.checksum, "Both dispatchers emit the same values in the same order");
+
+    return s_failures > 0 ? 1 : 0;
+}
@@ -52,6 +52,8 @@ Heos::Heos(const QHostAddress &hostAddress, QObject *parent) :
     connect(m_socket, &QTcpSocket::readyRead, this, &Heos::readData);
     connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onError(QAbstractSocket::SocketError)));
 
+    setupResponseHandlers();
+
     m_reconnectTimer = new QTimer(this);
     m_reconnectTimer->setInterval(5000);
     connect(m_reconnectTimer, &QTimer::timeout, this, [this]{
@@ -559,6 +561,7 @@ void Heos::onConnected()
 
 void Heos::onDisconnected()
 {
+    m_receiveBuffer.clear();
     m_reconnectTimer->start();
     qCDebug(dcDenon()) << "Heos: Disconnected from" << m_hostAddress.toString() << "try reconnecting in 5 seconds";
     emit connectionStatusChanged(false);
@@ -588,602 +591,621 @@ void Heos::onError(QAbstractSocket::SocketError socketError)
 
 void Heos::readData()
 {
-    QByteArray data;
+    m_receiveBuffer.append(m_socket->readAll());
+
+    // Responses are terminated by \r\n, keep incomplete ones until the rest arrives
+    int index = m_receiveBuffer.indexOf('\n');
+    while (index >= 0) {
+        QByteArray line = m_receiveBuffer.left(index).trimmed();
+        m_receiveBuffer.remove(0, index + 1);
+        if (!line.isEmpty()) {
+            processResponse(line);
+        }
+        index = m_receiveBuffer.indexOf('\n');
+    }
+
+    // Larger responses (e.g. long queues) stay well below 1 MB, anything else is a broken stream
+    if (m_receiveBuffer.size() > 1024 * 1024) {
+        qCWarning(dcDenon()) << "Heos: Received more than 1 MB without line end from" << m_hostAddress.toString() << ", dropping the connection";
+        m_receiveBuffer.clear();
+        m_socket->abort();
+    }
+}
+
+void Heos::processResponse(const QByteArray &data)
+{
     QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        // Skip this line only, the following ones are still fine
+        qCWarning(dcDenon) << "failed to parse json :" << error.errorString() << data;
+        return;
+    }
 
-    while (m_socket->canReadLine()) {
-        data = m_socket->readLine();
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcDenon) << "failed to parse json :" << error.errorString();
-            return;
-        }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-        if (dataMap.contains("heos")) {
-            QString command = dataMap.value("heos").toMap().value("command").toString();
-            QUrlQuery message(dataMap.value("heos").toMap().value("message").toString());
-            bool success = false;
-            if(dataMap.value("heos").toMap().contains("result")) {
-                //If the message doesn't contain result it is an event message
-                success = dataMap.value("heos").toMap().value("result").toString().contains("success");
-                if (!success) {
-                    qCWarning(dcDenon()) << "Command:" << command << "was not successfull. Message:" << message.toString();
-                    if (command == "system/sign_in") {
-                        emit userChanged(false, "");
-                    }
-                }
+    QJsonObject heosObject = jsonDoc.object().value("heos").toObject();
+    if (heosObject.isEmpty())
+        return;
+
+    Response response(jsonDoc.object());
+    response.command = heosObject.value("command").toString().trimmed();
+    response.rawMessage = heosObject.value("message").toString();
+    if (heosObject.contains("result")) {
+        //If the message doesn't contain result it is an event message
+        response.success = heosObject.value("result").toString().contains("success");
+        if (!response.success) {
+            qCWarning(dcDenon()) << "Command:" << response.command << "was not successfull. Message:" << response.rawMessage;
+            if (response.command == "system/sign_in") {
+                emit userChanged(false, "");
             }
-            /*
-             * 4.1 System Commands
-             *  4.1.1 Register for Change Events
-             *  4.1.2 HEOS Account Check
-             *  4.1.3 HEOS Account Sign In
-             *  4.1.4 HEOS Account Sign Out
-             *  4.1.5 HEOS System Heart Beat
-             *  4.1.6 HEOS Speaker Reboot
-             *  4.1.7 Prettify JSON response
-            */
-            if (command.startsWith("system")) {
-                if (command.contains("register_for_change_events")) {
-                    QString enabled = message.queryItemValue("enabled");
-                    if (enabled.contains("off")) {
-                        qDebug(dcDenon) << "Events are disabled";
-                        m_eventRegistered = false;
-                        emit systemEventsEnabled(false);
-                    } else {
-                        qDebug(dcDenon) << "Events are enabled";
-                        m_eventRegistered = true;
-                        emit systemEventsEnabled(true);
-                    }
-
-                } else if (command.contains("check_account")) {
-
-                    qDebug(dcDenon()) << "System command check_account:" << message.toString();
-                    bool signedIn;
-                    QString username = "";
-                    if (message.hasQueryItem("signed_in")){
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    } else {
-                        signedIn = false;
-                    }
-                    emit userChanged(signedIn, username);
-
-                } else if (command.contains("sign_in")) {
-
-                    qDebug(dcDenon()) << "System command sign_in:" << message.toString();
-
-                    if (message.hasQueryItem("signed_in")) {
-                        QString username = message.queryItemValue("un");
-                        emit userChanged(true, username);
-
-                    } // otherwise it will be command under process and we will wait for the event
-                } else if (command.contains("sign_out")) {
-
-                    qDebug(dcDenon()) << "System command sign_out:" << message.toString();
-                    emit userChanged(false, "");
-
-                } else if (command.contains("heart_beat")) {
-
-                } else if (command.contains("reboot")) {
-
-                } else if (command.contains("prettify_json_response")) {
-
-                }  else {
-                    qDebug(dcDenon) << "Unhandled Heos system command" << command;
-                }
-                /* 4.2 Player Commands
-             *  4.2.1 Get Players
-             *  4.2.2 Get Player Info
-             *  4.2.3 Get Play State
-             *  4.2.4 Set Play State
-             *  4.2.5 Get Now Playing Media
-             *  4.2.6 Get Volume
-             *  4.2.7 Set Volume
-             *  4.2.8 Volume Up
-             *  4.2.9 Volume Down
-             *  4.2.10 Get Mute
-             *  4.2.11 Set Mute
-             *  4.2.12 Toggle Mute
-             *  4.2.13 Get Play Mode
-             *  4.2.14 Set Play Mode
-             *  4.2.15 Get Queue
-             *  4.2.16 Play Queue Item
-             *  4.2.17 Remove Item(s) from Queue
-             *  4.2.18 Save Queue as Playlist
-             *  4.2.19 Clear Queue
-             *  4.2.20 Move Queue
-             *  4.2.21 Play Next
-             *  4.2.22 Play Previous
-             *  4.2.23 Set QuickSelect [LS AVR Only]
-             *  4.2.24 Play QuickSelect [LS AVR Only]
-             *  4.2.25 Get QuickSelects [LS AVR Only]
-             *  4.2.26 Check for Firmware Update
-             */
-            } else if (command.startsWith("player")) {
-                int playerId = 0;
-                if (message.hasQueryItem("pid")) {
-                    playerId = message.queryItemValue("pid").toInt();
-                }
-
-                if (command.contains("get_players")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<HeosPlayer *> players;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        HeosPlayer *player = new HeosPlayer(payloadEntryVariant.toMap().value("pid").toInt());
-                        player->setSerialNumber(payloadEntryVariant.toMap().value("serial").toString());
-                        player->setName(payloadEntryVariant.toMap().value("name").toString());
-                        getPlayerInfo(player->playerId());
-                        players.append(player);
-                    }
-                    emit playersRecieved(players);
-
-                } else if (command.contains("get_player_info")) {
-                    //update heos player info
-                    int pid = dataMap.value("payload").toMap().value("pid").toInt();
-                    HeosPlayer *player = new HeosPlayer(pid);
-                    player->setName(dataMap.value("payload").toMap().value("name").toString());
-                    if (dataMap.value("payload").toMap().contains("gid")) {
-                        player->setGroupId(dataMap.value("payload").toMap().value("gid").toInt());
-                    } else {
-                        player->setGroupId(-1); //no group assigned
-                    }
-                    player->setPlayerModel(dataMap.value("payload").toMap().value("model").toString());
-                    player->setPlayerVersion(dataMap.value("payload").toMap().value("version").toString());
-                    player->setLineOut(dataMap.value("payload").toMap().value("lineout").toString());
-                    player->setControl(dataMap.value("payload").toMap().value("control").toString());
-                    player->setSerialNumber(dataMap.value("payload").toMap().value("serial").toString());
-                    player->setNetwork(dataMap.value("payload").toMap().value("network").toString());
-                    emit playerInfoRecieved(player);
-
-                } else if (command.contains("get_now_playing_media")) {
-
-                    QString artist = dataMap.value("payload").toMap().value("artist").toString();
-                    QString song = dataMap.value("payload").toMap().value("song").toString();
-                    QString artwork = dataMap.value("payload").toMap().value("image_url").toString();
-                    QString album = dataMap.value("payload").toMap().value("album").toString();
-                    QString sourceId = dataMap.value("payload").toMap().value("sid").toString();
-                    qDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
-                    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
-
-                } else if (command.contains("get_play_state") || command.contains("set_play_state")) {
-                    if (message.hasQueryItem("state")) {
-                        PLAYER_STATE playState =  PLAYER_STATE_STOP;
-                        if (message.queryItemValue("state").contains("play")) {
-                            playState =  PLAYER_STATE_PLAY;
-                        } else if (message.queryItemValue("state").contains("pause")) {
-                            playState = PLAYER_STATE_PAUSE;
-                        } else if (message.queryItemValue("state").contains("stop")) {
-                            playState =  PLAYER_STATE_STOP;
-                        }
-                        emit playerPlayStateReceived(playerId, playState);
-                    }
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit playerVolumeReceived(playerId, volume);
-                    }
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(playerId, true);
-                        } else {
-                            emit playerMuteStatusReceived(playerId, false);
-                        }
-                    }
-                } else if (command.contains("get_play_mode") || command.contains("set_play_mode")) {
-                    if (message.hasQueryItem("shuffle") && message.hasQueryItem("repeat")) {
-                        bool shuffle;
-                        if (message.queryItemValue("shuffle").contains("on")){
-                            shuffle = true;
-                        } else {
-                            shuffle = false;
-                        }
-                        emit playerShuffleModeReceived(playerId, shuffle);
-
-                        REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                        if (message.queryItemValue("repeat").contains("on_all")){
-                            repeatMode = REPEAT_MODE_ALL;
-                        } else if (message.queryItemValue("repeat").contains("on_one")){
-                            repeatMode = REPEAT_MODE_ONE;
-                        } else  if (message.queryItemValue("repeat").contains("off")){
-                            repeatMode = REPEAT_MODE_OFF;
-                        }
-                        emit playerRepeatModeReceived(playerId, repeatMode);
-                    }
-                } else if (command.contains("check_update")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    bool updateExist = payloadVariantMap.value("update").toString().contains("exist");
-                    emit playerUpdateAvailable(playerId, updateExist);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
-                /*
-             * 4.3 Group Commands
-             *  4.3.1 Get Groups
-             *  4.3.2 Get Group Info
-             *  4.3.3 Set Group
-             *  4.3.4 Get Group Volume
-             *  4.3.5 Set Group Volume
-             *  4.2.6 Group Volume Up
-             *  4.2.7 Group Volume Down
-             *  4.3.8 Get Group Mute
-             *  4.3.9 Set Group Mute
-             *  4.3.10 Toggle Group Mute
-             */
-            } else if (command.startsWith("group")) {
-                int groupId = 0;
-                if (message.hasQueryItem("gid")) {
-                    qDebug(dcDenon) << "Group id" << message.queryItemValue("gid");
-                    groupId = message.queryItemValue("gid").toInt();
-                }
-                if (command.contains("get_groups")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<GroupObject> groups;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        GroupObject group;
-                        group.groupId = payloadEntryVariant.toMap().value("gid").toInt();
-                        group.name = payloadEntryVariant.toMap().value("name").toString();
-                        if (!payloadEntryVariant.toMap().value("players").toList().isEmpty()) {
-                            QVariantList playerlist = payloadEntryVariant.toMap().value("players").toList();
-                            foreach (const QVariant &playerVariant, playerlist) {
-                                PlayerObject player;
-                                player.name = playerVariant.toMap().value("name").toString();
-                                player.playerId = playerVariant.toMap().value("pid").toInt();
-                                group.players.append(player);
-                            }
-                        }
-                        groups.append(group);
-                    }
-                    emit groupsReceived(groups);
-                } else if (command.contains("get_group_info")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    GroupObject group;
-                    group.groupId = payloadVariantMap.value("gid").toInt();
-                    group.name = payloadVariantMap.value("name").toString();
-                    if (!payloadVariantMap.value("players").toList().isEmpty()) {
-                        QVariantList playerlist = payloadVariantMap.value("players").toList();
-                        foreach (const QVariant &playerVariant, playerlist) {
-                            PlayerObject player;
-                            player.name = playerVariant.toMap().value("name").toString();
-                            player.playerId = playerVariant.toMap().value("pid").toInt();
-                            group.players.append(player);
-                        }
-                    }
-                    emit groupInfoReceived(group);
-
-                } else if (command.contains("set_group")) {
-                    if (message.hasQueryItem("gid")) {
-
-                        int groupId = message.queryItemValue("gid").toInt();
-                        QString groupName = message.queryItemValue("name");
-                        emit setGroupReceived(groupId, groupName);
-                    } else {
-                        //No group Id so it must have been an ungoup request
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit deleteGroupReceived(playerId);
-                    }
-
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit groupVolumeReceived(groupId, volume);
-                    }
-
-                } else if (command.contains("volume_up") || command.contains("volume_down")) {
-
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(groupId, true);
-                        } else {
-                            emit playerMuteStatusReceived(groupId, false);
-                        }
-                    }
-                } else if (command.contains("toggle_mute")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
-
-
-                /* 4.4 Browse Commands
-                                                  *  4.4.1 Get Music Sources                         - "command": "browse/get_music_sources"
-                                                  *  4.4.2 Get Source Info                           - "command": "browse/get_source_info"
-                                                  *  4.4.3 Browse Source                             - "command": "browse/browse",
-                                                  *  4.4.4 Browse Source Containers                  - "command": "browse/browse",
-                                                  *  4.4.5 Get Source Search Criteria                - "command": "browse/get_search_criteria"
-                                                  *  4.4.6 Search                                    - "command": "browse/search"
-                                                  *  4.4.7 Play Station                              - "command": "browse/play_stream"
-                                                  *  4.4.8 Play Preset Station                       - "command": "browse/play_preset"
-                                                  *  4.4.9 Play Input source                         - "command": "browse/play_input"
-                                                  *  4.4.10 Play URL                                 - "command": "browse/play_stream "
-                                                  *  4.4.11 Add Container to Queue with Options      - "command": "browse/add_to_queue"
-                                                  *  4.4.12 Add Track to Queue with Options          - "command": "browse/add_to_queue"
-                                                  *  4.4.14 Rename HEOS Playlist                     - "command": "browse/rename_playlist"
-                                                  *  4.4.15 Delete HEOS Playlist                     - "command": "browse/delete_playlist "
-                                                  *  4.4.17 Retrieve Album Metadata                  - "command": "browse/retrieve_metadata",
-                                                 */
-            } else if (command.startsWith("browse") || command.startsWith(" browse")) {
-
-                quint32 sequenceNumber = 0;
-                if (message.hasQueryItem("SEQUENCE")) {
-                    qDebug(dcDenon) << "Sequence number" << message.queryItemValue("SEQUENCE");
-                    sequenceNumber = message.queryItemValue("SEQUENCE").toUInt();
-                }
-
-                if (command.contains("get_music_sources") || command.contains("get_source_info")) {
-                    qDebug(dcDenon()) << "Get music source request response received" << command;
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<MusicSourceObject> musicSources;
-                    if (success) {
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            MusicSourceObject source;
-                            source.name = payloadEntryVariant.toMap().value("name").toString();
-                            source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                            source.type = payloadEntryVariant.toMap().value("type").toString();
-                            source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                            source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                            source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                            musicSources.append(source);
-                        }
-                        emit musicSourcesReceived(sequenceNumber, musicSources);
-                    }
-
-                } else if (command.contains("browse/browse")) {
-                    qDebug(dcDenon()) << "Browse response:"  << jsonDoc.toVariant().toMap().value("payload");
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QString sourceId;
-                    QString containerId;
-                    if (message.hasQueryItem("sid")) {
-                        sourceId = message.queryItemValue("sid");
-                    }
-                    if (message.hasQueryItem("cid")) {
-                        containerId = message.queryItemValue("cid");
-                    }
-
-                    if (message.toString().contains("command under process")){
-                        qDebug(dcDenon()) << "Browse command is beeing processed";
-                        return;
-                    }
-                    if (success) {
-                        QList<MusicSourceObject> musicSources;
-                        QList<MediaObject> mediaItems;
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            QString type = payloadEntryVariant.toMap().value("type").toString();
-                            if (type == "source") {
-                                MusicSourceObject source;
-                                source.name = payloadEntryVariant.toMap().value("name").toString();
-                                source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                                source.type = payloadEntryVariant.toMap().value("type").toString();
-                                source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                                qDebug(dcDenon()) << "Source" << source.name << source.type << source.sourceId << payloadEntryVariant.toMap().value("sid");
-                                //source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                                //source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                                musicSources.append(source);
-                            } else {
-                                MediaObject media;
-                                qDebug(dcDenon()) << "Media Item" << payloadEntryVariant.toMap().value("mid").toString() << payloadEntryVariant.toMap().value("cid").toString();
-                                media.name = payloadEntryVariant.toMap().value("name").toString();
-                                if (payloadEntryVariant.toMap().contains("cid")) {
-                                    media.containerId = payloadEntryVariant.toMap().value("cid").toString();
-                                } else {
-                                    media.containerId = message.queryItemValue("cid");
-                                }
-                                media.mediaId = payloadEntryVariant.toMap().value("mid").toString();
-                                media.imageUrl = payloadEntryVariant.toMap().value("image_url").toString();
-                                media.isPlayable = payloadEntryVariant.toMap().value("playable").toString().contains("yes");
-                                media.isContainer = payloadEntryVariant.toMap().value("container").toString().contains("yes");
-                                media.sourceId = sourceId;
-                                if (type == "artist") {
-                                    media.mediaType = MEDIA_TYPE_ARTIST;
-                                } else if (type == "song") {
-                                    media.mediaType = MEDIA_TYPE_SONG;
-                                } else if (type == "genre") {
-                                    media.mediaType = MEDIA_TYPE_GENRE;
-                                } else if (type == "station") {
-                                    media.mediaType = MEDIA_TYPE_STATION;
-                                } else if (type == "album") {
-                                    media.mediaType = MEDIA_TYPE_ALBUM;
-                                } else if (type == "container") {
-                                    media.mediaType = MEDIA_TYPE_CONTAINER;
-                                }
-                                mediaItems.append(media);
-                            }
-                        }
-                        emit browseRequestReceived(sequenceNumber, sourceId, containerId, musicSources, mediaItems);
-                    }
-                    else {
-                        int errorId = message.queryItemValue("eid").toInt();
-                        QString text = message.queryItemValue("text");
-                        emit browseErrorReceived(sourceId, containerId, errorId, text);
-                    }
-                } else if (command.contains("play_preset")) {
-
-                } else if (command.contains("play_input")) {
-                    qCDebug(dcDenon()) << "Command play input";
-
-                } else if (command.contains("add_to_queue")) {
-
-                } else if (command.contains("rename_playlist")) {
-
-                } else if (command.contains("delete_playlist")) {
-
-                } else if (command.contains("retrieve_metadata")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos browse command" << command;
-                }
-
-
-                /*
-             * 5. Change Events (Unsolicited Responses) 5.1 Sources Changed
-             * 5.2 Players Changed
-             * 5.3 Group Changed
-             * 5.4 Player State Changed
-             * 5.5 Player Now Playing Changed
-             * 5.6 Player Now Playing Progress
-             * 5.7 Player Playback Error
-             * 5.8 Player Queue Changed
-             * 5.9 Player Volume Changed
-             * 5.10 Player Repeat Mode Changed
-             * 5.11 Player Shuffle Mode Changed
-             * 5.12 Group Volume Changed
-             * 5.13 User Changed
-             */
-            } else if (command.startsWith("event")) {
-                if (command.contains("sources_changed")) {
-                    emit sourcesChanged();
-
-                } else if (command.contains("players_changed")) {
-                    emit playersChanged();
-
-                } else if (command.contains("groups_changed")) {
-                    emit groupsChanged();
-
-                } else if (command.contains("player_state_changed")) {
-                    qDebug(dcDenon()) << "Player state changed";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        if (message.hasQueryItem("state")) {
-                            PLAYER_STATE playState = PLAYER_STATE_STOP;
-                            if (message.queryItemValue("state").contains("play")) {
-                                playState = PLAYER_STATE_PLAY;
-                            } else if (message.queryItemValue("state").contains("pause")) {
-                                playState = PLAYER_STATE_PAUSE;
-                            } else if (message.queryItemValue("state").contains("stop")) {
-                                playState = PLAYER_STATE_STOP;
-                            }
-                            emit playerPlayStateReceived(playerId, playState);
-                        }
-                    }
-                } else if (command.contains("player_now_playing_changed")) {
-                    qDebug(dcDenon()) << "Player now playing changed, player id:" << message.queryItemValue("pid").toInt();
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit playerNowPlayingChanged(playerId);
-                    }
-                } else if (command.contains("player_now_playing_progress")) {
-                    //qDebug(dcDenon()) << "Player now playing progress";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        int currentPossition = message.queryItemValue("cur_pos").toInt();
-                        int duration = message.queryItemValue("duration").toInt();
-                        emit playerNowPlayingProgressReceived(playerId, currentPossition, duration);
-                    }
-                } else if (command.contains("player_playback_error")) {
-                    qDebug(dcDenon) << "Player playback error";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        QString errorMessage = message.queryItemValue("error");
-                        emit playerPlaybackErrorReceived(playerId, errorMessage);
-                    }
-                } else if (command.contains("player_queue_changed")) {
-                    qDebug(dcDenon()) << "Player queue Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        emit playerQueueChanged(playerId);
-                    }
-                } else if (command.contains("player_volume_changed")) {
-                    qDebug(dcDenon()) << "Event player volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit playerVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit playerMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("repeat_mode_changed")) {
-                    qDebug(dcDenon()) << "Repeat mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("repeat")) {
-                            REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                            if (message.queryItemValue("repeat").contains("on_all")){
-                                repeatMode = REPEAT_MODE_ALL;
-                            } else if (message.queryItemValue("repeat").contains("on_one")){
-                                repeatMode = REPEAT_MODE_ONE;
-                            } else  if (message.queryItemValue("repeat").contains("off")){
-                                repeatMode = REPEAT_MODE_OFF;
-                            }
-                            emit playerRepeatModeReceived(playerId, repeatMode);
-                        }
-                    }
-                } else if (command.contains("shuffle_mode_changed")) {
-                    qDebug(dcDenon()) << "Shuffle mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("shuffle")) {
-                            bool shuffle;
-                            if (message.queryItemValue("shuffle").contains("on")){
-                                shuffle = true;
-                            } else {
-                                shuffle = false;
-                            }
-                            emit playerShuffleModeReceived(playerId, shuffle);
-                        }
-                    }
-                } else if (command.contains("group_volume_changed")) {
-                    qDebug(dcDenon()) << "Event group volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("gid")) {
-                        playerId = message.queryItemValue("gid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit groupVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit groupMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("user_changed")) {
-
-                    qDebug(dcDenon()) << "Event user changed" << message.toString();
-                    bool signedIn;
-                    QString username;
-                    if (message.hasQueryItem("signed_out")){
-                        signedIn = false;
-                    } else {
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    }
-                    emit userChanged(signedIn, username);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos event";
-                }
+        }
+    }
+
+    if (!m_responseHandlers.contains(response.command)) {
+        qDebug(dcDenon) << "Unhandled Heos command" << response.command;
+        return;
+    }
+
+    ResponseHandler handler = m_responseHandlers.value(response.command);
+    if (handler) {
+        (this->*handler)(response);
+    }
+}
+
+void Heos::setupResponseHandlers()
+{
+    /*
+     * 4.1 System Commands
+     *  4.1.1 Register for Change Events
+     *  4.1.2 HEOS Account Check
+     *  4.1.3 HEOS Account Sign In
+     *  4.1.4 HEOS Account Sign Out
+     *  4.1.5 HEOS System Heart Beat
+     *  4.1.6 HEOS Speaker Reboot
+     *  4.1.7 Prettify JSON response
+     */
+    m_responseHandlers.insert("system/register_for_change_events", &Heos::onRegisterForChangeEventsResponse);
+    m_responseHandlers.insert("system/check_account", &Heos::onCheckAccountResponse);
+    m_responseHandlers.insert("system/sign_in", &Heos::onSignInResponse);
+    m_responseHandlers.insert("system/sign_out", &Heos::onSignOutResponse);
+    m_responseHandlers.insert("system/heart_beat", nullptr);
+    m_responseHandlers.insert("system/reboot", nullptr);
+    m_responseHandlers.insert("system/prettify_json_response", nullptr);
+
+    /* 4.2 Player Commands
+     *  4.2.1 Get Players
+     *  4.2.2 Get Player Info
+     *  4.2.3 Get Play State
+     *  4.2.4 Set Play State
+     *  4.2.5 Get Now Playing Media
+     *  4.2.6 Get Volume
+     *  4.2.7 Set Volume
+     *  4.2.8 Volume Up
+     *  4.2.9 Volume Down
+     *  4.2.10 Get Mute
+     *  4.2.11 Set Mute
+     *  4.2.12 Toggle Mute
+     *  4.2.13 Get Play Mode
+     *  4.2.14 Set Play Mode
+     *  4.2.15 Get Queue
+     *  4.2.16 Play Queue Item
+     *  4.2.17 Remove Item(s) from Queue
+     *  4.2.18 Save Queue as Playlist
+     *  4.2.19 Clear Queue
+     *  4.2.20 Move Queue
+     *  4.2.21 Play Next
+     *  4.2.22 Play Previous
+     *  4.2.23 Set QuickSelect [LS AVR Only]
+     *  4.2.24 Play QuickSelect [LS AVR Only]
+     *  4.2.25 Get QuickSelects [LS AVR Only]
+     *  4.2.26 Check for Firmware Update
+     */
+    m_responseHandlers.insert("player/get_players", &Heos::onGetPlayersResponse);
+    m_responseHandlers.insert("player/get_player_info", &Heos::onGetPlayerInfoResponse);
+    m_responseHandlers.insert("player/get_now_playing_media", &Heos::onGetNowPlayingMediaResponse);
+    m_responseHandlers.insert("player/get_play_state", &Heos::onPlayerPlayStateResponse);
+    m_responseHandlers.insert("player/set_play_state", &Heos::onPlayerPlayStateResponse);
+    m_responseHandlers.insert("player/get_volume", &Heos::onPlayerVolumeResponse);
+    m_responseHandlers.insert("player/set_volume", &Heos::onPlayerVolumeResponse);
+    m_responseHandlers.insert("player/get_mute", &Heos::onPlayerMuteResponse);
+    m_responseHandlers.insert("player/set_mute", &Heos::onPlayerMuteResponse);
+    m_responseHandlers.insert("player/get_play_mode", &Heos::onPlayerPlayModeResponse);
+    m_responseHandlers.insert("player/set_play_mode", &Heos::onPlayerPlayModeResponse);
+    m_responseHandlers.insert("player/check_update", &Heos::onCheckUpdateResponse);
+
+    /*
+     * 4.3 Group Commands
+     *  4.3.1 Get Groups
+     *  4.3.2 Get Group Info
+     *  4.3.3 Set Group
+     *  4.3.4 Get Group Volume
+     *  4.3.5 Set Group Volume
+     *  4.2.6 Group Volume Up
+     *  4.2.7 Group Volume Down
+     *  4.3.8 Get Group Mute
+     *  4.3.9 Set Group Mute
+     *  4.3.10 Toggle Group Mute
+     */
+    m_responseHandlers.insert("group/get_groups", &Heos::onGetGroupsResponse);
+    m_responseHandlers.insert("group/get_group_info", &Heos::onGetGroupInfoResponse);
+    m_responseHandlers.insert("group/set_group", &Heos::onSetGroupResponse);
+    m_responseHandlers.insert("group/get_volume", &Heos::onGroupVolumeResponse);
+    m_responseHandlers.insert("group/set_volume", &Heos::onGroupVolumeResponse);
+    m_responseHandlers.insert("group/volume_up", nullptr);
+    m_responseHandlers.insert("group/volume_down", nullptr);
+    m_responseHandlers.insert("group/get_mute", &Heos::onGroupMuteResponse);
+    m_responseHandlers.insert("group/set_mute", &Heos::onGroupMuteResponse);
+    m_responseHandlers.insert("group/toggle_mute", nullptr);
+
+    /* 4.4 Browse Commands
+     *  4.4.1 Get Music Sources                         - "command": "browse/get_music_sources"
+     *  4.4.2 Get Source Info                           - "command": "browse/get_source_info"
+     *  4.4.3 Browse Source                             - "command": "browse/browse",
+     *  4.4.4 Browse Source Containers                  - "command": "browse/browse",
+     *  4.4.5 Get Source Search Criteria                - "command": "browse/get_search_criteria"
+     *  4.4.6 Search                                    - "command": "browse/search"
+     *  4.4.7 Play Station                              - "command": "browse/play_stream"
+     *  4.4.8 Play Preset Station                       - "command": "browse/play_preset"
+     *  4.4.9 Play Input source                         - "command": "browse/play_input"
+     *  4.4.10 Play URL                                 - "command": "browse/play_stream "
+     *  4.4.11 Add Container to Queue with Options      - "command": "browse/add_to_queue"
+     *  4.4.12 Add Track to Queue with Options          - "command": "browse/add_to_queue"
+     *  4.4.14 Rename HEOS Playlist                     - "command": "browse/rename_playlist"
+     *  4.4.15 Delete HEOS Playlist                     - "command": "browse/delete_playlist "
+     *  4.4.17 Retrieve Album Metadata                  - "command": "browse/retrieve_metadata",
+     */
+    m_responseHandlers.insert("browse/get_music_sources", &Heos::onGetMusicSourcesResponse);
+    m_responseHandlers.insert("browse/get_source_info", &Heos::onGetMusicSourcesResponse);
+    m_responseHandlers.insert("browse/browse", &Heos::onBrowseResponse);
+    m_responseHandlers.insert("browse/play_preset", nullptr);
+    m_responseHandlers.insert("browse/play_input", nullptr);
+    m_responseHandlers.insert("browse/add_to_queue", nullptr);
+    m_responseHandlers.insert("browse/rename_playlist", nullptr);
+    m_responseHandlers.insert("browse/delete_playlist", nullptr);
+    m_responseHandlers.insert("browse/retrieve_metadata", nullptr);
+
+    /*
+     * 5. Change Events (Unsolicited Responses)
+     * 5.1 Sources Changed
+     * 5.2 Players Changed
+     * 5.3 Group Changed
+     * 5.4 Player State Changed
+     * 5.5 Player Now Playing Changed
+     * 5.6 Player Now Playing Progress
+     * 5.7 Player Playback Error
+     * 5.8 Player Queue Changed
+     * 5.9 Player Volume Changed
+     * 5.10 Player Repeat Mode Changed
+     * 5.11 Player Shuffle Mode Changed
+     * 5.12 Group Volume Changed
+     * 5.13 User Changed
+     */
+    m_responseHandlers.insert("event/sources_changed", &Heos::onSourcesChangedEvent);
+    m_responseHandlers.insert("event/players_changed", &Heos::onPlayersChangedEvent);
+    m_responseHandlers.insert("event/groups_changed", &Heos::onGroupsChangedEvent);
+    m_responseHandlers.insert("event/player_state_changed", &Heos::onPlayerStateChangedEvent);
+    m_responseHandlers.insert("event/player_now_playing_changed", &Heos::onPlayerNowPlayingChangedEvent);
+    m_responseHandlers.insert("event/player_now_playing_progress", &Heos::onPlayerNowPlayingProgressEvent);
+    m_responseHandlers.insert("event/player_playback_error", &Heos::onPlayerPlaybackErrorEvent);
+    m_responseHandlers.insert("event/player_queue_changed", &Heos::onPlayerQueueChangedEvent);
+    m_responseHandlers.insert("event/player_volume_changed", &Heos::onPlayerVolumeChangedEvent);
+    m_responseHandlers.insert("event/repeat_mode_changed", &Heos::onRepeatModeChangedEvent);
+    m_responseHandlers.insert("event/shuffle_mode_changed", &Heos::onShuffleModeChangedEvent);
+    m_responseHandlers.insert("event/group_volume_changed", &Heos::onGroupVolumeChangedEvent);
+    m_responseHandlers.insert("event/user_changed", &Heos::onUserChangedEvent);
+}
+
+PLAYER_STATE Heos::parsePlayerState(const QString &state)
+{
+    if (state.contains("play")) {
+        return PLAYER_STATE_PLAY;
+    } else if (state.contains("pause")) {
+        return PLAYER_STATE_PAUSE;
+    }
+    return PLAYER_STATE_STOP;
+}
+
+REPEAT_MODE Heos::parseRepeatMode(const QString &repeatMode)
+{
+    if (repeatMode.contains("on_all")) {
+        return REPEAT_MODE_ALL;
+    } else if (repeatMode.contains("on_one")) {
+        return REPEAT_MODE_ONE;
+    }
+    return REPEAT_MODE_OFF;
+}
+
+void Heos::onRegisterForChangeEventsResponse(const Response &response)
+{
+    QString enabled = response.message().queryItemValue("enabled");
+    if (enabled.contains("off")) {
+        qDebug(dcDenon) << "Events are disabled";
+        m_eventRegistered = false;
+        emit systemEventsEnabled(false);
+    } else {
+        qDebug(dcDenon) << "Events are enabled";
+        m_eventRegistered = true;
+        emit systemEventsEnabled(true);
+    }
+}
+
+void Heos::onCheckAccountResponse(const Response &response)
+{
+    qDebug(dcDenon()) << "System command check_account:" << response.rawMessage;
+    if (response.message().hasQueryItem("signed_in")) {
+        emit userChanged(true, response.message().queryItemValue("un"));
+    } else {
+        emit userChanged(false, "");
+    }
+}
+
+void Heos::onSignInResponse(const Response &response)
+{
+    qDebug(dcDenon()) << "System command sign_in:" << response.rawMessage;
+    if (response.message().hasQueryItem("signed_in")) {
+        emit userChanged(true, response.message().queryItemValue("un"));
+    } // otherwise it will be command under process and we will wait for the event
+}
+
+void Heos::onSignOutResponse(const Response &response)
+{
+    qDebug(dcDenon()) << "System command sign_out:" << response.rawMessage;
+    emit userChanged(false, "");
+}
+
+void Heos::onGetPlayersResponse(const Response &response)
+{
+    QList<HeosPlayer *> players;
+    foreach (const QVariant &payloadEntryVariant, response.payload().toList()) {
+        QVariantMap payloadEntry = payloadEntryVariant.toMap();
+        HeosPlayer *player = new HeosPlayer(payloadEntry.value("pid").toInt());
+        player->setSerialNumber(payloadEntry.value("serial").toString());
+        player->setName(payloadEntry.value("name").toString());
+        getPlayerInfo(player->playerId());
+        players.append(player);
+    }
+    emit playersRecieved(players);
+}
+
+void Heos::onGetPlayerInfoResponse(const Response &response)
+{
+    //update heos player info
+    QVariantMap payload = response.payload().toMap();
+    HeosPlayer *player = new HeosPlayer(payload.value("pid").toInt());
+    player->setName(payload.value("name").toString());
+    if (payload.contains("gid")) {
+        player->setGroupId(payload.value("gid").toInt());
+    } else {
+        player->setGroupId(-1); //no group assigned
+    }
+    player->setPlayerModel(payload.value("model").toString());
+    player->setPlayerVersion(payload.value("version").toString());
+    player->setLineOut(payload.value("lineout").toString());
+    player->setControl(payload.value("control").toString());
+    player->setSerialNumber(payload.value("serial").toString());
+    player->setNetwork(payload.value("network").toString());
+    emit playerInfoRecieved(player);
+}
+
+void Heos::onGetNowPlayingMediaResponse(const Response &response)
+{
+    int playerId = response.message().queryItemValue("pid").toInt();
+    QVariantMap payload = response.payload().toMap();
+    QString artist = payload.value("artist").toString();
+    QString song = payload.value("song").toString();
+    QString artwork = payload.value("image_url").toString();
+    QString album = payload.value("album").toString();
+    QString sourceId = payload.value("sid").toString();
+    qDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
+    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
+}
+
+void Heos::onPlayerPlayStateResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("state")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerPlayStateReceived(playerId, parsePlayerState(response.message().queryItemValue("state")));
+    }
+}
+
+void Heos::onPlayerVolumeResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("level")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerVolumeReceived(playerId, response.message().queryItemValue("level").toInt());
+    }
+}
+
+void Heos::onPlayerMuteResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("state")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerMuteStatusReceived(playerId, response.message().queryItemValue("state").contains("on"));
+    }
+}
+
+void Heos::onPlayerPlayModeResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("shuffle") && response.message().hasQueryItem("repeat")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerShuffleModeReceived(playerId, response.message().queryItemValue("shuffle").contains("on"));
+        emit playerRepeatModeReceived(playerId, parseRepeatMode(response.message().queryItemValue("repeat")));
+    }
+}
+
+void Heos::onCheckUpdateResponse(const Response &response)
+{
+    int playerId = response.message().queryItemValue("pid").toInt();
+    bool updateExist = response.payload().toMap().value("update").toString().contains("exist");
+    emit playerUpdateAvailable(playerId, updateExist);
+}
+
+void Heos::onGetGroupsResponse(const Response &response)
+{
+    QList<GroupObject> groups;
+    foreach (const QVariant &payloadEntryVariant, response.payload().toList()) {
+        QVariantMap payloadEntry = payloadEntryVariant.toMap();
+        GroupObject group;
+        group.groupId = payloadEntry.value("gid").toInt();
+        group.name = payloadEntry.value("name").toString();
+        foreach (const QVariant &playerVariant, payloadEntry.value("players").toList()) {
+            PlayerObject player;
+            player.name = playerVariant.toMap().value("name").toString();
+            player.playerId = playerVariant.toMap().value("pid").toInt();
+            group.players.append(player);
+        }
+        groups.append(group);
+    }
+    emit groupsReceived(groups);
+}
+
+void Heos::onGetGroupInfoResponse(const Response &response)
+{
+    QVariantMap payload = response.payload().toMap();
+    GroupObject group;
+    group.groupId = payload.value("gid").toInt();
+    group.name = payload.value("name").toString();
+    foreach (const QVariant &playerVariant, payload.value("players").toList()) {
+        PlayerObject player;
+        player.name = playerVariant.toMap().value("name").toString();
+        player.playerId = playerVariant.toMap().value("pid").toInt();
+        group.players.append(player);
+    }
+    emit groupInfoReceived(group);
+}
+
+void Heos::onSetGroupResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("gid")) {
+        int groupId = response.message().queryItemValue("gid").toInt();
+        QString groupName = response.message().queryItemValue("name");
+        emit setGroupReceived(groupId, groupName);
+    } else {
+        //No group Id so it must have been an ungoup request
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit deleteGroupReceived(playerId);
+    }
+}
+
+void Heos::onGroupVolumeResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("level")) {
+        int groupId = response.message().queryItemValue("gid").toInt();
+        emit groupVolumeReceived(groupId, response.message().queryItemValue("level").toInt());
+    }
+}
+
+void Heos::onGroupMuteResponse(const Response &response)
+{
+    if (response.message().hasQueryItem("state")) {
+        int groupId = response.message().queryItemValue("gid").toInt();
+        emit playerMuteStatusReceived(groupId, response.message().queryItemValue("state").contains("on"));
+    }
+}
+
+void Heos::onGetMusicSourcesResponse(const Response &response)
+{
+    qDebug(dcDenon()) << "Get music source request response received" << response.command;
+    if (!response.success)
+        return;
+
+    quint32 sequenceNumber = response.message().queryItemValue("SEQUENCE").toUInt();
+    QList<MusicSourceObject> musicSources;
+    foreach (const QVariant &payloadEntryVariant, response.payload().toList()) {
+        QVariantMap payloadEntry = payloadEntryVariant.toMap();
+        MusicSourceObject source;
+        source.name = payloadEntry.value("name").toString();
+        source.image_url = payloadEntry.value("image_url").toString();
+        source.type = payloadEntry.value("type").toString();
+        source.sourceId = payloadEntry.value("sid").toInt();
+        source.available = payloadEntry.value("available").toString().contains("true");
+        source.serviceUsername = payloadEntry.value("service_username").toString();
+        musicSources.append(source);
+    }
+    emit musicSourcesReceived(sequenceNumber, musicSources);
+}
+
+void Heos::onBrowseResponse(const Response &response)
+{
+    const QUrlQuery &message = response.message();
+    if (message.toString().contains("command under process")){
+        qDebug(dcDenon()) << "Browse command is beeing processed";
+        return;
+    }
+
+    quint32 sequenceNumber = message.queryItemValue("SEQUENCE").toUInt();
+    QString sourceId = message.queryItemValue("sid");
+    QString containerId = message.queryItemValue("cid");
+
+    if (!response.success) {
+        int errorId = message.queryItemValue("eid").toInt();
+        QString text = message.queryItemValue("text");
+        emit browseErrorReceived(sourceId, containerId, errorId, text);
+        return;
+    }
+
+    QList<MusicSourceObject> musicSources;
+    QList<MediaObject> mediaItems;
+    foreach (const QVariant &payloadEntryVariant, response.payload().toList()) {
+        QVariantMap payloadEntry = payloadEntryVariant.toMap();
+        QString type = payloadEntry.value("type").toString();
+        if (type == "source") {
+            MusicSourceObject source;
+            source.name = payloadEntry.value("name").toString();
+            source.image_url = payloadEntry.value("image_url").toString();
+            source.type = type;
+            source.sourceId = payloadEntry.value("sid").toInt();
+            musicSources.append(source);
+        } else {
+            MediaObject media;
+            media.name = payloadEntry.value("name").toString();
+            if (payloadEntry.contains("cid")) {
+                media.containerId = payloadEntry.value("cid").toString();
             } else {
-                qDebug(dcDenon) << "Unhandled Heos category" << command;
+                media.containerId = containerId;
+            }
+            media.mediaId = payloadEntry.value("mid").toString();
+            media.imageUrl = payloadEntry.value("image_url").toString();
+            media.isPlayable = payloadEntry.value("playable").toString().contains("yes");
+            media.isContainer = payloadEntry.value("container").toString().contains("yes");
+            media.sourceId = sourceId;
+            if (type == "artist") {
+                media.mediaType = MEDIA_TYPE_ARTIST;
+            } else if (type == "song") {
+                media.mediaType = MEDIA_TYPE_SONG;
+            } else if (type == "genre") {
+                media.mediaType = MEDIA_TYPE_GENRE;
+            } else if (type == "station") {
+                media.mediaType = MEDIA_TYPE_STATION;
+            } else if (type == "album") {
+                media.mediaType = MEDIA_TYPE_ALBUM;
+            } else if (type == "container") {
+                media.mediaType = MEDIA_TYPE_CONTAINER;
             }
+            mediaItems.append(media);
         }
     }
+    qDebug(dcDenon()) << "Browse response:" << sourceId << containerId << musicSources.count() << "sources" << mediaItems.count() << "media items";
+    emit browseRequestReceived(sequenceNumber, sourceId, containerId, musicSources, mediaItems);
+}
+
+void Heos::onSourcesChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit sourcesChanged();
+}
+
+void Heos::onPlayersChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit playersChanged();
+}
+
+void Heos::onGroupsChangedEvent(const Response &response)
+{
+    Q_UNUSED(response)
+    emit groupsChanged();
+}
+
+void Heos::onPlayerStateChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Player state changed";
+    if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("state")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerPlayStateReceived(playerId, parsePlayerState(response.message().queryItemValue("state")));
+    }
+}
+
+void Heos::onPlayerNowPlayingChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Player now playing changed, player id:" << response.message().queryItemValue("pid").toInt();
+    if (response.message().hasQueryItem("pid")) {
+        emit playerNowPlayingChanged(response.message().queryItemValue("pid").toInt());
+    }
+}
+
+void Heos::onPlayerNowPlayingProgressEvent(const Response &response)
+{
+    if (response.message().hasQueryItem("pid")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        int currentPossition = response.message().queryItemValue("cur_pos").toInt();
+        int duration = response.message().queryItemValue("duration").toInt();
+        emit playerNowPlayingProgressReceived(playerId, currentPossition, duration);
+    }
+}
+
+void Heos::onPlayerPlaybackErrorEvent(const Response &response)
+{
+    qDebug(dcDenon) << "Player playback error";
+    if (response.message().hasQueryItem("pid")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerPlaybackErrorReceived(playerId, response.message().queryItemValue("error"));
+    }
+}
+
+void Heos::onPlayerQueueChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Player queue Changed";
+    if (response.message().hasQueryItem("pid")) {
+        emit playerQueueChanged(response.message().queryItemValue("pid").toInt());
+    }
+}
+
+void Heos::onPlayerVolumeChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Event player volume Changed";
+    const QUrlQuery &message = response.message();
+    if (message.hasQueryItem("pid")) {
+        int playerId = message.queryItemValue("pid").toInt();
+        if (message.hasQueryItem("level")) {
+            emit playerVolumeReceived(playerId, message.queryItemValue("level").toInt());
+        }
+        if (message.hasQueryItem("mute")) {
+            emit playerMuteStatusReceived(playerId, message.queryItemValue("mute").contains("on"));
+        }
+    }
+}
+
+void Heos::onRepeatModeChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Repeat mode Changed";
+    if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("repeat")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerRepeatModeReceived(playerId, parseRepeatMode(response.message().queryItemValue("repeat")));
+    }
+}
+
+void Heos::onShuffleModeChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Shuffle mode Changed";
+    if (response.message().hasQueryItem("pid") && response.message().hasQueryItem("shuffle")) {
+        int playerId = response.message().queryItemValue("pid").toInt();
+        emit playerShuffleModeReceived(playerId, response.message().queryItemValue("shuffle").contains("on"));
+    }
+}
+
+void Heos::onGroupVolumeChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Event group volume Changed";
+    const QUrlQuery &message = response.message();
+    if (message.hasQueryItem("gid")) {
+        int groupId = message.queryItemValue("gid").toInt();
+        if (message.hasQueryItem("level")) {
+            emit groupVolumeReceived(groupId, message.queryItemValue("level").toInt());
+        }
+        if (message.hasQueryItem("mute")) {
+            emit groupMuteStatusReceived(groupId, message.queryItemValue("mute").contains("on"));
+        }
+    }
+}
+
+void Heos::onUserChangedEvent(const Response &response)
+{
+    qDebug(dcDenon()) << "Event user changed" << response.rawMessage;
+    if (response.message().hasQueryItem("signed_out")) {
+        emit userChanged(false, QString());
+    } else {
+        emit userChanged(true, response.message().queryItemValue("un"));
+    }
 }
 
 quint32 Heos::createRandomNumber()
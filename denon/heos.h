@@ -35,6 +35,9 @@
 #include <QHostAddress>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QHash>
+#include <QUrlQuery>
+#include <QJsonObject>
 
 #include "heosplayer.h"
 #include "heostypes.h"
@@ -122,12 +125,87 @@ public:
     quint32 playUrl(int playerId, const QUrl &url);
 
 private:
+    // A single response line, the message query is only parsed if a handler asks for it
+    class Response
+    {
+    public:
+        explicit Response(const QJsonObject &object) : m_object(object) { }
+
+        QString command;
+        QString rawMessage;
+        bool success = false;
+
+        const QUrlQuery &message() const {
+            if (!m_messageParsed) {
+                m_message = QUrlQuery(rawMessage);
+                m_messageParsed = true;
+            }
+            return m_message;
+        }
+        QVariant payload() const { return m_object.value("payload").toVariant(); }
+
+    private:
+        QJsonObject m_object;
+        mutable QUrlQuery m_message;
+        mutable bool m_messageParsed = false;
+    };
+    typedef void (Heos::*ResponseHandler)(const Response &response);
+
     bool m_eventRegistered = false;
     QHostAddress m_hostAddress;
     QTcpSocket *m_socket = nullptr;
     QTimer *m_reconnectTimer = nullptr;
+    QByteArray m_receiveBuffer;
+    QHash<QString, ResponseHandler> m_responseHandlers;
     void setConnected(const bool &connected);
 
+    void setupResponseHandlers();
+    void processResponse(const QByteArray &data);
+    static PLAYER_STATE parsePlayerState(const QString &state);
+    static REPEAT_MODE parseRepeatMode(const QString &repeatMode);
+
+    // System commands
+    void onRegisterForChangeEventsResponse(const Response &response);
+    void onCheckAccountResponse(const Response &response);
+    void onSignInResponse(const Response &response);
+    void onSignOutResponse(const Response &response);
+
+    // Player commands
+    void onGetPlayersResponse(const Response &response);
+    void onGetPlayerInfoResponse(const Response &response);
+    void onGetNowPlayingMediaResponse(const Response &response);
+    void onPlayerPlayStateResponse(const Response &response);
+    void onPlayerVolumeResponse(const Response &response);
+    void onPlayerMuteResponse(const Response &response);
+    void onPlayerPlayModeResponse(const Response &response);
+    void onCheckUpdateResponse(const Response &response);
+
+    // Group commands
+    void onGetGroupsResponse(const Response &response);
+    void onGetGroupInfoResponse(const Response &response);
+    void onSetGroupResponse(const Response &response);
+    void onGroupVolumeResponse(const Response &response);
+    void onGroupMuteResponse(const Response &response);
+
+    // Browse commands
+    void onGetMusicSourcesResponse(const Response &response);
+    void onBrowseResponse(const Response &response);
+
+    // Change events
+    void onSourcesChangedEvent(const Response &response);
+    void onPlayersChangedEvent(const Response &response);
+    void onGroupsChangedEvent(const Response &response);
+    void onPlayerStateChangedEvent(const Response &response);
+    void onPlayerNowPlayingChangedEvent(const Response &response);
+    void onPlayerNowPlayingProgressEvent(const Response &response);
+    void onPlayerPlaybackErrorEvent(const Response &response);
+    void onPlayerQueueChangedEvent(const Response &response);
+    void onPlayerVolumeChangedEvent(const Response &response);
+    void onRepeatModeChangedEvent(const Response &response);
+    void onShuffleModeChangedEvent(const Response &response);
+    void onGroupVolumeChangedEvent(const Response &response);
+    void onUserChangedEvent(const Response &response);
+
 signals:
     void connectionStatusChanged(bool status);
     void systemEventsEnabled(bool status);
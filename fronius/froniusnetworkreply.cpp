@@ -60,6 +60,11 @@ QNetworkReply *FroniusNetworkReply::networkReply() const
     return m_networkReply;
 }
 
+qint64 FroniusNetworkReply::elapsed() const
+{
+    return m_timer.isValid() ? m_timer.elapsed() : 0;
+}
+
 FroniusNetworkReply::FroniusNetworkReply(const QNetworkRequest &request, QObject *parent) :
     QObject(parent),
     m_request(request)
@@ -70,6 +75,7 @@ FroniusNetworkReply::FroniusNetworkReply(const QNetworkRequest &request, QObject
 void FroniusNetworkReply::setNetworkReply(QNetworkReply *networkReply)
 {
     m_networkReply = networkReply;
+    m_timer.start();
 
     // The QNetworkReply will be deleted in the destructor if set
     connect(m_networkReply, &QNetworkReply::finished, this, &FroniusNetworkReply::finished);
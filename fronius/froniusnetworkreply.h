@@ -33,6 +33,7 @@
 
 #include <QObject>
 #include <QNetworkReply>
+#include <QElapsedTimer>
 
 class FroniusNetworkReply : public QObject
 {
@@ -48,6 +49,9 @@ public:
     QNetworkRequest request() const;
     QNetworkReply *networkReply() const;
 
+    // Milliseconds since the request has been sent
+    qint64 elapsed() const;
+
 signals:
     void finished();
 
@@ -56,6 +60,7 @@ private:
 
     QNetworkRequest m_request;
     QNetworkReply *m_networkReply = nullptr;
+    QElapsedTimer m_timer;
 
     void setNetworkReply(QNetworkReply *networkReply);
 };
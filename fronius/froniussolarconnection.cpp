@@ -31,6 +31,7 @@
 #include "froniussolarconnection.h"
 #include "extern-plugininfo.h"
 
+#include <QtMath>
 #include <QUrlQuery>
 
 FroniusSolarConnection::FroniusSolarConnection(NetworkAccessManager *networkManager, const QHostAddress &address, QObject *parent) :
@@ -64,6 +65,8 @@ void FroniusSolarConnection::setAddress(const QHostAddress &address)
         m_currentReply = nullptr;
     }
 
+    m_refreshCycleRunning = false;
+
     if (m_address.isNull()) {
         m_available = false;
         emit availableChanged(m_available);
@@ -77,35 +80,43 @@ bool FroniusSolarConnection::available() const
 
 bool FroniusSolarConnection::busy() const
 {
-    return m_requestQueue.count() > 1;
+    return m_refreshCycleRunning || m_requestQueue.count() > 1;
 }
 
-FroniusNetworkReply *FroniusSolarConnection::getVersion()
+bool FroniusSolarConnection::refreshDue() const
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/GetAPIVersion.cgi");
+    if (busy())
+        return false;
 
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
+    // Allow some jitter since the refresh gets triggered by a timer with a resolution of one second
+    return !m_refreshCycleTimer.isValid() || m_refreshCycleTimer.elapsed() + 500 >= m_refreshInterval;
+}
+
+void FroniusSolarConnection::startRefreshCycle()
+{
+    m_refreshCycleRunning = true;
+    m_refreshCycleRequestCount = 0;
+    m_refreshCycleMaxRoundTripTime = 0;
+    m_refreshCycleTimer.start();
+}
+
+int FroniusSolarConnection::refreshInterval() const
+{
+    return m_refreshInterval;
+}
+
+FroniusNetworkReply *FroniusSolarConnection::getVersion()
+{
+    FroniusNetworkReply *reply = createRequest("/solar_api/GetAPIVersion.cgi");
     sendNextRequest();
     return reply;
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getActiveDevices()
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetActiveDeviceInfo.cgi");
-
     QUrlQuery query;
     query.addQueryItem("DeviceClass", "System");
-    requestUrl.setQuery(query);
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetActiveDeviceInfo.cgi", query);
 
     // Note: we use this request for detecting if the logger is available or not.
     connect(reply, &FroniusNetworkReply::finished, this, [=](){
@@ -136,69 +147,87 @@ FroniusNetworkReply *FroniusSolarConnection::getActiveDevices()
 
 FroniusNetworkReply *FroniusSolarConnection::getPowerFlowRealtimeData()
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetPowerFlowRealtimeData.fcgi");
-
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetPowerFlowRealtimeData.fcgi");
     sendNextRequest();
     return reply;
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getInverterRealtimeData(int inverterId)
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetInverterRealtimeData.cgi");
-
     QUrlQuery query;
     query.addQueryItem("Scope", "Device");
     query.addQueryItem("DeviceId", QString::number(inverterId));
     query.addQueryItem("DataCollection", "CommonInverterData");
-    requestUrl.setQuery(query);
 
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetInverterRealtimeData.cgi", query);
     sendNextRequest();
     return reply;
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getMeterRealtimeData(int meterId)
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetMeterRealtimeData.cgi");
-
     QUrlQuery query;
     query.addQueryItem("Scope", "Device");
     query.addQueryItem("DeviceId", QString::number(meterId));
-    requestUrl.setQuery(query);
 
-    FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
-    m_requestQueue.enqueue(reply);
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetMeterRealtimeData.cgi", query);
     sendNextRequest();
     return reply;
 }
 
 FroniusNetworkReply *FroniusSolarConnection::getStorageRealtimeData(int meterId)
 {
-    QUrl requestUrl;
-    requestUrl.setScheme("http");
-    requestUrl.setHost(m_address.toString());
-    requestUrl.setPath("/solar_api/v1/GetStorageRealtimeData.cgi");
-
     QUrlQuery query;
     query.addQueryItem("Scope", "Device");
     query.addQueryItem("DeviceId", QString::number(meterId));
-    requestUrl.setQuery(query);
+
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetStorageRealtimeData.cgi", query);
+    sendNextRequest();
+    return reply;
+}
+
+FroniusNetworkReply *FroniusSolarConnection::getSystemInverterRealtimeData()
+{
+    // Note: in system scope the values are grouped by value name, each containing the values of all inverters by id
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetInverterRealtimeData.cgi", query);
+    sendNextRequest();
+    return reply;
+}
+
+FroniusNetworkReply *FroniusSolarConnection::getSystemMeterRealtimeData()
+{
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetMeterRealtimeData.cgi", query);
+    sendNextRequest();
+    return reply;
+}
+
+FroniusNetworkReply *FroniusSolarConnection::getSystemStorageRealtimeData()
+{
+    QUrlQuery query;
+    query.addQueryItem("Scope", "System");
+
+    FroniusNetworkReply *reply = createRequest("/solar_api/v1/GetStorageRealtimeData.cgi", query);
+    sendNextRequest();
+    return reply;
+}
+
+FroniusNetworkReply *FroniusSolarConnection::createRequest(const QString &path, const QUrlQuery &query)
+{
+    QUrl requestUrl;
+    requestUrl.setScheme("http");
+    requestUrl.setHost(m_address.toString());
+    requestUrl.setPath(path);
+    if (!query.isEmpty())
+        requestUrl.setQuery(query);
 
     FroniusNetworkReply *reply = new FroniusNetworkReply(QNetworkRequest(requestUrl), this);
     m_requestQueue.enqueue(reply);
-    sendNextRequest();
     return reply;
 }
 
@@ -220,10 +249,42 @@ void FroniusSolarConnection::sendNextRequest()
             qCWarning(dcFronius()) << "Connection: Request finished with error:" << m_currentReply->networkReply()->error() << "for url" << m_currentReply->request().url().toString();
         }
 
+        if (m_refreshCycleRunning) {
+            m_refreshCycleRequestCount++;
+            m_refreshCycleMaxRoundTripTime = qMax(m_refreshCycleMaxRoundTripTime, static_cast<int>(m_currentReply->elapsed()));
+        }
+
         // Note: the network reply will be deleted in the destructor
         m_currentReply->deleteLater();
 
         m_currentReply = nullptr;
         sendNextRequest();
+
+        // The finished handlers of the reply may still enqueue follow up requests for this cycle,
+        // so check for the end of the cycle once they all have been processed.
+        if (m_refreshCycleRunning) {
+            QMetaObject::invokeMethod(this, &FroniusSolarConnection::checkRefreshCycleFinished, Qt::QueuedConnection);
+        }
     });
 }
+
+void FroniusSolarConnection::checkRefreshCycleFinished()
+{
+    if (!m_refreshCycleRunning || m_currentReply || !m_requestQueue.isEmpty())
+        return;
+
+    m_refreshCycleRunning = false;
+    int duration = static_cast<int>(m_refreshCycleTimer.elapsed());
+
+    // Smooth the duration and keep the logger busy for at most half of the time
+    if (m_averageRefreshCycleDuration == 0) {
+        m_averageRefreshCycleDuration = duration;
+    } else {
+        m_averageRefreshCycleDuration = 0.75 * m_averageRefreshCycleDuration + 0.25 * duration;
+    }
+    int interval = qCeil(2 * m_averageRefreshCycleDuration / 1000) * 1000;
+    m_refreshInterval = qBound(2000, interval, 60000);
+
+    qCDebug(dcFronius()) << "Connection: Refresh cycle finished for" << m_address.toString() << "within" << duration << "ms using" << m_refreshCycleRequestCount << "requests. Refresh interval:" << m_refreshInterval << "ms";
+    emit refreshCycleFinished(duration, m_refreshCycleRequestCount, m_refreshCycleMaxRoundTripTime);
+}
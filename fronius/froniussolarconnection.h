@@ -34,6 +34,8 @@
 #include <QObject>
 #include <QQueue>
 #include <QHostAddress>
+#include <QElapsedTimer>
+#include <QUrlQuery>
 
 #include <network/networkaccessmanager.h>
 
@@ -52,6 +54,12 @@ public:
 
     bool busy() const;
 
+    // Refresh cycle scheduling. A cycle lasts from startRefreshCycle() until the request queue runs empty.
+    // The interval between two cycles adapts to the measured cycle duration in order to not overload the logger.
+    bool refreshDue() const;
+    void startRefreshCycle();
+    int refreshInterval() const;
+
     FroniusNetworkReply *getVersion();
     FroniusNetworkReply *getActiveDevices();
     FroniusNetworkReply *getPowerFlowRealtimeData();
@@ -60,8 +68,14 @@ public:
     FroniusNetworkReply *getMeterRealtimeData(int meterId);
     FroniusNetworkReply *getStorageRealtimeData(int meterId);
 
+    // Scope=System: data of all devices of the given class within one request
+    FroniusNetworkReply *getSystemInverterRealtimeData();
+    FroniusNetworkReply *getSystemMeterRealtimeData();
+    FroniusNetworkReply *getSystemStorageRealtimeData();
+
 signals:
     void availableChanged(bool available);
+    void refreshCycleFinished(int duration, int requestCount, int maxRoundTripTime);
 
 private:
     NetworkAccessManager *m_networkManager = nullptr;
@@ -73,7 +87,17 @@ private:
     FroniusNetworkReply *m_currentReply = nullptr;
     QQueue<FroniusNetworkReply *> m_requestQueue;
 
+    // Refresh cycle statistics
+    bool m_refreshCycleRunning = false;
+    QElapsedTimer m_refreshCycleTimer;
+    int m_refreshCycleRequestCount = 0;
+    int m_refreshCycleMaxRoundTripTime = 0;
+    double m_averageRefreshCycleDuration = 0;
+    int m_refreshInterval = 2000;
+
+    FroniusNetworkReply *createRequest(const QString &path, const QUrlQuery &query = QUrlQuery());
     void sendNextRequest();
+    void checkRefreshCycleFinished();
 
 };
 
@@ -168,6 +168,12 @@ void IntegrationPluginFronius::setupThing(ThingSetupInfo *info)
             }
         });
 
+        connect(connection, &FroniusSolarConnection::refreshCycleFinished, thing, [=](int duration, int requestCount, int maxRoundTripTime){
+            thing->setStateValue(connectionRefreshIntervalStateTypeId, connection->refreshInterval() / 1000.0);
+            thing->setStateValue(connectionRefreshCycleDurationStateTypeId, duration);
+            thing->setStateValue(connectionRefreshCycleRequestsStateTypeId, requestCount);
+            thing->setStateValue(connectionMaxRoundTripTimeStateTypeId, maxRoundTripTime);
+        });
 
         if (info->isInitialSetup()) {
             // Verify the version
@@ -247,12 +253,15 @@ void IntegrationPluginFronius::postSetupThing(Thing *thing)
 
     if (thing->thingClassId() == connectionThingClassId) {
 
-        // Create a refresh timer for monitoring the active devices
+        // Create a refresh timer for monitoring the active devices. Each connection
+        // gets refreshed once its own, adaptive refresh interval has passed.
         if (!m_connectionRefreshTimer) {
-            m_connectionRefreshTimer = hardwareManager()->pluginTimerManager()->registerTimer(2);
+            m_connectionRefreshTimer = hardwareManager()->pluginTimerManager()->registerTimer(1);
             connect(m_connectionRefreshTimer, &PluginTimer::timeout, this, [this]() {
                 foreach (FroniusSolarConnection *connection, m_froniusConnections.keys()) {
-                    refreshConnection(connection);
+                    if (connection->refreshDue()) {
+                        refreshConnection(connection);
+                    }
                 }
             });
 
@@ -305,6 +314,9 @@ void IntegrationPluginFronius::refreshConnection(FroniusSolarConnection *connect
         return;
     }
 
+    // All requests queued from now on until the queue runs empty belong to this refresh cycle
+    connection->startRefreshCycle();
+
     // Note: this call will be used to monitor the available state of the connection internally
     FroniusNetworkReply *reply = connection->getActiveDevices();
     connect(reply, &FroniusNetworkReply::finished, this, [=]() {
@@ -536,63 +548,62 @@ void IntegrationPluginFronius::updatePowerFlow(FroniusSolarConnection *connectio
 void IntegrationPluginFronius::updateInverters(FroniusSolarConnection *connection)
 {
     Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *inverterThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(inverterThingClassId)) {
-        int inverterId = inverterThing->paramValue(inverterThingIdParamTypeId).toInt();
+    Things inverterThings = myThings().filterByParentId(parentThing->id()).filterByThingClassId(inverterThingClassId);
+    if (inverterThings.isEmpty())
+        return;
 
-        // Get the inverter realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getInverterRealtimeData(inverterId);
+    if (parentThing->setting(connectionSettingsSystemScopeParamTypeId).toBool()) {
+        // Get the realtime data of all inverters within one request
+        FroniusNetworkReply *realtimeDataReply = connection->getSystemInverterRealtimeData();
         connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
-                markInverterAsDisconnected(inverterThing);
-                return;
-            }
-
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Inverter", &dataMap)) {
+                foreach (Thing *inverterThing, inverterThings)
+                    markInverterAsDisconnected(inverterThing);
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Inverter: Failed to parse JSON data" << data << ":" << error.errorString();
-                markInverterAsDisconnected(inverterThing);
                 return;
             }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Inverter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
-
-            // Note: this is the PV power after feeding the battery, we have to use the total PV production from the power flow
-            //if (dataMap.contains("PAC")) {
-            //    QVariantMap map = dataMap.value("PAC").toMap();
-            //    if (map.value("Unit") == "W") {
-            //        inverterThing->setStateValue(inverterCurrentPowerStateTypeId, - map.value("Value").toDouble());
-            //    }
-            //}
-
-            // Set the inverter device state
-            if (dataMap.contains("DAY_ENERGY")) {
-                QVariantMap map = dataMap.value("DAY_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterEnergyDayStateTypeId, map.value("Value").toDouble() / 1000);
+            // The system scope groups the values by name and contains the value of each inverter by id:
+            // "DAY_ENERGY": { "Unit": "Wh", "Values": { "1": 1234 } }
+            foreach (Thing *inverterThing, inverterThings) {
+                QString inverterId = inverterThing->paramValue(inverterThingIdParamTypeId).toString();
+                QVariantMap inverterDataMap;
+                foreach (const QString &valueName, dataMap.keys()) {
+                    QVariantMap valueMap = dataMap.value(valueName).toMap();
+                    QVariantMap values = valueMap.value("Values").toMap();
+                    if (values.contains(inverterId)) {
+                        QVariantMap map;
+                        map.insert("Unit", valueMap.value("Unit"));
+                        map.insert("Value", values.value(inverterId));
+                        inverterDataMap.insert(valueName, map);
+                    }
                 }
-            }
 
-            if (dataMap.contains("YEAR_ENERGY")) {
-                QVariantMap map = dataMap.value("YEAR_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterEnergyYearStateTypeId, map.value("Value").toDouble() / 1000);
+                if (inverterDataMap.isEmpty()) {
+                    markInverterAsDisconnected(inverterThing);
+                } else {
+                    updateInverterStates(inverterThing, inverterDataMap);
                 }
             }
+        });
+        return;
+    }
 
-            if (dataMap.contains("TOTAL_ENERGY")) {
-                QVariantMap map = dataMap.value("TOTAL_ENERGY").toMap();
-                if (map.value("Unit") == "Wh") {
-                    inverterThing->setStateValue(inverterTotalEnergyProducedStateTypeId, map.value("Value").toDouble() / 1000);
-                }
+    foreach (Thing *inverterThing, inverterThings) {
+        int inverterId = inverterThing->paramValue(inverterThingIdParamTypeId).toInt();
+
+        // Get the inverter realtime data
+        FroniusNetworkReply *realtimeDataReply = connection->getInverterRealtimeData(inverterId);
+        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Inverter", &dataMap)) {
+                // Thing does not seem to be reachable
+                markInverterAsDisconnected(inverterThing);
+                return;
             }
 
-            inverterThing->setStateValue("connected", true);
+            updateInverterStates(inverterThing, dataMap);
         });
     }
 }
@@ -600,145 +611,241 @@ void IntegrationPluginFronius::updateInverters(FroniusSolarConnection *connectio
 void IntegrationPluginFronius::updateMeters(FroniusSolarConnection *connection)
 {
     Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *meterThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(meterThingClassId)) {
-        int meterId = meterThing->paramValue(inverterThingIdParamTypeId).toInt();
+    Things meterThings = myThings().filterByParentId(parentThing->id()).filterByThingClassId(meterThingClassId);
+    if (meterThings.isEmpty())
+        return;
 
-        // Get the inverter realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getMeterRealtimeData(meterId);
+    if (parentThing->setting(connectionSettingsSystemScopeParamTypeId).toBool()) {
+        // Get the realtime data of all meters within one request, the data is mapped by meter id
+        FroniusNetworkReply *realtimeDataReply = connection->getSystemMeterRealtimeData();
         connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
-                markMeterAsDisconnected(meterThing);
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Meter", &dataMap)) {
+                foreach (Thing *meterThing, meterThings)
+                    markMeterAsDisconnected(meterThing);
+
                 return;
             }
 
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+            foreach (Thing *meterThing, meterThings) {
+                QString meterId = meterThing->paramValue(meterThingIdParamTypeId).toString();
+                if (!dataMap.contains(meterId)) {
+                    markMeterAsDisconnected(meterThing);
+                    continue;
+                }
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Meter: Failed to parse JSON data" << data << ":" << error.errorString();
+                updateMeterStates(meterThing, dataMap.value(meterId).toMap());
+            }
+        });
+        return;
+    }
+
+    foreach (Thing *meterThing, meterThings) {
+        int meterId = meterThing->paramValue(meterThingIdParamTypeId).toInt();
+
+        // Get the meter realtime data
+        FroniusNetworkReply *realtimeDataReply = connection->getMeterRealtimeData(meterId);
+        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Meter", &dataMap)) {
+                // Thing does not seem to be reachable
                 markMeterAsDisconnected(meterThing);
                 return;
             }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Meter data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
+            updateMeterStates(meterThing, dataMap);
+        });
+    }
+}
 
-            // Power
-            if (dataMap.contains("PowerReal_P_Sum")) {
-                meterThing->setStateValue(meterCurrentPowerStateTypeId, dataMap.value("PowerReal_P_Sum").toDouble());
-            }
+void IntegrationPluginFronius::updateStorages(FroniusSolarConnection *connection)
+{
+    Thing *parentThing = m_froniusConnections.value(connection);
+    Things storageThings = myThings().filterByParentId(parentThing->id()).filterByThingClassId(storageThingClassId);
+    if (storageThings.isEmpty())
+        return;
 
-            if (dataMap.contains("PowerReal_P_Phase_1")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseAStateTypeId, dataMap.value("PowerReal_P_Phase_1").toDouble());
-            }
+    if (parentThing->setting(connectionSettingsSystemScopeParamTypeId).toBool()) {
+        // Get the realtime data of all storages within one request, the data is mapped by storage id
+        FroniusNetworkReply *realtimeDataReply = connection->getSystemStorageRealtimeData();
+        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Storage", &dataMap)) {
+                foreach (Thing *storageThing, storageThings)
+                    markStorageAsDisconnected(storageThing);
 
-            if (dataMap.contains("PowerReal_P_Phase_2")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseBStateTypeId, dataMap.value("PowerReal_P_Phase_2").toDouble());
+                return;
             }
 
-            if (dataMap.contains("PowerReal_P_Phase_3")) {
-                meterThing->setStateValue(meterCurrentPowerPhaseCStateTypeId, dataMap.value("PowerReal_P_Phase_3").toDouble());
-            }
+            foreach (Thing *storageThing, storageThings) {
+                QString storageId = storageThing->paramValue(storageThingIdParamTypeId).toString();
+                if (!dataMap.contains(storageId)) {
+                    markStorageAsDisconnected(storageThing);
+                    continue;
+                }
 
-            // Current
-            if (dataMap.contains("Current_AC_Phase_1")) {
-                meterThing->setStateValue(meterCurrentPhaseAStateTypeId, dataMap.value("Current_AC_Phase_1").toDouble());
+                updateStorageStates(storageThing, dataMap.value(storageId).toMap());
             }
+        });
+        return;
+    }
 
-            if (dataMap.contains("Current_AC_Phase_2")) {
-                meterThing->setStateValue(meterCurrentPhaseBStateTypeId, dataMap.value("Current_AC_Phase_2").toDouble());
-            }
+    foreach (Thing *storageThing, storageThings) {
+        int storageId = storageThing->paramValue(storageThingIdParamTypeId).toInt();
 
-            if (dataMap.contains("Current_AC_Phase_3")) {
-                meterThing->setStateValue(meterCurrentPhaseCStateTypeId, dataMap.value("Current_AC_Phase_3").toDouble());
+        // Get the storage realtime data
+        FroniusNetworkReply *realtimeDataReply = connection->getStorageRealtimeData(storageId);
+        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
+            QVariantMap dataMap;
+            if (!readRealtimeData(realtimeDataReply, "Storage", &dataMap)) {
+                // Thing does not seem to be reachable
+                markStorageAsDisconnected(storageThing);
+                return;
             }
 
-            // Voltage
-            if (dataMap.contains("Voltage_AC_Phase_1")) {
-                meterThing->setStateValue(meterVoltagePhaseAStateTypeId, dataMap.value("Voltage_AC_Phase_1").toDouble());
-            }
+            updateStorageStates(storageThing, dataMap);
+        });
+    }
+}
 
-            if (dataMap.contains("Voltage_AC_Phase_2")) {
-                meterThing->setStateValue(meterVoltagePhaseBStateTypeId, dataMap.value("Voltage_AC_Phase_2").toDouble());
-            }
+bool IntegrationPluginFronius::readRealtimeData(FroniusNetworkReply *reply, const QString &deviceType, QVariantMap *dataMap)
+{
+    if (reply->networkReply()->error() != QNetworkReply::NoError) {
+        return false;
+    }
 
-            if (dataMap.contains("Voltage_AC_Phase_3")) {
-                meterThing->setStateValue(meterVoltagePhaseCStateTypeId, dataMap.value("Voltage_AC_Phase_3").toDouble());
-            }
+    QByteArray data = reply->networkReply()->readAll();
 
-            // Total energy
-            if (dataMap.contains("EnergyReal_WAC_Sum_Produced")) {
-                meterThing->setStateValue(meterTotalEnergyProducedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Produced").toInt()/1000.00);
-            }
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcFronius()) << qUtf8Printable(deviceType) << "Failed to parse JSON data" << data << ":" << error.errorString();
+        return false;
+    }
 
-            if (dataMap.contains("EnergyReal_WAC_Sum_Consumed")) {
-                meterThing->setStateValue(meterTotalEnergyConsumedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Consumed").toInt()/1000.00);
-            }
+    *dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
+    //qCDebug(dcFronius()) << qUtf8Printable(deviceType) << "data" << qUtf8Printable(QJsonDocument::fromVariant(*dataMap).toJson(QJsonDocument::Indented));
+    return true;
+}
 
-            // Frequency
-            if (dataMap.contains("Frequency_Phase_Average")) {
-                meterThing->setStateValue(meterFrequencyStateTypeId, dataMap.value("Frequency_Phase_Average").toDouble());
-            }
+void IntegrationPluginFronius::updateInverterStates(Thing *inverterThing, const QVariantMap &dataMap)
+{
+    // Note: this is the PV power after feeding the battery, we have to use the total PV production from the power flow
+    //if (dataMap.contains("PAC")) {
+    //    QVariantMap map = dataMap.value("PAC").toMap();
+    //    if (map.value("Unit") == "W") {
+    //        inverterThing->setStateValue(inverterCurrentPowerStateTypeId, - map.value("Value").toDouble());
+    //    }
+    //}
+
+    // Set the inverter device state
+    if (dataMap.contains("DAY_ENERGY")) {
+        QVariantMap map = dataMap.value("DAY_ENERGY").toMap();
+        if (map.value("Unit") == "Wh") {
+            inverterThing->setStateValue(inverterEnergyDayStateTypeId, map.value("Value").toDouble() / 1000);
+        }
+    }
 
-            meterThing->setStateValue("connected", true);
-        });
+    if (dataMap.contains("YEAR_ENERGY")) {
+        QVariantMap map = dataMap.value("YEAR_ENERGY").toMap();
+        if (map.value("Unit") == "Wh") {
+            inverterThing->setStateValue(inverterEnergyYearStateTypeId, map.value("Value").toDouble() / 1000);
+        }
+    }
+
+    if (dataMap.contains("TOTAL_ENERGY")) {
+        QVariantMap map = dataMap.value("TOTAL_ENERGY").toMap();
+        if (map.value("Unit") == "Wh") {
+            inverterThing->setStateValue(inverterTotalEnergyProducedStateTypeId, map.value("Value").toDouble() / 1000);
+        }
     }
+
+    inverterThing->setStateValue("connected", true);
 }
 
-void IntegrationPluginFronius::updateStorages(FroniusSolarConnection *connection)
+void IntegrationPluginFronius::updateMeterStates(Thing *meterThing, const QVariantMap &dataMap)
 {
-    Thing *parentThing = m_froniusConnections.value(connection);
-    foreach (Thing *storageThing, myThings().filterByParentId(parentThing->id()).filterByThingClassId(storageThingClassId)) {
-        int storageId = storageThing->paramValue(storageThingIdParamTypeId).toInt();
+    // Power
+    if (dataMap.contains("PowerReal_P_Sum")) {
+        meterThing->setStateValue(meterCurrentPowerStateTypeId, dataMap.value("PowerReal_P_Sum").toDouble());
+    }
 
-        // Get the storage realtime data
-        FroniusNetworkReply *realtimeDataReply = connection->getStorageRealtimeData(storageId);
-        connect(realtimeDataReply, &FroniusNetworkReply::finished, this, [=]() {
-            if (realtimeDataReply->networkReply()->error() != QNetworkReply::NoError) {
-                // Thing does not seem to be reachable
-                markStorageAsDisconnected(storageThing);
-                return;
-            }
+    if (dataMap.contains("PowerReal_P_Phase_1")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseAStateTypeId, dataMap.value("PowerReal_P_Phase_1").toDouble());
+    }
 
-            QByteArray data = realtimeDataReply->networkReply()->readAll();
+    if (dataMap.contains("PowerReal_P_Phase_2")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseBStateTypeId, dataMap.value("PowerReal_P_Phase_2").toDouble());
+    }
 
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcFronius()) << "Storage: Failed to parse JSON data" << data << ":" << error.errorString();
-                markStorageAsDisconnected(storageThing);
-                return;
-            }
+    if (dataMap.contains("PowerReal_P_Phase_3")) {
+        meterThing->setStateValue(meterCurrentPowerPhaseCStateTypeId, dataMap.value("PowerReal_P_Phase_3").toDouble());
+    }
 
-            // Parse the data and update the states of our device
-            QVariantMap dataMap = jsonDoc.toVariant().toMap().value("Body").toMap().value("Data").toMap();
-            //qCDebug(dcFronius()) << "Storage data" << qUtf8Printable(QJsonDocument::fromVariant(dataMap).toJson(QJsonDocument::Indented));
+    // Current
+    if (dataMap.contains("Current_AC_Phase_1")) {
+        meterThing->setStateValue(meterCurrentPhaseAStateTypeId, dataMap.value("Current_AC_Phase_1").toDouble());
+    }
 
-            QVariantMap storageInfoMap = dataMap.value("Controller").toMap();
+    if (dataMap.contains("Current_AC_Phase_2")) {
+        meterThing->setStateValue(meterCurrentPhaseBStateTypeId, dataMap.value("Current_AC_Phase_2").toDouble());
+    }
 
-            // copy retrieved information to thing states
-            if (storageInfoMap.contains("StateOfCharge_Relative")) {
-                storageThing->setStateValue(storageBatteryLevelStateTypeId, storageInfoMap.value("StateOfCharge_Relative").toInt());
-                if (storageThing->stateValue(storageChargingStateStateTypeId).toString() == "charging" && (storageInfoMap.value("StateOfCharge_Relative").toInt() < 5)) {
-                    storageThing->setStateValue(storageBatteryCriticalStateTypeId, true);
-                } else {
-                    storageThing->setStateValue(storageBatteryCriticalStateTypeId, false);
-                }
-            }
+    if (dataMap.contains("Current_AC_Phase_3")) {
+        meterThing->setStateValue(meterCurrentPhaseCStateTypeId, dataMap.value("Current_AC_Phase_3").toDouble());
+    }
 
-            if (storageInfoMap.contains("Temperature_Cell"))
-                storageThing->setStateValue(storageCellTemperatureStateTypeId, storageInfoMap.value("Temperature_Cell").toDouble());
+    // Voltage
+    if (dataMap.contains("Voltage_AC_Phase_1")) {
+        meterThing->setStateValue(meterVoltagePhaseAStateTypeId, dataMap.value("Voltage_AC_Phase_1").toDouble());
+    }
 
-            if (storageInfoMap.contains("Capacity_Maximum"))
-                storageThing->setStateValue(storageCapacityStateTypeId, storageInfoMap.value("Capacity_Maximum").toDouble());
+    if (dataMap.contains("Voltage_AC_Phase_2")) {
+        meterThing->setStateValue(meterVoltagePhaseBStateTypeId, dataMap.value("Voltage_AC_Phase_2").toDouble());
+    }
 
+    if (dataMap.contains("Voltage_AC_Phase_3")) {
+        meterThing->setStateValue(meterVoltagePhaseCStateTypeId, dataMap.value("Voltage_AC_Phase_3").toDouble());
+    }
 
-            storageThing->setStateValue("connected", true);
-        });
+    // Total energy
+    if (dataMap.contains("EnergyReal_WAC_Sum_Produced")) {
+        meterThing->setStateValue(meterTotalEnergyProducedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Produced").toInt()/1000.00);
+    }
+
+    if (dataMap.contains("EnergyReal_WAC_Sum_Consumed")) {
+        meterThing->setStateValue(meterTotalEnergyConsumedStateTypeId, dataMap.value("EnergyReal_WAC_Sum_Consumed").toInt()/1000.00);
+    }
+
+    // Frequency
+    if (dataMap.contains("Frequency_Phase_Average")) {
+        meterThing->setStateValue(meterFrequencyStateTypeId, dataMap.value("Frequency_Phase_Average").toDouble());
+    }
+
+    meterThing->setStateValue("connected", true);
+}
+
+void IntegrationPluginFronius::updateStorageStates(Thing *storageThing, const QVariantMap &dataMap)
+{
+    QVariantMap storageInfoMap = dataMap.value("Controller").toMap();
+
+    // copy retrieved information to thing states
+    if (storageInfoMap.contains("StateOfCharge_Relative")) {
+        storageThing->setStateValue(storageBatteryLevelStateTypeId, storageInfoMap.value("StateOfCharge_Relative").toInt());
+        if (storageThing->stateValue(storageChargingStateStateTypeId).toString() == "charging" && (storageInfoMap.value("StateOfCharge_Relative").toInt() < 5)) {
+            storageThing->setStateValue(storageBatteryCriticalStateTypeId, true);
+        } else {
+            storageThing->setStateValue(storageBatteryCriticalStateTypeId, false);
+        }
     }
+
+    if (storageInfoMap.contains("Temperature_Cell"))
+        storageThing->setStateValue(storageCellTemperatureStateTypeId, storageInfoMap.value("Temperature_Cell").toDouble());
+
+    if (storageInfoMap.contains("Capacity_Maximum"))
+        storageThing->setStateValue(storageCapacityStateTypeId, storageInfoMap.value("Capacity_Maximum").toDouble());
+
+    storageThing->setStateValue("connected", true);
 }
 
 void IntegrationPluginFronius::markInverterAsDisconnected(Thing *thing)
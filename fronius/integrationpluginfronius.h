@@ -67,6 +67,11 @@ private:
     void updateMeters(FroniusSolarConnection *connection);
     void updateStorages(FroniusSolarConnection *connection);
 
+    bool readRealtimeData(FroniusNetworkReply *reply, const QString &deviceType, QVariantMap *dataMap);
+    void updateInverterStates(Thing *inverterThing, const QVariantMap &dataMap);
+    void updateMeterStates(Thing *meterThing, const QVariantMap &dataMap);
+    void updateStorageStates(Thing *storageThing, const QVariantMap &dataMap);
+
     void markInverterAsDisconnected(Thing *thing);
     void markMeterAsDisconnected(Thing *thing);
     void markStorageAsDisconnected(Thing *thing);
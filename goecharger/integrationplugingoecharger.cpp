@@ -32,6 +32,7 @@
 #include "integrationplugingoecharger.h"
 #include "network/networkdevicediscovery.h"
 
+#include <QTimer>
 #include <QUrlQuery>
 #include <QHostAddress>
 #include <QDataStream>
@@ -44,6 +45,9 @@
 //     V1: https://github.com/goecharger/go-eCharger-API-v1
 //     V2: https://github.com/goecharger/go-eCharger-API-v2
 
+// The keys consumed by updateV2(). The HTTP polling requests only these in order to keep the payload small.
+static const QString statusFilterV2 = "alw,car,ast,tma,eto,wh,upd,fwv,amp,adi,fhz,cbl,ama,var,pnp,nrg";
+
 IntegrationPluginGoECharger::IntegrationPluginGoECharger()
 {
 
@@ -537,7 +541,7 @@ QNetworkRequest IntegrationPluginGoECharger::buildStatusRequest(Thing *thing, bo
         requestUrl.setPath("/api/status");
         if (!fullStatus) {
             QUrlQuery query;
-            query.addQueryItem("filter", "alw,car,ast,tma,eto,wh,upd,fwv,amp,adi,fhz,cbl,ama,var,pnp,nrg");
+            query.addQueryItem("filter", statusFilterV2);
             requestUrl.setQuery(query);
         }
         break;
@@ -1481,6 +1485,7 @@ void IntegrationPluginGoECharger::reconfigureMqttChannelV2(Thing *thing)
 void IntegrationPluginGoECharger::refreshHttp()
 {
     // Update all things which don't use mqtt
+    Things httpThings;
     foreach (Thing *thing, myThings()) {
         if (thing->thingClassId() != goeHomeThingClassId) {
             continue;
@@ -1491,51 +1496,68 @@ void IntegrationPluginGoECharger::refreshHttp()
             continue;
         }
 
-        // Make sure there is not a request pending for this thing, otherwise wait for the next refresh
-        if (m_pendingReplies.contains(thing) && m_pendingReplies.value(thing)) {
-            continue;
+        httpThings.append(thing);
+    }
+
+    // Spread the requests over the refresh interval instead of sending all of them at once
+    uint interval = configValue(goEChargerPluginHttpRefreshIntervalParamTypeId).toUInt() * 1000;
+    for (int i = 0; i < httpThings.count(); i++) {
+        Thing *thing = httpThings.at(i);
+        int delay = interval * i / httpThings.count();
+        if (delay == 0) {
+            requestStatusHttp(thing);
+        } else {
+            QTimer::singleShot(delay, thing, [this, thing](){ requestStatusHttp(thing); });
         }
+    }
+}
 
-        QNetworkRequest request = buildStatusRequest(thing);
-        QNetworkReply *reply = hardwareManager()->networkManager()->get(request);
-        m_pendingReplies.insert(thing, reply);
+void IntegrationPluginGoECharger::requestStatusHttp(Thing *thing)
+{
+    // Make sure there is not a request pending for this thing, otherwise wait for the next refresh
+    if (m_pendingReplies.contains(thing) && m_pendingReplies.value(thing)) {
+        return;
+    }
 
-        connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
-        connect(reply, &QNetworkReply::finished, thing, [=](){
-            // We are done with this thing reply
-            m_pendingReplies.remove(thing);
+    QNetworkRequest request = buildStatusRequest(thing);
+    QNetworkReply *reply = hardwareManager()->networkManager()->get(request);
+    m_pendingReplies.insert(thing, reply);
 
-            if (reply->error() != QNetworkReply::NoError) {
-                qCWarning(dcGoECharger()) << "HTTP status reply error for thing" << thing->name() << reply->errorString() << "Request was:" << request.url().toString();
-                markAsDisconnected(thing);
-                return;
-            }
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    connect(reply, &QNetworkReply::finished, thing, [=](){
+        // We are done with this thing reply
+        m_pendingReplies.remove(thing);
 
-            QByteArray data = reply->readAll();
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcGoECharger()) << "Failed to parse status data for thing" << thing->name() << qUtf8Printable(data) << error.errorString() << "Request was:" << request.url().toString();
-                markAsDisconnected(thing);
-                return;
-            }
+        if (reply->error() != QNetworkReply::NoError) {
+            qCWarning(dcGoECharger()) << "HTTP status reply error for thing" << thing->name() << reply->errorString() << "Request was:" << request.url().toString();
+            markAsDisconnected(thing);
+            return;
+        }
 
-            ApiVersion apiVersion = getApiVersion(thing);
-            // Valid json data received, connected true
-            thing->setStateValue("connected", true);
+        QByteArray data = reply->readAll();
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcGoECharger()) << "Failed to parse status data for thing" << thing->name() << qUtf8Printable(data) << error.errorString() << "Request was:" << request.url().toString();
+            markAsDisconnected(thing);
+            return;
+        }
 
-            //qCDebug(dcGoECharger()) << "Received" << qUtf8Printable(jsonDoc.toJson());
-            QVariantMap statusMap = jsonDoc.toVariant().toMap();
-            switch (apiVersion) {
-            case ApiVersion1:
-                updateV1(thing, statusMap);
-                break;
-            case ApiVersion2:
-                updateV2(thing, statusMap);
-                break;
-            }
-        });
-    }
+        ApiVersion apiVersion = getApiVersion(thing);
+        // Valid json data received, connected true
+        thing->setStateValue("connected", true);
+
+        //qCDebug(dcGoECharger()) << "Received" << qUtf8Printable(jsonDoc.toJson());
+        QVariantMap statusMap = jsonDoc.toVariant().toMap();
+        switch (apiVersion) {
+        case ApiVersion1:
+            updateV1(thing, statusMap);
+            break;
+        case ApiVersion2:
+            updateV2(thing, statusMap);
+            break;
+        }
+    });
 }
 
 void IntegrationPluginGoECharger::onConfigValueChanged(const ParamTypeId &paramTypeId, const QVariant &value)
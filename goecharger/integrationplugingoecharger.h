@@ -115,6 +115,7 @@ private:
     // General methods
     void setupGoeHome(ThingSetupInfo *info);
     QNetworkRequest buildStatusRequest(Thing *thing, bool fullStatus = false);
+    void requestStatusHttp(Thing *thing);
     QHostAddress getHostAddress(Thing *thing);
     ApiVersion getApiVersion(Thing *thing);
 
@@ -46,9 +46,24 @@ HomeConnect::HomeConnect(NetworkAccessManager *networkmanager,  const QByteArray
     m_tokenRefreshTimer = new QTimer(this);
     m_tokenRefreshTimer->setSingleShot(true);
     connect(m_tokenRefreshTimer, &QTimer::timeout, this, &HomeConnect::onRefreshTimeout);
+
+    m_eventStreamReconnectTimer = new QTimer(this);
+    m_eventStreamReconnectTimer->setSingleShot(true);
+    connect(m_eventStreamReconnectTimer, &QTimer::timeout, this, [this] {
+        qCDebug(dcHomeConnect()) << "Reconnecting event stream";
+        connectEventStream();
+    });
     setSimulationMode(simulationMode);
 }
 
+HomeConnect::~HomeConnect()
+{
+    if (m_eventStreamReply) {
+        m_eventStreamReply->disconnect(this);
+        m_eventStreamReply->abort();
+    }
+}
+
 QByteArray HomeConnect::accessToken()
 {
     return m_accessToken;
@@ -745,105 +760,72 @@ void HomeConnect::getSettings(const QString &haid)
 
 void HomeConnect::connectEventStream()
 {
+    if (m_eventStreamReply) {
+        qCDebug(dcHomeConnect()) << "Event stream already connected";
+        return;
+    }
+    m_eventStreamReconnectTimer->stop();
+
     QUrl url = QUrl(m_baseControlUrl+"/api/homeappliances/events");
 
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", "Bearer "+m_accessToken);
     request.setRawHeader("Accept-Language", "en-US");
     request.setRawHeader("accept", "text/event-stream");
+    if (!m_eventStreamParser.lastEventId().isEmpty()) {
+        request.setRawHeader("Last-Event-ID", m_eventStreamParser.lastEventId());
+    }
+    m_eventStreamParser.reset();
 
     QNetworkReply *reply = m_networkManager->get(request);
+    m_eventStreamReply = reply;
     connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
-    connect(reply, &QNetworkReply::finished, [reply, this] {
-        int reconnectTime = 5000; // Usual reconnect in 5 s
+    connect(reply, &QNetworkReply::finished, this, [reply, this] {
+        m_eventStreamReply = nullptr;
         if (reply->error() != QNetworkReply::NetworkError::NoError) {
             qCDebug(dcHomeConnect()) << "Event stream error" << reply->errorString() << reply->readAll();
         }
         qCDebug(dcHomeConnect()) << "Eventstream disconected";
+
+        // Exponential backoff, starting with the reconnection time requested by the server if any
+        int reconnectTime = m_eventStreamReconnectDelay;
+        int baseDelay = m_eventStreamParser.retryInterval() > 0 ? m_eventStreamParser.retryInterval() : m_eventStreamBaseDelay;
+        reconnectTime = qMax(reconnectTime, baseDelay);
+        m_eventStreamReconnectDelay = qMin(reconnectTime * 2, m_eventStreamMaxDelay);
+
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
         if (status == 429) {
-            reconnectTime = 600000;
+            reconnectTime = 600000; // Too many requests, respect the rate limit
         }
         qCDebug(dcHomeConnect()) << "Trying to reconnect event stream in" << reconnectTime/1000 << "seconds";
-        QTimer::singleShot(reconnectTime, this, [this] {
-            qCDebug(dcHomeConnect()) << "Reconnecting event stream";
-            connectEventStream();
-        });
+        m_eventStreamReconnectTimer->start(reconnectTime);
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]{
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status != 200)
+            return;
+
+        qCDebug(dcHomeConnect()) << "Event stream connected";
+        m_eventStreamReconnectDelay = 0;
+        if (m_eventStreamWasConnected) {
+            // Events sent while the stream was down are lost, let the plugin catch up
+            emit eventStreamReconnected();
+        }
+        m_eventStreamWasConnected = true;
     });
     connect(reply, &QNetworkReply::readyRead, this, [this, reply]{
 
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        if (status == 200) {
-            while (reply->canReadLine()) {
-                QJsonDocument data;
-                QString haId;
-                EventType eventType;
-
-                QByteArray eventTypeLine = reply->readLine();
-                if (eventTypeLine == "\n")
-                    continue;
-                if (eventTypeLine.startsWith("event")) {
-                    QString eventString = eventTypeLine.split(':').last().trimmed();
-                    if (eventString == "KEEP-ALIVE") {
-                        eventType = EventTypeKeepAlive;
-                    } else if (eventString == "STATUS") {
-                        eventType = EventTypeStatus;
-                    } else if (eventString == "EVENT") {
-                        eventType = EventTypeEvent;
-                    } else if (eventString == "NOTIFY") {
-                        eventType = EventTypeNotify;
-                    } else if (eventString == "DISCONNECTED") {
-                        eventType = EventTypeDisconnected;
-                    } else if (eventString == "CONNECTED") {
-                        eventType = EventTypeConnected;
-                    } else if (eventString == "PAIRED") {
-                        eventType = EventTypePaired;
-                    } else if (eventString == "DEPAIRED") {
-                        eventType = EventTypeDepaired;
-                    } else {
-                        qCWarning(dcHomeConnect()) << "Unhandled event type" << eventString;
-                        return;
-                    }
-                    QByteArray dataLine = reply->readLine();
-                    if (dataLine.startsWith("data")) {
-                        data = QJsonDocument::fromJson(dataLine.remove(0,6));
-
-                        QByteArray idLine = reply->readLine();
-                        if (idLine.startsWith("id")) {
-                            haId = idLine.split(':').last().trimmed();
-                        } else {
-                            qCWarning(dcHomeConnect()) << "Id line: Unexpected line" << eventTypeLine;
-                            continue;
-                        }
-                    } else {
-                        qCWarning(dcHomeConnect()) << "Data Line: Unexpected line" << eventTypeLine;
-                        continue;
-                    }
-                } else {
-                    qCWarning(dcHomeConnect()) << "Event type: Unexpected line" << eventTypeLine;
-                    continue;
-                }
-
-                if (data.toVariant().toMap().contains("items")) {
-                    QList<Event> events;
-                    QVariantList itemsList = data.toVariant().toMap().value("items").toList();
-                    Q_FOREACH(QVariant item, itemsList) {
-                        QVariantMap map = item.toMap();
-                        Event event;
-                        event.key = map["key"].toString();
-                        event.uri = map["uri"].toString();
-                        event.name = map["uri"].toString();
-                        event.value  = map["value"];
-                        event.unit = map["unit"].toString();
-                        event.timestamp  = map["timestamp"].toInt();
-                        events.append(event);
-                    }
-                    if (!events.isEmpty())
-                        emit receivedEvents(eventType, haId, events);
-                } else if (data.toVariant().toMap().contains("error")) {
-                    qCWarning(dcHomeConnect()) << "Event stream error" << data.toVariant().toMap().value("error");
-                }
-            }
+        if (status != 200)
+            return;
+
+        Q_FOREACH(const EventStreamParser::Event &event, m_eventStreamParser.parse(reply->readAll())) {
+            processStreamEvent(event);
+        }
+
+        if (m_eventStreamParser.overflowed()) {
+            qCWarning(dcHomeConnect()) << "Event stream sent an oversized event, reconnecting";
+            reply->abort();
         }
     });
 }
@@ -886,6 +868,54 @@ QUuid HomeConnect::sendCommand(const QString &haid, const QString &command)
     return commandId;
 }
 
+void HomeConnect::processStreamEvent(const EventStreamParser::Event &streamEvent)
+{
+    EventType eventType;
+    if (streamEvent.type == "KEEP-ALIVE") {
+        eventType = EventTypeKeepAlive;
+    } else if (streamEvent.type == "STATUS") {
+        eventType = EventTypeStatus;
+    } else if (streamEvent.type == "EVENT") {
+        eventType = EventTypeEvent;
+    } else if (streamEvent.type == "NOTIFY") {
+        eventType = EventTypeNotify;
+    } else if (streamEvent.type == "DISCONNECTED") {
+        eventType = EventTypeDisconnected;
+    } else if (streamEvent.type == "CONNECTED") {
+        eventType = EventTypeConnected;
+    } else if (streamEvent.type == "PAIRED") {
+        eventType = EventTypePaired;
+    } else if (streamEvent.type == "DEPAIRED") {
+        eventType = EventTypeDepaired;
+    } else {
+        qCWarning(dcHomeConnect()) << "Unhandled event type" << streamEvent.type;
+        return;
+    }
+
+    // The event id is the home appliance id
+    QString haId = QString::fromUtf8(streamEvent.id);
+    QVariantMap data = QJsonDocument::fromJson(streamEvent.data).toVariant().toMap();
+    if (data.contains("items")) {
+        QList<Event> events;
+        QVariantList itemsList = data.value("items").toList();
+        Q_FOREACH(QVariant item, itemsList) {
+            QVariantMap map = item.toMap();
+            Event event;
+            event.key = map["key"].toString();
+            event.uri = map["uri"].toString();
+            event.name = map["uri"].toString();
+            event.value  = map["value"];
+            event.unit = map["unit"].toString();
+            event.timestamp  = map["timestamp"].toInt();
+            events.append(event);
+        }
+        if (!events.isEmpty())
+            emit receivedEvents(eventType, haId, events);
+    } else if (data.contains("error")) {
+        qCWarning(dcHomeConnect()) << "Event stream error" << data.value("error");
+    }
+}
+
 void HomeConnect::setAuthenticated(bool state)
 {
     if (state != m_authenticated) {
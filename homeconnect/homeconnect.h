@@ -36,6 +36,7 @@
 #include <QUuid>
 
 #include "network/networkaccessmanager.h"
+#include "eventstreamparser.h"
 
 class HomeConnect : public QObject
 {
@@ -110,6 +111,7 @@ public:
     };
 
     HomeConnect(NetworkAccessManager *networkmanager, const QByteArray &clientKey, const QByteArray &clientSecret, bool simulationMode = false, QObject *parent = nullptr);
+    ~HomeConnect() override;
     QByteArray accessToken();
     QByteArray refreshToken();
     void setSimulationMode(bool simulation);
@@ -159,6 +161,16 @@ private:
     NetworkAccessManager *m_networkManager = nullptr;
     QTimer *m_tokenRefreshTimer = nullptr;
 
+    EventStreamParser m_eventStreamParser;
+    QNetworkReply *m_eventStreamReply = nullptr;
+    QTimer *m_eventStreamReconnectTimer = nullptr;
+    int m_eventStreamBaseDelay = 5000;
+    int m_eventStreamMaxDelay = 300000;
+    int m_eventStreamReconnectDelay = 0;
+    bool m_eventStreamWasConnected = false;
+
+    void processStreamEvent(const EventStreamParser::Event &streamEvent);
+
     void setAuthenticated(bool state);
     void setConnected(bool state);
 
@@ -185,5 +197,6 @@ signals:
     void receivedActiveProgram(const QString &haId, const QString &key, const QHash<QString, QVariant> &options);
     void receivedSelectedProgram(const QString &haId, const QString &key, const QHash<QString, QVariant> &options);
     void receivedEvents(EventType eventType, const QString &haId, const QList<Event> &events);
+    void eventStreamReconnected();
 };
 #endif // HOMECONNECT_H
@@ -2,6 +2,8 @@ include(../plugins.pri)
 
 QT += network
 
+include(../common/eventstreamparser/eventstreamparser.pri)
+
 SOURCES += \
     integrationpluginhomeconnect.cpp \
     homeconnect.cpp \
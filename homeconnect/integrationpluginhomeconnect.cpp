@@ -298,6 +298,7 @@ void IntegrationPluginHomeConnect::setupThing(ThingSetupInfo *info)
         connect(homeConnect, &HomeConnect::receivedSelectedProgram, this, &IntegrationPluginHomeConnect::onReceivedSelectedProgram);
         connect(homeConnect, &HomeConnect::receivedSettings, this, &IntegrationPluginHomeConnect::onReceivedSettings);
         connect(homeConnect, &HomeConnect::receivedEvents, this, &IntegrationPluginHomeConnect::onReceivedEvents);
+        connect(homeConnect, &HomeConnect::eventStreamReconnected, this, &IntegrationPluginHomeConnect::onEventStreamReconnected);
 
     } else if (m_idParamTypeIds.contains(thing->thingClassId())) {
         Thing *parentThing = myThings().findById(thing->parentId());
@@ -330,12 +331,7 @@ void IntegrationPluginHomeConnect::postSetupThing(Thing *thing)
                     continue;
                 }
                 homeConnect->getHomeAppliances();
-                Q_FOREACH (Thing *childThing, myThings().filterByParentId(thing->id())) {
-                    QString haId = childThing->paramValue(m_idParamTypeIds.value(childThing->thingClassId())).toString();
-                    homeConnect->getStatus(haId);
-                    homeConnect->getSettings(haId);
-                    homeConnect->getProgramsSelected(haId);
-                }
+                refreshHomeAppliances(thing, homeConnect);
             }
         });
     }
@@ -1007,6 +1003,27 @@ void IntegrationPluginHomeConnect::onReceivedStatusList(const QString &haId, con
     }
 }
 
+void IntegrationPluginHomeConnect::onEventStreamReconnected()
+{
+    HomeConnect *homeConnect = static_cast<HomeConnect *>(sender());
+    Thing *thing = m_homeConnectConnections.key(homeConnect);
+    if (!thing)
+        return;
+
+    qCDebug(dcHomeConnect()) << "Event stream reconnected, refreshing appliances of" << thing->name();
+    refreshHomeAppliances(thing, homeConnect);
+}
+
+void IntegrationPluginHomeConnect::refreshHomeAppliances(Thing *parentThing, HomeConnect *homeConnect)
+{
+    Q_FOREACH (Thing *childThing, myThings().filterByParentId(parentThing->id())) {
+        QString haId = childThing->paramValue(m_idParamTypeIds.value(childThing->thingClassId())).toString();
+        homeConnect->getStatus(haId);
+        homeConnect->getSettings(haId);
+        homeConnect->getProgramsSelected(haId);
+    }
+}
+
 void IntegrationPluginHomeConnect::onReceivedEvents(HomeConnect::EventType eventType, const QString &haId, const QList<HomeConnect::Event> &events)
 {
 
@@ -92,6 +92,7 @@ private:
 
     void parseKey(Thing *thing, const QString &key, const QVariant &value);
     void parseSettingKey(Thing *thing, const QString &key, const QVariant &value);
+    void refreshHomeAppliances(Thing *parentThing, HomeConnect *homeConnect);
     bool checkIfActionIsPossible(ThingActionInfo *info);
 
 private slots:
@@ -100,6 +101,7 @@ private slots:
     void onRequestExecuted(QUuid requestId, bool success);
     void onReceivedHomeAppliances(const QList<HomeConnect::HomeAppliance> &appliances);
     void onReceivedStatusList(const QString &haId, const QHash<QString, QVariant> &statusList);
+    void onEventStreamReconnected();
     void onReceivedEvents(HomeConnect::EventType eventType, const QString &haId, const QList<HomeConnect::Event> &events);
     void onReceivedSelectedProgram(const QString &haId, const QString &key, const QHash<QString, QVariant> &options);
     void onReceivedSettings(const QString &haId, const QHash<QString, QVariant> &settings);
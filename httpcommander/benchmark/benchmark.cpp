@@ -0,0 +1,266 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Load test for HttpSimpleServer: local clients, each in its own thread with a blocking keep-alive
+// connection, send requests at a fixed rate (1000 requests/s in total by default) and measure the
+// latency of every response. GET, POST with Content-Length and POST with a chunked body written in
+// two pieces alternate. The server counts the requests it emits, all of them have to arrive.
+//
+// Usage: benchmark [requests/s] [seconds] [connections], a rate of 0 sends as fast as possible.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <algorithm>
+
+#include "httpsimpleserver.h"
+
+Q_LOGGING_CATEGORY(dcHttpCommander, "HttpCommander")
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+class ClientThread : public QThread
+{
+public:
+    ClientThread(quint16 port, int requestCount, qint64 intervalNs, int index) :
+        m_port(port),
+        m_requestCount(requestCount),
+        m_intervalNs(intervalNs),
+        m_index(index)
+    {
+    }
+
+    QVector<qint64> latencies;
+    int okCount = 0;
+    int errorCount = 0;
+    int reconnectCount = 0;
+    int bodyBytes = 0;
+
+protected:
+    void run() override
+    {
+        QTcpSocket socket;
+        latencies.reserve(m_requestCount);
+
+        QElapsedTimer clock;
+        clock.start();
+        for (int i = 0; i < m_requestCount; i++) {
+            // Keep the schedule, requests which are late are sent right away
+            qint64 due = i * m_intervalNs;
+            qint64 now = clock.nsecsElapsed();
+            if (due > now) {
+                QThread::usleep((due - now) / 1000);
+            }
+
+            if (socket.state() != QAbstractSocket::ConnectedState) {
+                if (i > 0)
+                    reconnectCount++;
+                socket.connectToHost(QHostAddress::LocalHost, m_port);
+                if (!socket.waitForConnected(5000)) {
+                    errorCount++;
+                    continue;
+                }
+            }
+
+            QElapsedTimer latency;
+            latency.start();
+            sendRequest(socket, i);
+            int status = readResponse(socket);
+            latencies.append(latency.nsecsElapsed());
+            if (status == 200) {
+                okCount++;
+            } else {
+                errorCount++;
+            }
+        }
+        socket.disconnectFromHost();
+    }
+
+private:
+    void sendRequest(QTcpSocket &socket, int i)
+    {
+        QByteArray path = "/bench/" + QByteArray::number(m_index) + "/" + QByteArray::number(i);
+        QByteArray body = "{\"client\":" + QByteArray::number(m_index) + ",\"request\":" + QByteArray::number(i) + "}";
+        if (i % 3 != 0)
+            bodyBytes += body.size();
+        switch (i % 3) {
+        case 0:
+            socket.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            break;
+        case 1:
+            socket.write("POST " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: "
+                         + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+            break;
+        default:
+            // The chunked body goes out in two writes, the server has to wait for the second one
+            socket.write("POST " + path + " HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n"
+                         + QByteArray::number(body.size() / 2, 16) + "\r\n" + body.left(body.size() / 2) + "\r\n");
+            socket.flush();
+            socket.write(QByteArray::number(body.size() - body.size() / 2, 16) + "\r\n" + body.mid(body.size() / 2) + "\r\n0\r\n\r\n");
+            break;
+        }
+        socket.flush();
+    }
+
+    // Responses of the server have no body, read up to the end of the headers
+    int readResponse(QTcpSocket &socket)
+    {
+        int headerEnd = m_response.indexOf("\r\n\r\n");
+        while (headerEnd < 0) {
+            if (!socket.waitForReadyRead(5000)) {
+                m_response.clear();
+                socket.abort();
+                return -1;
+            }
+            m_response.append(socket.readAll());
+            headerEnd = m_response.indexOf("\r\n\r\n");
+        }
+        QByteArray statusLine = m_response.left(m_response.indexOf("\r\n"));
+        m_response.remove(0, headerEnd + 4);
+        return statusLine.split(' ').value(1).toInt();
+    }
+
+    quint16 m_port = 0;
+    int m_requestCount = 0;
+    qint64 m_intervalNs = 0;
+    int m_index = 0;
+    QByteArray m_response;
+};
+
+static qint64 percentile(const QVector<qint64> &sorted, double fraction)
+{
+    if (sorted.isEmpty())
+        return 0;
+
+    return sorted.at(qMin(sorted.count() - 1, static_cast<int>(sorted.count() * fraction)));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    // Debug output for every request would dominate the measurement
+    QLoggingCategory::setFilterRules("HttpCommander.debug=false");
+
+    QStringList arguments = application.arguments();
+    int rate = arguments.value(1, "1000").toInt();
+    int seconds = arguments.value(2, "10").toInt();
+    int connections = qMax(1, arguments.value(3, "4").toInt());
+    int totalRequests = (rate > 0 ? rate : 20000) * seconds;
+    int requestsPerClient = totalRequests / connections;
+    totalRequests = requestsPerClient * connections;
+    qint64 intervalNs = rate > 0 ? 1000000000LL * connections / rate : 0;
+
+    HttpSimpleServer server(0);
+    if (!server.isListening()) {
+        qWarning() << "The server is not listening" << server.errorString();
+        return 1;
+    }
+
+    int received = 0;
+    int bodyBytes = 0;
+    QObject::connect(&server, &HttpSimpleServer::requestReceived, [&received, &bodyBytes](const QString &type, const QString &path, const QString &body){
+        Q_UNUSED(type)
+        Q_UNUSED(path)
+        received++;
+        bodyBytes += body.size();
+    });
+
+    qInfo().noquote() << QString("Sending %1 requests over %2 keep-alive connections to port %3, %4")
+                         .arg(totalRequests).arg(connections).arg(server.serverPort())
+                         .arg(rate > 0 ? QString("%1 requests/s").arg(rate) : QString("as fast as possible"));
+
+    QList<ClientThread *> clients;
+    int running = connections;
+    for (int i = 0; i < connections; i++) {
+        ClientThread *client = new ClientThread(server.serverPort(), requestsPerClient, intervalNs, i);
+        QObject::connect(client, &QThread::finished, &application, [&running, &application](){
+            if (--running == 0) {
+                application.quit();
+            }
+        });
+        clients.append(client);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach (ClientThread *client, clients) {
+        client->start();
+    }
+    application.exec();
+    qint64 elapsed = timer.nsecsElapsed();
+
+    // Deliver the last requests still queued in the server
+    QCoreApplication::processEvents();
+
+    QVector<qint64> latencies;
+    int ok = 0;
+    int errors = 0;
+    int reconnects = 0;
+    int sentBodyBytes = 0;
+    foreach (ClientThread *client, clients) {
+        client->wait();
+        latencies += client->latencies;
+        ok += client->okCount;
+        errors += client->errorCount;
+        reconnects += client->reconnectCount;
+        sentBodyBytes += client->bodyBytes;
+    }
+    qDeleteAll(clients);
+    std::sort(latencies.begin(), latencies.end());
+
+    qInfo().noquote() << QString("throughput:  %1 requests/s").arg(ok * 1000000000.0 / elapsed, 0, 'f', 0);
+    qInfo().noquote() << QString("latency:     p50 %1 us, p99 %2 us, max %3 us")
+                         .arg(percentile(latencies, 0.5) / 1000.0, 0, 'f', 1)
+                         .arg(percentile(latencies, 0.99) / 1000.0, 0, 'f', 1)
+                         .arg((latencies.isEmpty() ? 0 : latencies.last()) / 1000.0, 0, 'f', 1);
+    qInfo().noquote() << QString("responses:   %1 ok, %2 failed, %3 reconnects").arg(ok).arg(errors).arg(reconnects);
+
+    check(ok == totalRequests, QString("All %1 requests got a 200 response").arg(totalRequests));
+    check(received == totalRequests, QString("The server emitted all requests (%1)").arg(received));
+    check(bodyBytes == sentBodyBytes, QString("All request bodies arrived complete (%1 bytes)").arg(bodyBytes));
+    check(reconnects == 0, "All connections were kept alive");
+    if (rate > 0) {
+        check(elapsed < seconds * 1100000000LL, "The requested rate was sustained");
+    }
+
+    return s_failures > 0 ? 1 : 0;
+}
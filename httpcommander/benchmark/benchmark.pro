@@ -0,0 +1,16 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT += network
+QT -= gui
+
+# The stub extern-plugininfo.h in this directory replaces the generated plugin header
+INCLUDEPATH += $$PWD $$PWD/..
+
+SOURCES += \
+    benchmark.cpp \
+    ../httpsimpleserver.cpp \
+
+HEADERS += \
+    extern-plugininfo.h \
+    ../httpsimpleserver.h \
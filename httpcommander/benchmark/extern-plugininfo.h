@@ -0,0 +1,9 @@
+#ifndef EXTERNPLUGININFO_H
+#define EXTERNPLUGININFO_H
+
+#include <QLoggingCategory>
+
+// Stand-in for the header generated by the plugin build, so the benchmark can link httpsimpleserver.cpp
+Q_DECLARE_LOGGING_CATEGORY(dcHttpCommander)
+
+#endif // EXTERNPLUGININFO_H
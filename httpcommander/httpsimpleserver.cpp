@@ -30,15 +30,14 @@
 
 #include "httpsimpleserver.h"
 
-#include "types/statetype.h"
 #include "extern-plugininfo.h"
 
 #include <QTcpSocket>
 #include <QDebug>
 #include <QDateTime>
 #include <QUrlQuery>
-#include <QRegExp>
 #include <QStringList>
+#include <QTimer>
 
 HttpSimpleServer::HttpSimpleServer(quint16 port, QObject *parent):
     QTcpServer(parent)
@@ -62,34 +61,58 @@ void HttpSimpleServer::incomingConnection(qintptr socket)
     connect(tcpSocket, SIGNAL(disconnected()), this, SLOT(discardClient()));
     tcpSocket->setSocketDescriptor(socket);
 
+    // Kept alive connections are closed after some time of inactivity
+    QTimer *idleTimer = new QTimer(tcpSocket);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(30000);
+    connect(idleTimer, &QTimer::timeout, tcpSocket, &QTcpSocket::disconnectFromHost);
+    connect(tcpSocket, &QTcpSocket::readyRead, idleTimer, QOverload<>::of(&QTimer::start));
+    idleTimer->start();
+
 }
 
 void HttpSimpleServer::readClient()
 {
-    // This slot is called when the client sent data to the server. The
-    // server looks if it was a get request and sends a very simple HTML
-    // document back.
+    // This slot is called when the client sent data to the server. Requests may
+    // arrive in pieces or several at once (pipelining), so the data is collected
+    // per connection and parsed step by step as far as it is available.
     QTcpSocket* tcpSocket = static_cast<QTcpSocket*>(sender());
-    if (tcpSocket->canReadLine()) {
+    Client &client = m_clients[tcpSocket];
+    client.buffer.append(tcpSocket->readAll());
+
+    forever {
+        int errorCode = 400;
+        ParseResult result = parseRequest(client, errorCode);
+        if (result == ParseResultIncomplete) {
+            return;
+        }
 
-        QByteArray data = tcpSocket->readAll();
-        QStringList tokens = QString(data).split(QRegExp("[ \r\n][ \r\n]*"));
-        qCDebug(dcHttpCommander()) << "Http Request, type" << tokens[0] << "path" << tokens[1] << "body" << tokens.last();
+        if (result == ParseResultError) {
+            qCWarning(dcHttpCommander()) << "Invalid HTTP request from" << tcpSocket->peerAddress().toString() << "Responding with" << errorCode;
+            // Closing the connection will discard the client
+            sendResponse(tcpSocket, errorCode, errorCode == 413 ? "Payload Too Large" : "Bad Request", false);
+            return;
+        }
 
-        if ((tokens[0] == "GET")      ||
-                (tokens[0] == "PUT")  ||
-                (tokens[0] == "POST") ||
-                (tokens[0] == "DELETE")) {
+        QString type = QString::fromLatin1(client.method);
+        QString path = QString::fromUtf8(client.path);
+        QString body = QString::fromUtf8(client.body);
+        qCDebug(dcHttpCommander()) << "Http Request, type" << type << "path" << path << "body" << body;
 
-            QTextStream os(tcpSocket);
-            os.setAutoDetectUnicode(true);
-            os << generateHeader();
-            tcpSocket->close();
+        // HTTP/1.1 keeps the connection by default, HTTP/1.0 only if asked for
+        QByteArray connection = client.headers.value("connection").toLower();
+        bool keepAlive = client.version == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
 
-            if (tcpSocket->state() == QTcpSocket::UnconnectedState)
-                delete tcpSocket;
+        bool supported = type == "GET" || type == "PUT" || type == "POST" || type == "DELETE";
+        client.resetRequest();
+        sendResponse(tcpSocket, supported ? 200 : 405, supported ? "OK" : "Method Not Allowed", keepAlive);
 
-            emit requestReceived(tokens[0], tokens[1], tokens.last());
+        if (supported) {
+            emit requestReceived(type, path, body);
+        }
+
+        if (!keepAlive) {
+            return;
         }
     }
 }
@@ -97,15 +120,155 @@ void HttpSimpleServer::readClient()
 void HttpSimpleServer::discardClient()
 {
     QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+    m_clients.remove(socket);
     socket->deleteLater();
 }
 
-QString HttpSimpleServer::generateHeader()
+void HttpSimpleServer::Client::resetRequest()
+{
+    stage = ParseStageRequestLine;
+    method.clear();
+    path.clear();
+    version.clear();
+    headers.clear();
+    remaining = 0;
+    body.clear();
+}
+
+HttpSimpleServer::ParseResult HttpSimpleServer::parseRequest(Client &client, int &errorCode)
+{
+    // Limits to protect from clients sending garbage endlessly
+    static const int maxLineLength = 8192;
+    static const int maxHeaderCount = 100;
+    static const qint64 maxBodySize = 1024 * 1024;
+
+    forever {
+        if (client.stage == ParseStageBody) {
+            qint64 count = qMin(client.remaining, static_cast<qint64>(client.buffer.size()));
+            client.body.append(client.buffer.constData(), count);
+            client.buffer.remove(0, count);
+            client.remaining -= count;
+            if (client.remaining > 0) {
+                return ParseResultIncomplete;
+            }
+            return ParseResultComplete;
+        }
+
+        if (client.stage == ParseStageChunkData) {
+            // Chunk data is followed by CRLF
+            if (client.buffer.size() < client.remaining + 2) {
+                return ParseResultIncomplete;
+            }
+            if (client.buffer.at(client.remaining) != '\r' || client.buffer.at(client.remaining + 1) != '\n') {
+                return ParseResultError;
+            }
+            client.body.append(client.buffer.constData(), client.remaining);
+            client.buffer.remove(0, client.remaining + 2);
+            client.remaining = 0;
+            client.stage = ParseStageChunkSize;
+            continue;
+        }
+
+        // All other stages are line based
+        int lineEnd = client.buffer.indexOf('\n');
+        if (lineEnd < 0) {
+            if (client.buffer.size() > maxLineLength) {
+                return ParseResultError;
+            }
+            return ParseResultIncomplete;
+        }
+        QByteArray line = client.buffer.left(lineEnd);
+        client.buffer.remove(0, lineEnd + 1);
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+
+        switch (client.stage) {
+        case ParseStageRequestLine: {
+            // Ignore empty lines between pipelined requests (RFC 7230 3.5)
+            if (line.isEmpty()) {
+                continue;
+            }
+            QList<QByteArray> parts = line.split(' ');
+            if (parts.count() != 3 || !parts.at(2).startsWith("HTTP/1.")) {
+                return ParseResultError;
+            }
+            client.method = parts.at(0);
+            client.path = parts.at(1);
+            client.version = parts.at(2);
+            client.stage = ParseStageHeaders;
+            break;
+        }
+        case ParseStageHeaders: {
+            if (!line.isEmpty()) {
+                int colon = line.indexOf(':');
+                if (colon <= 0 || client.headers.count() >= maxHeaderCount) {
+                    return ParseResultError;
+                }
+                client.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+                break;
+            }
+
+            // End of headers, figure out how the body is transferred
+            if (client.headers.value("transfer-encoding").toLower().contains("chunked")) {
+                client.stage = ParseStageChunkSize;
+                break;
+            }
+            if (client.headers.contains("content-length")) {
+                bool ok = false;
+                client.remaining = client.headers.value("content-length").toLongLong(&ok);
+                if (!ok || client.remaining < 0) {
+                    return ParseResultError;
+                }
+                if (client.remaining > maxBodySize) {
+                    errorCode = 413;
+                    return ParseResultError;
+                }
+                client.body.reserve(client.remaining);
+                client.stage = ParseStageBody;
+                break;
+            }
+            return ParseResultComplete;
+        }
+        case ParseStageChunkSize: {
+            // Chunk extensions after ';' are ignored
+            int extension = line.indexOf(';');
+            bool ok = false;
+            qint64 chunkSize = line.left(extension < 0 ? line.size() : extension).trimmed().toLongLong(&ok, 16);
+            if (!ok || chunkSize < 0) {
+                return ParseResultError;
+            }
+            if (client.body.size() + chunkSize > maxBodySize) {
+                errorCode = 413;
+                return ParseResultError;
+            }
+            client.remaining = chunkSize;
+            client.stage = chunkSize == 0 ? ParseStageChunkTrailer : ParseStageChunkData;
+            break;
+        }
+        case ParseStageChunkTrailer:
+            // Trailer fields are not of interest, the empty line ends the request
+            if (line.isEmpty()) {
+                return ParseResultComplete;
+            }
+            break;
+        default:
+            return ParseResultError;
+        }
+    }
+}
+
+void HttpSimpleServer::sendResponse(QTcpSocket *socket, int statusCode, const QByteArray &reason, bool keepAlive)
 {
-    QString contentHeader(
-                "HTTP/1.0 200 Ok\r\n"
-                "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                "\r\n"
-                );
-    return contentHeader;
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(statusCode) + ' ' + reason + "\r\n";
+    response += "Content-Type: text/html; charset=\"utf-8\"\r\n";
+    response += "Content-Length: 0\r\n";
+    response += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    socket->write(response);
+
+    if (!keepAlive) {
+        // Closes once the response is written
+        socket->disconnectFromHost();
+    }
 }
@@ -31,9 +31,9 @@
 #ifndef HTTPSIMPLESERVER1_H
 #define HTTPSIMPLESERVER1_H
 
-#include "typeutils.h"
-
 #include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
 #include <QUuid>
 #include <QDateTime>
 #include <QUrl>
@@ -62,7 +62,40 @@ private slots:
     void discardClient();
 
 private:
-    QString generateHeader();
+    enum ParseStage {
+        ParseStageRequestLine,
+        ParseStageHeaders,
+        ParseStageBody,
+        ParseStageChunkSize,
+        ParseStageChunkData,
+        ParseStageChunkTrailer
+    };
+
+    enum ParseResult {
+        ParseResultIncomplete,
+        ParseResultComplete,
+        ParseResultError
+    };
+
+    // Parser state of a single connection, kept across reads and reset after each request
+    class Client {
+    public:
+        QByteArray buffer;
+        ParseStage stage = ParseStageRequestLine;
+        QByteArray method;
+        QByteArray path;
+        QByteArray version;
+        QHash<QByteArray, QByteArray> headers;
+        qint64 remaining = 0;
+        QByteArray body;
+
+        void resetRequest();
+    };
+
+    QHash<QTcpSocket *, Client> m_clients;
+
+    ParseResult parseRequest(Client &client, int &errorCode);
+    void sendResponse(QTcpSocket *socket, int statusCode, const QByteArray &reason, bool keepAlive);
 
 };
 
@@ -205,18 +205,37 @@ void IntegrationPluginKeba::postSetupThing(Thing *thing)
 
     refresh(thing, keba);
 
+    // Assign the refresh slots round-robin, preferring the slot used by the fewest wallboxes
+    if (!m_refreshSlots.contains(thing->id())) {
+        int slot = m_nextRefreshSlot;
+        for (int i = 0; i < m_refreshSlotCount; i++) {
+            int candidate = (m_nextRefreshSlot + i) % m_refreshSlotCount;
+            if (m_refreshSlots.keys(candidate).count() < m_refreshSlots.keys(slot).count()) {
+                slot = candidate;
+            }
+        }
+        m_refreshSlots.insert(thing->id(), slot);
+        m_nextRefreshSlot = (slot + 1) % m_refreshSlotCount;
+    }
+
     if (!m_updateTimer) {
-        m_updateTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
+        // Each wallbox gets refreshed every 10 seconds, but the wallboxes are spread over
+        // the interval instead of polling all of them within the same second.
+        m_updateTimer = hardwareManager()->pluginTimerManager()->registerTimer(1);
         connect(m_updateTimer, &PluginTimer::timeout, this, [this]() {
+            m_refreshSlot = (m_refreshSlot + 1) % m_refreshSlotCount;
             foreach (const ThingId &thingId, m_kebaDevices.keys()) {
+                if (m_refreshSlots.value(thingId) != m_refreshSlot)
+                    continue;
+
                 KeContact *keba = m_kebaDevices.value(thingId);
                 Thing *thing = myThings().findById(thingId);
                 if (!thing)
-                    return;
+                    continue;
 
                 if (!keba) {
                     qCWarning(dcKeba()) << "No Keba connection found for" << thing->name();
-                    return;
+                    continue;
                 }
 
                 refresh(thing, keba);
@@ -240,6 +259,7 @@ void IntegrationPluginKeba::thingRemoved(Thing *thing)
     }
 
     m_lastSessionId.remove(thing->id());
+    m_refreshSlots.remove(thing->id());
 
     if (myThings().empty()) {
         qCDebug(dcKeba()) << "Stopping plugin timers ...";
@@ -552,9 +572,13 @@ void IntegrationPluginKeba::setDevicePlugState(Thing *thing, KeContact::PlugStat
 
 void IntegrationPluginKeba::refresh(Thing *thing, KeContact *keba)
 {
+    thing->setStateValue("queueDepth", keba->queueDepth());
+    thing->setStateValue("responseTime", keba->responseTime());
+
     if (m_monitors.contains(thing) && !m_monitors.value(thing)->reachable())
         return;
 
+    // Note: equal reports still pending from the last refresh will be merged by the KeContact
     keba->getReport2();
     // No valid information if no meter
     if (thing->thingClassId() != kebaSimpleThingClassId) {
@@ -68,6 +68,10 @@ public:
 
 private:
     PluginTimer *m_updateTimer = nullptr;
+    int m_refreshSlot = 0;
+    int m_refreshSlotCount = 10;
+    int m_nextRefreshSlot = 0;
+    QHash<ThingId, int> m_refreshSlots;
     KeContactDataLayer *m_kebaDataLayer = nullptr;
 
     QHash<ThingId, KeContact *> m_kebaDevices;
@@ -57,6 +57,13 @@ KebaDiscovery::KebaDiscovery(KeContactDataLayer *kebaDataLayer, NetworkDeviceDis
             return;
         }
 
+        // Only a report 1 is of interest, skip anything else before parsing it
+        int reportId = 0;
+        if (KeContactDataLayer::classifyDatagram(datagram, &reportId) != KeContactDataLayer::DatagramTypeReport || reportId != 1) {
+            qCDebug(dcKeba()) << "Discovery: Received data on data layer but this is not a report 1 we requested for:" << datagram;
+            return;
+        }
+
         // Try to convert the received data to a json document
         QJsonParseError error;
         QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram, &error);
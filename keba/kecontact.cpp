@@ -62,12 +62,17 @@ KeContact::KeContact(const QHostAddress &address, KeContactDataLayer *dataLayer,
         sendNextCommand();
     });
 
-    connect(m_dataLayer, &KeContactDataLayer::datagramReceived, this, &KeContact::onReceivedDatagram);
+    if (m_dataLayer) {
+        m_dataLayer->registerContact(this);
+    }
 }
 
 KeContact::~KeContact()
 {
     qCDebug(dcKeba()) << "Deleting KeContact connection for address" << m_address.toString();
+    if (m_dataLayer) {
+        m_dataLayer->unregisterContact(this);
+    }
 }
 
 QHostAddress KeContact::address() const
@@ -86,8 +91,7 @@ QUuid KeContact::start(const QByteArray &rfidToken, const QByteArray &rfidClassi
     QByteArray datagram = "start " + rfidToken + " " + rfidClassifier;
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Start: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -102,8 +106,7 @@ QUuid KeContact::stop(const QByteArray &rfidToken)
     QByteArray datagram = "stop " + rfidToken;
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Stop: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -113,7 +116,15 @@ void KeContact::setAddress(const QHostAddress &address)
         return;
 
     qCDebug(dcKeba()) << "Updating Keba connection address from" << m_address.toString() << "to" << address.toString();
+    if (m_dataLayer) {
+        m_dataLayer->unregisterContact(this);
+    }
+
     m_address = address;
+
+    if (m_dataLayer) {
+        m_dataLayer->registerContact(this);
+    }
 }
 
 bool KeContact::reachable() const
@@ -121,6 +132,46 @@ bool KeContact::reachable() const
     return m_reachable;
 }
 
+int KeContact::queueDepth() const
+{
+    return m_requestQueue.count() + (m_currentRequest.isValid() ? 1 : 0);
+}
+
+int KeContact::responseTime() const
+{
+    return qRound(m_responseTime);
+}
+
+void KeContact::enqueueRequest(const KeContactRequest &request)
+{
+    if (request.priority() == KeContactRequest::PriorityLow) {
+        // There is no point in asking twice for the same report, the pending one will deliver the same data.
+        // This also keeps the queue bounded if the wallbox responds slower than it gets polled.
+        if (m_currentRequest.command() == request.command()) {
+            qCDebug(dcKeba()) << "Request" << request.command() << "already pending for" << m_address.toString() << ". Skipping.";
+            return;
+        }
+
+        foreach (const KeContactRequest &queuedRequest, m_requestQueue) {
+            if (queuedRequest.command() == request.command()) {
+                qCDebug(dcKeba()) << "Request" << request.command() << "already queued for" << m_address.toString() << ". Skipping.";
+                return;
+            }
+        }
+
+        m_requestQueue.enqueue(request);
+    } else {
+        // User actions jump ahead of any pending polling request, keeping the order among themselves
+        int index = 0;
+        while (index < m_requestQueue.count() && m_requestQueue.at(index).priority() == KeContactRequest::PriorityHigh)
+            index++;
+
+        m_requestQueue.insert(index, request);
+    }
+
+    sendNextCommand();
+}
+
 void KeContact::sendCommand(const QByteArray &command)
 {
     if (!m_dataLayer) {
@@ -130,6 +181,7 @@ void KeContact::sendCommand(const QByteArray &command)
     }
 
     m_dataLayer->write(m_address, command);
+    m_responseTimer.start();
     m_requestTimeoutTimer->start(5000);
 }
 
@@ -143,6 +195,10 @@ void KeContact::sendNextCommand()
     if (m_currentRequest.isValid())
         return;
 
+    // Pacing between two commands, the pause timer will continue
+    if (m_pauseTimer->isActive())
+        return;
+
     m_currentRequest = m_requestQueue.dequeue();
     sendCommand(m_currentRequest.command());
 }
@@ -183,8 +239,7 @@ QUuid KeContact::enableOutput(bool state)
     KeContactRequest request(QUuid::createUuid(), datagram);
     request.setDelayUntilNextCommand(2000);
     qCDebug(dcKeba()) << "Enable output: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -208,8 +263,7 @@ QUuid KeContact::setMaxAmpere(int milliAmpere)
     KeContactRequest request(QUuid::createUuid(), datagram);
     request.setDelayUntilNextCommand(1200);
     qCDebug(dcKeba()) << "Set max charging amps: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -232,8 +286,7 @@ QUuid KeContact::setMaxAmpereGeneral(int milliAmpere)
     QByteArray datagram = commandLine.toUtf8();
     KeContactRequest request(QUuid::createUuid(), datagram);
     request.setDelayUntilNextCommand(1200);
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -261,8 +314,7 @@ QUuid KeContact::displayMessage(const QByteArray &message)
     datagram.append("display 0 0 0 0 " + modifiedMessage);
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Display message: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -278,8 +330,7 @@ QUuid KeContact::chargeWithEnergyLimit(double energy)
     datagram.append("setenergy " + QVariant(static_cast<int>(energy*10000)).toByteArray());
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Charge with energy limit: Datagram: " << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -298,8 +349,7 @@ QUuid KeContact::setFailsafe(int timeout, int current, bool save)
     data.append((save ? " 1":" 0"));
     KeContactRequest request(QUuid::createUuid(), data);
     qCDebug(dcKeba()) << "Set failsafe mode: Datagram: " << data;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -308,9 +358,9 @@ void KeContact::getDeviceInformation()
     QByteArray data;
     data.append("i");
     KeContactRequest request(QUuid::createUuid(), data);
+    request.setPriority(KeContactRequest::PriorityLow);
     qCDebug(dcKeba()) << "Get device information: Datagram: " << data;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
 }
 
 void KeContact::getReport1()
@@ -347,8 +397,7 @@ QUuid KeContact::setOutputX2(bool state)
 
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Set Output X2, state:" << state << "Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
@@ -364,9 +413,9 @@ void KeContact::getReport(int reportNumber)
     datagram.append("report " + QVariant(reportNumber).toByteArray());
 
     KeContactRequest request(QUuid::createUuid(), datagram);
+    request.setPriority(KeContactRequest::PriorityLow);
     qCDebug(dcKeba()) << "Get report" << reportNumber << "Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
 }
 
 QUuid KeContact::unlockCharger()
@@ -382,208 +431,210 @@ QUuid KeContact::unlockCharger()
 
     KeContactRequest request(QUuid::createUuid(), datagram);
     qCDebug(dcKeba()) << "Unlock charger: Datagram:" << datagram;
-    m_requestQueue.enqueue(request);
-    sendNextCommand();
+    enqueueRequest(request);
     return request.requestId();
 }
 
-void KeContact::onReceivedDatagram(const QHostAddress &address, const QByteArray &datagram)
+void KeContact::finishCurrentRequest()
 {
-    // Make sure the datagram is for this keba
-    if (address != m_address)
-        return;
+    // Command response has been received, now send the next command
+    m_requestTimeoutTimer->stop();
+    if (m_currentRequest.isValid()) {
+        int responseTime = static_cast<int>(m_responseTimer.elapsed());
+        m_responseTime = m_responseTime == 0 ? responseTime : 0.8 * m_responseTime + 0.2 * responseTime;
+
+        // Schedule pause timer to send next request
+        m_pauseTimer->start(m_currentRequest.delayUntilNextCommand());
+        m_currentRequest = KeContactRequest();
+    }
+}
 
-    if (datagram.contains("TCH-OK")){
+void KeContact::processDatagram(KeContactDataLayer::DatagramType type, int reportId, const QByteArray &datagram)
+{
+    switch (type) {
+    case KeContactDataLayer::DatagramTypeCommandResponse:
         // We received valid data from the address over the data link, so the wallbox must be reachable
         setReachable(true);
 
-        //Command response has been received, now send the next command
-        m_requestTimeoutTimer->stop();
-
         if (m_currentRequest.isValid()) {
-            if (datagram.contains("done")) {
+            if (datagram.contains("TCH-OK") && datagram.contains("done")) {
                 qCDebug(dcKeba()) << "Command" << m_currentRequest.command() << "finished successfully";
                 emit commandExecuted(m_currentRequest.requestId(), true);
             } else {
                 qCWarning(dcKeba()) << "Command" << m_currentRequest.command() << "finished with error" << datagram;
                 emit commandExecuted(m_currentRequest.requestId(), false);
             }
-
-            // Schedule pause timer to send next request
-            m_pauseTimer->start(m_currentRequest.delayUntilNextCommand());
-            m_currentRequest = KeContactRequest();
         } else {
             //Probably the response has taken too long and the requestId has been already removed
-            qCWarning(dcKeba()) << "Received command OK response without pending request." << datagram;
+            qCWarning(dcKeba()) << "Received command response without pending request." << datagram;
         }
-    } else if (datagram.left(8).contains("Firmware")){
+        finishCurrentRequest();
+        return;
+    case KeContactDataLayer::DatagramTypeFirmware: {
         // We received valid data from the address over the data link, so the wallbox must be reachable
         setReachable(true);
-
-        // Command response has been received, now send the next command
-        m_requestTimeoutTimer->stop();
-        if (m_currentRequest.isValid()) {
-            // Schedule pause timer to send next request
-            m_pauseTimer->start(m_currentRequest.delayUntilNextCommand());
-            m_currentRequest = KeContactRequest();
-        }
+        finishCurrentRequest();
 
         qCDebug(dcKeba()) << "Firmware information received";
         QByteArrayList firmware = datagram.split(':');
         if (firmware.length() >= 2) {
             emit deviceInformationReceived(firmware[1]);
         }
-    } else {
-        //Command response has been received, now send the next command
-        m_requestTimeoutTimer->stop();
-        if (m_currentRequest.isValid()) {
-            // Schedule pause timer to send next request
-            m_pauseTimer->start(m_currentRequest.delayUntilNextCommand());
-            m_currentRequest = KeContactRequest();
-        }
-
-        // Convert the rawdata to a json document
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcKeba()) << "Failed to parse JSON data" << datagram << ":" << error.errorString();
-            return;
-        }
+        return;
+    }
+    case KeContactDataLayer::DatagramTypeReport:
+        // Reports are responses to our requests, broadcasts are sent unsolicited and must not finish a pending request
+        finishCurrentRequest();
+        break;
+    case KeContactDataLayer::DatagramTypeBroadcast:
+        break;
+    case KeContactDataLayer::DatagramTypeUnknown:
+        finishCurrentRequest();
+        qCWarning(dcKeba()) << "Received unknown datagram" << datagram;
+        return;
+    }
 
-        QVariantMap data = jsonDoc.toVariant().toMap();
-
-        if (data.contains("ID")) {
-            int id = data.value("ID").toInt();
-            if (id == 1) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-
-                ReportOne reportOne;
-                //qCDebug(dcKeba()) << "Report 1 received";
-                reportOne.product      = data.value("Product").toString();
-                reportOne.firmware     = data.value("Firmware").toString();
-                reportOne.serialNumber = data.value("Serial").toString();
-                //"Backend:"
-                //"timeQ": 3
-                //"DIP-Sw1": "0x22"
-                //"DIP-Sw2":
-                reportOne.dipSw1 = data.value("DIP-Sw1").toString().remove("0x").toUInt(nullptr, 16);
-                reportOne.dipSw2 = data.value("DIP-Sw2").toString().remove("0x").toUInt(nullptr, 16);
-
-                if (data.contains("COM-module")) {
-                    reportOne.comModule = (data.value("COM-module").toInt() == 1);
-                } else {
-                    reportOne.comModule = false;
-                }
-                if (data.contains("Sec")) {
-                    reportOne.comModule = data.value("Sec").toInt();
-                } else {
-                    reportOne.comModule = 0;
-                }
-                emit reportOneReceived(reportOne);
-
-            } else if (id == 2) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-
-                ReportTwo reportTwo;
-                //qCDebug(dcKeba()) << "Report 2 received";
-                int state = data.value("State").toInt();
-                reportTwo.state = State(state);
-                reportTwo.error1 = data.value("Error1").toInt();
-                reportTwo.error2 = data.value("Error2").toInt();
-                reportTwo.plugState = PlugState(data.value("Plug").toInt());
-                reportTwo.enableUser = data.value("Enable user").toBool();
-                reportTwo.enableSys = data.value("Enable sys").toBool();
-                reportTwo.maxCurrent = data.value("Max curr").toInt() / 1000.00;
-                reportTwo.maxCurrentPercentage = data.value("Max curr %").toInt() / 10.00;
-                reportTwo.currentHardwareLimitation = data.value("Curr HW").toInt() / 1000.00;
-                reportTwo.currentUser = data.value("Curr user").toInt() / 1000.00;
-                reportTwo.currTimer = data.value("Curr timer").toInt() / 1000.00;
-                reportTwo.timeoutCt = data.value("Tmo CT").toInt();
-                reportTwo.currentFailsafe = data.value("Curr FS").toInt() / 1000.00;
-                reportTwo.timeoutFailsafe = data.value("Tmo FS").toInt();
-                reportTwo.setEnergy = data.value("Setenergy").toInt() / 10000.00;
-                reportTwo.output = data.value("Output").toInt();
-                reportTwo.input= data.value("Input").toInt();
-                reportTwo.serialNumber = data.value("Serial").toString();
-                reportTwo.seconds = data.value("Sec").toInt();
-                // Not documented:
-                //"AuthON": 0
-                //"Authreq": 0
-                emit reportTwoReceived(reportTwo);
-
-            } else if (id == 3) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-
-                ReportThree reportThree;
-                //qCDebug(dcKeba()) << "Report 3 received";
-                reportThree.currentPhase1 = data.value("I1").toInt() / 1000.00;
-                reportThree.currentPhase2 = data.value("I2").toInt() / 1000.00;
-                reportThree.currentPhase3 = data.value("I3").toInt() / 1000.00;
-                reportThree.voltagePhase1 = data.value("U1").toInt();
-                reportThree.voltagePhase2 = data.value("U2").toInt();
-                reportThree.voltagePhase3 = data.value("U3").toInt();
-                reportThree.power         = data.value("P").toInt() / 1000.00;
-                reportThree.powerFactor   = data.value("PF").toInt() / 10.00;
-                reportThree.energySession = data.value("E pres").toInt() / 10000.00;
-                reportThree.energyTotal   = data.value("E total").toInt() / 10000.00;
-                reportThree.serialNumber  = data.value("Serial").toString();
-                reportThree.seconds  = data.value("Sec").toInt();
-                emit reportThreeReceived(reportThree);
-            } else if (id >= 100) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-
-                Report1XX report;
-                //qCDebug(dcKeba()) << "Report" << id << "received";
-                report.sessionId = data.value("Session ID").toInt();
-                report.currHW = data.value("Curr HW").toInt();
-                report.startEnergy = data.value("E start").toInt() / 10000.00;
-                report.presentEnergy = data.value("E pres").toInt() / 10000.00;
-                report.startTime = data.value("started[s]").toInt();
-                report.endTime = data.value("ended[s]").toInt();
-                report.stopReason = data.value("reason").toInt();
-                report.rfidTag = data.value("RFID tag").toByteArray();
-                report.rfidClass = data.value("RFID class").toByteArray();
-                report.serialNumber = data.value("Serial").toString();
-                report.seconds = data.value("Sec").toInt();
-                emit report1XXReceived(id, report);
-            }
-        } else {
-            // Broadcast message, lets see what we recognize
+    // Convert the rawdata to a json document
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(datagram, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcKeba()) << "Failed to parse JSON data" << datagram << ":" << error.errorString();
+        return;
+    }
 
-            if (data.contains("State")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypeState, data.value("State"));
-            }
-            if (data.contains("Plug")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypePlug, data.value("Plug"));
-            }
-            if (data.contains("Input")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypeInput, data.value("Input"));
-            }
-            if (data.contains("Enable sys")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypeEnableSys, data.value("Enable sys"));
-            }
-            if (data.contains("Max curr")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypeMaxCurr, data.value("Max curr"));
+    QVariantMap data = jsonDoc.toVariant().toMap();
+
+    if (type == KeContactDataLayer::DatagramTypeReport) {
+        int id = reportId;
+        if (id == 1) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+
+            ReportOne reportOne;
+            //qCDebug(dcKeba()) << "Report 1 received";
+            reportOne.product      = data.value("Product").toString();
+            reportOne.firmware     = data.value("Firmware").toString();
+            reportOne.serialNumber = data.value("Serial").toString();
+            //"Backend:"
+            //"timeQ": 3
+            //"DIP-Sw1": "0x22"
+            //"DIP-Sw2":
+            reportOne.dipSw1 = data.value("DIP-Sw1").toString().remove("0x").toUInt(nullptr, 16);
+            reportOne.dipSw2 = data.value("DIP-Sw2").toString().remove("0x").toUInt(nullptr, 16);
+
+            if (data.contains("COM-module")) {
+                reportOne.comModule = (data.value("COM-module").toInt() == 1);
+            } else {
+                reportOne.comModule = false;
             }
-            if (data.contains("E pres")) {
-                // We received valid data from the address over the data link, so the wallbox must be reachable
-                setReachable(true);
-                emit broadcastReceived(BroadcastType::BroadcastTypeEPres, data.value("E pres"));
+            if (data.contains("Sec")) {
+                reportOne.comModule = data.value("Sec").toInt();
+            } else {
+                reportOne.comModule = 0;
             }
+            emit reportOneReceived(reportOne);
+
+        } else if (id == 2) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+
+            ReportTwo reportTwo;
+            //qCDebug(dcKeba()) << "Report 2 received";
+            int state = data.value("State").toInt();
+            reportTwo.state = State(state);
+            reportTwo.error1 = data.value("Error1").toInt();
+            reportTwo.error2 = data.value("Error2").toInt();
+            reportTwo.plugState = PlugState(data.value("Plug").toInt());
+            reportTwo.enableUser = data.value("Enable user").toBool();
+            reportTwo.enableSys = data.value("Enable sys").toBool();
+            reportTwo.maxCurrent = data.value("Max curr").toInt() / 1000.00;
+            reportTwo.maxCurrentPercentage = data.value("Max curr %").toInt() / 10.00;
+            reportTwo.currentHardwareLimitation = data.value("Curr HW").toInt() / 1000.00;
+            reportTwo.currentUser = data.value("Curr user").toInt() / 1000.00;
+            reportTwo.currTimer = data.value("Curr timer").toInt() / 1000.00;
+            reportTwo.timeoutCt = data.value("Tmo CT").toInt();
+            reportTwo.currentFailsafe = data.value("Curr FS").toInt() / 1000.00;
+            reportTwo.timeoutFailsafe = data.value("Tmo FS").toInt();
+            reportTwo.setEnergy = data.value("Setenergy").toInt() / 10000.00;
+            reportTwo.output = data.value("Output").toInt();
+            reportTwo.input= data.value("Input").toInt();
+            reportTwo.serialNumber = data.value("Serial").toString();
+            reportTwo.seconds = data.value("Sec").toInt();
+            // Not documented:
+            //"AuthON": 0
+            //"Authreq": 0
+            emit reportTwoReceived(reportTwo);
+
+        } else if (id == 3) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+
+            ReportThree reportThree;
+            //qCDebug(dcKeba()) << "Report 3 received";
+            reportThree.currentPhase1 = data.value("I1").toInt() / 1000.00;
+            reportThree.currentPhase2 = data.value("I2").toInt() / 1000.00;
+            reportThree.currentPhase3 = data.value("I3").toInt() / 1000.00;
+            reportThree.voltagePhase1 = data.value("U1").toInt();
+            reportThree.voltagePhase2 = data.value("U2").toInt();
+            reportThree.voltagePhase3 = data.value("U3").toInt();
+            reportThree.power         = data.value("P").toInt() / 1000.00;
+            reportThree.powerFactor   = data.value("PF").toInt() / 10.00;
+            reportThree.energySession = data.value("E pres").toInt() / 10000.00;
+            reportThree.energyTotal   = data.value("E total").toInt() / 10000.00;
+            reportThree.serialNumber  = data.value("Serial").toString();
+            reportThree.seconds  = data.value("Sec").toInt();
+            emit reportThreeReceived(reportThree);
+        } else if (id >= 100) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+
+            Report1XX report;
+            //qCDebug(dcKeba()) << "Report" << id << "received";
+            report.sessionId = data.value("Session ID").toInt();
+            report.currHW = data.value("Curr HW").toInt();
+            report.startEnergy = data.value("E start").toInt() / 10000.00;
+            report.presentEnergy = data.value("E pres").toInt() / 10000.00;
+            report.startTime = data.value("started[s]").toInt();
+            report.endTime = data.value("ended[s]").toInt();
+            report.stopReason = data.value("reason").toInt();
+            report.rfidTag = data.value("RFID tag").toByteArray();
+            report.rfidClass = data.value("RFID class").toByteArray();
+            report.serialNumber = data.value("Serial").toString();
+            report.seconds = data.value("Sec").toInt();
+            emit report1XXReceived(id, report);
+        }
+    } else {
+        // Broadcast message, lets see what we recognize
+
+        if (data.contains("State")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypeState, data.value("State"));
+        }
+        if (data.contains("Plug")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypePlug, data.value("Plug"));
+        }
+        if (data.contains("Input")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypeInput, data.value("Input"));
+        }
+        if (data.contains("Enable sys")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypeEnableSys, data.value("Enable sys"));
+        }
+        if (data.contains("Max curr")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypeMaxCurr, data.value("Max curr"));
+        }
+        if (data.contains("E pres")) {
+            // We received valid data from the address over the data link, so the wallbox must be reachable
+            setReachable(true);
+            emit broadcastReceived(BroadcastType::BroadcastTypeEPres, data.value("E pres"));
         }
     }
 }
@@ -38,12 +38,19 @@
 #include <QUdpSocket>
 #include <QUuid>
 #include <QQueue>
+#include <QPointer>
+#include <QElapsedTimer>
 
 #include "kecontactdatalayer.h"
 
 class KeContactRequest
 {
 public:
+    enum Priority {
+        PriorityLow = 0,    // Polling, may be merged with an equal pending request
+        PriorityHigh        // User actions, sent before any pending polling request
+    };
+
     KeContactRequest() = default;
     KeContactRequest(const QUuid &requestId, const QByteArray &command) : m_requestId(requestId), m_command(command) { }
 
@@ -53,18 +60,25 @@ public:
     uint delayUntilNextCommand() const { return m_delayUntilNextCommand; }
     void setDelayUntilNextCommand(uint delayUntilNextCommand) { m_delayUntilNextCommand = delayUntilNextCommand; }
 
-    bool isValid() { return !m_requestId.isNull() && !m_command.isEmpty(); }
+    Priority priority() const { return m_priority; }
+    void setPriority(Priority priority) { m_priority = priority; }
+
+    bool isValid() const { return !m_requestId.isNull() && !m_command.isEmpty(); }
 
 private:
     QUuid m_requestId;
     QByteArray m_command;
     uint m_delayUntilNextCommand = 200;
+    Priority m_priority = PriorityHigh;
 };
 
 
 class KeContact : public QObject
 {
     Q_OBJECT
+
+    friend class KeContactDataLayer;
+
 public:
     enum DipSwitchOne {
         // Power settings
@@ -185,6 +199,11 @@ public:
 
     bool reachable() const;
 
+    // Number of requests waiting or in flight
+    int queueDepth() const;
+    // Smoothed time between sending a request and receiving its response in ms
+    int responseTime() const;
+
     QUuid start(const QByteArray &rfidToken, const QByteArray &rfidClassifier);     // Command “start”
     QUuid stop(const QByteArray &rfidToken);                // Command “stop”
 
@@ -206,7 +225,7 @@ public:
     QUuid setOutputX2(bool state);                       // Command “output”
 
 private:
-    KeContactDataLayer *m_dataLayer = nullptr;
+    QPointer<KeContactDataLayer> m_dataLayer;
     bool m_reachable = false;
 
     QHostAddress m_address;
@@ -218,12 +237,20 @@ private:
     KeContactRequest m_currentRequest;
     QQueue<KeContactRequest> m_requestQueue;
 
+    QElapsedTimer m_responseTimer;
+    double m_responseTime = 0;
+
     void getReport(int reportNumber);
 
+    void enqueueRequest(const KeContactRequest &request);
     void sendCommand(const QByteArray &command);
     void sendNextCommand();
     void setReachable(bool reachable);
 
+    // Called by the data layer for each datagram received from this wallbox
+    void processDatagram(KeContactDataLayer::DatagramType type, int reportId, const QByteArray &datagram);
+    void finishCurrentRequest();
+
 signals:
     void reachableChanged(bool status);
     void commandExecuted(QUuid requestId, bool success);
@@ -234,9 +261,6 @@ signals:
     void report1XXReceived(int reportNumber, const Report1XX &report);
     void broadcastReceived(BroadcastType type, const QVariant &content);
 
-private slots:
-    void onReceivedDatagram(const QHostAddress &address, const QByteArray &datagram);
-
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(KeContact::DipSwitchOneFlag);
@@ -30,6 +30,9 @@
 
 #include "kecontactdatalayer.h"
 #include "extern-plugininfo.h"
+#include "kecontact.h"
+
+#include <cctype>
 
 KeContactDataLayer::KeContactDataLayer(QObject *parent) : QObject(parent)
 {
@@ -70,6 +73,79 @@ void KeContactDataLayer::write(const QHostAddress &address, const QByteArray &da
     m_udpSocket->writeDatagram(data, address, m_port);
 }
 
+void KeContactDataLayer::registerContact(KeContact *contact)
+{
+    if (contact->address().isNull())
+        return;
+
+    KeContact *existingContact = m_contacts.value(contact->address());
+    if (existingContact && existingContact != contact) {
+        qCWarning(dcKeba()) << "KeContactDataLayer: There is already a connection registered for" << contact->address().toString() << ". Replacing it.";
+    }
+
+    m_contacts.insert(contact->address(), contact);
+}
+
+void KeContactDataLayer::unregisterContact(KeContact *contact)
+{
+    QHash<QHostAddress, KeContact *>::iterator it = m_contacts.begin();
+    while (it != m_contacts.end()) {
+        if (it.value() == contact) {
+            it = m_contacts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+KeContactDataLayer::DatagramType KeContactDataLayer::classifyDatagram(const QByteArray &datagram, int *reportId)
+{
+    const char *data = datagram.constData();
+    int size = datagram.size();
+    int pos = 0;
+
+    while (pos < size && isspace(static_cast<unsigned char>(data[pos])))
+        pos++;
+
+    if (size - pos >= 4 && qstrncmp(data + pos, "TCH-", 4) == 0)
+        return DatagramTypeCommandResponse;
+
+    if (size - pos >= 8 && qstrncmp(data + pos, "Firmware", 8) == 0)
+        return DatagramTypeFirmware;
+
+    if (pos >= size || data[pos] != '{')
+        return DatagramTypeUnknown;
+
+    // Reports always start with the "ID" key, broadcasts never contain it: {"State": 2}
+    pos++;
+    while (pos < size && isspace(static_cast<unsigned char>(data[pos])))
+        pos++;
+
+    if (size - pos < 4 || qstrncmp(data + pos, "\"ID\"", 4) != 0)
+        return DatagramTypeBroadcast;
+
+    pos += 4;
+    // Skip the separator and the optional quote of the value: "ID": "2"
+    while (pos < size && (isspace(static_cast<unsigned char>(data[pos])) || data[pos] == ':' || data[pos] == '"'))
+        pos++;
+
+    int id = 0;
+    int digits = 0;
+    while (pos < size && data[pos] >= '0' && data[pos] <= '9' && digits < 6) {
+        id = id * 10 + (data[pos] - '0');
+        pos++;
+        digits++;
+    }
+
+    if (digits == 0)
+        return DatagramTypeUnknown;
+
+    if (reportId)
+        *reportId = id;
+
+    return DatagramTypeReport;
+}
+
 void KeContactDataLayer::readPendingDatagrams()
 {
     QUdpSocket *socket= qobject_cast<QUdpSocket*>(sender());
@@ -82,6 +158,15 @@ void KeContactDataLayer::readPendingDatagrams()
         datagram.resize(socket->pendingDatagramSize());
         socket->readDatagram(datagram.data(), datagram.size(), &senderAddress, &senderPort);
         qCDebug(dcKeba()) << "KeContactDataLayer: <--" << senderAddress.toString() << datagram;
+
+        KeContact *contact = m_contacts.value(senderAddress);
+        if (contact) {
+            int reportId = 0;
+            DatagramType type = classifyDatagram(datagram, &reportId);
+            contact->processDatagram(type, reportId, datagram);
+        }
+
+        // Note: used for the discovery, which also needs datagrams from unregistered addresses
         emit datagramReceived(senderAddress, datagram);
     }
 }
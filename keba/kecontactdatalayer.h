@@ -31,13 +31,25 @@
 #ifndef KECONTACTDATALAYER_H
 #define KECONTACTDATALAYER_H
 
+#include <QHash>
 #include <QObject>
 #include <QUdpSocket>
 
+class KeContact;
+
 class KeContactDataLayer : public QObject
 {
     Q_OBJECT
 public:
+    enum DatagramType {
+        DatagramTypeUnknown = 0,
+        DatagramTypeCommandResponse,    // TCH-OK / TCH-ERR
+        DatagramTypeFirmware,           // Response to "i"
+        DatagramTypeReport,             // JSON report with "ID" (1, 2, 3, 1xx)
+        DatagramTypeBroadcast           // JSON without "ID", sent by the wallbox on changes
+    };
+    Q_ENUM(DatagramType)
+
     explicit KeContactDataLayer(QObject *parent = nullptr);
     ~KeContactDataLayer();
 
@@ -46,11 +58,21 @@ public:
 
     void write(const QHostAddress &address, const QByteArray &data);
 
+    // Datagrams from a registered address are delivered directly to the owning KeContact
+    void registerContact(KeContact *contact);
+    void unregisterContact(KeContact *contact);
+
+    // Cheap classification by looking at the beginning of the datagram only, without parsing any JSON.
+    // For reports the report id gets written to reportId.
+    static DatagramType classifyDatagram(const QByteArray &datagram, int *reportId = nullptr);
+
 private:
     bool m_initialized = false;
     int m_port = 7090;
     QUdpSocket *m_udpSocket = nullptr;
 
+    QHash<QHostAddress, KeContact *> m_contacts;
+
 signals:
     void datagramReceived(const QHostAddress &address, const QByteArray &data);
 
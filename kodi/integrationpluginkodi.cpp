@@ -36,9 +36,12 @@
 #include "network/zeroconf/zeroconfservicebrowser.h"
 #include "network/zeroconf/zeroconfserviceentry.h"
 #include "network/networkaccessmanager.h"
+#include "nymeasettings.h"
 
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QDir>
+#include <QFile>
 
 IntegrationPluginKodi::IntegrationPluginKodi()
 {
@@ -95,6 +98,18 @@ void IntegrationPluginKodi::setupThing(ThingSetupInfo *info)
     Kodi *kodi= new Kodi(hostInfo.address, hostInfo.rpcPort, hostInfo.httpPort, thing);
     m_kodis.insert(thing, kodi);
 
+    // The library cache can be persisted so browsing is fast right after a restart
+    QDir().mkpath(NymeaSettings::cachePath());
+    QString snapshotFile = librarySnapshotFile(thing->id());
+    if (thing->setting(kodiSettingsLibrarySnapshotParamTypeId).toBool()) {
+        kodi->setLibrarySnapshotFile(snapshotFile);
+    }
+    connect(thing, &Thing::settingChanged, kodi, [kodi, snapshotFile](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == kodiSettingsLibrarySnapshotParamTypeId) {
+            kodi->setLibrarySnapshotFile(value.toBool() ? snapshotFile : QString());
+        }
+    });
+
     if (info->isInitialSetup()) {
         connect(kodi, &Kodi::connectionStatusChanged, info, [info](bool connected){
             if (connected) {
@@ -195,7 +210,18 @@ void IntegrationPluginKodi::postSetupThing(Thing */*thing*/)
 
 void IntegrationPluginKodi::thingRemoved(Thing *thing)
 {
-    m_kodis.remove(thing);
+    if (m_kodis.contains(thing)) {
+        // Writes a pending library snapshot
+        delete m_kodis.take(thing);
+    }
+
+    // This is also called when the thing gets reconfigured, keep the snapshot unless the thing is gone for good
+    ThingId thingId = thing->id();
+    QTimer::singleShot(0, this, [this, thingId](){
+        if (!myThings().findById(thingId)) {
+            QFile::remove(librarySnapshotFile(thingId));
+        }
+    });
 
     if (myThings().isEmpty()) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer);
@@ -493,3 +519,7 @@ void IntegrationPluginKodi::onPlaybackStatusChanged(const QString &playbackStatu
     }
 }
 
+QString IntegrationPluginKodi::librarySnapshotFile(const ThingId &thingId) const
+{
+    return NymeaSettings::cachePath() + "/kodi-library-" + thingId.toString().remove(QRegExp("[{}]")) + ".json";
+}
@@ -71,6 +71,7 @@ private:
     };
 
     KodiHostInfo resolve(Thing *thing);
+    QString librarySnapshotFile(const ThingId &thingId) const;
 
 private:
     PluginTimer *m_pluginTimer = nullptr;
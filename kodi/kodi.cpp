@@ -34,6 +34,9 @@
 #include <QUrl>
 #include <QTime>
 
+// Library lists are fetched in pages of this size to keep single replies small
+static const int libraryPageSize = 500;
+
 Kodi::Kodi(const QHostAddress &hostAddress, int port, int httpPort, QObject *parent) :
     QObject(parent),
     m_httpPort(httpPort),
@@ -47,6 +50,8 @@ Kodi::Kodi(const QHostAddress &hostAddress, int port, int httpPort, QObject *par
     connect(m_jsonHandler, &KodiJsonHandler::notificationReceived, this, &Kodi::processNotification);
     connect(m_jsonHandler, &KodiJsonHandler::replyReceived, this, &Kodi::processResponse);
 
+    m_libraryCache = new KodiLibraryCache(this);
+
 
     // Init FS
     m_virtualFs = new VirtualFsNode(BrowserItem());
@@ -216,6 +221,11 @@ bool Kodi::connected() const
     return m_connection->connected();
 }
 
+void Kodi::setLibrarySnapshotFile(const QString &fileName)
+{
+    m_libraryCache->setSnapshotFile(fileName);
+}
+
 int Kodi::setMuted(const bool &muted)
 {
     QVariantMap params;
@@ -348,6 +358,11 @@ void Kodi::browse(BrowseResult *result)
             return;
         }
 
+        if (KodiLibraryCache::isLibraryMethod(node->getMethod)) {
+            browseLibrary(result, node->getMethod, node->getParams);
+            return;
+        }
+
         qCDebug(dcKodi()) << "Sending:" << node->getMethod << node->getParams;
         int id = m_jsonHandler->sendData(node->getMethod, node->getParams);
         m_pendingBrowseRequests.insert(id, result);
@@ -371,8 +386,7 @@ void Kodi::browse(BrowseResult *result)
         albumProperties.append("artist");
         albumProperties.append("year");
         params.insert("properties", albumProperties);
-        int id = m_jsonHandler->sendData("AudioLibrary.GetAlbums", params);
-        m_pendingBrowseRequests.insert(id, result);
+        browseLibrary(result, "AudioLibrary.GetAlbums", params);
         return;
     }
 
@@ -389,8 +403,7 @@ void Kodi::browse(BrowseResult *result)
         songProperties.append("album");
         songProperties.append("year");
         params.insert("properties", songProperties);
-        int id = m_jsonHandler->sendData("AudioLibrary.GetSongs", params);
-        m_pendingBrowseRequests.insert(id, result);
+        browseLibrary(result, "AudioLibrary.GetSongs", params);
         return;
     }
 
@@ -405,8 +418,7 @@ void Kodi::browse(BrowseResult *result)
         properties.append("thumbnail");
         properties.append("showtitle");
         params.insert("properties", properties);
-        int id = m_jsonHandler->sendData("VideoLibrary.GetSeasons", params);
-        m_pendingBrowseRequests.insert(id, result);
+        browseLibrary(result, "VideoLibrary.GetSeasons", params);
         return;
     }
 
@@ -424,9 +436,7 @@ void Kodi::browse(BrowseResult *result)
         properties.append("showtitle");
         properties.append("season");
         params.insert("properties", properties);
-        qCDebug(dcKodi()) << "getting episodes:" << params;
-        int id = m_jsonHandler->sendData("VideoLibrary.GetEpisodes", params);
-        m_pendingBrowseRequests.insert(id, result);
+        browseLibrary(result, "VideoLibrary.GetEpisodes", params);
         return;
     }
 
@@ -488,6 +498,14 @@ void Kodi::browserItem(BrowserItemResult *result)
         result->finish(Thing::ThingErrorItemNotFound);
         return;
     }
+
+    QVariantMap cachedItem = m_libraryCache->findItem(itemId.left(itemId.indexOf(':')), idString.toInt());
+    if (!cachedItem.isEmpty()) {
+        BrowserItem item(itemId, cachedItem.value("label").toString());
+        result->finish(item);
+        return;
+    }
+
     int id = m_jsonHandler->sendData(method, params);
     m_pendingBrowserItemRequests.insert(id, result);
 }
@@ -570,6 +588,16 @@ void Kodi::onConnectionStatusChanged()
     if (m_connection->connected()) {
         checkVersion();
     } else {
+        // Pages of unfinished library fetches won't arrive anymore
+        foreach (const LibraryFetch &fetch, m_libraryFetches) {
+            foreach (BrowseResult *result, fetch.results) {
+                if (result) {
+                    result->finish(Thing::ThingErrorHardwareNotAvailable);
+                }
+            }
+        }
+        m_libraryFetches.clear();
+        m_pendingLibraryPages.clear();
         emit connectionStatusChanged(false);
     }
 }
@@ -687,6 +715,27 @@ void Kodi::processNotification(const QString &method, const QVariantMap &params)
             method == "Player.OnStop" ||
             method == "Player.OnAVChange") {
         update();
+        return;
+    }
+
+    if (method == "VideoLibrary.OnUpdate" || method == "AudioLibrary.OnUpdate") {
+        QVariantMap data = params.value("data").toMap();
+        // VideoLibrary wraps the item in "item", AudioLibrary doesn't
+        QVariantMap item = data.contains("item") ? data.value("item").toMap() : data;
+        m_libraryCache->itemUpdated(item.value("type").toString(), item.value("id").toInt(), data.value("added").toBool());
+        return;
+    }
+
+    if (method == "VideoLibrary.OnRemove" || method == "AudioLibrary.OnRemove") {
+        QVariantMap data = params.value("data").toMap();
+        m_libraryCache->itemRemoved(data.value("type").toString(), data.value("id").toInt());
+        return;
+    }
+
+    // Scans and cleanups may batch their changes without per item notifications
+    if (method.endsWith(".OnScanFinished") || method.endsWith(".OnCleanFinished")) {
+        m_libraryCache->invalidateLibrary(method.left(method.indexOf('.')));
+        return;
     }
 }
 
@@ -745,17 +794,193 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
         return;
     }
 
+    if (m_pendingLibraryPages.contains(id)) {
+        processLibraryPage(id, method, response);
+        return;
+    }
+
     if (method == "Player.SetShuffle" || method == "Player.SetRepeat") {
         updatePlayerProperties();
         emit actionExecuted(id, !response.contains("error"));
         return;
     }
 
-    if (method == "AudioLibrary.GetArtists") {
+    if (method == "Addons.GetAddons") {
+        BrowseResult *result = m_pendingBrowseRequests.take(id);
+        foreach (const QVariant &addonVariant, response.value("result").toMap().value("addons").toList()) {
+            QVariantMap addon = addonVariant.toMap();
+            qCDebug(dcKodi()) << "Entry:" << addon;
+            BrowserItem item("addon:" + addon.value("addonid").toString(), addon.value("name").toString());
+            item.setBrowsable(true);
+            item.setIcon(BrowserItem::BrowserIconApplication);
+            item.setThumbnail(prepareThumbnail(addon.value("thumbnail").toString()));
+            result->addItem(item);
+        }
+        result->finish(Thing::ThingErrorNoError);
+        return;
+    }
+
+    if (method == "Files.GetDirectory") {
         BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &artistVariant, response.value("result").toMap().value("artists").toList()) {
+        foreach (const QVariant &fileVariant, response.value("result").toMap().value("files").toList()) {
+            QVariantMap file = fileVariant.toMap();
+            qCDebug(dcKodi()) << "Entry:" << file;
+            BrowserItem item("file:" + file.value("file").toString(), file.value("label").toString());
+            if (file.value("type").toString() == "directory" || file.value("type").toString() == "unknown") {
+                item.setBrowsable(true);
+                item.setIcon(BrowserItem::BrowserIconFolder);
+            } else if (file.value("type").toString() == "episode" || file.value("type").toString() == "movie") {
+                item.setExecutable(true);
+                item.setIcon(BrowserItem::BrowserIconVideo);
+            } else if (file.value("type").toString() == "song") {
+                item.setExecutable(true);
+                item.setIcon(BrowserItem::BrowserIconMusic);
+            }
+            item.setThumbnail(prepareThumbnail(file.value("thumbnail").toString()));
+            result->addItem(item);
+        }
+        result->finish(Thing::ThingErrorNoError);
+        return;
+    }
+
+    if (method == "AudioLibrary.GetSongDetails") {
+        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
+        BrowserItem item("song:" + response.value("result").toMap().value("songdetails").toMap().value("songid").toString());
+        item.setDisplayName(response.value("result").toMap().value("songdetails").toMap().value("label").toString());
+        qCDebug(dcKodi()) << "Song details:" << item.displayName();
+        result->finish(item);
+        return;
+    }
+
+    if (method == "VideoLibrary.GetMovieDetails") {
+        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
+        BrowserItem item("movie:" + response.value("result").toMap().value("moviedetails").toMap().value("movieid").toString());
+        item.setDisplayName(response.value("result").toMap().value("moviedetails").toMap().value("label").toString());
+        qCDebug(dcKodi()) << "Movie details:" << item.displayName();
+        result->finish(item);
+        return;
+    }
+
+    if (method == "VideoLibrary.GetEpisodeDetails") {
+        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
+        BrowserItem item("movie:" + response.value("result").toMap().value("episodedetails").toMap().value("episodeid").toString());
+        item.setDisplayName(response.value("result").toMap().value("episodedetails").toMap().value("label").toString());
+        qCDebug(dcKodi()) << "Episode details:" << item.displayName();
+        result->finish(item);
+        return;
+    }
+
+    if (method == "VideoLibrary.GetMusicVideoDetails") {
+        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
+        BrowserItem item("movie:" + response.value("result").toMap().value("musicvideodetails").toMap().value("musicvideoid").toString());
+        item.setDisplayName(response.value("result").toMap().value("musicvideodetails").toMap().value("label").toString());
+        qCDebug(dcKodi()) << "Episode details:" << item.displayName();
+        result->finish(item);
+        return;
+    }
+
+    if (method == "VideoLibrary.Scan" || method == "VideoLibrary.Clean" || method == "AudioLibrary.Scan" || method == "AudioLibrary.Clean") {
+        emit browserItemActionExecuted(id, !response.contains("error"));
+        return;
+    }
+
+    if (method == "Player.Open") {
+        emit browserItemExecuted(id, !response.contains("error"));
+        return;
+    }
+
+    // Default
+    emit actionExecuted(id, !response.contains("error"));
+}
+
+void Kodi::browseLibrary(BrowseResult *result, const QString &method, const QVariantMap &params)
+{
+    QString key = KodiLibraryCache::cacheKey(method, params);
+
+    if (m_libraryCache->contains(key)) {
+        qCDebug(dcKodi()) << "Serving" << method << "from library cache";
+        addLibraryItems(result, method, m_libraryCache->entries(key));
+        return;
+    }
+
+    if (m_libraryFetches.contains(key)) {
+        m_libraryFetches[key].results.append(result);
+        return;
+    }
+
+    LibraryFetch fetch;
+    fetch.method = method;
+    fetch.params = params;
+    fetch.generation = m_libraryCache->generation();
+    fetch.results.append(result);
+    m_libraryFetches.insert(key, fetch);
+    requestLibraryPage(key, 0);
+}
+
+void Kodi::requestLibraryPage(const QString &key, int start)
+{
+    const LibraryFetch &fetch = m_libraryFetches[key];
+
+    QVariantMap limits;
+    limits.insert("start", start);
+    limits.insert("end", start + libraryPageSize);
+    QVariantMap params = fetch.params;
+    params.insert("limits", limits);
+
+    qCDebug(dcKodi()) << "Sending:" << fetch.method << params;
+    int id = m_jsonHandler->sendData(fetch.method, params);
+    m_pendingLibraryPages.insert(id, key);
+}
+
+void Kodi::processLibraryPage(int id, const QString &method, const QVariantMap &response)
+{
+    QString key = m_pendingLibraryPages.take(id);
+    if (!m_libraryFetches.contains(key)) {
+        return;
+    }
+
+    if (response.contains("error")) {
+        LibraryFetch fetch = m_libraryFetches.take(key);
+        foreach (BrowseResult *result, fetch.results) {
+            if (result) {
+                result->finish(Thing::ThingErrorHardwareFailure);
+            }
+        }
+        return;
+    }
+
+    LibraryFetch &fetch = m_libraryFetches[key];
+    QVariantMap result = response.value("result").toMap();
+    QVariantList page = result.value(KodiLibraryCache::listKey(method)).toList();
+    fetch.entries.append(page);
+
+    QVariantMap limits = result.value("limits").toMap();
+    int total = limits.value("total").toInt();
+    if (!page.isEmpty() && fetch.entries.count() < total) {
+        requestLibraryPage(key, fetch.entries.count());
+        return;
+    }
+
+    LibraryFetch finishedFetch = m_libraryFetches.take(key);
+    qCDebug(dcKodi()) << "Fetched" << finishedFetch.entries.count() << "items for" << method;
+
+    // Don't cache lists the library changed underneath while they were fetched
+    if (finishedFetch.generation == m_libraryCache->generation()) {
+        m_libraryCache->insert(key, method, finishedFetch.entries);
+    }
+
+    foreach (BrowseResult *browseResult, finishedFetch.results) {
+        if (browseResult) {
+            addLibraryItems(browseResult, method, finishedFetch.entries);
+        }
+    }
+}
+
+void Kodi::addLibraryItems(BrowseResult *result, const QString &method, const QVariantList &entries)
+{
+    if (method == "AudioLibrary.GetArtists") {
+        foreach (const QVariant &artistVariant, entries) {
             QVariantMap artist = artistVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << artist;
             BrowserItem item("artist:" + artist.value("artistid").toString(), artist.value("label").toString());
             item.setBrowsable(true);
             item.setIcon(BrowserItem::BrowserIconFolder);
@@ -768,7 +993,6 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
                 description.append(artist.value("genre").toStringList().join(", "));
             }
             item.setDescription(description.join(" - "));
-            qCDebug(dcKodi()) << "Thumbnail" << item.thumbnail();
             result->addItem(item);
         }
         result->finish(Thing::ThingErrorNoError);
@@ -776,8 +1000,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "AudioLibrary.GetAlbums") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &albumVariant, response.value("result").toMap().value("albums").toList()) {
+        foreach (const QVariant &albumVariant, entries) {
             QVariantMap album = albumVariant.toMap();
             BrowserItem item("album:" + album.value("albumid").toString(), album.value("label").toString());
             item.setBrowsable(true);
@@ -798,11 +1021,9 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "AudioLibrary.GetSongs") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
         int i = 0;
-        foreach (const QVariant &songVariant, response.value("result").toMap().value("songs").toList()) {
+        foreach (const QVariant &songVariant, entries) {
             QVariantMap song = songVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << song;
             QString newId = "song:";
             if (song.contains("albumid")) {
                 newId += QString::number(i);
@@ -833,10 +1054,8 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
 
 
     if (method == "VideoLibrary.GetMovies") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &movieVariant, response.value("result").toMap().value("movies").toList()) {
+        foreach (const QVariant &movieVariant, entries) {
             QVariantMap movie = movieVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << movie;
             BrowserItem item("movie:" + movie.value("movieid").toString(), movie.value("label").toString());
             item.setExecutable(true);
             item.setIcon(BrowserItem::BrowserIconVideo);
@@ -863,10 +1082,8 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "VideoLibrary.GetTVShows") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &tvShowVariant, response.value("result").toMap().value("tvshows").toList()) {
+        foreach (const QVariant &tvShowVariant, entries) {
             QVariantMap tvShow = tvShowVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << tvShow;
             BrowserItem item("tvshow:" + tvShow.value("tvshowid").toString(), tvShow.value("label").toString());
             item.setBrowsable(true);
             item.setIcon(BrowserItem::BrowserIconFolder);
@@ -887,10 +1104,8 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "VideoLibrary.GetSeasons") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &seasonVariant, response.value("result").toMap().value("seasons").toList()) {
+        foreach (const QVariant &seasonVariant, entries) {
             QVariantMap season = seasonVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << season;
             BrowserItem item("season:" + season.value("season").toString() + ",tvshow:" + season.value("tvshowid").toString(), season.value("label").toString());
             item.setBrowsable(true);
             item.setIcon(BrowserItem::BrowserIconFolder);
@@ -903,10 +1118,8 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "VideoLibrary.GetEpisodes") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &episodeVariant, response.value("result").toMap().value("episodes").toList()) {
+        foreach (const QVariant &episodeVariant, entries) {
             QVariantMap episode = episodeVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << episode;
             BrowserItem item("episode:" + episode.value("episodeid").toString(), episode.value("label").toString());
             item.setExecutable(true);
             item.setIcon(BrowserItem::BrowserIconVideo);
@@ -923,10 +1136,8 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     }
 
     if (method == "VideoLibrary.GetMusicVideos") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &musicVideoVariant, response.value("result").toMap().value("musicvideos").toList()) {
+        foreach (const QVariant &musicVideoVariant, entries) {
             QVariantMap musicVideo = musicVideoVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << musicVideo;
             BrowserItem item("musicvideo:" + musicVideo.value("musicvideoid").toString(), musicVideo.value("label").toString());
             item.setExecutable(true);
             item.setIcon(BrowserItem::BrowserIconVideo);
@@ -937,92 +1148,7 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
         return;
     }
 
-    if (method == "Addons.GetAddons") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &addonVariant, response.value("result").toMap().value("addons").toList()) {
-            QVariantMap addon = addonVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << addon;
-            BrowserItem item("addon:" + addon.value("addonid").toString(), addon.value("name").toString());
-            item.setBrowsable(true);
-            item.setIcon(BrowserItem::BrowserIconApplication);
-            item.setThumbnail(prepareThumbnail(addon.value("thumbnail").toString()));
-            result->addItem(item);
-        }
-        result->finish(Thing::ThingErrorNoError);
-        return;
-    }
-
-    if (method == "Files.GetDirectory") {
-        BrowseResult *result = m_pendingBrowseRequests.take(id);
-        foreach (const QVariant &fileVariant, response.value("result").toMap().value("files").toList()) {
-            QVariantMap file = fileVariant.toMap();
-            qCDebug(dcKodi()) << "Entry:" << file;
-            BrowserItem item("file:" + file.value("file").toString(), file.value("label").toString());
-            if (file.value("type").toString() == "directory" || file.value("type").toString() == "unknown") {
-                item.setBrowsable(true);
-                item.setIcon(BrowserItem::BrowserIconFolder);
-            } else if (file.value("type").toString() == "episode" || file.value("type").toString() == "movie") {
-                item.setExecutable(true);
-                item.setIcon(BrowserItem::BrowserIconVideo);
-            } else if (file.value("type").toString() == "song") {
-                item.setExecutable(true);
-                item.setIcon(BrowserItem::BrowserIconMusic);
-            }
-            item.setThumbnail(prepareThumbnail(file.value("thumbnail").toString()));
-            result->addItem(item);
-        }
-        result->finish(Thing::ThingErrorNoError);
-        return;
-    }
-
-    if (method == "AudioLibrary.GetSongDetails") {
-        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
-        BrowserItem item("song:" + response.value("result").toMap().value("songdetails").toMap().value("songid").toString());
-        item.setDisplayName(response.value("result").toMap().value("songdetails").toMap().value("label").toString());
-        qCDebug(dcKodi()) << "Song details:" << item.displayName();
-        result->finish(item);
-        return;
-    }
-
-    if (method == "VideoLibrary.GetMovieDetails") {
-        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
-        BrowserItem item("movie:" + response.value("result").toMap().value("moviedetails").toMap().value("movieid").toString());
-        item.setDisplayName(response.value("result").toMap().value("moviedetails").toMap().value("label").toString());
-        qCDebug(dcKodi()) << "Movie details:" << item.displayName();
-        result->finish(item);
-        return;
-    }
-
-    if (method == "VideoLibrary.GetEpisodeDetails") {
-        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
-        BrowserItem item("movie:" + response.value("result").toMap().value("episodedetails").toMap().value("episodeid").toString());
-        item.setDisplayName(response.value("result").toMap().value("episodedetails").toMap().value("label").toString());
-        qCDebug(dcKodi()) << "Episode details:" << item.displayName();
-        result->finish(item);
-        return;
-    }
-
-    if (method == "VideoLibrary.GetMusicVideoDetails") {
-        BrowserItemResult *result = m_pendingBrowserItemRequests.take(id);
-        BrowserItem item("movie:" + response.value("result").toMap().value("musicvideodetails").toMap().value("musicvideoid").toString());
-        item.setDisplayName(response.value("result").toMap().value("musicvideodetails").toMap().value("label").toString());
-        qCDebug(dcKodi()) << "Episode details:" << item.displayName();
-        result->finish(item);
-        return;
-    }
-
-    if (method == "VideoLibrary.Scan" || method == "VideoLibrary.Clean" || method == "AudioLibrary.Scan" || method == "AudioLibrary.Clean") {
-        emit browserItemActionExecuted(id, !response.contains("error"));
-        return;
-    }
-
-    if (method == "Player.Open") {
-        emit browserItemExecuted(id, !response.contains("error"));
-        return;
-    }
-
-    // Default
-    emit actionExecuted(id, !response.contains("error"));
+    result->finish(Thing::ThingErrorItemNotFound);
 }
 
 void Kodi::updatePlayerProperties()
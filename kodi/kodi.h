@@ -33,9 +33,11 @@
 
 #include <QObject>
 #include <QHostAddress>
+#include <QPointer>
 
 #include "kodiconnection.h"
 #include "kodijsonhandler.h"
+#include "kodilibrarycache.h"
 
 #include "types/browseritem.h"
 #include "types/browseritemaction.h"
@@ -62,6 +64,9 @@ public:
 
     bool connected() const;
 
+    // Empty file name keeps the library cache in memory only
+    void setLibrarySnapshotFile(const QString &fileName);
+
     // propertys
     int setMuted(const bool &muted);
     bool muted() const;
@@ -119,6 +124,11 @@ private slots:
 private:
     QString prepareThumbnail(const QString &thumbnail);
 
+    void browseLibrary(BrowseResult *result, const QString &method, const QVariantMap &params);
+    void requestLibraryPage(const QString &key, int start);
+    void processLibraryPage(int id, const QString &method, const QVariantMap &response);
+    void addLibraryItems(BrowseResult *result, const QString &method, const QVariantList &entries);
+
 private:
     KodiConnection *m_connection;
     int m_httpPort;
@@ -151,6 +161,20 @@ private:
     QHash<int, BrowseResult*> m_pendingBrowseRequests;
     QHash<int, BrowserItemResult*> m_pendingBrowserItemRequests;
 
+    // Library lists are fetched in pages and merged before being cached.
+    // Concurrent browse requests for the same list share one fetch.
+    class LibraryFetch {
+    public:
+        QString method;
+        QVariantMap params;
+        QVariantList entries;
+        quint64 generation = 0;
+        QList<QPointer<BrowseResult>> results;
+    };
+    KodiLibraryCache *m_libraryCache = nullptr;
+    QHash<QString, LibraryFetch> m_libraryFetches;
+    QHash<int, QString> m_pendingLibraryPages;
+
 };
 
 #endif // KODI_H
@@ -9,6 +9,7 @@ SOURCES += \
     kodiconnection.cpp \
     kodijsonhandler.cpp \
     kodi.cpp \
+    kodilibrarycache.cpp \
     kodireply.cpp
 
 HEADERS += \
@@ -16,5 +17,6 @@ HEADERS += \
     kodiconnection.h \
     kodijsonhandler.h \
     kodi.h \
+    kodilibrarycache.h \
     kodireply.h
 
@@ -99,6 +99,7 @@ void KodiConnection::onDisconnected()
 {
     qCDebug(dcKodi) << "disconnected from" << hostAddress().toString() << port();
     m_connected = false;
+    resetFraming();
     emit connectionStatusChanged();
 }
 
@@ -111,22 +112,70 @@ void KodiConnection::onError(QAbstractSocket::SocketError socketError)
 
 void KodiConnection::readData()
 {
-    QByteArray data = m_socket->readAll();
-
-    QStringList commandList = QString(data).split("}{");
-    for(int i = 0; i < commandList.count(); ++i) {
-        QString command = commandList.at(i);
-        if(command.isEmpty()) {
+    m_buffer.append(m_socket->readAll());
+
+    // Kodi sends the JSON messages back to back without any separator. Track the nesting depth,
+    // skipping braces within strings, and emit each message as soon as its outermost object closes.
+    // Only the newly received bytes are scanned, the state of an incomplete message is kept.
+    int messageStart = 0;
+    const char *data = m_buffer.constData();
+    for (int i = m_scanPosition; i < m_buffer.size(); i++) {
+        const char c = data[i];
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
             continue;
         }
-        if(i < commandList.count() - 1) {
-            command.append("}");
-        }
-        if(i > 0) {
-            command.prepend("{");
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            break;
+        case '{':
+        case '[':
+            if (m_depth == 0)
+                messageStart = i;
+            m_depth++;
+            break;
+        case '}':
+        case ']':
+            if (m_depth == 0) {
+                qCWarning(dcKodi()) << "Unexpected closing bracket in data stream, skipping it";
+                messageStart = i + 1;
+                break;
+            }
+            m_depth--;
+            if (m_depth == 0) {
+                // The receivers handle the data synchronously, no need to copy it out of the buffer
+                emit dataReady(QByteArray::fromRawData(data + messageStart, i - messageStart + 1));
+                messageStart = i + 1;
+            }
+            break;
+        default:
+            // Whitespace between messages
+            if (m_depth == 0)
+                messageStart = i + 1;
+            break;
         }
-        emit dataReady(command.toUtf8());
     }
+
+    // Drop everything consumed, keep the incomplete message
+    m_buffer.remove(0, messageStart);
+    m_scanPosition = m_buffer.size();
+}
+
+void KodiConnection::resetFraming()
+{
+    m_buffer.clear();
+    m_scanPosition = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
 }
 
 void KodiConnection::sendData(const QByteArray &message)
@@ -60,6 +60,15 @@ private:
     int m_port;
     bool m_connected;
 
+    // Incremental JSON framing state, kept across reads
+    QByteArray m_buffer;
+    int m_scanPosition = 0;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escaped = false;
+
+    void resetFraming();
+
 private slots:
     void onConnected();
     void onDisconnected();
@@ -0,0 +1,399 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "kodilibrarycache.h"
+#include "extern-plugininfo.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Snapshot entries older than this are dropped when loading, Kodi might have changed meanwhile
+static const qint64 snapshotMaxAge = 24 * 60 * 60;
+
+struct LibraryMethod {
+    const char *method;
+    const char *listKey;
+    const char *type;
+    const char *idField;
+};
+
+static const LibraryMethod libraryMethods[] = {
+    { "VideoLibrary.GetMovies", "movies", "movie", "movieid" },
+    { "VideoLibrary.GetTVShows", "tvshows", "tvshow", "tvshowid" },
+    { "VideoLibrary.GetSeasons", "seasons", "season", "seasonid" },
+    { "VideoLibrary.GetEpisodes", "episodes", "episode", "episodeid" },
+    { "VideoLibrary.GetMusicVideos", "musicvideos", "musicvideo", "musicvideoid" },
+    { "AudioLibrary.GetArtists", "artists", "artist", "artistid" },
+    { "AudioLibrary.GetAlbums", "albums", "album", "albumid" },
+    { "AudioLibrary.GetSongs", "songs", "song", "songid" }
+};
+
+static const LibraryMethod *findLibraryMethod(const QString &method)
+{
+    for (const LibraryMethod &libraryMethod : libraryMethods) {
+        if (method == QLatin1String(libraryMethod.method)) {
+            return &libraryMethod;
+        }
+    }
+    return nullptr;
+}
+
+// Lists which may change when an item of the given type is added to the library
+static QStringList affectedMethods(const QString &type)
+{
+    if (type == "movie")
+        return { "VideoLibrary.GetMovies" };
+    if (type == "tvshow")
+        return { "VideoLibrary.GetTVShows" };
+    if (type == "season")
+        return { "VideoLibrary.GetSeasons", "VideoLibrary.GetTVShows" };
+    if (type == "episode")
+        return { "VideoLibrary.GetEpisodes", "VideoLibrary.GetSeasons", "VideoLibrary.GetTVShows" };
+    if (type == "musicvideo")
+        return { "VideoLibrary.GetMusicVideos" };
+    if (type == "artist")
+        return { "AudioLibrary.GetArtists" };
+    if (type == "album")
+        return { "AudioLibrary.GetAlbums", "AudioLibrary.GetArtists" };
+    if (type == "song")
+        return { "AudioLibrary.GetSongs", "AudioLibrary.GetAlbums", "AudioLibrary.GetArtists" };
+    return QStringList();
+}
+
+KodiLibraryCache::KodiLibraryCache(QObject *parent) :
+    QObject(parent)
+{
+    m_snapshotTimer.setSingleShot(true);
+    m_snapshotTimer.setInterval(10000);
+    connect(&m_snapshotTimer, &QTimer::timeout, this, &KodiLibraryCache::saveSnapshot);
+}
+
+KodiLibraryCache::~KodiLibraryCache()
+{
+    if (m_snapshotTimer.isActive()) {
+        saveSnapshot();
+    }
+}
+
+bool KodiLibraryCache::isLibraryMethod(const QString &method)
+{
+    return findLibraryMethod(method) != nullptr;
+}
+
+QString KodiLibraryCache::listKey(const QString &method)
+{
+    const LibraryMethod *libraryMethod = findLibraryMethod(method);
+    return libraryMethod ? QString(libraryMethod->listKey) : QString();
+}
+
+QString KodiLibraryCache::cacheKey(const QString &method, const QVariantMap &params)
+{
+    // QJsonObject sorts its keys, so equal params always give the same key
+    return method + QJsonDocument(QJsonObject::fromVariantMap(params)).toJson(QJsonDocument::Compact);
+}
+
+QString KodiLibraryCache::snapshotFile() const
+{
+    return m_snapshotFile;
+}
+
+void KodiLibraryCache::setSnapshotFile(const QString &snapshotFile)
+{
+    if (m_snapshotFile == snapshotFile) {
+        return;
+    }
+
+    if (snapshotFile.isEmpty()) {
+        m_snapshotTimer.stop();
+        QFile::remove(m_snapshotFile);
+        m_snapshotFile.clear();
+        return;
+    }
+
+    m_snapshotFile = snapshotFile;
+    if (m_entries.isEmpty()) {
+        loadSnapshot();
+    } else {
+        scheduleSnapshot();
+    }
+}
+
+quint64 KodiLibraryCache::generation() const
+{
+    return m_generation;
+}
+
+bool KodiLibraryCache::contains(const QString &key) const
+{
+    return m_entries.contains(key);
+}
+
+QVariantList KodiLibraryCache::entries(const QString &key) const
+{
+    return m_entries.value(key).entries;
+}
+
+void KodiLibraryCache::insert(const QString &key, const QString &method, const QVariantList &entries)
+{
+    removeEntry(key);
+
+    Entry entry;
+    entry.method = method;
+    entry.entries = entries;
+    entry.timestamp = QDateTime::currentDateTime();
+    m_entries.insert(key, entry);
+    indexEntry(key);
+
+    qCDebug(dcKodi()) << "Library cache: stored" << entries.count() << "items for" << method;
+    scheduleSnapshot();
+}
+
+QVariantMap KodiLibraryCache::findItem(const QString &type, int id) const
+{
+    QString itemKey = type + ':' + QString::number(id);
+    foreach (const QString &key, m_itemIndex.value(itemKey)) {
+        const Entry &entry = m_entries[key];
+        const LibraryMethod *libraryMethod = findLibraryMethod(entry.method);
+        foreach (const QVariant &itemVariant, entry.entries) {
+            QVariantMap item = itemVariant.toMap();
+            if (item.value(libraryMethod->idField).toInt() == id) {
+                return item;
+            }
+        }
+    }
+    return QVariantMap();
+}
+
+void KodiLibraryCache::itemUpdated(const QString &type, int id, bool added)
+{
+    m_generation++;
+
+    if (added) {
+        qCDebug(dcKodi()) << "Library cache: new" << type << id << "added, invalidating affected lists";
+        removeMethods(affectedMethods(type));
+        return;
+    }
+
+    // Drop only the lists which actually show this item, they will be fetched again on the next browse
+    QStringList keys = m_itemIndex.value(type + ':' + QString::number(id));
+    foreach (const QString &key, keys) {
+        removeEntry(key);
+    }
+    if (!keys.isEmpty()) {
+        qCDebug(dcKodi()) << "Library cache:" << type << id << "updated, invalidated" << keys.count() << "lists";
+        scheduleSnapshot();
+    }
+}
+
+void KodiLibraryCache::itemRemoved(const QString &type, int id)
+{
+    m_generation++;
+
+    // The item is gone, no need to fetch anything again. Just remove it from the cached lists.
+    QString itemKey = type + ':' + QString::number(id);
+    QStringList keys = m_itemIndex.take(itemKey);
+    foreach (const QString &key, keys) {
+        Entry &entry = m_entries[key];
+        const LibraryMethod *libraryMethod = findLibraryMethod(entry.method);
+        for (int i = entry.entries.count() - 1; i >= 0; i--) {
+            if (entry.entries.at(i).toMap().value(libraryMethod->idField).toInt() == id) {
+                entry.entries.removeAt(i);
+            }
+        }
+    }
+    if (!keys.isEmpty()) {
+        qCDebug(dcKodi()) << "Library cache: removed" << type << id << "from" << keys.count() << "lists";
+        scheduleSnapshot();
+    }
+}
+
+void KodiLibraryCache::invalidateLibrary(const QString &library)
+{
+    m_generation++;
+
+    QStringList methods;
+    for (const LibraryMethod &libraryMethod : libraryMethods) {
+        if (QString(libraryMethod.method).startsWith(library + '.')) {
+            methods.append(libraryMethod.method);
+        }
+    }
+    qCDebug(dcKodi()) << "Library cache: invalidating" << library;
+    removeMethods(methods);
+}
+
+void KodiLibraryCache::clear()
+{
+    m_generation++;
+    m_entries.clear();
+    m_itemIndex.clear();
+    scheduleSnapshot();
+}
+
+void KodiLibraryCache::indexEntry(const QString &key)
+{
+    const Entry &entry = m_entries[key];
+    const LibraryMethod *libraryMethod = findLibraryMethod(entry.method);
+    if (!libraryMethod) {
+        return;
+    }
+
+    QString prefix = QString(libraryMethod->type) + ':';
+    foreach (const QVariant &itemVariant, entry.entries) {
+        QVariant id = itemVariant.toMap().value(libraryMethod->idField);
+        if (!id.isValid()) {
+            continue;
+        }
+        QStringList &keys = m_itemIndex[prefix + id.toString()];
+        if (!keys.contains(key)) {
+            keys.append(key);
+        }
+    }
+}
+
+void KodiLibraryCache::unindexEntry(const QString &key)
+{
+    const Entry &entry = m_entries[key];
+    const LibraryMethod *libraryMethod = findLibraryMethod(entry.method);
+    if (!libraryMethod) {
+        return;
+    }
+
+    QString prefix = QString(libraryMethod->type) + ':';
+    foreach (const QVariant &itemVariant, entry.entries) {
+        QString itemKey = prefix + itemVariant.toMap().value(libraryMethod->idField).toString();
+        QHash<QString, QStringList>::iterator it = m_itemIndex.find(itemKey);
+        if (it == m_itemIndex.end()) {
+            continue;
+        }
+        it.value().removeAll(key);
+        if (it.value().isEmpty()) {
+            m_itemIndex.erase(it);
+        }
+    }
+}
+
+void KodiLibraryCache::removeEntry(const QString &key)
+{
+    if (!m_entries.contains(key)) {
+        return;
+    }
+    unindexEntry(key);
+    m_entries.remove(key);
+}
+
+void KodiLibraryCache::removeMethods(const QStringList &methods)
+{
+    QStringList keys;
+    for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (methods.contains(it.value().method)) {
+            keys.append(it.key());
+        }
+    }
+    foreach (const QString &key, keys) {
+        removeEntry(key);
+    }
+    if (!keys.isEmpty()) {
+        scheduleSnapshot();
+    }
+}
+
+void KodiLibraryCache::scheduleSnapshot()
+{
+    // Library scans may send lots of notifications, don't write the file for each of them
+    if (!m_snapshotFile.isEmpty() && !m_snapshotTimer.isActive()) {
+        m_snapshotTimer.start();
+    }
+}
+
+void KodiLibraryCache::loadSnapshot()
+{
+    QFile file(m_snapshotFile);
+    if (!file.exists()) {
+        return;
+    }
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(dcKodi()) << "Library cache: cannot open snapshot" << m_snapshotFile << file.errorString();
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcKodi()) << "Library cache: discarding invalid snapshot" << m_snapshotFile << error.errorString();
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    foreach (const QVariant &entryVariant, jsonDoc.toVariant().toMap().value("entries").toList()) {
+        QVariantMap entryMap = entryVariant.toMap();
+        Entry entry;
+        entry.method = entryMap.value("method").toString();
+        entry.entries = entryMap.value("entries").toList();
+        entry.timestamp = QDateTime::fromMSecsSinceEpoch(entryMap.value("timestamp").toLongLong());
+        if (!isLibraryMethod(entry.method) || entry.timestamp.secsTo(now) > snapshotMaxAge) {
+            continue;
+        }
+        QString key = entryMap.value("key").toString();
+        m_entries.insert(key, entry);
+        indexEntry(key);
+    }
+    qCDebug(dcKodi()) << "Library cache: loaded" << m_entries.count() << "lists from" << m_snapshotFile;
+}
+
+void KodiLibraryCache::saveSnapshot()
+{
+    if (m_snapshotFile.isEmpty()) {
+        return;
+    }
+
+    QVariantList entries;
+    for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QVariantMap entryMap;
+        entryMap.insert("key", it.key());
+        entryMap.insert("method", it.value().method);
+        entryMap.insert("timestamp", it.value().timestamp.toMSecsSinceEpoch());
+        entryMap.insert("entries", it.value().entries);
+        entries.append(entryMap);
+    }
+    QVariantMap snapshot;
+    snapshot.insert("entries", entries);
+
+    QSaveFile file(m_snapshotFile);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(dcKodi()) << "Library cache: cannot write snapshot" << m_snapshotFile << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument::fromVariant(snapshot).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(dcKodi()) << "Library cache: failed to store snapshot" << m_snapshotFile << file.errorString();
+    }
+}
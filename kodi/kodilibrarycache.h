@@ -0,0 +1,101 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef KODILIBRARYCACHE_H
+#define KODILIBRARYCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QDateTime>
+#include <QStringList>
+#include <QVariantMap>
+
+// Caches the item lists of the Kodi library queries (VideoLibrary.GetMovies, AudioLibrary.GetSongs...)
+// so browsing a folder a second time doesn't require to transfer the whole library again.
+// Entries are invalidated selectively from the library notifications sent by Kodi.
+class KodiLibraryCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KodiLibraryCache(QObject *parent = nullptr);
+    ~KodiLibraryCache();
+
+    static bool isLibraryMethod(const QString &method);
+    static QString listKey(const QString &method);
+    static QString cacheKey(const QString &method, const QVariantMap &params);
+
+    // Empty file name disables the on-disk snapshot
+    QString snapshotFile() const;
+    void setSnapshotFile(const QString &snapshotFile);
+
+    // Increased on every invalidation. Fetches started with an older generation must not be cached.
+    quint64 generation() const;
+
+    bool contains(const QString &key) const;
+    QVariantList entries(const QString &key) const;
+    void insert(const QString &key, const QString &method, const QVariantList &entries);
+
+    // Returns the cached entry for e.g. type "movie" and id 42, if any cached list contains it
+    QVariantMap findItem(const QString &type, int id) const;
+
+    void itemUpdated(const QString &type, int id, bool added);
+    void itemRemoved(const QString &type, int id);
+    void invalidateLibrary(const QString &library);
+    void clear();
+
+private:
+    class Entry {
+    public:
+        QString method;
+        QVariantList entries;
+        QDateTime timestamp;
+    };
+
+    QHash<QString, Entry> m_entries;
+    // "movie:42" -> cache keys of the lists containing that item
+    QHash<QString, QStringList> m_itemIndex;
+    quint64 m_generation = 0;
+
+    QString m_snapshotFile;
+    QTimer m_snapshotTimer;
+
+    void indexEntry(const QString &key);
+    void unindexEntry(const QString &key);
+    void removeEntry(const QString &key);
+    void removeMethods(const QStringList &methods);
+    void scheduleSnapshot();
+    void loadSnapshot();
+
+private slots:
+    void saveSnapshot();
+};
+
+#endif // KODILIBRARYCACHE_H
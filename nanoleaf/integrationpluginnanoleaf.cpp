@@ -176,6 +176,8 @@ void IntegrationPluginNanoleaf::thingRemoved(Thing *thing)
     if(thing->thingClassId() == lightPanelsThingClassId) {
         Nanoleaf *nanoleaf = m_nanoleafConnections.take(thing->id());
         nanoleaf->deleteLater();
+        m_selectedEffects.remove(thing->id());
+        m_effectsBeforeExternalControl.remove(thing->id());
     }
 
     if (myThings().isEmpty()) {
@@ -223,6 +225,58 @@ void IntegrationPluginNanoleaf::executeAction(ThingActionInfo *info)
             QUuid requestId = nanoleaf->identify();
             connect(info, &ThingActionInfo::aborted,[requestId, this](){m_asyncActions.remove(requestId);});
             m_asyncActions.insert(requestId, info);
+        } else if (action.actionTypeId() == lightPanelsExternalControlActionTypeId) {
+            bool externalControl = action.param(lightPanelsExternalControlActionExternalControlParamTypeId).value().toBool();
+            QUuid requestId;
+            if (externalControl) {
+                m_effectsBeforeExternalControl.insert(thing->id(), m_selectedEffects.value(thing->id()));
+                requestId = nanoleaf->startExternalControl();
+            } else {
+                // Leave the external control mode by restoring the previous effect or the last color
+                nanoleaf->stopExternalControl();
+                QString effect = m_effectsBeforeExternalControl.take(thing->id());
+                if (effect.isEmpty() || effect.startsWith('*')) {
+                    requestId = nanoleaf->setColor(QColor(thing->stateValue(lightPanelsColorStateTypeId).toString()));
+                } else {
+                    requestId = nanoleaf->setEffect(effect);
+                }
+            }
+            connect(info, &ThingActionInfo::aborted,[requestId, this](){m_asyncActions.remove(requestId);});
+            m_asyncActions.insert(requestId, info);
+        } else if (action.actionTypeId() == lightPanelsSetPanelColorActionTypeId) {
+            if (!nanoleaf->externalControlActive()) {
+                return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("External control is not enabled."));
+            }
+            int panelId = action.param(lightPanelsSetPanelColorActionPanelIdParamTypeId).value().toInt();
+            QColor color(action.param(lightPanelsSetPanelColorActionColorParamTypeId).value().toString());
+            int transitionTime = action.param(lightPanelsSetPanelColorActionTransitionTimeParamTypeId).value().toInt();
+            nanoleaf->setPanelColor(panelId, color, qRound(transitionTime / 100.0));
+            info->finish(Thing::ThingErrorNoError);
+        } else if (action.actionTypeId() == lightPanelsSetPanelColorsActionTypeId) {
+            if (!nanoleaf->externalControlActive()) {
+                return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("External control is not enabled."));
+            }
+            // A whole frame, given as comma separated "panelId:color" pairs
+            int transitionTime = qRound(action.param(lightPanelsSetPanelColorsActionTransitionTimeParamTypeId).value().toInt() / 100.0);
+            QList<Nanoleaf::PanelColor> panelColors;
+            foreach (const QString &entry, action.param(lightPanelsSetPanelColorsActionPanelColorsParamTypeId).value().toString().split(',')) {
+                if (entry.trimmed().isEmpty())
+                    continue;
+
+                QStringList parts = entry.trimmed().split(':');
+                bool ok = false;
+                Nanoleaf::PanelColor panelColor;
+                panelColor.panelId = parts.first().toInt(&ok);
+                panelColor.color = QColor(parts.last().trimmed());
+                panelColor.transitionTime = transitionTime;
+                if (parts.count() != 2 || !ok || !panelColor.color.isValid()) {
+                    qCWarning(dcNanoleaf()) << "Invalid panel color" << entry;
+                    return info->finish(Thing::ThingErrorInvalidParameter, QT_TR_NOOP("The panel colors must be given as comma separated \"panel ID:color\" pairs."));
+                }
+                panelColors.append(panelColor);
+            }
+            nanoleaf->setPanelColors(panelColors);
+            info->finish(Thing::ThingErrorNoError);
         }
     }
 }
@@ -268,6 +322,8 @@ Nanoleaf *IntegrationPluginNanoleaf::createNanoleafConnection(const QHostAddress
     connect(nanoleaf, &Nanoleaf::colorTemperatureReceived, this, &IntegrationPluginNanoleaf::onColorTemperatureReceived);
     connect(nanoleaf, &Nanoleaf::effectListReceived, this, &IntegrationPluginNanoleaf::onEffectListReceived);
     connect(nanoleaf, &Nanoleaf::selectedEffectReceived, this, &IntegrationPluginNanoleaf::onSelectedEffectReceived);
+    connect(nanoleaf, &Nanoleaf::panelLayoutReceived, this, &IntegrationPluginNanoleaf::onPanelLayoutReceived);
+    connect(nanoleaf, &Nanoleaf::externalControlChanged, this, &IntegrationPluginNanoleaf::onExternalControlChanged);
     return nanoleaf;
 }
 
@@ -489,6 +545,30 @@ void IntegrationPluginNanoleaf::onSelectedEffectReceived(const QString &effect)
     if (!thing)
         return;
     //qCDebug(dcNanoleaf()) << "Selected effect received" << effect;
+    m_selectedEffects.insert(thing->id(), QString(effect).remove('"'));
     thing->setStateValue(lightPanelsEffectNameStateTypeId, QString(effect).remove('"').remove('*'));
 }
 
+void IntegrationPluginNanoleaf::onPanelLayoutReceived(const QList<int> &panelIds)
+{
+    Nanoleaf *nanoleaf = static_cast<Nanoleaf *>(sender());
+    Thing *thing = myThings().findById(m_nanoleafConnections.key(nanoleaf));
+    if (!thing)
+        return;
+    QStringList ids;
+    foreach (int panelId, panelIds) {
+        ids.append(QString::number(panelId));
+    }
+    thing->setStateValue(lightPanelsPanelIdsStateTypeId, ids.join(", "));
+}
+
+void IntegrationPluginNanoleaf::onExternalControlChanged(bool active)
+{
+    Nanoleaf *nanoleaf = static_cast<Nanoleaf *>(sender());
+    Thing *thing = myThings().findById(m_nanoleafConnections.key(nanoleaf));
+    if (!thing)
+        return;
+    qCDebug(dcNanoleaf()) << "External control" << (active ? "enabled" : "disabled") << "for" << thing->name();
+    thing->setStateValue(lightPanelsExternalControlStateTypeId, active);
+}
+
@@ -71,6 +71,8 @@ private:
     QHash<QUuid, ThingActionInfo *> m_asyncActions;
     QHash<Nanoleaf *, ThingPairingInfo *> m_unfinishedPairing;
     QHash<Nanoleaf *, ThingSetupInfo *> m_asyncDeviceSetup;
+    QHash<ThingId, QString> m_selectedEffects;
+    QHash<ThingId, QString> m_effectsBeforeExternalControl;
 
     QHash<Nanoleaf *, BrowseResult *> m_asyncBrowseResults;
     QHash<QUuid, BrowserActionInfo *> m_asyncBrowserItem;
@@ -95,6 +97,8 @@ public slots:
     void onEffectListReceived(const QStringList &effects);
     void onColorTemperatureReceived(int kelvin);
     void onSelectedEffectReceived(const QString &effect);
+    void onPanelLayoutReceived(const QList<int> &panelIds);
+    void onExternalControlChanged(bool active);
 };
 
 #endif // INTEGRATIONPLUGINNANOLEAF_H
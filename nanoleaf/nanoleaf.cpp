@@ -35,6 +35,10 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QUrlQuery>
+#include <QDataStream>
+
+static const quint16 externalControlPort = 60222;
+static const int frameInterval = 100;
 
 Nanoleaf::Nanoleaf(NetworkAccessManager *networkManager, const QHostAddress &address, int port, QObject *parent) :
     QObject(parent),
@@ -42,7 +46,30 @@ Nanoleaf::Nanoleaf(NetworkAccessManager *networkManager, const QHostAddress &add
     m_address(address),
     m_port(port)
 {
+    m_eventStreamReconnectTimer = new QTimer(this);
+    m_eventStreamReconnectTimer->setSingleShot(true);
+    connect(m_eventStreamReconnectTimer, &QTimer::timeout, this, &Nanoleaf::registerForEvents);
+
+    m_udpSocket = new QUdpSocket(this);
+
+    // Send the panel colors set in between as one frame at a fixed rate, stop once nothing is pending any more
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setInterval(frameInterval);
+    connect(m_frameTimer, &QTimer::timeout, this, [this] {
+        if (m_pendingFrame.isEmpty()) {
+            m_frameTimer->stop();
+            return;
+        }
+        flushFrame();
+    });
+}
 
+Nanoleaf::~Nanoleaf()
+{
+    if (m_eventStreamReply) {
+        m_eventStreamReply->disconnect(this);
+        m_eventStreamReply->abort();
+    }
 }
 
 void Nanoleaf::setIpAddress(const QHostAddress &address)
@@ -219,8 +246,12 @@ void Nanoleaf::getControllerInfo()
         }
 
         if (map.contains("panelLayout")) {
-            //QVariantMap panelLayout = map.value("panelLayout").toMap();
-            //emit panelLayoutReceived();
+            QVariantMap layout = map.value("panelLayout").toMap().value("layout").toMap();
+            QList<int> panelIds;
+            foreach (const QVariant &panel, layout.value("positionData").toList()) {
+                panelIds.append(panel.toMap().value("panelId").toInt());
+            }
+            emit panelLayoutReceived(panelIds);
         }
 
         if (map.contains("rhythm")) {
@@ -431,6 +462,12 @@ void Nanoleaf::getColorMode()
 
 void Nanoleaf::registerForEvents()
 {
+    if (m_eventStreamReply) {
+        qCDebug(dcNanoleaf()) << "Already registered for events";
+        return;
+    }
+    m_eventStreamReconnectTimer->stop();
+
     QUrl url;
     url.setHost(m_address.toString());
     url.setPort(m_port);
@@ -441,71 +478,37 @@ void Nanoleaf::registerForEvents()
     url.setQuery(query);
     QNetworkRequest request;
     request.setUrl(url);
+    request.setRawHeader("Accept", "text/event-stream");
+    m_eventStreamParser.reset();
     QNetworkReply *reply = m_networkManager->get(request);
+    m_eventStreamReply = reply;
 
     connect(reply, &QNetworkReply::readyRead, this, [reply, this] {
-        QJsonParseError error;
-        QJsonDocument data = QJsonDocument::fromJson(reply->readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
-            qDebug(dcNanoleaf()) << "Recieved invalide JSON object";
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status < 200 || status > 204)
             return;
+
+        foreach (const EventStreamParser::Event &event, m_eventStreamParser.parse(reply->readAll())) {
+            processStreamEvent(event);
+        }
+
+        if (m_eventStreamParser.overflowed()) {
+            qCWarning(dcNanoleaf()) << "Event stream sent an oversized event, reconnecting";
+            reply->abort();
         }
-        qCDebug(dcNanoleaf()) << "On event stream" << data.toJson();
     });
     connect(reply, &QNetworkReply::finished, this, [reply, this] {
         reply->deleteLater();
+        m_eventStreamReply = nullptr;
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
         if (status < 200 || status > 204 || reply->error() != QNetworkReply::NoError) {
-            qCWarning(dcNanoleaf()) << "Request error:" << status << reply->errorString();
+            qCWarning(dcNanoleaf()) << "Event stream error:" << status << reply->errorString();
             emit connectionChanged(false);
-            return;
-        }
-        QJsonParseError error;
-        QJsonDocument data = QJsonDocument::fromJson(reply->readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
-            qDebug(dcNanoleaf()) << "Recieved invalide JSON object";
-            return;
-        }
-        qCDebug(dcNanoleaf()) << "Event received" << data.toJson();
-        QVariantList events = data.toVariant().toList();
-
-        foreach (QVariant variant, events) {
-            QVariantMap event = variant.toMap();
-            switch (event["attr"].toInt()) {
-            case 1:  //ON
-                emit powerReceived(event["value"].toBool());
-                break;
-            case 2:  //Brightness
-                emit brightnessReceived(event["value"].toInt());
-                break;
-            case 3: //Hue
-                emit hueReceived(event["value"].toInt());
-                break;
-            case 4: //Saturation
-                emit saturationReceived(event["value"].toInt());
-                break;
-            case 5: //Color Temperature
-                emit colorTemperatureReceived(event["value"].toInt());
-                break;
-            case 6: { //colorMode
-                QString colorModeString = event["value"].toString();
-                if (colorModeString == "effect") {
-                    emit colorModeReceived(ColorMode::EffectMode);
-                } else if (colorModeString == "hs") {
-                    emit colorModeReceived(ColorMode::HueSaturationMode);
-                } else if (colorModeString == "ct") {
-                    emit colorModeReceived(ColorMode::ColorTemperatureMode);
-                } else {
-                    qCWarning(dcNanoleaf()) << "Unrecognized color mode";
-                }
-                break;
-            }
-            default:
-                qCWarning(dcNanoleaf()) << "Unrecognised Event received";
-            }
-
         }
+        int reconnectTime = m_eventStreamParser.retryInterval() > 0 ? m_eventStreamParser.retryInterval() : 5000;
+        qCDebug(dcNanoleaf()) << "Event stream closed, reconnecting in" << reconnectTime/1000 << "seconds";
+        m_eventStreamReconnectTimer->start(reconnectTime);
     });
 }
 
@@ -824,5 +827,205 @@ QUuid Nanoleaf::identify()
     return requestId;
 }
 
+QUuid Nanoleaf::startExternalControl()
+{
+    QUuid requestId = QUuid::createUuid();
+    QUrl url;
+    url.setHost(m_address.toString());
+    url.setPort(m_port);
+    url.setScheme("http");
+    url.setPath(QString("/api/v1/%1/effects").arg(m_authToken));
+
+    QVariantMap write;
+    write.insert("command", "display");
+    write.insert("animType", "extControl");
+    write.insert("extControlVersion", "v2");
+    QVariantMap map;
+    map.insert("write", write);
+    QJsonDocument body = QJsonDocument::fromVariant(map);
+
+    QNetworkRequest request;
+    request.setUrl(url);
+    request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
+    QNetworkReply *reply = m_networkManager->put(request, body.toJson());
+    qDebug(dcNanoleaf()) << "Sending request" << request.url();
+    connect(reply, &QNetworkReply::finished, this, [requestId, reply, this] {
+        reply->deleteLater();
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        if (status < 200 || status > 204 || reply->error() != QNetworkReply::NoError) {
+            emit requestExecuted(requestId, false);
+            qCWarning(dcNanoleaf()) << "Request error:" << status << reply->errorString();
+            return;
+        }
+        setExternalControlActive(true);
+        emit requestExecuted(requestId, true);
+    });
+    return requestId;
+}
+
+void Nanoleaf::stopExternalControl()
+{
+    // The device leaves the external control mode as soon as another effect or color is selected
+    setExternalControlActive(false);
+}
+
+bool Nanoleaf::externalControlActive()
+{
+    return m_externalControl;
+}
+
+void Nanoleaf::setPanelColor(int panelId, const QColor &color, int transitionTime)
+{
+    PanelColor panelColor;
+    panelColor.panelId = panelId;
+    panelColor.color = color;
+    panelColor.transitionTime = transitionTime;
+    queuePanelColor(panelColor);
+
+    if (!m_frameTimer->isActive()) {
+        m_frameTimer->start();
+    }
+}
+
+void Nanoleaf::setPanelColors(const QList<PanelColor> &panelColors)
+{
+    foreach (const PanelColor &panelColor, panelColors) {
+        queuePanelColor(panelColor);
+    }
+    flushFrame();
+}
 
+void Nanoleaf::queuePanelColor(const PanelColor &panelColor)
+{
+    // Only the latest color of a panel is sent
+    for (int i = 0; i < m_pendingFrame.count(); i++) {
+        if (m_pendingFrame.at(i).panelId == panelColor.panelId) {
+            m_pendingFrame.removeAt(i);
+            break;
+        }
+    }
+    m_pendingFrame.append(panelColor);
+}
+
+void Nanoleaf::flushFrame()
+{
+    if (m_pendingFrame.isEmpty())
+        return;
+
+    sendExternalControlFrame(m_pendingFrame);
+    m_pendingFrame.clear();
+}
+
+bool Nanoleaf::sendExternalControlFrame(const QList<PanelColor> &panelColors)
+{
+    if (!m_externalControl) {
+        qCWarning(dcNanoleaf()) << "Not sending frame, external control is not enabled";
+        return false;
+    }
+
+    // extControlVersion v2: nPanels, then per panel: panelId, R, G, B, W, transitionTime (16 bit values big endian)
+    QByteArray datagram;
+    QDataStream stream(&datagram, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream << static_cast<quint16>(panelColors.count());
+    foreach (const PanelColor &panelColor, panelColors) {
+        QColor rgb = panelColor.color.toRgb();
+        stream << static_cast<quint16>(panelColor.panelId);
+        stream << static_cast<quint8>(rgb.red()) << static_cast<quint8>(rgb.green()) << static_cast<quint8>(rgb.blue()) << static_cast<quint8>(0);
+        stream << static_cast<quint16>(qBound(0, panelColor.transitionTime, 0xffff));
+    }
+
+    if (m_udpSocket->writeDatagram(datagram, m_address, externalControlPort) != datagram.size()) {
+        qCWarning(dcNanoleaf()) << "Could not send external control frame:" << m_udpSocket->errorString();
+        return false;
+    }
+    return true;
+}
+
+void Nanoleaf::processStreamEvent(const EventStreamParser::Event &streamEvent)
+{
+    QJsonParseError error;
+    QJsonDocument data = QJsonDocument::fromJson(streamEvent.data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qDebug(dcNanoleaf()) << "Recieved invalide JSON object";
+        return;
+    }
+    qCDebug(dcNanoleaf()) << "Event received" << streamEvent.id << data.toJson(QJsonDocument::Compact);
+    QVariantList events = data.toVariant().toMap().value("events").toList();
+
+    // The event id is the event type requested in the registration
+    int eventType = streamEvent.id.toInt();
+    foreach (QVariant variant, events) {
+        QVariantMap event = variant.toMap();
+        switch (eventType) {
+        case 1: //State
+            switch (event["attr"].toInt()) {
+            case 1:  //ON
+                emit powerReceived(event["value"].toBool());
+                break;
+            case 2:  //Brightness
+                emit brightnessReceived(event["value"].toInt());
+                break;
+            case 3: //Hue
+                emit hueReceived(event["value"].toInt());
+                break;
+            case 4: //Saturation
+                emit saturationReceived(event["value"].toInt());
+                break;
+            case 5: //Color Temperature
+                emit colorTemperatureReceived(event["value"].toInt());
+                break;
+            case 6: { //colorMode
+                QString colorModeString = event["value"].toString();
+                if (colorModeString == "effect") {
+                    emit colorModeReceived(ColorMode::EffectMode);
+                } else if (colorModeString == "hs") {
+                    emit colorModeReceived(ColorMode::HueSaturationMode);
+                } else if (colorModeString == "ct") {
+                    emit colorModeReceived(ColorMode::ColorTemperatureMode);
+                } else {
+                    qCWarning(dcNanoleaf()) << "Unrecognized color mode";
+                }
+                break;
+            }
+            default:
+                qCWarning(dcNanoleaf()) << "Unrecognised Event received";
+            }
+            break;
+        case 2: //Layout
+            getControllerInfo(); // Refreshes the panel ids
+            break;
+        case 3: { //Effects
+            QString effect = event["value"].toString();
+            if (m_externalControl && !effect.contains("ExtControl")) {
+                setExternalControlActive(false);
+            }
+            emit selectedEffectReceived(effect);
+            break;
+        }
+        case 4: { //Touch
+            int gesture = event["gesture"].toInt();
+            if (gesture >= SingleTap && gesture <= SwipeRight) {
+                emit touchEventReceived(static_cast<GestureID>(gesture));
+            }
+            break;
+        }
+        default:
+            qCWarning(dcNanoleaf()) << "Unrecognised Event received";
+        }
+    }
+}
 
+void Nanoleaf::setExternalControlActive(bool active)
+{
+    if (m_externalControl == active)
+        return;
+
+    m_externalControl = active;
+    if (!active) {
+        m_frameTimer->stop();
+        m_pendingFrame.clear();
+    }
+    emit externalControlChanged(active);
+}
@@ -36,10 +36,13 @@
 #include <QUuid>
 #include <QHostAddress>
 #include <QColor>
+#include <QUdpSocket>
 
 #include "network/networkaccessmanager.h"
 #include "integrations/thing.h"
 
+#include "eventstreamparser.h"
+
 class Nanoleaf : public QObject
 {
     Q_OBJECT
@@ -67,7 +70,14 @@ public:
         SwipeRight  = 5
     };
 
+    struct PanelColor {
+        int panelId;
+        QColor color;
+        int transitionTime; // In 100 ms steps
+    };
+
     explicit Nanoleaf(NetworkAccessManager *networkManager, const QHostAddress &address, int port = 16021, QObject *parent = nullptr);
+    ~Nanoleaf() override;
     void setIpAddress(const QHostAddress &address);
     QHostAddress ipAddress();
 
@@ -108,12 +118,35 @@ public:
 
     QUuid identify();
 
+    //EXTERNAL CONTROL (UDP streaming, extControlVersion v2)
+    QUuid startExternalControl();
+    void stopExternalControl();
+    bool externalControlActive();
+    void setPanelColor(int panelId, const QColor &color, int transitionTime = 1); // Queued, pending colors are sent as one frame every 100 ms
+    void setPanelColors(const QList<PanelColor> &panelColors); // Sent right away as one frame, along with pending colors
+    bool sendExternalControlFrame(const QList<PanelColor> &panelColors);
+
 private:
     NetworkAccessManager *m_networkManager = nullptr;
     QString m_authToken;
     QHostAddress m_address;
     int m_port;
 
+    EventStreamParser m_eventStreamParser;
+    QNetworkReply *m_eventStreamReply = nullptr;
+    QTimer *m_eventStreamReconnectTimer = nullptr;
+
+    QUdpSocket *m_udpSocket = nullptr;
+    bool m_externalControl = false;
+    QList<PanelColor> m_pendingFrame;
+    QTimer *m_frameTimer = nullptr;
+
+    void queuePanelColor(const PanelColor &panelColor);
+    void flushFrame();
+
+    void processStreamEvent(const EventStreamParser::Event &streamEvent);
+    void setExternalControlActive(bool active);
+
 signals:
     void connectionChanged(bool connected);
     void authenticationStatusChanged(bool authenticated);
@@ -130,6 +163,8 @@ signals:
     void colorReceived(QColor color);
     void colorTemperatureReceived(int kelvin);
     void selectedEffectReceived(const QString &effect);
+    void panelLayoutReceived(const QList<int> &panelIds);
+    void externalControlChanged(bool active);
 
     //Only supported by Canvas
     void touchEventReceived(GestureID gesture);
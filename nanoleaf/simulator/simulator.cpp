@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Local sink for the Nanoleaf external control stream (extControlVersion v2). Decodes the UDP
+// frames sent to port 60222 and prints the panel colors along with the frame rate.
+//
+// With "--http" it also answers every request on the Nanoleaf API port 16021 with
+// "204 No Content", which is enough for the plugin to enable the external control mode
+// when the address of this machine is configured for a light panels thing.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QNetworkDatagram>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+static const quint16 externalControlPort = 60222;
+static const quint16 apiPort = 16021;
+
+static void printFrame(const QByteArray &datagram)
+{
+    QDataStream stream(datagram);
+    stream.setByteOrder(QDataStream::BigEndian);
+
+    quint16 panelCount = 0;
+    stream >> panelCount;
+    if (datagram.size() != 2 + panelCount * 8) {
+        qWarning() << "Invalid frame:" << datagram.size() << "bytes for" << panelCount << "panels" << datagram.toHex();
+        return;
+    }
+
+    QStringList panels;
+    for (int i = 0; i < panelCount; i++) {
+        quint16 panelId, transitionTime;
+        quint8 red, green, blue, white;
+        stream >> panelId >> red >> green >> blue >> white >> transitionTime;
+        panels.append(QString("%1:#%2%3%4/%5ms")
+                      .arg(panelId)
+                      .arg(static_cast<int>(red), 2, 16, QChar('0'))
+                      .arg(static_cast<int>(green), 2, 16, QChar('0'))
+                      .arg(static_cast<int>(blue), 2, 16, QChar('0'))
+                      .arg(transitionTime * 100));
+    }
+    qInfo().noquote() << "Frame with" << panelCount << "panels:" << panels.join(' ');
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Receives and decodes Nanoleaf external control frames (extControlVersion v2).");
+    parser.addHelpOption();
+    QCommandLineOption httpOption("http", "Answer all requests on the Nanoleaf API port with \"204 No Content\".");
+    parser.addOption(httpOption);
+    parser.process(app);
+
+    QUdpSocket udpSocket;
+    if (!udpSocket.bind(QHostAddress::Any, externalControlPort)) {
+        qCritical() << "Cannot listen on UDP port" << externalControlPort << udpSocket.errorString();
+        return 1;
+    }
+    qInfo() << "Waiting for external control frames on UDP port" << externalControlPort;
+
+    int frames = 0;
+    QElapsedTimer rateTimer;
+    rateTimer.start();
+    QObject::connect(&udpSocket, &QUdpSocket::readyRead, &app, [&](){
+        while (udpSocket.hasPendingDatagrams()) {
+            printFrame(udpSocket.receiveDatagram().data());
+            frames++;
+        }
+        if (rateTimer.elapsed() >= 1000) {
+            qInfo() << "Frame rate:" << frames * 1000.0 / rateTimer.restart() << "frames per second";
+            frames = 0;
+        }
+    });
+
+    QTcpServer httpServer;
+    if (parser.isSet(httpOption)) {
+        if (!httpServer.listen(QHostAddress::Any, apiPort)) {
+            qCritical() << "Cannot listen on TCP port" << apiPort << httpServer.errorString();
+            return 1;
+        }
+        QObject::connect(&httpServer, &QTcpServer::newConnection, &app, [&httpServer](){
+            QTcpSocket *socket = httpServer.nextPendingConnection();
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket](){
+                // Requests are small, assume they arrive in one piece
+                QByteArray request = socket->readAll();
+                qInfo().noquote() << "HTTP request:" << request.left(request.indexOf("\r\n"));
+                socket->write("HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n");
+                socket->disconnectFromHost();
+            });
+        });
+        qInfo() << "Answering HTTP requests on TCP port" << apiPort;
+    }
+
+    return app.exec();
+}
@@ -39,6 +39,13 @@ IntegrationPluginOneWire::IntegrationPluginOneWire()
 {
 }
 
+IntegrationPluginOneWire::~IntegrationPluginOneWire()
+{
+    // Stop the bus workers, including ones still shutting down, before the interfaces they use get deleted
+    qDeleteAll(findChildren<OneWireBus *>(QString(), Qt::FindDirectChildrenOnly));
+    m_bus = nullptr;
+}
+
 void IntegrationPluginOneWire::discoverThings(ThingDiscoveryInfo *info)
 {
     ThingClassId deviceClassId = info->thingClassId();
@@ -333,17 +340,30 @@ void IntegrationPluginOneWire::executeAction(ThingActionInfo *info)
 
 void IntegrationPluginOneWire::thingRemoved(Thing *thing)
 {
-    if (thing->thingClassId() == oneWireInterfaceThingClassId) {
-        if (m_owfsInterface) {
-            m_owfsInterface->deleteLater();
-            m_owfsInterface = nullptr;
-        }
+    bool removeOwfsInterface = thing->thingClassId() == oneWireInterfaceThingClassId && m_owfsInterface;
+    bool removeW1Interface = myThings().filterByThingClassId(temperatureSensorThingClassId).isEmpty() && m_w1Interface;
+    QList<QObject *> removedInterfaces;
+    if (removeOwfsInterface) {
+        removedInterfaces.append(m_owfsInterface);
+        m_owfsInterface = nullptr;
+    }
+    if (removeW1Interface) {
+        removedInterfaces.append(m_w1Interface);
+        m_w1Interface = nullptr;
     }
 
-    if (myThings().filterByThingClassId(temperatureSensorThingClassId).isEmpty()) {
-        if(m_w1Interface) {
-            m_w1Interface->deleteLater();
-            m_w1Interface = nullptr;
+    // A running poll might still be using the interfaces. Shut down the bus without blocking
+    // and delete them once it is gone. The bus gets recreated on the next poll.
+    OneWireBus *bus = removedInterfaces.isEmpty() ? nullptr : m_bus;
+    if (bus) {
+        m_bus = nullptr;
+        bus->shutdown();
+    }
+    foreach (QObject *oneWireInterface, removedInterfaces) {
+        if (bus) {
+            connect(bus, &QObject::destroyed, oneWireInterface, &QObject::deleteLater);
+        } else {
+            oneWireInterface->deleteLater();
         }
     }
 
@@ -395,110 +415,113 @@ void IntegrationPluginOneWire::setupOwfsTemperatureHumiditySensor(ThingSetupInfo
 
 void IntegrationPluginOneWire::onPluginTimer()
 {
-    foreach (Thing *thing, myThings()) {
-        if (thing->thingClassId() == oneWireInterfaceThingClassId) {
-            thing->setStateValue(oneWireInterfaceConnectedStateTypeId, m_owfsInterface->interfaceIsAvailable());
+    if (!m_bus) {
+        m_bus = new OneWireBus(this);
+        connect(m_bus, &OneWireBus::pollFinished, this, &IntegrationPluginOneWire::onBusPollFinished);
+    }
 
-        } else if (thing->thingClassId() == temperatureSensorThingClassId) {
-            QByteArray address = thing->paramValue(temperatureSensorThingAddressParamTypeId).toByteArray();
-            bool ok = true;
-            double temperature = 0;
-            bool connected = false;
+    OneWireBus::Request request;
+    request.owfs = m_owfsInterface;
+    request.w1 = m_w1Interface;
 
+    foreach (Thing *thing, myThings()) {
+        if (thing->thingClassId() == temperatureSensorThingClassId) {
+            QByteArray address = thing->paramValue(temperatureSensorThingAddressParamTypeId).toByteArray();
             if (!thing->parentId().isNull()) {
                 if (m_owfsInterface) {
-                    connected = m_owfsInterface->isConnected(address);
-                    bool ok;
-                    temperature = m_owfsInterface->getTemperature(address, &ok);
+                    request.owfsTemperatureSensors.append(address);
                 } else {
                     qCWarning(dcOneWire()) << "onPlugInTimer: OWFS interface not setup for thing" << thing->name();
                 }
-
-            } else {
-                temperature = m_w1Interface->getTemperature(address);
-                connected = m_w1Interface->deviceAvailable(address);
+            } else if (m_w1Interface) {
+                request.w1TemperatureSensors.append(address);
             }
+        } else if (!m_owfsInterface) {
+            continue;
+        } else if (thing->thingClassId() == temperatureHumiditySensorThingClassId) {
+            request.owfsTemperatureHumiditySensors.append(thing->paramValue(temperatureHumiditySensorThingAddressParamTypeId).toByteArray());
+        } else if (thing->thingClassId() == singleChannelSwitchThingClassId) {
+            request.owfsSwitches.insert(thing->paramValue(singleChannelSwitchThingAddressParamTypeId).toByteArray(), 1);
+        } else if (thing->thingClassId() == dualChannelSwitchThingClassId) {
+            request.owfsSwitches.insert(thing->paramValue(dualChannelSwitchThingAddressParamTypeId).toByteArray(), 2);
+        } else if (thing->thingClassId() == eightChannelSwitchThingClassId) {
+            request.owfsSwitches.insert(thing->paramValue(eightChannelSwitchThingAddressParamTypeId).toByteArray(), 8);
+        }
+    }
 
-            if (ok) {
-                thing->setStateValue(temperatureSensorTemperatureStateTypeId, temperature);
-            }
-            thing->setStateValue(temperatureSensorConnectedStateTypeId, connected);
-        } else if (thing->thingClassId() == temperatureHumiditySensorThingClassId)  {
-            if (!m_owfsInterface)
+    m_bus->poll(request);
+}
+
+void IntegrationPluginOneWire::onBusPollFinished(const OneWireBus::Result &result)
+{
+    foreach (Thing *thing, myThings()) {
+        if (thing->thingClassId() == oneWireInterfaceThingClassId) {
+            thing->setStateValue(oneWireInterfaceConnectedStateTypeId, result.owfsAvailable);
+
+        } else if (thing->thingClassId() == temperatureSensorThingClassId) {
+            QByteArray address = thing->paramValue(temperatureSensorThingAddressParamTypeId).toByteArray();
+            if (!result.values.contains(address))
                 continue;
+
+            OneWireBus::SensorValues values = result.values.value(address);
+            if (values.temperatureValid) {
+                thing->setStateValue(temperatureSensorTemperatureStateTypeId, values.temperature);
+            }
+            thing->setStateValue(temperatureSensorConnectedStateTypeId, values.connected);
+
+        } else if (thing->thingClassId() == temperatureHumiditySensorThingClassId) {
             QByteArray address = thing->paramValue(temperatureHumiditySensorThingAddressParamTypeId).toByteArray();
-            bool ok;
-            double temp = m_owfsInterface->getTemperature(address, &ok);
-            if (ok) {
-                thing->setStateValue(temperatureHumiditySensorTemperatureStateTypeId, temp);
+            if (!result.values.contains(address))
+                continue;
+
+            OneWireBus::SensorValues values = result.values.value(address);
+            if (values.temperatureValid) {
+                thing->setStateValue(temperatureHumiditySensorTemperatureStateTypeId, values.temperature);
             }
-            double humidity = m_owfsInterface->getHumidity(address, &ok);
-            if (ok) {
-                thing->setStateValue(temperatureHumiditySensorHumidityStateTypeId, humidity);
+            if (values.humidityValid) {
+                thing->setStateValue(temperatureHumiditySensorHumidityStateTypeId, values.humidity);
             }
-            thing->setStateValue(temperatureHumiditySensorConnectedStateTypeId, m_owfsInterface->isConnected(address));
+            thing->setStateValue(temperatureHumiditySensorConnectedStateTypeId, values.connected);
+
         } else if (thing->thingClassId() == singleChannelSwitchThingClassId) {
-            if (!m_owfsInterface)
-                continue;
             QByteArray address = thing->paramValue(singleChannelSwitchThingAddressParamTypeId).toByteArray();
-            bool ok;
-            bool output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_A, &ok);
-            if (ok) {
-                thing->setStateValue(singleChannelSwitchDigitalOutputStateTypeId, output);
+            if (!result.values.contains(address))
+                continue;
+
+            OneWireBus::SensorValues values = result.values.value(address);
+            if (values.switchOutputs.contains(0)) {
+                thing->setStateValue(singleChannelSwitchDigitalOutputStateTypeId, values.switchOutputs.value(0));
             }
-            thing->setStateValue(singleChannelSwitchConnectedStateTypeId, m_owfsInterface->isConnected(address));
+            thing->setStateValue(singleChannelSwitchConnectedStateTypeId, values.connected);
+
         } else if (thing->thingClassId() == dualChannelSwitchThingClassId) {
-            if (!m_owfsInterface)
-                continue;
             QByteArray address = thing->paramValue(dualChannelSwitchThingAddressParamTypeId).toByteArray();
-            bool ok;
-            bool output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_A, &ok);
-            if (ok) {
-                thing->setStateValue(dualChannelSwitchDigitalOutput1StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_B, &ok);
-            if (ok) {
-                thing->setStateValue(dualChannelSwitchDigitalOutput2StateTypeId, output);
+            if (!result.values.contains(address))
+                continue;
+
+            OneWireBus::SensorValues values = result.values.value(address);
+            QList<StateTypeId> outputStateTypeIds = {dualChannelSwitchDigitalOutput1StateTypeId, dualChannelSwitchDigitalOutput2StateTypeId};
+            foreach (int channel, values.switchOutputs.keys()) {
+                thing->setStateValue(outputStateTypeIds.at(channel), values.switchOutputs.value(channel));
             }
-            thing->setStateValue(dualChannelSwitchConnectedStateTypeId, m_owfsInterface->isConnected(address));
+            thing->setStateValue(dualChannelSwitchConnectedStateTypeId, values.connected);
+
         } else if (thing->thingClassId() == eightChannelSwitchThingClassId) {
-            if (!m_owfsInterface)
-                continue;
             QByteArray address = thing->paramValue(eightChannelSwitchThingAddressParamTypeId).toByteArray();
-            bool ok;
-            bool output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_A, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput1StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_B, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput2StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_C, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput3StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_D, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput4StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_E, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput5StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_F, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput6StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_G, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput7StateTypeId, output);
-            }
-            output = m_owfsInterface->getSwitchOutput(address, Owfs::SwitchChannel::PIO_H, &ok);
-            if (ok) {
-                thing->setStateValue(eightChannelSwitchDigitalOutput8StateTypeId, output);
-            }
-            thing->setStateValue(eightChannelSwitchConnectedStateTypeId, m_owfsInterface->isConnected(address));
+            if (!result.values.contains(address))
+                continue;
+
+            OneWireBus::SensorValues values = result.values.value(address);
+            QList<StateTypeId> outputStateTypeIds = {
+                eightChannelSwitchDigitalOutput1StateTypeId, eightChannelSwitchDigitalOutput2StateTypeId,
+                eightChannelSwitchDigitalOutput3StateTypeId, eightChannelSwitchDigitalOutput4StateTypeId,
+                eightChannelSwitchDigitalOutput5StateTypeId, eightChannelSwitchDigitalOutput6StateTypeId,
+                eightChannelSwitchDigitalOutput7StateTypeId, eightChannelSwitchDigitalOutput8StateTypeId
+            };
+            foreach (int channel, values.switchOutputs.keys()) {
+                thing->setStateValue(outputStateTypeIds.at(channel), values.switchOutputs.value(channel));
+            }
+            thing->setStateValue(eightChannelSwitchConnectedStateTypeId, values.connected);
         }
     }
 }
@@ -35,6 +35,7 @@
 #include "integrations/integrationplugin.h"
 #include "owfs.h"
 #include "w1.h"
+#include "onewirebus.h"
 
 #include "extern-plugininfo.h"
 
@@ -48,6 +49,7 @@ class IntegrationPluginOneWire : public IntegrationPlugin
 
 public:
     explicit IntegrationPluginOneWire();
+    ~IntegrationPluginOneWire() override;
 
     void discoverThings(ThingDiscoveryInfo *info) override;
     void setupThing(ThingSetupInfo *info) override;
@@ -59,6 +61,7 @@ private:
     PluginTimer *m_pluginTimer = nullptr;
     Owfs *m_owfsInterface = nullptr;
     W1 *m_w1Interface = nullptr;
+    OneWireBus *m_bus = nullptr;
 
     QHash<Thing*, ThingDiscoveryInfo*> m_runningDiscoveries;
 
@@ -67,6 +70,7 @@ private:
 
 private slots:
     void onPluginTimer();
+    void onBusPollFinished(const OneWireBus::Result &result);
     void onOneWireDevicesDiscovered(QList<Owfs::OwfsDevice> devices);
 };
 
@@ -8,11 +8,13 @@ LIBS +=      \
 
 SOURCES += \
     integrationpluginonewire.cpp \
+    onewirebus.cpp \
     owfs.cpp \
     w1.cpp \
 
 HEADERS += \
     integrationpluginonewire.h \
+    onewirebus.h \
     owfs.h \
     w1.h \
 
@@ -0,0 +1,166 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "onewirebus.h"
+#include "extern-plugininfo.h"
+
+#include <QElapsedTimer>
+
+OneWireBus::OneWireBus(QObject *parent) :
+    QObject(parent)
+{
+    qRegisterMetaType<OneWireBus::Request>();
+    qRegisterMetaType<OneWireBus::Result>();
+
+    m_worker = new OneWireBusWorker();
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &OneWireBusWorker::pollFinished, this, [this](const OneWireBus::Result &result){
+        m_busy = false;
+        qCDebug(dcOneWire()) << "Polled" << result.values.count() << "one wire devices in" << result.duration << "ms";
+        emit pollFinished(result);
+    });
+    m_workerThread.start();
+}
+
+OneWireBus::~OneWireBus()
+{
+    // Only blocks if the bus gets deleted without shutdown(), e.g. when the plugin is unloaded
+    m_workerThread.requestInterruption();
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void OneWireBus::shutdown()
+{
+    // The result of an interrupted poll gets dropped, queued polls don't run any more
+    disconnect(m_worker, &OneWireBusWorker::pollFinished, this, nullptr);
+    connect(&m_workerThread, &QThread::finished, this, &QObject::deleteLater);
+    m_workerThread.requestInterruption();
+    m_workerThread.quit();
+}
+
+bool OneWireBus::busy() const
+{
+    return m_busy;
+}
+
+bool OneWireBus::poll(const Request &request)
+{
+    if (m_busy) {
+        qCDebug(dcOneWire()) << "Previous poll cycle still running. Skipping this one.";
+        return false;
+    }
+
+    m_busy = true;
+    QMetaObject::invokeMethod(m_worker, "poll", Qt::QueuedConnection, Q_ARG(OneWireBus::Request, request));
+    return true;
+}
+
+OneWireBusWorker::OneWireBusWorker(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+void OneWireBusWorker::poll(const OneWireBus::Request &request)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Checked between two sensors, so shutting down doesn't wait for a whole poll cycle
+    QThread *thread = QThread::currentThread();
+
+    OneWireBus::Result result;
+    if (request.owfs) {
+        Owfs *owfs = request.owfs;
+        result.owfsAvailable = owfs->interfaceIsAvailable();
+
+        // One conversion for all sensors instead of up to 750 ms per sensor
+        bool simultaneous = !request.owfsTemperatureSensors.isEmpty() && owfs->startSimultaneousTemperatureConversion();
+        foreach (const QByteArray &address, request.owfsTemperatureSensors) {
+            if (thread->isInterruptionRequested())
+                return;
+
+            OneWireBus::SensorValues values;
+            values.connected = owfs->isConnected(address);
+            if (simultaneous) {
+                values.temperature = owfs->getLatestTemperature(address, &values.temperatureValid);
+            } else {
+                values.temperature = owfs->getTemperature(address, &values.temperatureValid);
+            }
+            result.values.insert(address, values);
+        }
+
+        foreach (const QByteArray &address, request.owfsTemperatureHumiditySensors) {
+            if (thread->isInterruptionRequested())
+                return;
+
+            OneWireBus::SensorValues values;
+            values.connected = owfs->isConnected(address);
+            values.temperature = owfs->getTemperature(address, &values.temperatureValid);
+            values.humidity = owfs->getHumidity(address, &values.humidityValid);
+            result.values.insert(address, values);
+        }
+
+        foreach (const QByteArray &address, request.owfsSwitches.keys()) {
+            if (thread->isInterruptionRequested())
+                return;
+
+            OneWireBus::SensorValues values;
+            values.connected = owfs->isConnected(address);
+            for (int channel = 0; channel < request.owfsSwitches.value(address); channel++) {
+                bool ok = false;
+                bool output = owfs->getSwitchOutput(address, static_cast<Owfs::SwitchChannel>(channel), &ok);
+                if (ok) {
+                    values.switchOutputs.insert(channel, output);
+                }
+            }
+            result.values.insert(address, values);
+        }
+    }
+
+    if (request.w1 && !request.w1TemperatureSensors.isEmpty()) {
+        W1 *w1 = request.w1;
+        w1->startBulkTemperatureConversion();
+        foreach (const QString &address, request.w1TemperatureSensors) {
+            if (thread->isInterruptionRequested())
+                return;
+
+            OneWireBus::SensorValues values;
+            values.connected = w1->deviceAvailable(address);
+            values.temperature = w1->getTemperature(address, &values.temperatureValid);
+            result.values.insert(address.toUtf8(), values);
+        }
+    }
+
+    result.duration = timer.elapsed();
+    emit pollFinished(result);
+}
@@ -0,0 +1,108 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef ONEWIREBUS_H
+#define ONEWIREBUS_H
+
+#include <QHash>
+#include <QObject>
+#include <QThread>
+
+#include "owfs.h"
+#include "w1.h"
+
+class OneWireBusWorker;
+
+// Polls the one wire sensors in a worker thread, so the slow bus transactions never block
+// the event loop. Temperature sensors are converted simultaneously, which makes the poll
+// cycle take roughly one conversion time regardless of the number of sensors.
+class OneWireBus : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request {
+        Owfs *owfs = nullptr;
+        W1 *w1 = nullptr;
+        QList<QByteArray> owfsTemperatureSensors;
+        QList<QByteArray> owfsTemperatureHumiditySensors;
+        QHash<QByteArray, int> owfsSwitches; // Address, channel count
+        QStringList w1TemperatureSensors;
+    };
+
+    struct SensorValues {
+        bool connected = false;
+        bool temperatureValid = false;
+        double temperature = 0;
+        bool humidityValid = false;
+        double humidity = 0;
+        QHash<int, bool> switchOutputs;
+    };
+
+    struct Result {
+        bool owfsAvailable = false;
+        QHash<QByteArray, SensorValues> values;
+        qint64 duration = 0;
+    };
+
+    explicit OneWireBus(QObject *parent = nullptr);
+    ~OneWireBus() override;
+
+    bool busy() const;
+    bool poll(const Request &request);
+
+    // Interrupts a running poll and deletes the bus once the worker thread has finished, without blocking
+    void shutdown();
+
+signals:
+    void pollFinished(const OneWireBus::Result &result);
+
+private:
+    QThread m_workerThread;
+    OneWireBusWorker *m_worker = nullptr;
+    bool m_busy = false;
+};
+
+Q_DECLARE_METATYPE(OneWireBus::Request)
+Q_DECLARE_METATYPE(OneWireBus::Result)
+
+class OneWireBusWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OneWireBusWorker(QObject *parent = nullptr);
+
+public slots:
+    void poll(const OneWireBus::Request &request);
+
+signals:
+    void pollFinished(const OneWireBus::Result &result);
+};
+
+#endif // ONEWIREBUS_H
@@ -135,8 +135,8 @@ bool Owfs::isConnected(const QByteArray &address)
 /* watches for total length and free allocated space */
 QByteArray Owfs::getValue(const QByteArray &address, const QByteArray &type)
 {
-    char * getBuffer ;
-    size_t getLength ;
+    char * getBuffer = nullptr;
+    size_t getLength = 0;
 
     QByteArray devicePath;
     devicePath.append(m_path);
@@ -149,6 +149,7 @@ QByteArray Owfs::getValue(const QByteArray &address, const QByteArray &type)
 
     if (OW_get(devicePath, &getBuffer, &getLength) < 0) {
         qWarning(dcOneWire()) << "ERROR reading" << devicePath << strerror(errno);
+        return QByteArray();
     }
 
     qDebug(dcOneWire()) << "Device value" << devicePath << getBuffer;
@@ -182,6 +183,31 @@ double Owfs::getTemperature(const QByteArray &address, bool *ok)
     return temperature.toDouble(ok);
 }
 
+bool Owfs::startSimultaneousTemperatureConversion()
+{
+    // Starts one conversion on all temperature sensors of the bus. OWFS waits for the
+    // conversion time, afterwards "latesttemp" returns the results without converting again.
+    QByteArray devicePath;
+    devicePath.append(m_path);
+    if(!m_path.endsWith('/'))
+        devicePath.append('/');
+    devicePath.append("simultaneous/temperature");
+    devicePath.append('\0');
+
+    if (OW_put(devicePath, "1", 1) < 0) {
+        qWarning(dcOneWire()) << "ERROR starting simultaneous conversion" << devicePath << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+double Owfs::getLatestTemperature(const QByteArray &address, bool *ok)
+{
+    QByteArray temperature = getValue(address, "latesttemp");
+    qDebug(dcOneWire()) << "Latest temperature" << temperature;
+    return temperature.replace(',','.').trimmed().toDouble(ok);
+}
+
 double Owfs::getHumidity(const QByteArray &address, bool *ok)
 {
     QByteArray humidity = getValue(address, "humidity");
@@ -76,6 +76,8 @@ public:
     bool isConnected(const QByteArray &address);
 
     double getTemperature( const QByteArray &address, bool *ok);
+    bool startSimultaneousTemperatureConversion();
+    double getLatestTemperature(const QByteArray &address, bool *ok);
     double getHumidity(const QByteArray &address, bool *ok);
     QByteArray getType(const QByteArray &address);
     bool getSwitchOutput(const QByteArray &address, SwitchChannel channel, bool *ok);
@@ -31,6 +31,9 @@
 #include "w1.h"
 #include "extern-plugininfo.h"
 
+#include <QThread>
+#include <QElapsedTimer>
+
 W1::W1(QObject *parent) :
     QObject(parent)
 {
@@ -72,8 +75,11 @@ bool W1::deviceAvailable(const QString &address)
    return temperatureSensor.exists();
 }
 
-double W1::getTemperature(const QString &address)
+double W1::getTemperature(const QString &address, bool *ok)
 {
+    if (ok)
+        *ok = false;
+
     QDir temperatureSensor("/sys/bus/w1/devices/"+address);
     if (temperatureSensor.exists()) {
         QFile temperature(temperatureSensor.path() +"/temperature");
@@ -84,9 +90,50 @@ double W1::getTemperature(const QString &address)
             qCWarning(dcOneWire()) << "Could not open file" << temperature.fileName();
             return 0;
         }
-        return temperature.readLine().toInt()/1000.00;
+        return temperature.readLine().trimmed().toInt(ok)/1000.00;
     } else {
         qCWarning(dcOneWire()) << "Could not find device" << temperatureSensor.currentPath();
     }
     return 0;
 }
+
+bool W1::startBulkTemperatureConversion()
+{
+    // Kernels >= 5.10 can start the conversion on all sensors of a bus master at once.
+    // Reading "temperature" afterwards returns the converted value without a new conversion.
+    QDir w1SysFSDir("/sys/bus/w1/devices/");
+    QStringList bulkReadFiles;
+    foreach (const QString &busMaster, w1SysFSDir.entryList(QStringList() << "w1_bus_master*", QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile bulkRead(w1SysFSDir.filePath(busMaster + "/therm_bulk_read"));
+        if (!bulkRead.open(QIODevice::WriteOnly)) {
+            continue;
+        }
+        if (bulkRead.write("trigger\n") > 0) {
+            bulkReadFiles.append(bulkRead.fileName());
+        }
+    }
+
+    if (bulkReadFiles.isEmpty())
+        return false;
+
+    // therm_bulk_read reads -1 as long as a conversion is in progress on the bus
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 1000) {
+        bool converting = false;
+        foreach (const QString &fileName, bulkReadFiles) {
+            QFile bulkRead(fileName);
+            if (bulkRead.open(QIODevice::ReadOnly | QIODevice::Text) && bulkRead.readLine().trimmed().toInt() == -1) {
+                converting = true;
+                break;
+            }
+        }
+        if (!converting)
+            return true;
+
+        QThread::msleep(50);
+    }
+
+    qCWarning(dcOneWire()) << "Bulk temperature conversion did not finish in time";
+    return true;
+}
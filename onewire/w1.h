@@ -45,7 +45,10 @@ public:
     QStringList discoverDevices();
     bool interfaceIsAvailable();
     bool deviceAvailable(const QString &address);
-    double getTemperature(const QString &address);
+    double getTemperature(const QString &address, bool *ok = nullptr);
+
+    // Blocks until the conversion is done, only call this from the bus worker thread
+    bool startBulkTemperatureConversion();
 
 private:
     QList<QDir> m_w1BusMasters;
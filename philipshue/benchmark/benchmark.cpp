@@ -0,0 +1,230 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Replays a /sensors refresh payload of the Hue API v1 against the sensor dispatch of the plugin,
+// comparing the former scan over all devices of all bridges with the per bridge resource index.
+//
+// sensors-100.json holds 100 devices (dimmer switches, taps, tap dials and motion sensors with
+// 211 sensor resources) in the format returned by the bridge. A payload captured from a real bridge
+// can be passed as argument instead, sensors are grouped into devices by their unique id.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QStringList>
+#include <QVariantMap>
+
+enum DeviceKind {
+    DeviceKindRemote,
+    DeviceKindTapDial,
+    DeviceKindMotionSensor
+};
+
+// Stand-in for HueRemote, HueTapDial and HueMotionSensor, counting the updates it receives
+struct Device {
+    int bridge = 0;
+    QList<int> sensorIds;
+    int updates = 0;
+    int checksum = 0;
+
+    bool hasSensor(int sensorId) const { return sensorIds.contains(sensorId); }
+    void updateStates(const QVariantMap &sensorMap)
+    {
+        updates++;
+        checksum += sensorMap.value("state").toMap().count() + sensorMap.value("config").toMap().count();
+    }
+};
+
+struct Bridges {
+    // Former containers: device -> bridge for each kind
+    QHash<DeviceKind, QHash<Device *, int>> devices;
+    // Index: bridge -> (resource id -> device) for each kind
+    QHash<DeviceKind, QHash<int, QHash<int, Device *>>> index;
+    QList<Device *> all;
+};
+
+static void dispatchScan(Bridges &bridges, int bridge, const QVariantMap &sensorsMap)
+{
+    const QHash<Device *, int> &remotes = bridges.devices[DeviceKindRemote];
+    const QHash<Device *, int> &tapDials = bridges.devices[DeviceKindTapDial];
+    const QHash<Device *, int> &motionSensors = bridges.devices[DeviceKindMotionSensor];
+
+    foreach (const QString &sensorId, sensorsMap.keys()) {
+        QVariantMap sensorMap = sensorsMap.value(sensorId).toMap();
+        foreach (Device *remote, remotes.keys()) {
+            if (remote->hasSensor(sensorId.toInt()) && remotes.value(remote) == bridge) {
+                remote->updateStates(sensorMap);
+            }
+        }
+        foreach (Device *tapDial, tapDials.keys()) {
+            if (tapDial->hasSensor(sensorId.toInt()) && tapDials.value(tapDial) == bridge) {
+                tapDial->updateStates(sensorMap);
+            }
+        }
+        foreach (Device *motionSensor, motionSensors.keys()) {
+            if (motionSensor->hasSensor(sensorId.toInt()) && motionSensors.value(motionSensor) == bridge) {
+                motionSensor->updateStates(sensorMap);
+            }
+        }
+    }
+}
+
+static void dispatchIndex(Bridges &bridges, int bridge, const QVariantMap &sensorsMap)
+{
+    const QHash<int, Device *> remotes = bridges.index[DeviceKindRemote].value(bridge);
+    const QHash<int, Device *> tapDials = bridges.index[DeviceKindTapDial].value(bridge);
+    const QHash<int, Device *> motionSensors = bridges.index[DeviceKindMotionSensor].value(bridge);
+
+    foreach (const QString &sensorId, sensorsMap.keys()) {
+        int id = sensorId.toInt();
+        if (Device *remote = remotes.value(id)) {
+            remote->updateStates(sensorsMap.value(sensorId).toMap());
+            continue;
+        }
+        if (Device *tapDial = tapDials.value(id)) {
+            tapDial->updateStates(sensorsMap.value(sensorId).toMap());
+            continue;
+        }
+        if (Device *motionSensor = motionSensors.value(id)) {
+            motionSensor->updateStates(sensorsMap.value(sensorId).toMap());
+            continue;
+        }
+    }
+}
+
+// Groups the sensor resources into devices by the MAC part of their unique id, like the discovery does
+static void addBridge(Bridges &bridges, int bridge, const QVariantMap &sensorsMap)
+{
+    QHash<QString, QList<int>> sensorIdsByDevice;
+    foreach (const QString &sensorId, sensorsMap.keys()) {
+        QString uniqueId = sensorsMap.value(sensorId).toMap().value("uniqueid").toString();
+        if (uniqueId.isEmpty())
+            continue;
+        sensorIdsByDevice[uniqueId.left(uniqueId.indexOf('-'))].append(sensorId.toInt());
+    }
+
+    foreach (const QList<int> &sensorIds, sensorIdsByDevice) {
+        Device *device = new Device;
+        device->bridge = bridge;
+        device->sensorIds = sensorIds;
+        DeviceKind kind = sensorIds.count() >= 3 ? DeviceKindMotionSensor : sensorIds.count() == 2 ? DeviceKindTapDial : DeviceKindRemote;
+        bridges.devices[kind].insert(device, bridge);
+        foreach (int sensorId, sensorIds) {
+            bridges.index[kind][bridge].insert(sensorId, device);
+        }
+        bridges.all.append(device);
+    }
+}
+
+static void resetCounters(Bridges &bridges, int *updates, int *checksum)
+{
+    *updates = 0;
+    *checksum = 0;
+    foreach (Device *device, bridges.all) {
+        *updates += device->updates;
+        *checksum += device->checksum;
+        device->updates = 0;
+        device->checksum = 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QString fileName = app.arguments().count() > 1 ? app.arguments().at(1) : QString(SAMPLE_DIR) + "/sensors-100.json";
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "Cannot open" << fileName << file.errorString();
+        return 1;
+    }
+    QByteArray payload = file.readAll();
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCritical() << "Cannot parse" << fileName << error.errorString();
+        return 1;
+    }
+    QVariantMap sensorsMap = jsonDoc.toVariant().toMap();
+
+    const int refreshes = 100;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < refreshes; i++) {
+        QJsonDocument::fromJson(payload).toVariant().toMap();
+    }
+    qInfo().noquote() << QString("Payload: %1 sensors, %2 bytes, parsing takes %3 us (same for both dispatchers)")
+                         .arg(sensorsMap.count()).arg(payload.size()).arg(timer.nsecsElapsed() / 1000.0 / refreshes, 0, 'f', 1);
+
+    bool mismatch = false;
+    foreach (int bridgeCount, QList<int>({1, 3, 5})) {
+        Bridges bridges;
+        for (int bridge = 0; bridge < bridgeCount; bridge++) {
+            addBridge(bridges, bridge, sensorsMap);
+        }
+
+        // One refresh cycle updates the sensors of every bridge
+        timer.restart();
+        for (int i = 0; i < refreshes; i++) {
+            for (int bridge = 0; bridge < bridgeCount; bridge++) {
+                dispatchScan(bridges, bridge, sensorsMap);
+            }
+        }
+        double scanTime = timer.nsecsElapsed() / 1000.0 / refreshes;
+        int scanUpdates, scanChecksum;
+        resetCounters(bridges, &scanUpdates, &scanChecksum);
+
+        timer.restart();
+        for (int i = 0; i < refreshes; i++) {
+            for (int bridge = 0; bridge < bridgeCount; bridge++) {
+                dispatchIndex(bridges, bridge, sensorsMap);
+            }
+        }
+        double indexTime = timer.nsecsElapsed() / 1000.0 / refreshes;
+        int indexUpdates, indexChecksum;
+        resetCounters(bridges, &indexUpdates, &indexChecksum);
+
+        qInfo().noquote() << QString("%1 bridge(s), %2 devices: scan %3 us, index %4 us per refresh cycle (%5x)")
+                             .arg(bridgeCount).arg(bridges.all.count())
+                             .arg(scanTime, 0, 'f', 1).arg(indexTime, 0, 'f', 1).arg(scanTime / indexTime, 0, 'f', 1);
+
+        if (scanUpdates != indexUpdates || scanChecksum != indexChecksum) {
+            qWarning() << "Dispatch mismatch: scan delivered" << scanUpdates << "updates, index" << indexUpdates;
+            mismatch = true;
+        }
+        qDeleteAll(bridges.all);
+    }
+
+    return mismatch ? 1 : 0;
+}
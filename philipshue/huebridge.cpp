@@ -75,7 +75,11 @@ QHostAddress HueBridge::hostAddress() const
 
 void HueBridge::setHostAddress(const QHostAddress &hostAddress)
 {
+    if (m_hostAddress == hostAddress)
+        return;
+
     m_hostAddress = hostAddress;
+    emit hostAddressChanged(m_hostAddress);
 }
 
 QString HueBridge::macAddress() const
@@ -118,6 +122,16 @@ void HueBridge::setZigbeeChannel(const int &zigbeeChannel)
     m_zigbeeChannel = zigbeeChannel;
 }
 
+HueEventStream *HueBridge::eventStream() const
+{
+    return m_eventStream;
+}
+
+void HueBridge::setEventStream(HueEventStream *eventStream)
+{
+    m_eventStream = eventStream;
+}
+
 QPair<QNetworkRequest, QByteArray> HueBridge::createDiscoverLightsRequest()
 {
     QNetworkRequest request(QUrl("http://" + hostAddress().toString() + "/api/" + apiKey() + "/lights/"));
@@ -35,6 +35,8 @@
 #include <QHostAddress>
 #include <QNetworkRequest>
 
+class HueEventStream;
+
 class HueBridge : public QObject
 {
     Q_OBJECT
@@ -65,6 +67,9 @@ public:
     int zigbeeChannel() const;
     void setZigbeeChannel(const int &zigbeeChannel);
 
+    HueEventStream *eventStream() const;
+    void setEventStream(HueEventStream *eventStream);
+
     QPair<QNetworkRequest, QByteArray> createDiscoverLightsRequest();
     QPair<QNetworkRequest, QByteArray> createSearchLightsRequest(const QString &deviceId);
     QPair<QNetworkRequest, QByteArray> createSearchSensorsRequest();
@@ -80,6 +85,10 @@ private:
     QString m_apiVersion;
     QString m_softwareVersion;
     int m_zigbeeChannel;
+    HueEventStream *m_eventStream = nullptr;
+
+signals:
+    void hostAddressChanged(const QHostAddress &hostAddress);
 };
 
 #endif // HUEBRIDGE_H
@@ -0,0 +1,207 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+#include "hueeventstream.h"
+#include "huebridge.h"
+#include "extern-plugininfo.h"
+
+#include "network/networkaccessmanager.h"
+
+#include <QNetworkReply>
+#include <QJsonDocument>
+
+HueEventStream::HueEventStream(NetworkAccessManager *networkManager, HueBridge *bridge, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager),
+    m_bridge(bridge)
+{
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &HueEventStream::start);
+
+    // Any data received, including keep-alive comments, restarts the timer. An idle bridge may not send
+    // anything for a while, so keep this well above its keep-alive period. The consistency sweep of the
+    // plugin keeps the states up to date in the meantime.
+    m_inactivityTimer.setSingleShot(true);
+    m_inactivityTimer.setInterval(900000);
+    connect(&m_inactivityTimer, &QTimer::timeout, this, [this](){
+        qCDebug(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "did not receive anything for" << m_inactivityTimer.interval() / 1000 << "seconds. Restarting.";
+        restart();
+    });
+
+    connect(m_bridge, &HueBridge::hostAddressChanged, this, [this](){
+        qCDebug(dcPhilipsHue()) << "Bridge host address changed to" << m_bridge->hostAddress().toString();
+        restart();
+    });
+}
+
+HueEventStream::~HueEventStream()
+{
+    stop();
+}
+
+bool HueEventStream::connected() const
+{
+    return m_connected;
+}
+
+void HueEventStream::start()
+{
+    m_enabled = true;
+    if (m_reply)
+        return;
+
+    if (m_bridge->hostAddress().isNull() || m_bridge->apiKey().isEmpty()) {
+        qCDebug(dcPhilipsHue()) << "Event stream: bridge not configured yet. Retrying in" << m_reconnectInterval / 1000 << "seconds";
+        m_reconnectTimer.start(m_reconnectInterval);
+        return;
+    }
+
+    QNetworkRequest request(QUrl("https://" + m_bridge->hostAddress().toString() + "/eventstream/clip/v2"));
+    request.setRawHeader("hue-application-key", m_bridge->apiKey().toUtf8());
+    request.setRawHeader("Accept", "text/event-stream");
+    if (!m_parser.lastEventId().isEmpty()) {
+        request.setRawHeader("Last-Event-ID", m_parser.lastEventId());
+    }
+
+    m_parser.reset();
+    QNetworkReply *reply = m_networkManager->get(request);
+    // The bridge uses a self signed certificate
+    connect(reply, &QNetworkReply::sslErrors, reply, [reply](){ reply->ignoreSslErrors(); });
+    m_reply = reply;
+    connect(m_reply, &QNetworkReply::readyRead, this, &HueEventStream::onReadyRead);
+    connect(m_reply, &QNetworkReply::finished, this, &HueEventStream::onFinished);
+    m_inactivityTimer.start();
+}
+
+void HueEventStream::stop()
+{
+    m_enabled = false;
+    m_reconnectTimer.stop();
+    m_inactivityTimer.stop();
+    if (m_reply) {
+        QNetworkReply *reply = m_reply;
+        m_reply = nullptr;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    setConnected(false);
+}
+
+void HueEventStream::restart()
+{
+    if (!m_enabled)
+        return;
+
+    stop();
+    start();
+}
+
+void HueEventStream::onReadyRead()
+{
+    int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200) {
+        return;
+    }
+
+    if (!m_connected) {
+        qCDebug(dcPhilipsHue()) << "Event stream connected to" << m_bridge->hostAddress().toString();
+        m_reconnectInterval = 5000;
+        setConnected(true);
+    }
+
+    m_inactivityTimer.start();
+    foreach (const EventStreamParser::Event &event, m_parser.parse(m_reply->readAll())) {
+        processData(event.data);
+    }
+
+    if (m_parser.overflowed()) {
+        qCWarning(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "sent an oversized event. Restarting.";
+        restart();
+    }
+}
+
+void HueEventStream::onFinished()
+{
+    QNetworkReply *reply = m_reply;
+    m_reply = nullptr;
+    reply->deleteLater();
+    m_inactivityTimer.stop();
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    qCDebug(dcPhilipsHue()) << "Event stream of bridge" << m_bridge->hostAddress().toString() << "closed:" << status << reply->errorString();
+    setConnected(false);
+
+    if (!m_enabled)
+        return;
+
+    // Bridges without API v2 don't provide an event stream, no need to hammer them.
+    if (status == 404) {
+        m_reconnectInterval = 600000;
+    }
+
+    qCDebug(dcPhilipsHue()) << "Reconnecting event stream in" << m_reconnectInterval / 1000 << "seconds";
+    m_reconnectTimer.start(m_reconnectInterval);
+    m_reconnectInterval = qMin(m_reconnectInterval * 2, 600000);
+}
+
+void HueEventStream::setConnected(bool connected)
+{
+    if (m_connected == connected)
+        return;
+
+    m_connected = connected;
+    emit connectedChanged(m_connected);
+}
+
+void HueEventStream::processData(const QByteArray &data)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcPhilipsHue()) << "Event stream json error:" << error.errorString() << data;
+        return;
+    }
+
+    foreach (const QVariant &eventVariant, jsonDoc.toVariant().toList()) {
+        QVariantMap eventMap = eventVariant.toMap();
+        if (eventMap.value("type").toString() != "update")
+            continue;
+
+        foreach (const QVariant &resourceVariant, eventMap.value("data").toList()) {
+            QVariantMap resource = resourceVariant.toMap();
+            QString idV1 = resource.value("id_v1").toString();
+            if (idV1.startsWith("/lights/")) {
+                emit lightChanged(idV1.mid(8).toInt(), resource);
+            } else if (idV1.startsWith("/sensors/")) {
+                emit sensorChanged(idV1.mid(9).toInt(), resource);
+            }
+        }
+    }
+}
@@ -172,6 +172,34 @@ void HueLight::updateStates(const QVariantMap &statesMap)
     emit stateChanged();
 }
 
+void HueLight::updateStatesFromEvent(const QVariantMap &resource)
+{
+    // Event stream resources (API v2) only contain the changed properties
+    if (resource.contains("on")) {
+        setPower(resource.value("on").toMap().value("on").toBool());
+    }
+    if (resource.contains("dimming")) {
+        setBrigtness(qRound(resource.value("dimming").toMap().value("brightness").toDouble() * 254 / 100.0));
+    }
+    if (resource.contains("color")) {
+        QVariantMap xyMap = resource.value("color").toMap().value("xy").toMap();
+        setXy(QPointF(xyMap.value("x").toDouble(), xyMap.value("y").toDouble()));
+        setColorMode(ColorModeXY);
+    }
+    if (resource.contains("color_temperature")) {
+        QVariantMap colorTemperatureMap = resource.value("color_temperature").toMap();
+        if (colorTemperatureMap.value("mirek_valid").toBool()) {
+            setCt(colorTemperatureMap.value("mirek").toInt());
+            setColorMode(ColorModeCT);
+        }
+    }
+    if (resource.contains("status") && modelId() != "LIGHTIFY Indoor Flex RGBW") {
+        setReachable(resource.value("status").toString() == "connected");
+    }
+
+    emit stateChanged();
+}
+
 void HueLight::processActionResponse(const QVariantList &responseList)
 {
     foreach (const QVariant &resultVariant, responseList) {
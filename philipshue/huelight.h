@@ -86,6 +86,7 @@ public:
 
     // update states
     void updateStates(const QVariantMap &statesMap);
+    void updateStatesFromEvent(const QVariantMap &resource);
     void processActionResponse(const QVariantList &responseList);
 
     // create action requests
@@ -174,8 +174,17 @@ void HueMotionSensor::updateStates(const QVariantMap &sensorMap)
                 emit presenceChanged(m_presence);
                 qCDebug(dcPhilipsHue) << "Motion sensor presence changed" << presence;
             }
-            qCDebug(dcPhilipsHue) << "Motion sensor restarting timeout" << m_timeout.interval();
-            m_timeout.start();
+            // While the event stream reported an ongoing motion, its end will be reported too
+            if (!m_eventPresence) {
+                qCDebug(dcPhilipsHue) << "Motion sensor restarting timeout" << m_timeout.interval();
+                m_timeout.start();
+            }
+        } else if (m_eventPresence) {
+            // The end of the motion has been missed on the event stream
+            m_eventPresence = false;
+            m_presence = false;
+            emit presenceChanged(m_presence);
+            qCDebug(dcPhilipsHue) << "Motion sensor presence changed" << presence;
         }
     }
 
@@ -194,6 +203,43 @@ void HueMotionSensor::updateStates(const QVariantMap &sensorMap)
     }
 }
 
+void HueMotionSensor::updateStatesFromEvent(int sensorId, const QVariantMap &resource)
+{
+    // Translate the API v2 event resource into the API v1 sensor format
+    QVariantMap sensorMap;
+    QVariantMap stateMap;
+    QVariantMap configMap;
+
+    if (resource.contains("temperature") && sensorId == m_temperatureSensorId) {
+        sensorMap.insert("uniqueid", m_temperatureSensorUuid);
+        stateMap.insert("temperature", qRound(resource.value("temperature").toMap().value("temperature").toDouble() * 100));
+    } else if (resource.contains("motion") && sensorId == m_presenceSensorId) {
+        // The bridge reports the start and the end of a motion, no need for the timeout
+        bool presence = resource.value("motion").toMap().value("motion").toBool();
+        m_timeout.stop();
+        m_eventPresence = presence;
+        if (m_presence != presence) {
+            m_presence = presence;
+            emit presenceChanged(m_presence);
+            qCDebug(dcPhilipsHue) << "Motion sensor presence changed" << presence;
+        }
+    } else if (resource.contains("light") && sensorId == m_lightSensorId) {
+        sensorMap.insert("uniqueid", m_lightSensorUuid);
+        stateMap.insert("lightlevel", resource.value("light").toMap().value("light_level").toInt());
+    }
+
+    if (resource.contains("power_state")) {
+        configMap.insert("battery", resource.value("power_state").toMap().value("battery_level").toInt());
+    }
+    if (resource.contains("status")) {
+        configMap.insert("reachable", resource.value("status").toString() == "connected");
+    }
+
+    sensorMap.insert("state", stateMap);
+    sensorMap.insert("config", configMap);
+    updateStates(sensorMap);
+}
+
 bool HueMotionSensor::isValid()
 {
     return !m_temperatureSensorUuid.isEmpty() && !m_presenceSensorUuid.isEmpty() && !m_lightSensorUuid.isEmpty();
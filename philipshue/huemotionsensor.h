@@ -70,6 +70,7 @@ public:
     int batteryLevel() const;
 
     void updateStates(const QVariantMap &sensorMap);
+    void updateStatesFromEvent(int sensorId, const QVariantMap &resource);
 
     bool isValid();
     bool hasSensor(int sensorId);
@@ -101,6 +102,7 @@ private:
     double m_temperature = 0;
     double m_lightIntensity = 0;
     bool m_presence = false;
+    bool m_eventPresence = false;
     int m_batteryLevel = 0;
 
 signals:
@@ -44,6 +44,8 @@
 #include <QDateTime>
 #include <QStringList>
 #include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 
 IntegrationPluginPhilipsHue::IntegrationPluginPhilipsHue()
 {
@@ -55,21 +57,28 @@ IntegrationPluginPhilipsHue::~IntegrationPluginPhilipsHue()
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer1Sec);
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer5Sec);
     hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer15Sec);
+    hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer60Sec);
 }
 
 void IntegrationPluginPhilipsHue::init()
 {
     m_pluginTimer1Sec = hardwareManager()->pluginTimerManager()->registerTimer(1);
     connect(m_pluginTimer1Sec, &PluginTimer::timeout, this, [this]() {
-        // refresh sensors every second
+        // refresh sensors every second, unless the bridge pushes them using the event stream
         foreach (HueBridge *bridge, m_bridges.keys()) {
+            if (bridge->eventStream() && bridge->eventStream()->connected())
+                continue;
+
             refreshSensors(bridge);
         }
     });
     m_pluginTimer5Sec = hardwareManager()->pluginTimerManager()->registerTimer(5);
     connect(m_pluginTimer5Sec, &PluginTimer::timeout, this, [this]() {
-        // refresh lights every 5 seconds
+        // refresh lights every 5 seconds, unless the bridge pushes them using the event stream
         foreach (HueBridge *bridge, m_bridges.keys()) {
+            if (bridge->eventStream() && bridge->eventStream()->connected())
+                continue;
+
             refreshLights(bridge);
         }
     });
@@ -80,6 +89,16 @@ void IntegrationPluginPhilipsHue::init()
             refreshBridge(thing);
         }
     });
+    m_pluginTimer60Sec = hardwareManager()->pluginTimerManager()->registerTimer(60);
+    connect(m_pluginTimer60Sec, &PluginTimer::timeout, this, [this]() {
+        // consistency sweep for bridges pushing their updates using the event stream
+        foreach (HueBridge *bridge, m_bridges.keys()) {
+            if (bridge->eventStream() && bridge->eventStream()->connected()) {
+                refreshLights(bridge);
+                refreshSensors(bridge);
+            }
+        }
+    });
 
     m_zeroConfBrowser = hardwareManager()->zeroConfController()->createServiceBrowser("_hue._tcp");
     connect(m_zeroConfBrowser, &ZeroConfServiceBrowser::serviceEntryAdded, this, [=](const ZeroConfServiceEntry &entry){
@@ -345,6 +364,44 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
             qCDebug(dcPhilipsHue()) << "Using IP from params:" << host;
             bridge->setHostAddress(QHostAddress(host));
         }
+
+        HueEventStream *eventStream = bridge->eventStream();
+        if (!eventStream) {
+            eventStream = new HueEventStream(hardwareManager()->networkManager(), bridge, bridge);
+            bridge->setEventStream(eventStream);
+            connect(eventStream, &HueEventStream::connectedChanged, this, [this, bridge](bool connected){
+                qCDebug(dcPhilipsHue()) << "Event stream" << (connected ? "connected. Reducing polling." : "disconnected. Falling back to polling.");
+                if (connected) {
+                    // Catch up with what we might have missed in the meantime
+                    Thing *bridgeThing = m_bridges.value(bridge);
+                    if (bridgeThing) {
+                        m_lightStateHashes.remove(bridgeThing->id());
+                        m_sensorStateHashes.remove(bridgeThing->id());
+                    }
+                    refreshLights(bridge);
+                    refreshSensors(bridge);
+                }
+            });
+            connect(eventStream, &HueEventStream::lightChanged, this, [this, thing](int lightId, const QVariantMap &resource){
+                processEventStreamLight(thing, lightId, resource);
+            });
+            connect(eventStream, &HueEventStream::sensorChanged, this, [this, thing](int sensorId, const QVariantMap &resource){
+                processEventStreamSensor(thing, sensorId, resource);
+            });
+            connect(thing, &Thing::settingChanged, eventStream, [eventStream](const ParamTypeId &paramTypeId, const QVariant &value){
+                if (paramTypeId == bridgeSettingsEventStreamParamTypeId) {
+                    if (value.toBool()) {
+                        eventStream->start();
+                    } else {
+                        eventStream->stop();
+                    }
+                }
+            });
+        }
+        if (thing->setting(bridgeSettingsEventStreamParamTypeId).toBool()) {
+            eventStream->start();
+        }
+
         discoverBridgeDevices(bridge);
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -369,6 +426,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
         m_lights.insert(hueLight, thing);
+        m_lightsIndex[thing->parentId()].insert(hueLight->id(), hueLight);
 
         refreshLight(thing);
 
@@ -387,6 +445,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
 
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
         m_lights.insert(hueLight, thing);
+        m_lightsIndex[thing->parentId()].insert(hueLight->id(), hueLight);
 
         refreshLight(thing);
 
@@ -431,6 +490,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
 
         m_lights.insert(hueLight, thing);
+        m_lightsIndex[thing->parentId()].insert(hueLight->id(), hueLight);
         refreshLight(thing);
 
         return info->finish(Thing::ThingErrorNoError);
@@ -450,6 +510,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueLight, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
 
         m_lights.insert(hueLight, thing);
+        m_lightsIndex[thing->parentId()].insert(hueLight->id(), hueLight);
         refreshLight(thing);
 
         return info->finish(Thing::ThingErrorNoError);
@@ -494,6 +555,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueRemote, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(hueRemote, thing);
+        m_remotesIndex[thing->parentId()].insert(hueRemote->id(), hueRemote);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -512,6 +574,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueDimmerSwitch2, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(hueDimmerSwitch2, thing);
+        m_remotesIndex[thing->parentId()].insert(hueDimmerSwitch2->id(), hueDimmerSwitch2);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -534,6 +597,8 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueTapDial, &HueTapDial::rotated, this, &IntegrationPluginPhilipsHue::onTapDialRotaryEvent);
 
         m_tapDials.insert(hueTapDial, thing);
+        m_tapDialsIndex[thing->parentId()].insert(hueTapDial->rotaryId(), hueTapDial);
+        m_tapDialsIndex[thing->parentId()].insert(hueTapDial->switchId(), hueTapDial);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -549,6 +614,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueTap, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(hueTap, thing);
+        m_remotesIndex[thing->parentId()].insert(hueTap->id(), hueTap);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -564,6 +630,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(hueFoh, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(hueFoh, thing);
+        m_remotesIndex[thing->parentId()].insert(hueFoh->id(), hueFoh);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -579,6 +646,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(smartButton, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(smartButton, thing);
+        m_remotesIndex[thing->parentId()].insert(smartButton->id(), smartButton);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -594,6 +662,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         connect(wallSwitch, &HueRemote::buttonPressed, this, &IntegrationPluginPhilipsHue::onRemoteButtonEvent);
 
         m_remotes.insert(wallSwitch, thing);
+        m_remotesIndex[thing->parentId()].insert(wallSwitch->id(), wallSwitch);
         return info->finish(Thing::ThingErrorNoError);
     }
 
@@ -625,6 +694,9 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         });
 
         m_motionSensors.insert(motionSensor, thing);
+        m_motionSensorsIndex[thing->parentId()].insert(motionSensor->temperatureSensorId(), motionSensor);
+        m_motionSensorsIndex[thing->parentId()].insert(motionSensor->presenceSensorId(), motionSensor);
+        m_motionSensorsIndex[thing->parentId()].insert(motionSensor->lightSensorId(), motionSensor);
 
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -657,6 +729,9 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         });
 
         m_motionSensors.insert(outdoorSensor, thing);
+        m_motionSensorsIndex[thing->parentId()].insert(outdoorSensor->temperatureSensorId(), outdoorSensor);
+        m_motionSensorsIndex[thing->parentId()].insert(outdoorSensor->presenceSensorId(), outdoorSensor);
+        m_motionSensorsIndex[thing->parentId()].insert(outdoorSensor->lightSensorId(), outdoorSensor);
 
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -675,6 +750,7 @@ void IntegrationPluginPhilipsHue::setupThing(ThingSetupInfo *info)
         });
         connect(smartPlug, &HueLight::stateChanged, this, &IntegrationPluginPhilipsHue::lightStateChanged);
         m_lights.insert(smartPlug, thing);
+        m_lightsIndex[thing->parentId()].insert(smartPlug->id(), smartPlug);
         info->finish(Thing::ThingErrorNoError);
         return;
     }
@@ -697,6 +773,12 @@ void IntegrationPluginPhilipsHue::thingRemoved(Thing *thing)
         qCDebug(dcPhilipsHue()) << "Bridge removed" << thing->name();
         HueBridge *bridge = m_bridges.key(thing);
         m_bridges.remove(bridge);
+        m_lightsIndex.remove(thing->id());
+        m_remotesIndex.remove(thing->id());
+        m_tapDialsIndex.remove(thing->id());
+        m_motionSensorsIndex.remove(thing->id());
+        m_lightStateHashes.remove(thing->id());
+        m_sensorStateHashes.remove(thing->id());
         bridge->deleteLater();
     }
 
@@ -707,24 +789,38 @@ void IntegrationPluginPhilipsHue::thingRemoved(Thing *thing)
             || thing->thingClassId() == smartPlugThingClassId) {
         HueLight *light = m_lights.key(thing);
         m_lights.remove(light);
+        m_lightsIndex[thing->parentId()].remove(light->id());
+        m_lightStateHashes[thing->parentId()].remove(light->id());
         light->deleteLater();
     }
 
     if (thing->thingClassId() == remoteThingClassId || thing->thingClassId() == dimmerSwitch2ThingClassId || thing->thingClassId() == tapThingClassId || thing->thingClassId() == fohThingClassId || thing->thingClassId() == smartButtonThingClassId || thing->thingClassId() == wallSwitchThingClassId) {
         HueRemote *remote = m_remotes.key(thing);
         m_remotes.remove(remote);
+        m_remotesIndex[thing->parentId()].remove(remote->id());
+        m_sensorStateHashes[thing->parentId()].remove(remote->id());
         remote->deleteLater();
     }
 
     if (thing->thingClassId() == tapDialThingClassId) {
         HueTapDial *tapDial = m_tapDials.key(thing);
         m_tapDials.remove(tapDial);
+        m_tapDialsIndex[thing->parentId()].remove(tapDial->rotaryId());
+        m_tapDialsIndex[thing->parentId()].remove(tapDial->switchId());
+        m_sensorStateHashes[thing->parentId()].remove(tapDial->rotaryId());
+        m_sensorStateHashes[thing->parentId()].remove(tapDial->switchId());
         tapDial->deleteLater();
     }
 
     if (thing->thingClassId() == outdoorSensorThingClassId || thing->thingClassId() == motionSensorThingClassId) {
         HueMotionSensor *motionSensor = m_motionSensors.key(thing);
         m_motionSensors.remove(motionSensor);
+        m_motionSensorsIndex[thing->parentId()].remove(motionSensor->temperatureSensorId());
+        m_motionSensorsIndex[thing->parentId()].remove(motionSensor->presenceSensorId());
+        m_motionSensorsIndex[thing->parentId()].remove(motionSensor->lightSensorId());
+        m_sensorStateHashes[thing->parentId()].remove(motionSensor->temperatureSensorId());
+        m_sensorStateHashes[thing->parentId()].remove(motionSensor->presenceSensorId());
+        m_sensorStateHashes[thing->parentId()].remove(motionSensor->lightSensorId());
         motionSensor->deleteLater();
     }
 }
@@ -1069,7 +1165,9 @@ void IntegrationPluginPhilipsHue::executeAction(ThingActionInfo *info)
         }
 
         if (info->thing()->thingClassId() != bridgeThingClassId) {
-            m_lights.key(info->thing())->processActionResponse(jsonDoc.toVariant().toList());
+            HueLight *light = m_lights.key(info->thing());
+            light->processActionResponse(jsonDoc.toVariant().toList());
+            m_lightStateHashes[info->thing()->parentId()].remove(light->id());
         }
 
         info->finish(Thing::ThingErrorNoError);
@@ -2246,16 +2344,24 @@ void IntegrationPluginPhilipsHue::processLightsRefreshResponse(Thing *thing, con
         return;
     }
 
-    // Update light states
-    QVariantMap lightsMap = jsonDoc.toVariant().toMap();
-    foreach (const QString &lightId, lightsMap.keys()) {
-        QVariantMap lightMap = lightsMap.value(lightId).toMap();
+    // Update light states, only decode the ones which have changed since the last refresh
+    const QHash<int, HueLight *> lights = m_lightsIndex.value(thing->id());
+    QHash<int, uint> &stateHashes = m_lightStateHashes[thing->id()];
+    QJsonObject lightsObject = jsonDoc.object();
+    for (QJsonObject::const_iterator it = lightsObject.constBegin(); it != lightsObject.constEnd(); ++it) {
         // get the light of this bridge
-        foreach (HueLight *light, m_lights.keys()) {
-            if (light->id() == lightId.toInt() && m_lights.value(light)->parentId() == thing->id()) {
-                light->updateStates(lightMap.value("state").toMap());
-            }
-        }
+        int lightId = it.key().toInt();
+        HueLight *light = lights.value(lightId);
+        if (!light)
+            continue;
+
+        QJsonObject stateObject = it.value().toObject().value("state").toObject();
+        uint stateHash = jsonHash(stateObject);
+        if (stateHashes.contains(lightId) && stateHashes.value(lightId) == stateHash)
+            continue;
+
+        stateHashes.insert(lightId, stateHash);
+        light->updateStates(stateObject.toVariantMap());
     }
 }
 
@@ -2271,36 +2377,77 @@ void IntegrationPluginPhilipsHue::processSensorsRefreshResponse(Thing *thing, co
     }
 
     // check response error
-    if (!jsonDoc.toVariant().toList().isEmpty()) {
+    if (jsonDoc.isArray() && !jsonDoc.array().isEmpty()) {
         qCWarning(dcPhilipsHue) << "Failed to refresh Hue Sensors:" << jsonDoc.toVariant().toList().first().toMap().value("error").toMap().value("description").toString();
         return;
     }
 
     // Update sensor states
-    QVariantMap sensorsMap = jsonDoc.toVariant().toMap();
-    foreach (const QString &sensorId, sensorsMap.keys()) {
-        QVariantMap sensorMap = sensorsMap.value(sensorId).toMap();
+    const QHash<int, HueRemote *> remotes = m_remotesIndex.value(thing->id());
+    const QHash<int, HueTapDial *> tapDials = m_tapDialsIndex.value(thing->id());
+    const QHash<int, HueMotionSensor *> motionSensors = m_motionSensorsIndex.value(thing->id());
+    QHash<int, uint> &stateHashes = m_sensorStateHashes[thing->id()];
+    QJsonObject sensorsObject = jsonDoc.object();
+    for (QJsonObject::const_iterator it = sensorsObject.constBegin(); it != sensorsObject.constEnd(); ++it) {
+        int id = it.key().toInt();
+        HueRemote *remote = remotes.value(id);
+        HueTapDial *tapDial = tapDials.value(id);
+        HueMotionSensor *motionSensor = motionSensors.value(id);
+        if (!remote && !tapDial && !motionSensor)
+            continue;
+
+        // Only decode the sensors which have changed since the last refresh. An ongoing
+        // presence needs to be passed on anyways, it keeps the motion sensor timeout running.
+        QJsonObject sensorObject = it.value().toObject();
+        QJsonObject stateObject = sensorObject.value("state").toObject();
+        uint stateHash = jsonHash(stateObject, jsonHash(sensorObject.value("config").toObject()));
+        bool present = motionSensor && stateObject.value("presence").toBool();
+        if (!present && stateHashes.contains(id) && stateHashes.value(id) == stateHash)
+            continue;
+
+        stateHashes.insert(id, stateHash);
+        QVariantMap sensorMap = sensorObject.toVariantMap();
 
         // Remotes
-        foreach (HueRemote *remote, m_remotes.keys()) {
-            if (remote->id() == sensorId.toInt() && m_remotes.value(remote)->parentId() == thing->id()) {
-                remote->updateStates(sensorMap.value("state").toMap(), sensorMap.value("config").toMap());
-            }
+        if (remote) {
+            remote->updateStates(sensorMap.value("state").toMap(), sensorMap.value("config").toMap());
+            continue;
         }
 
         // Tap dials
-        foreach (HueTapDial *tapDial, m_tapDials.keys()) {
-            if (tapDial->hasSensor(sensorId.toInt()) && m_tapDials.value(tapDial)->parentId() == thing->id()) {
-                tapDial->updateStates(sensorMap);
-            }
+        if (tapDial) {
+            tapDial->updateStates(sensorMap);
+            continue;
         }
 
         // Motion sensors
-        foreach (HueMotionSensor *motionSensor, m_motionSensors.keys()) {
-            if (motionSensor->hasSensor(sensorId.toInt()) && m_motionSensors.value(motionSensor)->parentId() == thing->id()) {
-                motionSensor->updateStates(sensorMap);
-            }
-        }
+        motionSensor->updateStates(sensorMap);
+    }
+}
+
+void IntegrationPluginPhilipsHue::processEventStreamLight(Thing *thing, int lightId, const QVariantMap &resource)
+{
+    HueLight *light = m_lightsIndex.value(thing->id()).value(lightId);
+    if (!light)
+        return;
+
+    light->updateStatesFromEvent(resource);
+    // The states don't match the last polled data any more, make sure the next poll gets processed
+    m_lightStateHashes[thing->id()].remove(lightId);
+}
+
+void IntegrationPluginPhilipsHue::processEventStreamSensor(Thing *thing, int sensorId, const QVariantMap &resource)
+{
+    HueMotionSensor *motionSensor = m_motionSensorsIndex.value(thing->id()).value(sensorId);
+    if (motionSensor) {
+        motionSensor->updateStatesFromEvent(sensorId, resource);
+        m_sensorStateHashes[thing->id()].remove(sensorId);
+        return;
+    }
+
+    // Button and rotary events can't be mapped to the API v1 event codes, fetch them from the bridge right away
+    if (m_remotesIndex.value(thing->id()).contains(sensorId) || m_tapDialsIndex.value(thing->id()).contains(sensorId)) {
+        refreshSensors(m_bridges.key(thing));
     }
 }
 
@@ -2532,6 +2679,35 @@ int IntegrationPluginPhilipsHue::percentageToBrightness(int percentage)
     return qRound((255.0 * percentage) / 100.0);
 }
 
+uint IntegrationPluginPhilipsHue::jsonHash(const QJsonValue &value, uint seed)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        return qHash(value.toBool(), seed);
+    case QJsonValue::Double:
+        return qHash(value.toDouble(), seed);
+    case QJsonValue::String:
+        return qHash(value.toString(), seed);
+    case QJsonValue::Array: {
+        uint hash = seed;
+        foreach (const QJsonValue &item, value.toArray()) {
+            hash = jsonHash(item, hash * 31);
+        }
+        return hash;
+    }
+    case QJsonValue::Object: {
+        QJsonObject object = value.toObject();
+        uint hash = seed;
+        for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it) {
+            hash = jsonHash(it.value(), qHash(it.key(), hash * 31));
+        }
+        return hash;
+    }
+    default:
+        return qHash(static_cast<int>(value.type()), seed);
+    }
+}
+
 void IntegrationPluginPhilipsHue::abortRequests(QHash<QNetworkReply *, Thing *> requestList, Thing *thing)
 {
     foreach (QNetworkReply* reply, requestList.keys()) {
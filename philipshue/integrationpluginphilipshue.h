@@ -33,6 +33,7 @@
 
 #include "integrations/integrationplugin.h"
 #include "huebridge.h"
+#include "hueeventstream.h"
 #include "huelight.h"
 #include "hueremote.h"
 #include "huemotionsensor.h"
@@ -46,6 +47,7 @@
 
 
 class QNetworkReply;
+class QJsonValue;
 
 class IntegrationPluginPhilipsHue: public IntegrationPlugin
 {
@@ -114,6 +116,7 @@ private:
     PluginTimer *m_pluginTimer1Sec = nullptr;
     PluginTimer *m_pluginTimer5Sec = nullptr;
     PluginTimer *m_pluginTimer15Sec = nullptr;
+    PluginTimer *m_pluginTimer60Sec = nullptr;
 
     QList<HueLight *> m_unconfiguredLights;
 
@@ -132,6 +135,16 @@ private:
     QHash<HueTapDial *, Thing *> m_tapDials;
     QHash<HueMotionSensor *, Thing *> m_motionSensors;
 
+    // Per bridge lookup of the devices by their resource id on that bridge (bridge thing id -> (id -> device))
+    QHash<ThingId, QHash<int, HueLight *>> m_lightsIndex;
+    QHash<ThingId, QHash<int, HueRemote *>> m_remotesIndex;
+    QHash<ThingId, QHash<int, HueTapDial *>> m_tapDialsIndex;
+    QHash<ThingId, QHash<int, HueMotionSensor *>> m_motionSensorsIndex;
+
+    // Hash of the last applied state per resource (bridge thing id -> (id -> hash))
+    QHash<ThingId, QHash<int, uint>> m_lightStateHashes;
+    QHash<ThingId, QHash<int, uint>> m_sensorStateHashes;
+
     void refreshLight(Thing *thing);
     void refreshBridge(Thing *thing);
 
@@ -151,6 +164,8 @@ private:
     void processLightsRefreshResponse(Thing *thing, const QByteArray &data);
     void processSensorsRefreshResponse(Thing *thing, const QByteArray &data);
     void processSetNameResponse(Thing *thing, const QByteArray &data);
+    void processEventStreamLight(Thing *thing, int lightId, const QVariantMap &resource);
+    void processEventStreamSensor(Thing *thing, int sensorId, const QVariantMap &resource);
 
     void bridgeReachableChanged(Thing *thing, bool reachable);
 
@@ -158,6 +173,8 @@ private:
     bool lightAlreadyAdded(const QString &uuid);
     bool sensorAlreadyAdded(const QString &uuid);
 
+    static uint jsonHash(const QJsonValue &value, uint seed = 0);
+
     int brightnessToPercentage(int brightness);
     int percentageToBrightness(int percentage);
 
@@ -4,11 +4,14 @@ TARGET = $$qtLibraryTarget(nymea_integrationpluginphilipshue)
 
 QT += network
 
+include(../common/eventstreamparser/eventstreamparser.pri)
+
 SOURCES += \
     integrationpluginphilipshue.cpp \
     #huebridgeconnection.cpp \
     #light.cpp \
     huebridge.cpp \
+    hueeventstream.cpp \
     huelight.cpp \
     huemotionsensor.cpp \
     hueremote.cpp \
@@ -21,6 +24,7 @@ HEADERS += \
     #light.h \
     #lightinterface.h \
     huebridge.h \
+    hueeventstream.h \
     huelight.h \
     huemotionsensor.h \
     hueremote.h \
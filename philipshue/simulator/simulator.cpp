@@ -0,0 +1,302 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Stand-in for the CLIP v2 event stream of a Hue bridge. Serves GET /eventstream/clip/v2 and plays
+// a script of update events in a loop, writing each frame in the given pieces so the plugin sees
+// events split across reads, including CRLF line endings split between the CR and the LF.
+//
+// Each script entry is written after "delay" ms and either holds the JSON array of a server-sent
+// event in "data" or a keep-alive "comment". "lineEnding" is "\n" (default), "\r\n" or "\r", "split"
+// lists the byte offsets at which the frame is cut, negative offsets count from its end.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QSslKey>
+#include <QSslSocket>
+#include <QTcpServer>
+#include <QTimer>
+
+#include <algorithm>
+
+struct Step {
+    int delay = 1000;
+    QList<QByteArray> pieces;
+};
+
+static QList<Step> loadScript(const QString &fileName, bool *ok)
+{
+    QList<Step> script;
+    *ok = false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open script" << fileName << file.errorString();
+        return script;
+    }
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Cannot parse script" << fileName << error.errorString();
+        return script;
+    }
+
+    int eventId = 0;
+    foreach (const QVariant &stepVariant, jsonDoc.toVariant().toList()) {
+        QVariantMap stepMap = stepVariant.toMap();
+        QByteArray lineEnding = stepMap.value("lineEnding", "\n").toByteArray();
+
+        QByteArray frame;
+        if (stepMap.contains("comment")) {
+            frame = ": " + stepMap.value("comment").toByteArray() + lineEnding + lineEnding;
+        } else {
+            QByteArray id = QByteArray::number(QDateTime::currentSecsSinceEpoch()) + ':' + QByteArray::number(eventId++);
+            QByteArray data = QJsonDocument::fromVariant(stepMap.value("data")).toJson(QJsonDocument::Compact);
+            frame = "id: " + id + lineEnding + "data: " + data + lineEnding + lineEnding;
+        }
+
+        QList<int> offsets;
+        foreach (const QVariant &offsetVariant, stepMap.value("split").toList()) {
+            int offset = offsetVariant.toInt();
+            if (offset < 0)
+                offset += frame.size();
+            if (offset > 0 && offset < frame.size() && !offsets.contains(offset))
+                offsets.append(offset);
+        }
+        std::sort(offsets.begin(), offsets.end());
+
+        Step step;
+        step.delay = stepMap.value("delay", 1000).toInt();
+        int start = 0;
+        foreach (int offset, offsets) {
+            step.pieces.append(frame.mid(start, offset - start));
+            start = offset;
+        }
+        step.pieces.append(frame.mid(start));
+        script.append(step);
+    }
+
+    *ok = !script.isEmpty();
+    return script;
+}
+
+// One client connection, answers the request and plays the script
+class Connection : public QObject
+{
+public:
+    Connection(QTcpSocket *socket, const QList<Step> &script, bool loop) :
+        QObject(socket),
+        m_socket(socket),
+        m_script(script),
+        m_loop(loop)
+    {
+        m_timer.setSingleShot(true);
+        connect(&m_timer, &QTimer::timeout, this, &Connection::writeNext);
+        connect(m_socket, &QTcpSocket::readyRead, this, &Connection::onReadyRead);
+        connect(m_socket, &QTcpSocket::disconnected, this, [this](){
+            qInfo() << "Client" << m_socket->peerAddress().toString() << "disconnected";
+            m_timer.stop();
+            m_socket->deleteLater();
+        });
+    }
+
+private:
+    void onReadyRead()
+    {
+        if (m_streaming) {
+            m_socket->readAll();
+            return;
+        }
+
+        m_request.append(m_socket->readAll());
+        int headerEnd = m_request.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            if (m_request.size() > 65536)
+                m_socket->disconnectFromHost();
+            return;
+        }
+
+        QList<QByteArray> lines = m_request.left(headerEnd).split('\n');
+        QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+        QHash<QByteArray, QByteArray> headers;
+        foreach (const QByteArray &line, lines) {
+            int colon = line.indexOf(':');
+            if (colon > 0) {
+                headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+            }
+        }
+
+        if (requestLine.count() < 2 || requestLine.at(0) != "GET" || requestLine.at(1) != "/eventstream/clip/v2") {
+            qInfo() << "Client" << m_socket->peerAddress().toString() << "requested" << requestLine;
+            m_socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            m_socket->disconnectFromHost();
+            return;
+        }
+        if (!headers.contains("hue-application-key")) {
+            qInfo() << "Client" << m_socket->peerAddress().toString() << "did not send an application key";
+            m_socket->write("HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            m_socket->disconnectFromHost();
+            return;
+        }
+
+        qInfo() << "Client" << m_socket->peerAddress().toString() << "connected, key" << headers.value("hue-application-key")
+                << "Last-Event-ID" << headers.value("last-event-id", "none");
+        m_streaming = true;
+        m_request.clear();
+        m_socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n");
+        m_socket->write(": hi\n\n");
+        m_timer.start(m_script.first().delay);
+    }
+
+    void writeNext()
+    {
+        const Step &step = m_script.at(m_step);
+        m_socket->write(step.pieces.at(m_piece));
+        m_socket->flush();
+
+        // Pause between the pieces of a frame so they arrive in separate reads
+        if (++m_piece < step.pieces.count()) {
+            m_timer.start(50);
+            return;
+        }
+
+        qInfo() << "Sent step" << m_step << "in" << step.pieces.count() << "pieces";
+        m_piece = 0;
+        if (++m_step >= m_script.count()) {
+            if (!m_loop) {
+                m_socket->disconnectFromHost();
+                return;
+            }
+            m_step = 0;
+        }
+        m_timer.start(m_script.at(m_step).delay);
+    }
+
+    QTcpSocket *m_socket = nullptr;
+    QList<Step> m_script;
+    bool m_loop = true;
+
+    QByteArray m_request;
+    bool m_streaming = false;
+    QTimer m_timer;
+    int m_step = 0;
+    int m_piece = 0;
+};
+
+class Simulator : public QTcpServer
+{
+public:
+    Simulator(const QList<Step> &script, bool loop) :
+        m_script(script),
+        m_loop(loop)
+    {
+    }
+
+    bool setCertificate(const QString &certificateFileName, const QString &keyFileName)
+    {
+        QFile certificateFile(certificateFileName);
+        QFile keyFile(keyFileName);
+        if (!certificateFile.open(QIODevice::ReadOnly) || !keyFile.open(QIODevice::ReadOnly)) {
+            qWarning() << "Cannot open" << certificateFileName << "or" << keyFileName;
+            return false;
+        }
+        m_certificate = QSslCertificate(&certificateFile, QSsl::Pem);
+        m_key = QSslKey(&keyFile, QSsl::Rsa, QSsl::Pem);
+        m_tls = !m_certificate.isNull() && !m_key.isNull();
+        return m_tls;
+    }
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        QTcpSocket *socket = nullptr;
+        if (m_tls) {
+            QSslSocket *sslSocket = new QSslSocket(this);
+            sslSocket->setLocalCertificate(m_certificate);
+            sslSocket->setPrivateKey(m_key);
+            sslSocket->setSocketDescriptor(socketDescriptor);
+            sslSocket->startServerEncryption();
+            socket = sslSocket;
+        } else {
+            socket = new QTcpSocket(this);
+            socket->setSocketDescriptor(socketDescriptor);
+        }
+        new Connection(socket, m_script, m_loop);
+    }
+
+private:
+    QList<Step> m_script;
+    bool m_loop = true;
+    bool m_tls = false;
+    QSslCertificate m_certificate;
+    QSslKey m_key;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Serves a scripted CLIP v2 event stream like a Hue bridge.");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "Port to listen on, the plugin connects to 443.", "port", "443");
+    QCommandLineOption scriptOption("script", "Event script to play.", "file", QString(SIMULATOR_DIR) + "/script.json");
+    QCommandLineOption plainOption("plain", "Serve plain HTTP instead of HTTPS, e.g. for curl.");
+    QCommandLineOption onceOption("once", "Close the stream after playing the script once.");
+    parser.addOptions({portOption, scriptOption, plainOption, onceOption});
+    parser.process(application);
+
+    bool ok = false;
+    QList<Step> script = loadScript(parser.value(scriptOption), &ok);
+    if (!ok) {
+        qWarning() << "The script does not contain any steps";
+        return 1;
+    }
+
+    Simulator simulator(script, !parser.isSet(onceOption));
+    if (!parser.isSet(plainOption) && !simulator.setCertificate(QString(SIMULATOR_DIR) + "/simulator.crt", QString(SIMULATOR_DIR) + "/simulator.key")) {
+        qWarning() << "Cannot load the TLS certificate, use --plain to serve HTTP";
+        return 1;
+    }
+
+    quint16 port = parser.value(portOption).toUShort();
+    if (!simulator.listen(QHostAddress::Any, port)) {
+        qWarning() << "Cannot listen on port" << port << simulator.errorString();
+        return 1;
+    }
+
+    qInfo() << "Serving" << script.count() << "steps on port" << port << (parser.isSet(plainOption) ? "(HTTP)" : "(HTTPS)");
+    return application.exec();
+}
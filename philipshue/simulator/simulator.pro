@@ -0,0 +1,9 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT -= gui
+QT += network
+
+DEFINES += SIMULATOR_DIR=\\\"$$PWD\\\"
+
+SOURCES += simulator.cpp
@@ -0,0 +1,466 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Replays recorded CoIoT status PDUs against the multicast handling of the plugin, comparing the
+// former search through all things (parent by shelly id, children by parent, class and channel) with
+// the routing tables. Both sides apply the same state updates to their own copy of the things, which
+// have to be identical afterwards.
+//
+// coiot-100.json holds the things of a setup with 60 shellies (Shelly 1, 2.5 as relay with switch and
+// power meter children or as roller, Plug S and EM with channel children) and 5 rounds of status
+// messages of these plus 40 shellies on the LAN which are not set up, as raw CoAP datagrams in hex.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QStringList>
+#include <QUuid>
+#include <QVariantMap>
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+// Stand-in for Thing, states which the thing class doesn't have are ignored like in nymea
+struct Thing {
+    QUuid id = QUuid::createUuid();
+    QUuid parentId;
+    QString thingClass;
+    QVariantMap params;
+    QStringList interfaces;
+    QHash<QString, QVariant> states;
+    int events = 0;
+
+    bool hasState(const QString &name) const { return states.contains(name); }
+    QVariant stateValue(const QString &name) const { return states.value(name); }
+    void setStateValue(const QString &name, const QVariant &value)
+    {
+        QHash<QString, QVariant>::iterator it = states.find(name);
+        if (it != states.end())
+            it.value() = value;
+    }
+};
+typedef QList<Thing *> Things;
+
+static Thing *createThing(const QString &thingClass, const QUuid &parentId, const QVariantMap &params)
+{
+    static const QHash<QString, QStringList> classStates = {
+        {"shelly1", {"connected", "power", "temperature"}},
+        {"shelly25", {"connected", "channel1", "channel2", "temperature"}},
+        {"shellyPlug", {"connected", "power", "currentPower", "totalEnergyConsumed", "temperature"}},
+        {"shellyEm", {"connected", "power", "currentPowerPhaseA", "currentPowerPhaseB", "voltagePhaseA", "voltagePhaseB"}},
+        {"shellySwitch", {"connected", "power"}},
+        {"shellyPowerMeterChannel", {"connected", "currentPower", "totalEnergyConsumed"}},
+        {"shellyRoller", {"connected", "percentage", "currentPower", "moving"}},
+        {"shellyEmChannel", {"connected", "currentPower", "voltagePhaseA"}}
+    };
+
+    Thing *thing = new Thing;
+    thing->thingClass = thingClass;
+    thing->parentId = parentId;
+    thing->params = params;
+    if (thingClass == "shellyRoller")
+        thing->interfaces.append("extendedshutter");
+    foreach (const QString &state, classStates.value(thingClass)) {
+        thing->states.insert(state, QVariant());
+    }
+    return thing;
+}
+
+static Things createThings(const QVariantList &thingList)
+{
+    Things things;
+    foreach (const QVariant &thingVariant, thingList) {
+        QVariantMap thingMap = thingVariant.toMap();
+        Thing *parent = createThing(thingMap.value("class").toString(), QUuid(), {{"id", thingMap.value("id")}});
+        things.append(parent);
+        foreach (const QVariant &childVariant, thingMap.value("children").toList()) {
+            QVariantMap childMap = childVariant.toMap();
+            things.append(createThing(childMap.value("class").toString(), parent->id, {{"channel", childMap.value("channel")}}));
+        }
+    }
+    return things;
+}
+
+struct Pdu {
+    int code = 0;
+    QByteArray deviceId;
+    QByteArray payload;
+};
+
+// Minimal CoAP decoder, just enough for the code, the CoIoT device id option (3321) and the payload
+static bool decodePdu(const QByteArray &data, Pdu &pdu)
+{
+    if (data.size() < 4 || (static_cast<quint8>(data.at(0)) >> 6) != 1)
+        return false;
+
+    pdu.code = static_cast<quint8>(data.at(1));
+    int pos = 4 + (static_cast<quint8>(data.at(0)) & 0x0f);
+    int option = 0;
+    while (pos < data.size()) {
+        quint8 byte = static_cast<quint8>(data.at(pos++));
+        if (byte == 0xff) {
+            pdu.payload = data.mid(pos);
+            break;
+        }
+        int values[2] = { byte >> 4, byte & 0x0f };
+        for (int i = 0; i < 2; i++) {
+            if (values[i] == 13) {
+                values[i] = static_cast<quint8>(data.at(pos++)) + 13;
+            } else if (values[i] == 14) {
+                values[i] = (static_cast<quint8>(data.at(pos)) << 8 | static_cast<quint8>(data.at(pos + 1))) + 269;
+                pos += 2;
+            } else if (values[i] == 15) {
+                return false;
+            }
+        }
+        option += values[0];
+        if (option == 3321)
+            pdu.deviceId = data.mid(pos, values[1]);
+        pos += values[1];
+    }
+    return pos <= data.size();
+}
+
+// Former lookup: myThings() is searched for the parent and filtered for the children of every message
+class ScanRouter
+{
+public:
+    explicit ScanRouter(const Things &things) : m_things(things) { }
+
+    Thing *thing(const QString &shellyId)
+    {
+        foreach (Thing *t, m_things) {
+            if (t->params.value("id").toString().endsWith(shellyId)) {
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    Things children(Thing *parent)
+    {
+        Things result;
+        foreach (Thing *t, m_things) {
+            if (t->parentId == parent->id)
+                result.append(t);
+        }
+        return result;
+    }
+
+    // filterByParentId().filterByThingClassId().filterByParam()
+    Things children(Thing *parent, const QString &thingClass, int channel)
+    {
+        Things byClass;
+        foreach (Thing *t, children(parent)) {
+            if (t->thingClass == thingClass)
+                byClass.append(t);
+        }
+        Things result;
+        foreach (Thing *t, byClass) {
+            if (t->params.value("channel") == channel)
+                result.append(t);
+        }
+        return result;
+    }
+
+private:
+    Things m_things;
+};
+
+// Current lookup: shelly id -> parent and parent -> class -> channel -> children, filled on demand
+class IndexRouter
+{
+public:
+    explicit IndexRouter(const Things &things) : m_things(things) { }
+
+    Thing *thing(const QString &shellyId)
+    {
+        QHash<QString, Thing *>::const_iterator it = m_coiotThings.constFind(shellyId);
+        if (it != m_coiotThings.constEnd()) {
+            return it.value();
+        }
+
+        Thing *thing = nullptr;
+        foreach (Thing *t, m_things) {
+            if (t->parentId.isNull() && t->params.value("id").toString().endsWith(shellyId)) {
+                thing = t;
+                break;
+            }
+        }
+        m_coiotThings.insert(shellyId, thing);
+        return thing;
+    }
+
+    Things children(Thing *parent)
+    {
+        return routing(parent).all;
+    }
+
+    Things children(Thing *parent, const QString &thingClass, int channel)
+    {
+        return routing(parent).byChannel.value(thingClass).value(channel);
+    }
+
+private:
+    struct Children {
+        Things all;
+        QHash<QString, QHash<int, Things>> byChannel;
+    };
+
+    const Children &routing(Thing *parent)
+    {
+        QHash<Thing *, Children>::iterator it = m_coiotChildren.find(parent);
+        if (it == m_coiotChildren.end()) {
+            Children children;
+            foreach (Thing *child, m_things) {
+                if (child->parentId != parent->id)
+                    continue;
+                children.all.append(child);
+                children.byChannel[child->thingClass][child->params.value("channel").toInt()].append(child);
+            }
+            it = m_coiotChildren.insert(parent, children);
+        }
+        return it.value();
+    }
+
+    Things m_things;
+    QHash<QString, Thing *> m_coiotThings;
+    QHash<Thing *, Children> m_coiotChildren;
+};
+
+// The part of IntegrationPluginShelly::onMulticastMessageReceived() the recorded devices use
+template<typename Router>
+static void processPdu(Router &router, const Pdu &pdu, int &unknown)
+{
+    if (pdu.code != 0x1e)
+        return;
+
+    QStringList parts = QString(pdu.deviceId).split("#");
+    if (parts.length() != 3)
+        return;
+
+    Thing *thing = router.thing(parts.at(1));
+    if (!thing) {
+        unknown++;
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(pdu.payload, &error);
+    if (error.error != QJsonParseError::NoError)
+        return;
+
+    QVariantMap map = jsonDoc.toVariant().toMap();
+
+    thing->setStateValue("connected", true);
+    foreach (Thing *child, router.children(thing)) {
+        child->setStateValue("connected", true);
+    }
+
+    foreach (const QVariant &entry, map.value("G").toList()) {
+        int id = entry.toList().at(1).toInt();
+        QString value = entry.toList().at(2).toString();
+        switch (id) {
+        case 1101:
+            if (thing->hasState("power")) {
+                thing->setStateValue("power", value.toInt() == 1);
+            } else if (thing->hasState("channel1")) {
+                thing->setStateValue("channel1", value.toInt() == 1);
+            }
+            break;
+        case 1103:
+            foreach (Thing *roller, router.children(thing)) {
+                if (roller->interfaces.contains("extendedshutter"))
+                    roller->setStateValue("percentage", 100 - value.toUInt());
+            }
+            break;
+        case 1201:
+            thing->setStateValue("channel2", value.toInt() == 1);
+            break;
+        case 2101:
+        case 2201: {
+            bool on = value.toInt() == 1;
+            foreach (Thing *child, router.children(thing, "shellySwitch", id == 2101 ? 1 : 2)) {
+                if (child->stateValue("power").toBool() != on) {
+                    child->setStateValue("power", on);
+                    child->events++;
+                }
+            }
+            break;
+        }
+        case 3101:
+            thing->setStateValue("temperature", value.toDouble());
+            break;
+        case 4101:
+            if (thing->hasState("currentPower")) {
+                thing->setStateValue("currentPower", value);
+            }
+            foreach (Thing *child, router.children(thing, "shellyPowerMeterChannel", 1)) {
+                child->setStateValue("currentPower", value.toDouble());
+            }
+            break;
+        case 4201:
+            foreach (Thing *child, router.children(thing, "shellyPowerMeterChannel", 2)) {
+                child->setStateValue("currentPower", value.toDouble());
+            }
+            break;
+        case 4102:
+            foreach (Thing *child, router.children(thing, "shellyRoller", 1)) {
+                child->setStateValue("currentPower", value);
+            }
+            break;
+        case 4103:
+            if (thing->hasState("totalEnergyConsumed")) {
+                thing->setStateValue("totalEnergyConsumed", value.toDouble() / 60 / 1000);
+            }
+            foreach (Thing *child, router.children(thing, "shellyPowerMeterChannel", 1)) {
+                child->setStateValue("totalEnergyConsumed", value.toDouble() / 60 / 1000);
+            }
+            break;
+        case 4203:
+            foreach (Thing *child, router.children(thing, "shellyPowerMeterChannel", 2)) {
+                child->setStateValue("totalEnergyConsumed", value.toDouble() / 60 / 1000);
+            }
+            break;
+        case 4105:
+        case 4205:
+            if (thing->hasState(id == 4105 ? "currentPowerPhaseA" : "currentPowerPhaseB")) {
+                thing->setStateValue(id == 4105 ? "currentPowerPhaseA" : "currentPowerPhaseB", value.toDouble());
+            }
+            foreach (Thing *child, router.children(thing, "shellyEmChannel", id == 4105 ? 1 : 2)) {
+                child->setStateValue("currentPower", value.toDouble());
+            }
+            break;
+        case 4108:
+        case 4208:
+            if (thing->hasState(id == 4108 ? "voltagePhaseA" : "voltagePhaseB")) {
+                thing->setStateValue(id == 4108 ? "voltagePhaseA" : "voltagePhaseB", value.toDouble());
+            }
+            foreach (Thing *child, router.children(thing, "shellyEmChannel", id == 4108 ? 1 : 2)) {
+                child->setStateValue("voltagePhaseA", value.toDouble() / 1000);
+            }
+            break;
+        }
+    }
+
+    if (thing->thingClass == "shelly25") {
+        foreach (Thing *roller, router.children(thing)) {
+            if (!roller->interfaces.contains("extendedshutter"))
+                continue;
+            bool moving = thing->stateValue("channel1").toBool() || thing->stateValue("channel2").toBool();
+            roller->setStateValue("moving", moving);
+        }
+    }
+}
+
+template<typename Router>
+static qint64 replay(Router &router, const QList<Pdu> &pdus, int rounds, int &unknown)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rounds; i++) {
+        foreach (const Pdu &pdu, pdus) {
+            processPdu(router, pdu, unknown);
+        }
+    }
+    return timer.nsecsElapsed();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QString fileName = QString(SAMPLE_DIR) + "/coiot-100.json";
+    if (application.arguments().count() > 1)
+        fileName = application.arguments().at(1);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open" << fileName << file.errorString();
+        return 1;
+    }
+    QVariantMap recording = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+
+    // The CoAP decoding is the same for both sides and not part of the measurement
+    QList<Pdu> pdus;
+    foreach (const QVariant &pduVariant, recording.value("pdus").toList()) {
+        Pdu pdu;
+        if (!decodePdu(QByteArray::fromHex(pduVariant.toByteArray()), pdu)) {
+            qWarning() << "Skipping invalid PDU" << pduVariant.toString();
+            continue;
+        }
+        pdus.append(pdu);
+    }
+    if (pdus.isEmpty()) {
+        qWarning() << fileName << "does not contain any PDUs";
+        return 1;
+    }
+
+    Things scanThings = createThings(recording.value("things").toList());
+    Things indexThings = createThings(recording.value("things").toList());
+    qInfo().noquote() << "Replaying" << pdus.count() << "PDUs against" << scanThings.count() << "things";
+
+    const int rounds = qMax(1, 100000 / pdus.count());
+    int scanUnknown = 0;
+    int indexUnknown = 0;
+    ScanRouter scanRouter(scanThings);
+    IndexRouter indexRouter(indexThings);
+    qint64 scanTime = replay(scanRouter, pdus, rounds, scanUnknown);
+    qint64 indexTime = replay(indexRouter, pdus, rounds, indexUnknown);
+
+    qint64 total = static_cast<qint64>(pdus.count()) * rounds;
+    qInfo().noquote() << QString("search myThings(): %1 us/PDU").arg(scanTime / 1000.0 / total, 0, 'f', 3);
+    qInfo().noquote() << QString("routing tables:    %1 us/PDU").arg(indexTime / 1000.0 / total, 0, 'f', 3);
+    qInfo().noquote() << QString("speedup:           %1x").arg(static_cast<double>(scanTime) / indexTime, 0, 'f', 2);
+
+    bool statesEqual = true;
+    bool eventsEqual = true;
+    for (int i = 0; i < scanThings.count(); i++) {
+        statesEqual &= scanThings.at(i)->states == indexThings.at(i)->states;
+        eventsEqual &= scanThings.at(i)->events == indexThings.at(i)->events;
+    }
+    check(statesEqual, "All things end up with the same states");
+    check(eventsEqual, "All switch children emitted the same pressed events");
+    check(scanUnknown == indexUnknown, QString("Both skip the messages of unknown shellies (%1)").arg(scanUnknown / rounds));
+
+    qDeleteAll(scanThings);
+    qDeleteAll(indexThings);
+    return s_failures > 0 ? 1 : 0;
+}
@@ -228,6 +228,8 @@ void IntegrationPluginShelly::setupThing(ThingSetupInfo *info)
 
 void IntegrationPluginShelly::postSetupThing(Thing *thing)
 {
+    resetCoiotRouting();
+
     if (!m_statusUpdateTimer) {
         m_statusUpdateTimer = hardwareManager()->pluginTimerManager()->registerTimer(60);
         connect(m_statusUpdateTimer, &PluginTimer::timeout, this, &IntegrationPluginShelly::updateStatus);
@@ -282,6 +284,8 @@ void IntegrationPluginShelly::postSetupThing(Thing *thing)
 
 void IntegrationPluginShelly::thingRemoved(Thing *thing)
 {
+    resetCoiotRouting();
+
     if (myThings().isEmpty() && m_statusUpdateTimer) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_statusUpdateTimer);
         m_statusUpdateTimer = nullptr;
@@ -786,13 +790,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
     }
 
     QString shellyId = parts.at(1);
-    Thing *thing = nullptr;
-    foreach (Thing *t, myThings()) {
-        if (t->paramValue("id").toString().endsWith(shellyId)) {
-            thing = t;
-            break;
-        }
-    }
+    Thing *thing = coiotThing(shellyId);
     if (!thing) {
         qCDebug(dcShelly()) << "Received a status update message for a shelly we don't know.";
         return;
@@ -810,7 +808,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
     QVariantMap map = jsonDoc.toVariant().toMap();
 
     thing->setStateValue("connected", true);
-    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+    foreach (Thing *child, coiotChildren(thing).all) {
         child->setStateValue("connected", true);
     }
     // Remember when we recieved the last update
@@ -834,7 +832,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             }
             break;
         case 1103: // Roller position
-            foreach (Thing *roller, myThings().filterByParentId(thing->id()).filterByInterface("extendedshutter")) {
+            foreach (Thing *roller, coiotChildren(thing).all.filterByInterface("extendedshutter")) {
                 roller->setStateValue(shellyRollerPercentageStateTypeId, 100 - value.toUInt());
             }
             break;
@@ -851,7 +849,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
                 thing->setStateValue(shellyI3Input1StateTypeId, on);
                 break;
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellySwitchThingClassId).filterByParam(shellySwitchThingChannelParamTypeId, channel)) {
+            foreach (Thing *child, coiotChildren(thing, shellySwitchThingClassId, channel)) {
                 if (child->stateValue(shellySwitchPowerStateTypeId).toBool() != on) {
                     child->setStateValue(shellySwitchPowerStateTypeId, on);
                     emit emitEvent(Event(shellySwitchPressedEventTypeId, child->id()));
@@ -872,7 +870,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
                 thing->setStateValue(shellyI3Input2StateTypeId, on);
                 break;
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellySwitchThingClassId).filterByParam(shellySwitchThingChannelParamTypeId, channel)) {
+            foreach (Thing *child, coiotChildren(thing, shellySwitchThingClassId, channel)) {
                 if (child->stateValue(shellySwitchPowerStateTypeId).toBool() != on) {
                     child->setStateValue(shellySwitchPowerStateTypeId, on);
                     emit emitEvent(Event(shellySwitchPressedEventTypeId, child->id()));
@@ -936,17 +934,17 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("currentPower")) {
                 thing->setStateValue("currentPower", value);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyPowerMeterChannelThingClassId).filterByParam(shellyPowerMeterChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyPowerMeterChannelThingClassId, 1)) {
                 child->setStateValue(shellyPowerMeterChannelCurrentPowerStateTypeId, value.toDouble());
             }
             break;
         case 4201: // power meter for channel 2
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyPowerMeterChannelThingClassId).filterByParam(shellyPowerMeterChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyPowerMeterChannelThingClassId, 2)) {
                 child->setStateValue(shellyPowerMeterChannelCurrentPowerStateTypeId, value.toDouble());
             }
             break;
         case 4102: // roller current power
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyRollerThingClassId).filterByParam(shellyRollerThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyRollerThingClassId, 1)) {
                 child->setStateValue(shellyRollerCurrentPowerStateTypeId, value);
             }
             break;
@@ -954,12 +952,12 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("totalEnergyConsumed")) {
                 thing->setStateValue("totalEnergyConsumed", value.toDouble() / 60 / 1000);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyPowerMeterChannelThingClassId).filterByParam(shellyPowerMeterChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyPowerMeterChannelThingClassId, 1)) {
                 child->setStateValue(shellyPowerMeterChannelTotalEnergyConsumedStateTypeId, value.toDouble() / 60 / 1000); // Wmin -> kWh
             }
             break;
         case 4203: // totalEnergyConsumed channel 2
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyPowerMeterChannelThingClassId).filterByParam(shellyPowerMeterChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyPowerMeterChannelThingClassId, 2)) {
                 child->setStateValue(shellyPowerMeterChannelTotalEnergyConsumedStateTypeId, value.toDouble() / 60 / 1000); // Wmin -> kWh
             }
             break;
@@ -968,7 +966,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("currentPowerPhaseA")) {
                 thing->setStateValue("currentPowerPhaseA", value.toDouble());
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 1)) {
                 child->setStateValue(shellyEmChannelCurrentPowerStateTypeId, value.toDouble());
             }
             break;
@@ -976,7 +974,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("currentPowerPhaseB")) {
                 thing->setStateValue("currentPowerPhaseB", value.toDouble());
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 2)) {
                 child->setStateValue(shellyEmChannelCurrentPowerStateTypeId, value.toDouble());
             }
             break;
@@ -990,7 +988,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("energyConsumedPhaseA")) {
                 thing->setStateValue("energyConsumedPhaseA", value.toDouble() / 1000);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 1)) {
                 child->setStateValue(shellyEmChannelTotalEnergyConsumedStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -999,7 +997,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("energyConsumedPhaseB")) {
                 thing->setStateValue("energyConsumedPhaseB", value.toDouble() / 1000);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 2)) {
                 child->setStateValue(shellyEmChannelTotalEnergyConsumedStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -1012,7 +1010,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("energyProducedPhaseA")) {
                 thing->setStateValue("energyProducedPhaseA", value.toDouble() / 1000);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 1)) {
                 child->setStateValue(shellyEmChannelTotalEnergyProducedStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -1020,7 +1018,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("energyProducedPhaseB")) {
                 thing->setStateValue("energyProducedPhaseB", value.toDouble() / 1000);
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 2)) {
                 child->setStateValue(shellyEmChannelTotalEnergyProducedStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -1033,7 +1031,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("voltagePhaseA")) {
                 thing->setStateValue("voltagePhaseA", value.toDouble());
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 1)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 1)) {
                 child->setStateValue(shellyEmChannelVoltagePhaseAStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -1041,7 +1039,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
             if (thing->hasState("voltagePhaseB")) {
                 thing->setStateValue("voltagePhaseB", value.toDouble());
             }
-            foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId).filterByParam(shellyEmChannelThingChannelParamTypeId, 2)) {
+            foreach (Thing *child, coiotChildren(thing, shellyEmChannelThingClassId, 2)) {
                 child->setStateValue(shellyEmChannelVoltagePhaseAStateTypeId, value.toDouble() / 1000);
             }
             break;
@@ -1138,7 +1136,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
         }
     }
     if (thing->thingClassId() == shellyEmThingClassId) {
-        foreach (Thing *child, myThings().filterByParentId(thing->id()).filterByThingClassId(shellyEmChannelThingClassId)) {
+        foreach (Thing *child, coiotChildren(thing).all.filterByThingClassId(shellyEmChannelThingClassId)) {
             double power = child->stateValue(shellyEmChannelCurrentPowerStateTypeId).toDouble();
             double voltage = child->stateValue(shellyEmChannelVoltagePhaseAStateTypeId).toDouble();
             if (qFuzzyCompare(voltage, 0) == false) {
@@ -1159,7 +1157,7 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
     handleInputEvent(thing, "3", inputEvent3String, inputEvent3Count);
 
     if (thing->thingClassId() == shelly2ThingClassId || thing->thingClassId() == shelly25ThingClassId) {
-        foreach (Thing *roller, myThings().filterByInterface("extendedshutter").filterByParentId(thing->id())) {
+        foreach (Thing *roller, coiotChildren(thing).all.filterByInterface("extendedshutter")) {
             bool moving = thing->stateValue("channel1").toBool() || thing->stateValue("channel2").toBool();
             roller->setStateValue(shellyRollerMovingStateTypeId, moving);
         }
@@ -1172,6 +1170,52 @@ void IntegrationPluginShelly::onMulticastMessageReceived(const QHostAddress &sou
     }
 }
 
+Thing *IntegrationPluginShelly::coiotThing(const QString &shellyId)
+{
+    // Unknown shellies are remembered as nullptr too, they keep on sending as well
+    QHash<QString, Thing *>::const_iterator it = m_coiotThings.constFind(shellyId);
+    if (it != m_coiotThings.constEnd()) {
+        return it.value();
+    }
+
+    Thing *thing = nullptr;
+    foreach (Thing *t, myThings().filterByParentId(ThingId())) {
+        if (t->paramValue("id").toString().endsWith(shellyId)) {
+            thing = t;
+            break;
+        }
+    }
+    m_coiotThings.insert(shellyId, thing);
+    return thing;
+}
+
+const IntegrationPluginShelly::CoIoTChildren &IntegrationPluginShelly::coiotChildren(Thing *parent)
+{
+    QHash<Thing *, CoIoTChildren>::iterator it = m_coiotChildren.find(parent);
+    if (it == m_coiotChildren.end()) {
+        CoIoTChildren children;
+        foreach (Thing *child, myThings().filterByParentId(parent->id())) {
+            children.all.append(child);
+            ParamTypeId channelParamTypeId = child->thingClass().paramTypes().findByName("channel").id();
+            int channel = channelParamTypeId.isNull() ? 0 : child->paramValue(channelParamTypeId).toInt();
+            children.byChannel[child->thingClassId()][channel].append(child);
+        }
+        it = m_coiotChildren.insert(parent, children);
+    }
+    return it.value();
+}
+
+Things IntegrationPluginShelly::coiotChildren(Thing *parent, const ThingClassId &thingClassId, int channel)
+{
+    return coiotChildren(parent).byChannel.value(thingClassId).value(channel);
+}
+
+void IntegrationPluginShelly::resetCoiotRouting()
+{
+    m_coiotThings.clear();
+    m_coiotChildren.clear();
+}
+
 void IntegrationPluginShelly::updateStatus()
 {
     foreach (Thing *thing, myThings().filterByParentId(ThingId())) {
@@ -1179,17 +1223,18 @@ void IntegrationPluginShelly::updateStatus()
             continue;
         }
 
+        // Gen2 devices are push driven through their websocket and resynced on reconnect
         if (isGen2(thing->paramValue("id").toString())) {
-            fetchStatusGen2(thing);
-        } else {
-            //Skipping sleepy devices, as they won't reply to cyclic requests.
-            if (thing->thingClassId() == shellyFloodThingClassId
-                    || thing->thingClassId() == shellyTrvThingClassId) {
-                continue;
-            }
+            continue;
+        }
 
-            fetchStatusGen1(thing);
+        //Skipping sleepy devices, as they won't reply to cyclic requests.
+        if (thing->thingClassId() == shellyFloodThingClassId
+                || thing->thingClassId() == shellyTrvThingClassId) {
+            continue;
         }
+
+        fetchStatusGen1(thing);
     }
 }
 
@@ -1294,6 +1339,8 @@ void IntegrationPluginShelly::fetchStatusGen1(Thing *thing)
 
 void IntegrationPluginShelly::fetchStatusGen2(Thing *thing)
 {
+    // Gen2 devices push their state changes through the websocket. This is only used to resync
+    // the complete state after (re)connecting, as notifications may have been missed in between.
     ShellyJsonRpcClient *client = m_rpcClients.value(thing);
     ShellyRpcReply *statusReply = client->sendRequest("Shelly.GetStatus");
     connect(statusReply, &ShellyRpcReply::finished, thing, [thing, this](ShellyRpcReply::Status status, const QVariantMap &response){
@@ -1302,13 +1349,7 @@ void IntegrationPluginShelly::fetchStatusGen2(Thing *thing)
             return;
         }
         qCDebug(dcShelly()) << thing->name() << "Status reply:" << response;
-        int signalStrength = qMin(100, qMax(0, (response.value("wifi").toMap().value("rssi").toInt() + 100) * 2));
-        thing->setStateValue("connected", true);
-        thing->setStateValue("signalStrength", signalStrength);
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            child->setStateValue("connected", true);
-            child->setStateValue("signalStrength", signalStrength);
-        }
+        applyStatusGen2(thing, response, true);
     });
 
     ShellyRpcReply *infoReply = client->sendRequest("Shelly.GetDeviceInfo");
@@ -1338,6 +1379,152 @@ void IntegrationPluginShelly::fetchStatusGen2(Thing *thing)
 
 }
 
+void IntegrationPluginShelly::applyStatusGen2(Thing *thing, const QVariantMap &status, bool fullStatus)
+{
+    // status is either a full Shelly.GetStatus/NotifyFullStatus map or a NotifyStatus delta which
+    // only contains the components and fields that changed. Only touch states for fields present.
+    foreach (const QString &id, status.keys()) {
+        QVariantMap component = status.value(id).toMap();
+
+        if (id == "wifi") {
+            if (component.contains("rssi")) {
+                int signalStrength = qMin(100, qMax(0, (component.value("rssi").toInt() + 100) * 2));
+                thing->setStateValue("signalStrength", signalStrength);
+                foreach (Thing *child, coiotChildren(thing).all) {
+                    child->setStateValue("signalStrength", signalStrength);
+                }
+            }
+        }
+        if (id == "sys") {
+            if (component.contains("available_updates")) {
+                QVariantMap updates = component.value("available_updates").toMap();
+                if (updates.contains("stable")) {
+                    thing->setStateValue("availableVersion", updates.value("stable").toMap().value("version").toString());
+                    thing->setStateValue("updateStatus", "available");
+                } else {
+                    thing->setStateValue("availableVersion", "");
+                    thing->setStateValue("updateStatus", "idle");
+                }
+            }
+        }
+        if (id == "switch:0") {
+            if (component.contains("apower") && thing->hasState("currentPower")) { // for shellyplus1pm
+                thing->setStateValue("currentPower", component.value("apower").toDouble());
+            }
+            Thing *powerMeterChannel = coiotChildren(thing, shellyPowerMeterChannelThingClassId, 1).value(0);
+            if (powerMeterChannel) {
+                if (component.contains("apower")) {
+                    powerMeterChannel->setStateValue("currentPower", component.value("apower").toDouble());
+                }
+                if (component.contains("aenergy")) {
+                    powerMeterChannel->setStateValue("totalEnergyConsumed", component.value("aenergy").toMap().value("total").toDouble() / 1000);
+                }
+            } else {
+                if (component.contains("aenergy") && thing->hasState("totalEnergyConsumed")) { // for shellyplus1pm
+                    thing->setStateValue("totalEnergyConsumed", component.value("aenergy").toMap().value("total").toDouble() / 1000);
+                }
+            }
+            if (component.contains("output") && thing->hasState("power")) { // for shellyplus1pm
+                thing->setStateValue("power", component.value("output").toBool());
+            } else if (component.contains("output") && thing->hasState("channel1")) { // for shellyplus2pm
+                thing->setStateValue("channel1", component.value("output").toBool());
+            }
+        }
+        if (id == "switch:1") {
+            Thing *powerMeterChannel = coiotChildren(thing, shellyPowerMeterChannelThingClassId, 2).value(0);
+            if (powerMeterChannel) {
+                if (component.contains("apower")) {
+                    powerMeterChannel->setStateValue("currentPower", component.value("apower").toDouble());
+                }
+                if (component.contains("aenergy")) {
+                    powerMeterChannel->setStateValue("totalEnergyConsumed", component.value("aenergy").toMap().value("total").toDouble() / 1000);
+                }
+            }
+            if (component.contains("output") && thing->hasState("channel2")) { // for shellyplus2pm
+                thing->setStateValue("channel2", component.value("output").toBool());
+            }
+        }
+        if (id == "cover:0") {
+            Thing *roller = coiotChildren(thing, shellyRollerThingClassId, 1).value(0);
+            if (roller) {
+                if (component.contains("apower")) {
+                    roller->setStateValue("currentPower", component.value("apower").toDouble());
+                }
+                if (component.contains("aenergy")) {
+                    roller->setStateValue("totalEnergyConsumed", component.value("aenergy").toMap().value("total").toDouble());
+                }
+                if (component.contains("current_pos")) {
+                    roller->setStateValue("percentage", component.value("current_pos").toInt());
+                }
+                if (component.contains("state")) {
+                    QString coverState = component.value("state").toString();
+                    bool moving = coverState == "opening" || coverState == "closing" || coverState == "calibrating";
+                    roller->setStateValue("moving", moving);
+                }
+            }
+            if (component.contains("output") && thing->hasState("power")) {
+                thing->setStateValue("power", component.value("output").toBool());
+            } else if (component.contains("output") && thing->hasState("channel1")) { // for shellyplus2pm
+                thing->setStateValue("channel1", component.value("output").toBool());
+            }
+        }
+        if (id == "input:0" || id == "input:1") {
+            int channel = id == "input:0" ? 1 : 2;
+            Thing *input = coiotChildren(thing, shellySwitchThingClassId, channel).value(0);
+            if (input && component.contains("state")) {
+                input->setStateValue("power", component.value("state").toBool());
+                // A full status is a snapshot, not a button press
+                if (!fullStatus) {
+                    input->emitEvent("pressed");
+                }
+            }
+        }
+        if (id == "em:0") {
+            static const QList<QPair<QString, StateTypeId>> emStates = {
+                {"a_act_power", shellyPro3EMCurrentPowerPhaseAStateTypeId},
+                {"a_voltage", shellyPro3EMVoltagePhaseAStateTypeId},
+                {"a_current", shellyPro3EMCurrentPhaseAStateTypeId},
+                {"b_act_power", shellyPro3EMCurrentPowerPhaseBStateTypeId},
+                {"b_voltage", shellyPro3EMVoltagePhaseBStateTypeId},
+                {"b_current", shellyPro3EMCurrentPhaseBStateTypeId},
+                {"c_act_power", shellyPro3EMCurrentPowerPhaseCStateTypeId},
+                {"c_voltage", shellyPro3EMVoltagePhaseCStateTypeId},
+                {"c_current", shellyPro3EMCurrentPhaseCStateTypeId},
+                {"total_act_power", shellyPro3EMCurrentPowerStateTypeId}
+            };
+            for (int i = 0; i < emStates.count(); i++) {
+                if (component.contains(emStates.at(i).first)) {
+                    thing->setStateValue(emStates.at(i).second, component.value(emStates.at(i).first).toDouble());
+                }
+            }
+        }
+        if (id == "emdata:0") {
+            static const QList<QPair<QString, StateTypeId>> emDataStates = {
+                {"a_total_act_energy", shellyPro3EMEnergyConsumedPhaseAStateTypeId},
+                {"a_total_act_ret_energy", shellyPro3EMEnergyProducedPhaseAStateTypeId},
+                {"b_total_act_energy", shellyPro3EMEnergyConsumedPhaseBStateTypeId},
+                {"b_total_act_ret_energy", shellyPro3EMEnergyProducedPhaseBStateTypeId},
+                {"c_total_act_energy", shellyPro3EMEnergyConsumedPhaseCStateTypeId},
+                {"c_total_act_ret_energy", shellyPro3EMEnergyProducedPhaseCStateTypeId},
+                {"total_act", shellyPro3EMTotalEnergyConsumedStateTypeId},
+                {"total_act_ret", shellyPro3EMTotalEnergyProducedStateTypeId}
+            };
+            for (int i = 0; i < emDataStates.count(); i++) {
+                if (component.contains(emDataStates.at(i).first)) {
+                    thing->setStateValue(emDataStates.at(i).second, component.value(emDataStates.at(i).first).toDouble() / 1000);
+                }
+            }
+        }
+        if (id.startsWith("temperature") && component.contains("tC")) {
+            foreach (Thing *child, coiotChildren(thing, shellyAddonTempSensorThingClassId, 0)) {
+                if (child->paramValue(shellyAddonTempSensorThingAddonIdParamTypeId).toString() == id) {
+                    child->setStateValue(shellyAddonTempSensorTemperatureStateTypeId, component.value("tC").toDouble());
+                }
+            }
+        }
+    }
+}
+
 void IntegrationPluginShelly::setupGen1(ThingSetupInfo *info)
 {
     Thing *thing = info->thing();
@@ -1761,124 +1948,9 @@ void IntegrationPluginShelly::setupGen2(ThingSetupInfo *info)
             }
         }
     });
-    connect(client, &ShellyJsonRpcClient::notificationReceived, thing, [thing, this](const QVariantMap &notification){
+    connect(client, &ShellyJsonRpcClient::notificationReceived, thing, [thing, this](const QVariantMap &notification, bool fullStatus){
         qCDebug(dcShelly) << "notification received" << qUtf8Printable(QJsonDocument::fromVariant(notification).toJson());
-        foreach (const QVariant &key, notification.keys()) {
-            QString id = key.toString();
-            if (id == "switch:0") {
-                QVariantMap switch0 = notification.value("switch:0").toMap();
-                if (switch0.contains("apower") && thing->hasState("currentPower")) { // for shellyplus1pm
-                    thing->setStateValue("currentPower", switch0.value("apower").toDouble());
-                }
-                Thing *parentThing = myThings().filterByParentId(thing->id()).findByParams({Param(shellyPowerMeterChannelThingChannelParamTypeId, 1)});
-                if (parentThing) {
-                    if (switch0.contains("apower")) {
-                        parentThing->setStateValue("currentPower", switch0.value("apower").toDouble());
-                    }
-                    if (switch0.contains("aenergy")) {
-                        parentThing->setStateValue("totalEnergyConsumed", notification.value("switch:0").toMap().value("aenergy").toMap().value("total").toDouble() / 1000);
-                    }
-                } else {
-                    if (switch0.contains("aenergy") && thing->hasState("totalEnergyConsumed")) { // for shellyplus1pm
-                        thing->setStateValue("totalEnergyConsumed", notification.value("switch:0").toMap().value("aenergy").toMap().value("total").toDouble() / 1000);
-                    }
-                }
-                if (switch0.contains("output") && thing->hasState("power")) { // for shellyplus1pm
-                    thing->setStateValue("power", switch0.value("output").toBool());
-                } else if (switch0.contains("output") && thing->hasState("channel1")) { // for shellyplus2pm
-                    thing->setStateValue("channel1", switch0.value("output").toBool());
-                }
-            }
-            if (id == "switch:1") {
-                QVariantMap switch1 = notification.value("switch:1").toMap();
-                Thing *parentThing = myThings().filterByParentId(thing->id()).findByParams({Param(shellyPowerMeterChannelThingChannelParamTypeId, 2)});
-                if (parentThing) {
-                    if (switch1.contains("apower")) {
-                        parentThing->setStateValue("currentPower", switch1.value("apower").toDouble());
-                    }
-                    if (switch1.contains("aenergy")) {
-                        parentThing->setStateValue("totalEnergyConsumed", notification.value("switch:1").toMap().value("aenergy").toMap().value("total").toDouble() / 1000);
-                    }
-                }
-                if (switch1.contains("output") && thing->hasState("channel2")) { // for shellyplus2pm
-                    thing->setStateValue("channel2", switch1.value("output").toBool());
-                }
-            }
-            if (id == "cover:0") {
-                QVariantMap cover0 = notification.value("cover:0").toMap();
-                Thing *t = myThings().filterByParentId(thing->id()).findByParams({Param(shellyRollerThingChannelParamTypeId, 1)});
-                if (cover0.contains("apower") && t) {
-                    t->setStateValue("currentPower", cover0.value("apower").toDouble());
-                }
-                if (cover0.contains("aenergy") && t) {
-                    t->setStateValue("totalEnergyConsumed", notification.value("cover:0").toMap().value("aenergy").toMap().value("total").toDouble());
-                }
-                if (cover0.contains("current_pos") && t) {
-                    t->setStateValue("percentage", notification.value("cover:0").toMap().value("current_pos").toInt());
-                }
-                if (cover0.contains("state") && t) {
-                    QString coverState = notification.value("cover:0").toMap().value("state").toString();
-                    bool movingBool = false;
-                    if (coverState == "opening" || coverState == "closing" || coverState == "calibrating") {
-                        movingBool = true;
-                    }
-                    t->setStateValue("moving", movingBool);
-                }
-                if (cover0.contains("output") && thing->hasState("channel1")) { // for shellyplus2pm
-                    thing->setStateValue("power", cover0.value("output").toBool());
-                }
-            }
-            if (id == "input:0") {
-                QVariantMap input0 = notification.value("input:0").toMap();
-                Thing *t = myThings().filterByParentId(thing->id()).findByParams({Param(shellySwitchThingChannelParamTypeId, 1)});
-                if (t) {
-                    t->setStateValue("power", input0.value("state").toBool());
-                    t->emitEvent("pressed");
-                }
-            }
-            if (id == "input:1") {
-                QVariantMap input1 = notification.value("input:1").toMap();
-                Thing *t = myThings().filterByParentId(thing->id()).findByParams({Param(shellySwitchThingChannelParamTypeId, 2)});
-                if (t) {
-                    t->setStateValue("power", input1.value("state").toBool());
-                    t->emitEvent("pressed");
-                }
-            }
-            if (id == "em:0") {
-                QVariantMap em0 = notification.value("em:0").toMap();
-                thing->setStateValue(shellyPro3EMCurrentPowerPhaseAStateTypeId, em0.value("a_act_power").toDouble());
-                thing->setStateValue(shellyPro3EMVoltagePhaseAStateTypeId, em0.value("a_voltage").toDouble());
-                thing->setStateValue(shellyPro3EMCurrentPhaseAStateTypeId, em0.value("a_current").toDouble());
-                thing->setStateValue(shellyPro3EMCurrentPowerPhaseBStateTypeId, em0.value("b_act_power").toDouble());
-                thing->setStateValue(shellyPro3EMVoltagePhaseBStateTypeId, em0.value("b_voltage").toDouble());
-                thing->setStateValue(shellyPro3EMCurrentPhaseCStateTypeId, em0.value("c_current").toDouble());
-                thing->setStateValue(shellyPro3EMCurrentPowerPhaseCStateTypeId, em0.value("c_act_power").toDouble());
-                thing->setStateValue(shellyPro3EMVoltagePhaseCStateTypeId, em0.value("c_voltage").toDouble());
-                thing->setStateValue(shellyPro3EMCurrentPhaseCStateTypeId, em0.value("c_current").toDouble());
-
-                thing->setStateValue(shellyPro3EMCurrentPowerStateTypeId, em0.value("total_act_power").toDouble());
-            }
-            if (id == "emdata:0") {
-                QVariantMap emdata0 = notification.value("emdata:0").toMap();
-                thing->setStateValue(shellyPro3EMEnergyConsumedPhaseAStateTypeId, emdata0.value("a_total_act_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMEnergyProducedPhaseAStateTypeId, emdata0.value("a_total_act_ret_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMEnergyConsumedPhaseBStateTypeId, emdata0.value("b_total_act_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMEnergyProducedPhaseBStateTypeId, emdata0.value("b_total_act_ret_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMEnergyConsumedPhaseCStateTypeId, emdata0.value("c_total_act_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMEnergyProducedPhaseCStateTypeId, emdata0.value("c_total_act_ret_energy").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMTotalEnergyConsumedStateTypeId, emdata0.value("total_act").toDouble() / 1000);
-                thing->setStateValue(shellyPro3EMTotalEnergyProducedStateTypeId, emdata0.value("total_act_ret").toDouble() / 1000);
-            }
-
-            if (id.startsWith("temperature")) {
-                Thing *addonTempSensor = myThings().filterByParentId(thing->id()).findByParams({{shellyAddonTempSensorThingAddonIdParamTypeId, id}});
-                if (addonTempSensor) {
-                    QVariantMap temperatureMap = notification.value(id).toMap();
-                    addonTempSensor->setStateValue(shellyAddonTempSensorTemperatureStateTypeId, temperatureMap.value("tC").toDouble());
-                }
-
-            }
-        }
+        applyStatusGen2(thing, notification, fullStatus);
     });
 
     // Handle thing settings of devices
@@ -80,11 +80,26 @@ private:
     void setupGen2(ThingSetupInfo *info);
     void setupShellyChild(ThingSetupInfo *info);
 
+    void applyStatusGen2(Thing *thing, const QVariantMap &status, bool fullStatus);
+
     QHostAddress getIP(Thing *thing) const;
     bool isGen2(const QString &shellyId) const;
 
     void handleInputEvent(Thing *thing, const QString &buttonName, const QString &inputEventString, int inputEventCount);
 
+    // CoIoT status messages are routed through these tables instead of searching myThings() for every message.
+    // They are filled on demand and reset whenever things are added or removed.
+    class CoIoTChildren {
+    public:
+        Things all;
+        // thing class -> channel param (0 if the class has none) -> children
+        QHash<ThingClassId, QHash<int, Things>> byChannel;
+    };
+    Thing *coiotThing(const QString &shellyId);
+    const CoIoTChildren &coiotChildren(Thing *parent);
+    Things coiotChildren(Thing *parent, const ThingClassId &thingClassId, int channel);
+    void resetCoiotRouting();
+
     QNetworkRequest createHttpRequest(Thing *thing, const QString &path, const QUrlQuery &urlQuery = QUrlQuery());
     QVariantMap createRpcRequest(const QString &method);
 
@@ -96,6 +111,9 @@ private:
     Coap *m_coap = nullptr;
 
     QHash<Thing*, ShellyJsonRpcClient*> m_rpcClients;
+
+    QHash<QString, Thing *> m_coiotThings;
+    QHash<Thing *, CoIoTChildren> m_coiotChildren;
 };
 
 #endif // INTEGRATIONPLUGINSHELLY_H
@@ -27,8 +27,15 @@ ShellyJsonRpcClient::ShellyJsonRpcClient(QObject *parent)
     : QObject(parent)
 {
     m_socket = new QWebSocket("nymea", QWebSocketProtocol::VersionLatest, this);
-    connect(m_socket, &QWebSocket::stateChanged, this, &ShellyJsonRpcClient::stateChanged);
+    connect(m_socket, &QWebSocket::stateChanged, this, &ShellyJsonRpcClient::onStateChanged);
     connect(m_socket, &QWebSocket::textMessageReceived, this, &ShellyJsonRpcClient::onTextMessageReceived);
+    connect(m_socket, &QWebSocket::pong, this, [this](quint64 elapsedTime){
+        qCDebug(dcShelly()) << "Pong received from shelly after" << elapsedTime << "ms";
+        m_pongPending = false;
+    });
+
+    m_pingTimer.setInterval(30000);
+    connect(&m_pingTimer, &QTimer::timeout, this, &ShellyJsonRpcClient::sendPing);
 }
 
 void ShellyJsonRpcClient::open(const QHostAddress &address, const QString &user, const QString &password, const QString &shellyId)
@@ -84,8 +91,9 @@ void ShellyJsonRpcClient::onTextMessageReceived(const QString &message)
         return;
     }
 
-    if (data.value("method").toString() == "NotifyStatus") {
-        emit notificationReceived(data.value("params").toMap());
+    QString method = data.value("method").toString();
+    if (method == "NotifyStatus" || method == "NotifyFullStatus") {
+        emit notificationReceived(data.value("params").toMap(), method == "NotifyFullStatus");
         return;
     }
 
@@ -130,6 +138,29 @@ void ShellyJsonRpcClient::onTextMessageReceived(const QString &message)
     emit reply->finished(status, data.value("result").toMap());
 }
 
+void ShellyJsonRpcClient::onStateChanged(QAbstractSocket::SocketState state)
+{
+    if (state == QAbstractSocket::ConnectedState) {
+        m_pongPending = false;
+        m_pingTimer.start();
+    } else {
+        m_pingTimer.stop();
+    }
+    emit stateChanged(state);
+}
+
+void ShellyJsonRpcClient::sendPing()
+{
+    if (m_pongPending) {
+        qCWarning(dcShelly()) << "Shelly did not answer to the last ping. Dropping connection.";
+        m_pingTimer.stop();
+        m_socket->abort();
+        return;
+    }
+    m_pongPending = true;
+    m_socket->ping();
+}
+
 QVariantMap ShellyJsonRpcClient::createAuthMap() const
 {
     int cnonce = qrand();
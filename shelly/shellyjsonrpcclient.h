@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QWebSocket>
+#include <QTimer>
 
 class ShellyRpcReply: public QObject
 {
@@ -52,10 +53,13 @@ public:
 
 signals:
     void stateChanged(QAbstractSocket::SocketState state);
-    void notificationReceived(const QVariantMap &notification);
+    // fullStatus is true for NotifyFullStatus, which carries the complete state of all components
+    void notificationReceived(const QVariantMap &notification, bool fullStatus);
 
 private slots:
     void onTextMessageReceived(const QString &message);
+    void onStateChanged(QAbstractSocket::SocketState state);
+    void sendPing();
 
 private:
     QVariantMap createAuthMap() const;
@@ -63,6 +67,10 @@ private:
     QWebSocket *m_socket = nullptr;
     QHash<int, ShellyRpcReply*> m_pendingReplies;
 
+    // The state is push driven, so a silently dead connection must be detected actively
+    QTimer m_pingTimer;
+    bool m_pongPending = false;
+
     int m_currentId = 1;
 
     // Needed (only) for authentication
@@ -0,0 +1,205 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Runs ProcSampler against a synthetic /proc tree in a temporary directory and checks the CPU,
+// IO wait and pressure deltas, the process lookup including pid reuse and the memory values.
+// The /proc/stat written here has 512 cores, more than fit the former fixed size buffer.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+
+#include <unistd.h>
+
+#include "procsampler.h"
+
+Q_LOGGING_CATEGORY(dcSystemMonitor, "SystemMonitor")
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+static bool fuzzyEqual(double value, double expected)
+{
+    return qAbs(value - expected) < 0.0001;
+}
+
+static void writeFile(const QString &root, const QString &path, const QByteArray &content)
+{
+    QString fileName = root + "/" + path;
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qFatal("Cannot write %s", qPrintable(fileName));
+    }
+    file.write(content);
+}
+
+// user nice system idle iowait irq softirq steal for the aggregate line, every core gets the same
+// values divided by the core count. The long intr line follows like in the real file.
+static QByteArray statFile(quint64 user, quint64 system, quint64 idle, quint64 iowait, int cores)
+{
+    QByteArray data = QString("cpu  %1 0 %2 %3 %4 0 0 0 0 0\n").arg(user).arg(system).arg(idle).arg(iowait).toUtf8();
+    for (int i = 0; i < cores; i++) {
+        data += QString("cpu%1 %2 0 %3 %4 %5 0 0 0 0 0\n").arg(i).arg(user / cores).arg(system / cores).arg(idle / cores).arg(iowait / cores).toUtf8();
+    }
+    data += "intr 123456";
+    for (int i = 0; i < 1024; i++) {
+        data += " 0";
+    }
+    data += "\nctxt 987654\nbtime 1700000000\nprocesses 4242\nprocs_running 2\nprocs_blocked 0\n";
+    return data;
+}
+
+static QByteArray pressureFile(qint64 total)
+{
+    return QString("some avg10=0.00 avg60=0.00 avg300=0.00 total=%1\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n").arg(total).toUtf8();
+}
+
+// pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime cutime cstime ...
+static QByteArray processStatFile(int pid, const QByteArray &comm, int utime, int stime, int cutime, int cstime)
+{
+    return QString("%1 (%2) S 1 %1 %1 0 -1 4194560 1234 0 0 0 %3 %4 %5 %6 20 0 1 0 4711 123456789 2048 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 3 0 0 0 0 0\n")
+            .arg(pid).arg(QString::fromUtf8(comm)).arg(utime).arg(stime).arg(cutime).arg(cstime).toUtf8();
+}
+
+static void writeProcess(const QString &root, int pid, const QByteArray &comm, int utime)
+{
+    writeFile(root, QString("%1/comm").arg(pid), comm + "\n");
+    writeFile(root, QString("%1/stat").arg(pid), processStatFile(pid, comm, utime, 20, 3, 4));
+    writeFile(root, QString("%1/statm").arg(pid), "2500 1200 300 10 0 900 0\n");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning() << "Cannot create a temporary directory";
+        return 1;
+    }
+    const QString root = dir.path();
+    const int cores = 512;
+
+    QByteArray stat = statFile(1024000, 512000, 4096000, 51200, cores);
+    writeFile(root, "stat", stat);
+    check(stat.indexOf("intr") > 16384, "The core lines of the synthetic /proc/stat exceed the former 16 KiB buffer");
+    writeFile(root, "pressure/cpu", pressureFile(1000));
+    writeFile(root, "pressure/io", pressureFile(5000));
+    writeProcess(root, 100, "nymead", 50);
+    writeProcess(root, 200, "other", 10);
+    writeProcess(root, 250, "with (paren) s", 30);
+
+    ProcSampler sampler(QDir(root).absolutePath().toUtf8());
+
+    // First cycle, no deltas yet
+    check(sampler.sample(), "First sample succeeds");
+    check(sampler.coreCount() == cores, QString("All %1 cores are read (got %2)").arg(cores).arg(sampler.coreCount()));
+    check(sampler.cpuUsage() == -1, "No CPU usage without a previous sample");
+    check(sampler.ioWait() == -1, "No IO wait without a previous sample");
+    check(sampler.totalJiffiesDelta() == 0, "No jiffies delta without a previous sample");
+
+    // Second cycle: 512 user + 512 system + 2048 idle + 1024 iowait jiffies elapsed
+    writeFile(root, "stat", statFile(1024512, 512512, 4098048, 52224, cores));
+    writeFile(root, "pressure/cpu", pressureFile(1000));
+    writeFile(root, "pressure/io", pressureFile(5000));
+    check(sampler.sample(), "Second sample succeeds");
+    check(sampler.totalJiffiesDelta() == 4096, QString("Jiffies delta is 4096 (got %1)").arg(sampler.totalJiffiesDelta()));
+    check(fuzzyEqual(sampler.cpuUsage(), 25), QString("CPU usage is 25% (got %1)").arg(sampler.cpuUsage()));
+    check(fuzzyEqual(sampler.ioWait(), 25), QString("IO wait is 25% (got %1)").arg(sampler.ioWait()));
+    check(fuzzyEqual(sampler.coreUsage(0), 25), QString("Core 0 usage is 25% (got %1)").arg(sampler.coreUsage(0)));
+    check(fuzzyEqual(sampler.coreUsage(cores - 1), 25), QString("Last core usage is 25% (got %1)").arg(sampler.coreUsage(cores - 1)));
+    check(sampler.coreUsage(cores) == -1, "Usage of a core that doesn't exist is -1");
+    check(fuzzyEqual(sampler.pressure(ProcSampler::PressureCpu), 0), QString("CPU pressure without stalls is 0 (got %1)").arg(sampler.pressure(ProcSampler::PressureCpu)));
+    check(sampler.pressure(ProcSampler::PressureMemory) == -1, "Missing memory pressure file gives -1");
+
+    // Third cycle: IO stalls for a full minute, which is more than the elapsed wall time
+    writeFile(root, "stat", statFile(1025024, 513024, 4100096, 53248, cores));
+    writeFile(root, "pressure/io", pressureFile(5000 + 60000000));
+    check(sampler.sample(), "Third sample succeeds");
+    check(fuzzyEqual(sampler.pressure(ProcSampler::PressureIo), 100), QString("IO pressure is capped at 100% (got %1)").arg(sampler.pressure(ProcSampler::PressureIo)));
+
+    // Counters going backwards (e.g. wrapped) skip one cycle
+    writeFile(root, "stat", statFile(1000, 1000, 1000, 0, cores));
+    check(sampler.sample(), "Sample with decreasing counters succeeds");
+    check(sampler.cpuUsage() == -1, "CPU usage is skipped after the counters went backwards");
+    writeFile(root, "stat", statFile(1100, 1100, 1200, 0, cores));
+    check(sampler.sample(), "Sample after decreasing counters succeeds");
+    check(fuzzyEqual(sampler.cpuUsage(), 50), QString("CPU usage is back afterwards, 50% (got %1)").arg(sampler.cpuUsage()));
+
+    // Processes
+    ProcSampler::ProcessStat processStat;
+    check(sampler.readProcessStat("nymead", processStat), "nymead is found");
+    check(processStat.pid == 100, QString("nymead has pid 100 (got %1)").arg(processStat.pid));
+    check(processStat.workJiffies == 77, QString("nymead work jiffies are utime + stime + cutime + cstime = 77 (got %1)").arg(processStat.workJiffies));
+    check(sampler.readProcessStat("with (paren) s", processStat), "A comm with spaces and parenthesis is found");
+    check(processStat.pid == 250 && processStat.workJiffies == 57, QString("A comm with spaces and parenthesis is parsed (got %1 jiffies)").arg(processStat.workJiffies));
+    check(!sampler.readProcessStat("missing", processStat), "A process which is not running is not found");
+
+    quint64 totalKb = 0;
+    quint64 rssKb = 0;
+    quint64 sharedKb = 0;
+    quint64 pageSizeKb = sysconf(_SC_PAGE_SIZE) / 1024;
+    check(sampler.readProcessMemory(100, totalKb, rssKb, sharedKb), "nymead memory is read");
+    check(totalKb == 2500 * pageSizeKb && rssKb == 1200 * pageSizeKb && sharedKb == 300 * pageSizeKb, "nymead memory is converted from pages to kB");
+    check(!sampler.readProcessMemory(999, totalKb, rssKb, sharedKb), "Memory of a missing pid is not read");
+
+    // The cached pid gets reused by a different process and nymead restarts with a new pid
+    writeProcess(root, 100, "sh", 1);
+    writeProcess(root, 300, "nymead", 5);
+    writeFile(root, "stat", statFile(1200, 1200, 1400, 0, cores));
+    check(sampler.sample(), "Sample after the restart succeeds");
+    check(sampler.readProcessStat("nymead", processStat), "Restarted nymead is found");
+    check(processStat.pid == 300, QString("Restarted nymead has its new pid 300 (got %1)").arg(processStat.pid));
+    check(processStat.workJiffies == 32, QString("Restarted nymead work jiffies are 32 (got %1)").arg(processStat.workJiffies));
+
+    // A missing /proc/stat fails the sample and drops the previous values
+    QFile::remove(root + "/stat");
+    check(!sampler.sample(), "Sample without /proc/stat fails");
+    check(sampler.cpuUsage() == -1, "CPU usage is not available without /proc/stat");
+
+    ProcSampler missing(QDir(root + "/missing").absolutePath().toUtf8());
+    check(!missing.sample(), "Sample of a missing proc root fails");
+    check(!missing.readProcessStat("nymead", processStat), "Processes are not found in a missing proc root");
+
+    qInfo().noquote() << (s_failures == 0 ? "All checks passed" : QString("%1 checks failed").arg(s_failures));
+    return s_failures > 0 ? 1 : 0;
+}
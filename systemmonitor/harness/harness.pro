@@ -0,0 +1,15 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT -= gui
+
+# The stub extern-plugininfo.h in this directory replaces the generated plugin header
+INCLUDEPATH += $$PWD $$PWD/..
+
+SOURCES += \
+    harness.cpp \
+    ../procsampler.cpp \
+
+HEADERS += \
+    extern-plugininfo.h \
+    ../procsampler.h \
@@ -53,6 +53,7 @@ void IntegrationPluginSystemMonitor::setupThing(ThingSetupInfo *info)
     if (!m_refreshTimer) {
         m_refreshTimer = hardwareManager()->pluginTimerManager()->registerTimer(2);
         connect(m_refreshTimer, &PluginTimer::timeout, this, [=](){
+            m_sampler.sample();
 
             foreach (Thing *thing, myThings()) {
 
@@ -77,19 +78,51 @@ void IntegrationPluginSystemMonitor::thingRemoved(Thing *thing)
         m_refreshTimer = nullptr;
     }
 
-    m_oldTotalJiffies.remove(thing);
-    m_oldWorkJiffies.remove(thing);
-    m_oldProcessWorkJiffies.remove(thing);
+    m_oldProcessStats.remove(thing);
 }
 
 void IntegrationPluginSystemMonitor::updateSystemMonitor(Thing *thing)
 {
-    double cpuPercentage = readTotalCpuUsage(thing);
+    double cpuPercentage = m_sampler.cpuUsage();
     if (cpuPercentage >= 0) {
         thing->setStateValue(systemMonitorCpuUsageStateTypeId, cpuPercentage);
     }
     thing->setStateValue(systemMonitorPercentMemoryStateTypeId, readTotalMemoryUsage());
 
+    double busiestCore = -1;
+    QStringList coreUsages;
+    for (int i = 0; i < m_sampler.coreCount(); i++) {
+        double coreUsage = m_sampler.coreUsage(i);
+        if (coreUsage < 0) {
+            coreUsages.clear();
+            break;
+        }
+        busiestCore = qMax(busiestCore, coreUsage);
+        coreUsages.append(QString::number(coreUsage, 'f', 1));
+    }
+    if (!coreUsages.isEmpty()) {
+        thing->setStateValue(systemMonitorBusiestCoreUsageStateTypeId, busiestCore);
+        thing->setStateValue(systemMonitorCoreUsagesStateTypeId, coreUsages.join(", "));
+    }
+
+    double ioWait = m_sampler.ioWait();
+    if (ioWait >= 0) {
+        thing->setStateValue(systemMonitorIoWaitStateTypeId, ioWait);
+    }
+
+    double cpuPressure = m_sampler.pressure(ProcSampler::PressureCpu);
+    if (cpuPressure >= 0) {
+        thing->setStateValue(systemMonitorCpuPressureStateTypeId, cpuPressure);
+    }
+    double ioPressure = m_sampler.pressure(ProcSampler::PressureIo);
+    if (ioPressure >= 0) {
+        thing->setStateValue(systemMonitorIoPressureStateTypeId, ioPressure);
+    }
+    double memoryPressure = m_sampler.pressure(ProcSampler::PressureMemory);
+    if (memoryPressure >= 0) {
+        thing->setStateValue(systemMonitorMemoryPressureStateTypeId, memoryPressure);
+    }
+
     QStorageInfo storageInfo = QStorageInfo::root();
     double percentage = 100.0 * (storageInfo.bytesTotal() - storageInfo.bytesFree()) / storageInfo.bytesTotal();
     thing->setStateValue(systemMonitorPercentStorageStateTypeId, percentage);
@@ -103,73 +136,24 @@ void IntegrationPluginSystemMonitor::updateProcessMonitor(Thing *thing)
     if (processName.isEmpty()) {
         processName = "nymead";
     }
-    qint32 pid = getPidByName(processName);
-    if (pid == -1) {
+    ProcSampler::ProcessStat stat;
+    if (!m_sampler.readProcessStat(processName, stat)) {
         thing->setStateValue(processMonitorRunningStateTypeId, false);
+        m_oldProcessStats.remove(thing);
         return;
     }
     thing->setStateValue(processMonitorRunningStateTypeId, true);
 
     quint32 total, rss, shared;
     double percentage;
-    if (readProcessMemoryUsage(pid, total, rss, shared, percentage)) {
+    if (readProcessMemoryUsage(stat.pid, total, rss, shared, percentage)) {
         thing->setStateValue(processMonitorPercentMemoryStateTypeId, percentage);
         thing->setStateValue(processMonitorRssMemoryStateTypeId, rss);
         thing->setStateValue(processMonitorVirtualMemoryStateTypeId, total);
         thing->setStateValue(processMonitorSharedMemoryStateTypeId, shared);
     }
 
-    thing->setStateValue(processMonitorCpuUsageStateTypeId, readProcessCpuUsage(pid, thing));
-}
-
-double IntegrationPluginSystemMonitor::readTotalCpuUsage(Thing *thing)
-{
-    QFile f("/proc/stat");
-    if (!f.open(QFile::ReadOnly)) {
-        qCWarning(dcSystemMonitor()) << "Unable to open /proc/stat. Cannot read CPU usage";
-        return -1;
-    }
-    QByteArray cpuStat = f.readLine().replace("  ", " ");
-    f.close();
-    qCDebug(dcSystemMonitor()) << "SystemCPU:" << "stat:" << cpuStat;
-    QList<QByteArray> parts = cpuStat.split(' ');
-    if (parts.first() != "cpu" || parts.count() < 8) {
-        qCWarning(dcSystemMonitor()) << "/proc/stat not in expected format";
-        return -1;
-    }
-
-    qulonglong systemJiffies = parts.at(1).toULong();
-//    qulonglong niceJiffies = parts.at(2).toULong();
-    qulonglong userJiffies = parts.at(3).toULong();
-    qulonglong idleJiffies = parts.at(4).toULong();
-//    qulonglong ioWaitJiffies = parts.at(5).toULong();
-//    qulonglong irqJiffies = parts.at(6).toULong();
-//    qulonglong softirqJiffies = parts.at(7).toULong();
-
-    qulonglong workJiffies = systemJiffies + userJiffies;
-    qulonglong totalJiffies = workJiffies + idleJiffies;
-
-
-    double cpuPercentage = 0;
-    if (m_oldTotalJiffies.contains(thing)) {
-        qulonglong oldTotalJiffies = m_oldTotalJiffies.value(thing);
-        qulonglong oldWorkJiffies = m_oldWorkJiffies.value(thing);
-        qCDebug(dcSystemMonitor()) << "SystemCPU:" << "Current work:" << workJiffies << "total:" << totalJiffies << "Old work:" << oldWorkJiffies << "total:" << oldTotalJiffies;
-        if (workJiffies < oldWorkJiffies || totalJiffies < oldTotalJiffies) {
-            // One of the values overflowed. Skipping this cycle
-            m_oldTotalJiffies[thing] = totalJiffies;
-            m_oldWorkJiffies[thing] = workJiffies;
-            return -1;
-        }
-        qulonglong totalJiffDiff = totalJiffies - oldTotalJiffies;
-        qulonglong workJiffDiff = workJiffies - oldWorkJiffies;
-
-        cpuPercentage = 100.0 * workJiffDiff / totalJiffDiff;
-    }
-    m_oldTotalJiffies[thing] = totalJiffies;
-    m_oldWorkJiffies[thing] = workJiffies;
-
-    return cpuPercentage;
+    thing->setStateValue(processMonitorCpuUsageStateTypeId, readProcessCpuUsage(stat, thing));
 }
 
 double IntegrationPluginSystemMonitor::readTotalMemoryUsage()
@@ -195,32 +179,13 @@ double IntegrationPluginSystemMonitor::readTotalMemoryUsage()
 
 bool IntegrationPluginSystemMonitor::readProcessMemoryUsage(qint32 pid, quint32 &total, quint32 &rss, quint32 &shared, double &percentage)
 {
-    QFile f(QString("/proc/%1/statm").arg(pid));
-    if (!f.open(QFile::ReadOnly)) {
-        qCWarning(dcSystemMonitor()).nospace() << "Unable to open " << f.fileName() << ". Cannot read memory usage.";
+    quint64 totalKb, rssKb, sharedKb;
+    if (!m_sampler.readProcessMemory(pid, totalKb, rssKb, sharedKb)) {
         return false;
     }
-
-    QByteArray memStat = f.readLine();
-    f.close();
-
-    QList<QByteArray> parts = memStat.split(' ');
-    if (parts.count() < 3) {
-        qCWarning(dcSystemMonitor()) << f.fileName() << "not in expected format";
-        return false;
-    }
-    int tsize = parts.at(0).toInt();
-    int resident = parts.at(1).toInt();
-    int share = parts.at(2).toInt();
-
-    long page_size_kb = sysconf(_SC_PAGE_SIZE) / 1024;
-
-    total = tsize;
-    total *= page_size_kb;
-    rss = resident;
-    rss *= page_size_kb;
-    shared = share;
-    shared *= page_size_kb;
+    total = totalKb;
+    rss = rssKb;
+    shared = sharedKb;
 
     struct sysinfo memInfo;
     sysinfo(&memInfo);
@@ -234,88 +199,22 @@ bool IntegrationPluginSystemMonitor::readProcessMemoryUsage(qint32 pid, quint32
     return true;
 }
 
-double IntegrationPluginSystemMonitor::readProcessCpuUsage(qint32 pid, Thing *thing)
+double IntegrationPluginSystemMonitor::readProcessCpuUsage(const ProcSampler::ProcessStat &stat, Thing *thing)
 {
-    QFile systemFile("/proc/stat");
-    if (!systemFile.open(QFile::ReadOnly)) {
-        qCWarning(dcSystemMonitor()) << "Unable to open /proc/stat. Cannot read CPU usage";
-        return 0;
-    }
-    QByteArray cpuStat = systemFile.readLine().replace("  ", " ");
-    systemFile.close();
-    qCDebug(dcSystemMonitor()) << "ProcessCPU:" << "System stat:" << cpuStat;
-    QList<QByteArray> parts = cpuStat.split(' ');
-    if (parts.first() != "cpu" || parts.count() < 8) {
-        qCWarning(dcSystemMonitor()) << "/proc/stat not in expected format";
-        return 0;
-    }
-    parts.removeFirst();
-
-    qulonglong systemJiffies = parts.at(1).toULong();
-    qulonglong userJiffies = parts.at(3).toULong();
-//    qulonglong idleJiffies = parts.at(4).toULong();
-
-    qulonglong totalJiffies = systemJiffies + userJiffies;// + idleJiffies;
-
-    QFile f(QString("/proc/%1/stat").arg(pid));
-    if (!f.open(QFile::ReadOnly)) {
-        qCWarning(dcSystemMonitor()).nospace() << "Unable to open " << f.fileName() << ". Cannot read CPU usage.";
-        return 0;
-    }
-
-    QByteArray stat = f.readLine();
-    f.close();
-
-    qCDebug(dcSystemMonitor()) << "ProcessCPU:" << "Process stat:" << stat;
-
-    parts = stat.split(' ');
-    if (parts.length() < 15) {
-        qCWarning(dcSystemMonitor()) << f.fileName() << "not in expected format";
-        return 0;
-    }
-
-    qulonglong processUserJiffies = parts.at(13).toULongLong();
-    qulonglong processKernelJiffies = parts.at(14).toULongLong();
-    qulonglong processChildUserJiffies = parts.at(15).toULongLong();
-    qulonglong processChildKernelJiffies = parts.at(16).toULongLong();
-    qulonglong processWorkJiffies = processUserJiffies + processKernelJiffies + processChildUserJiffies + processChildKernelJiffies;
-
     double percentage = 0;
-    if (m_oldTotalJiffies.contains(thing)) {
-        qulonglong oldTotalJiffies = m_oldTotalJiffies.value(thing);
-        qulonglong oldProcessWorkJiffies = m_oldProcessWorkJiffies.value(thing);
+    quint64 totalJiffDiff = m_sampler.totalJiffiesDelta();
+    if (m_oldProcessStats.contains(thing) && totalJiffDiff > 0) {
+        ProcSampler::ProcessStat oldStat = m_oldProcessStats.value(thing);
 
-        qCDebug(dcSystemMonitor()) << "ProcessCPU:" << "Current total:" << totalJiffies << "process:" << processWorkJiffies << "Old total:" << oldTotalJiffies << "process:" << oldProcessWorkJiffies;
+        qCDebug(dcSystemMonitor()) << "ProcessCPU:" << "Current process:" << stat.workJiffies << "Old process:" << oldStat.workJiffies << "total diff:" << totalJiffDiff;
 
-        qulonglong totalJiffDiff = totalJiffies - oldTotalJiffies;
-        qulonglong processWorkJiffDiff = processWorkJiffies - oldProcessWorkJiffies;
-        if (totalJiffDiff > 0) {
-            percentage = 100.0 * processWorkJiffDiff / totalJiffDiff;
+        // Restarted processes start over counting
+        if (oldStat.pid == stat.pid && stat.workJiffies >= oldStat.workJiffies) {
+            percentage = 100.0 * (stat.workJiffies - oldStat.workJiffies) / totalJiffDiff;
         }
     }
 
-    m_oldTotalJiffies[thing] = totalJiffies;
-    m_oldProcessWorkJiffies[thing] = processWorkJiffies;
+    m_oldProcessStats[thing] = stat;
 
     return percentage;
 }
-
-qint32 IntegrationPluginSystemMonitor::getPidByName(const QString &processName)
-{
-    QDir proc("/proc");
-    foreach (const QString dirName, proc.entryList(QDir::AllDirs | QDir::NoDotAndDotDot)) {
-        QFile statusFile(proc.absoluteFilePath(dirName + QDir::separator() + "status"));
-        if (!statusFile.open(QFile::ReadOnly)) {
-            continue;
-        }
-        QString line = statusFile.readLine().trimmed();
-        line.remove(QRegExp("Name:(\\s)*"));
-//        qCDebug(dcSystemMonitor()) << "Found process:" << line << "looking for" << processName.left(15);
-        // names in /proc/<pid>/status are trimmed to 15 characters...
-        if (processName.left(15) == line.left(15)) {
-            return dirName.toInt();
-        }
-    }
-    return -1;
-}
-
@@ -39,6 +39,7 @@
 #include <QUrlQuery>
 
 #include "extern-plugininfo.h"
+#include "procsampler.h"
 
 class IntegrationPluginSystemMonitor: public IntegrationPlugin {
 	Q_OBJECT
@@ -56,19 +57,15 @@ private:
     void updateSystemMonitor(Thing *thing);
     void updateProcessMonitor(Thing *thing);
 
-    double readTotalCpuUsage(Thing *thing);
     double readTotalMemoryUsage();
     bool readProcessMemoryUsage(qint32 pid, quint32 &total, quint32 &rss, quint32 &shared, double &percentage);
-    double readProcessCpuUsage(qint32 pid, Thing *thing);
-
-    qint32 getPidByName(const QString &processName);
+    double readProcessCpuUsage(const ProcSampler::ProcessStat &stat, Thing *thing);
 
 private:
     PluginTimer *m_refreshTimer = nullptr;
 
-    QHash<Thing*, qulonglong> m_oldTotalJiffies;
-    QHash<Thing*, qulonglong> m_oldWorkJiffies;
-    QHash<Thing*, qulonglong> m_oldProcessWorkJiffies;
+    ProcSampler m_sampler;
+    QHash<Thing*, ProcSampler::ProcessStat> m_oldProcessStats;
 
 };
 
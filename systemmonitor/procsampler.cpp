@@ -0,0 +1,431 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "procsampler.h"
+#include "extern-plugininfo.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Reads up to size - 1 bytes of the given file and null terminates them. Returns the length or -1.
+static int readFile(const char *path, char *buffer, int size)
+{
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int length = 0;
+    while (length < size - 1) {
+        ssize_t count = ::read(fd, buffer + length, size - 1 - length);
+        if (count < 0) {
+            ::close(fd);
+            return -1;
+        }
+        if (count == 0) {
+            break;
+        }
+        length += count;
+    }
+    ::close(fd);
+    buffer[length] = '\0';
+    return length;
+}
+
+// Reads the whole file into buffer, growing it as needed, and null terminates it. The buffer
+// keeps its size so following reads of the same file don't allocate. Returns the length or -1.
+static int readFile(const char *path, QByteArray &buffer)
+{
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (buffer.size() < 4096) {
+        buffer.resize(4096);
+    }
+    int length = 0;
+    while (true) {
+        if (length == buffer.size() - 1) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t count = ::read(fd, buffer.data() + length, buffer.size() - 1 - length);
+        if (count < 0) {
+            ::close(fd);
+            return -1;
+        }
+        if (count == 0) {
+            break;
+        }
+        length += count;
+    }
+    ::close(fd);
+    buffer.data()[length] = '\0';
+    return length;
+}
+
+// Parses up to maxCount whitespace separated numbers starting at data. Returns the amount parsed.
+// Negative numbers (e.g. tpgid in /proc/<pid>/stat) are accepted but not meaningful as unsigned.
+static int parseNumbers(const char *data, quint64 *values, int maxCount)
+{
+    int count = 0;
+    const char *pos = data;
+    while (count < maxCount) {
+        while (*pos == ' ' || *pos == '\t') {
+            pos++;
+        }
+        if ((*pos < '0' || *pos > '9') && *pos != '-') {
+            break;
+        }
+        char *end = nullptr;
+        values[count++] = *pos == '-' ? static_cast<quint64>(strtoll(pos, &end, 10)) : strtoull(pos, &end, 10);
+        if (end == pos) {
+            return count - 1;
+        }
+        pos = end;
+    }
+    return count;
+}
+
+quint64 ProcSampler::CpuTimes::total() const
+{
+    return user + nice + system + idle + iowait + irq + softirq + steal;
+}
+
+quint64 ProcSampler::CpuTimes::busy() const
+{
+    return total() - idle - iowait;
+}
+
+ProcSampler::ProcSampler(const QByteArray &procRoot) :
+    m_procRoot(procRoot)
+{
+
+}
+
+bool ProcSampler::sample()
+{
+    m_scannedThisCycle = false;
+    m_scanResult.clear();
+
+    readPressure();
+    return readCpuTimes();
+}
+
+double ProcSampler::cpuUsage() const
+{
+    if (!m_hasPrevious) {
+        return -1;
+    }
+    qCDebug(dcSystemMonitor()) << "SystemCPU:" << "work diff:" << m_cpuTimes.busy() - m_previousCpuTimes.busy() << "total diff:" << totalJiffiesDelta();
+    return usage(m_cpuTimes, m_previousCpuTimes);
+}
+
+int ProcSampler::coreCount() const
+{
+    return m_coreTimes.count();
+}
+
+double ProcSampler::coreUsage(int core) const
+{
+    if (!m_hasPrevious || core < 0 || core >= m_coreTimes.count() || m_previousCoreTimes.count() != m_coreTimes.count()) {
+        return -1;
+    }
+    return usage(m_coreTimes.at(core), m_previousCoreTimes.at(core));
+}
+
+double ProcSampler::ioWait() const
+{
+    quint64 totalDiff = totalJiffiesDelta();
+    if (totalDiff == 0) {
+        return -1;
+    }
+    // iowait is not guaranteed to be monotonic, it may go backwards on idle cores
+    if (m_cpuTimes.iowait < m_previousCpuTimes.iowait) {
+        return 0;
+    }
+    return 100.0 * (m_cpuTimes.iowait - m_previousCpuTimes.iowait) / totalDiff;
+}
+
+double ProcSampler::pressure(PressureResource resource) const
+{
+    qint64 total = m_pressureTotals[resource];
+    qint64 previous = m_previousPressureTotals[resource];
+    if (total < 0 || previous < 0 || total < previous || m_pressureInterval <= 0) {
+        return -1;
+    }
+    return qMin(100.0, 100.0 * (total - previous) / m_pressureInterval);
+}
+
+bool ProcSampler::readCpuTimes()
+{
+    // The per core lines come right after the aggregate one and before the (long) intr line
+    QByteArray path = m_procRoot + "/stat";
+    if (readFile(path.constData(), m_statBuffer) < 0) {
+        qCWarning(dcSystemMonitor()).nospace() << "Unable to open " << path << ". Cannot read CPU usage.";
+        m_valid = false;
+        m_hasPrevious = false;
+        return false;
+    }
+
+    CpuTimes cpuTimes;
+    QVector<CpuTimes> coreTimes;
+    bool aggregateFound = false;
+
+    const char *line = m_statBuffer.constData();
+    while (strncmp(line, "cpu", 3) == 0) {
+        const char *lineEnd = strchr(line, '\n');
+        if (!lineEnd) {
+            break;
+        }
+
+        // cpu[N] user nice system idle iowait irq softirq steal guest guest_nice
+        const char *pos = line + 3;
+        bool aggregate = *pos == ' ';
+        while (*pos >= '0' && *pos <= '9') {
+            pos++;
+        }
+        quint64 values[8] = {0};
+        if (parseNumbers(pos, values, 8) < 4) {
+            break;
+        }
+
+        CpuTimes times;
+        times.user = values[0];
+        times.nice = values[1];
+        times.system = values[2];
+        times.idle = values[3];
+        times.iowait = values[4];
+        times.irq = values[5];
+        times.softirq = values[6];
+        times.steal = values[7];
+
+        if (aggregate) {
+            cpuTimes = times;
+            aggregateFound = true;
+        } else {
+            coreTimes.append(times);
+        }
+        line = lineEnd + 1;
+    }
+
+    if (!aggregateFound) {
+        qCWarning(dcSystemMonitor()) << path << "not in expected format";
+        m_valid = false;
+        m_hasPrevious = false;
+        return false;
+    }
+
+    m_previousCpuTimes = m_cpuTimes;
+    m_previousCoreTimes = m_coreTimes;
+    m_hasPrevious = m_valid;
+
+    m_cpuTimes = cpuTimes;
+    m_coreTimes = coreTimes;
+    m_valid = true;
+
+    if (m_hasPrevious && (m_cpuTimes.total() < m_previousCpuTimes.total() || m_cpuTimes.busy() < m_previousCpuTimes.busy())) {
+        // One of the values overflowed. Skipping this cycle
+        m_hasPrevious = false;
+    }
+    return true;
+}
+
+void ProcSampler::readPressure()
+{
+    static const char *files[] = { "cpu", "io", "memory" };
+
+    m_pressureInterval = m_pressureTimer.isValid() ? m_pressureTimer.nsecsElapsed() / 1000 : 0;
+    m_pressureTimer.start();
+
+    char path[PATH_MAX];
+    char buffer[256];
+    for (int i = 0; i < 3; i++) {
+        m_previousPressureTotals[i] = m_pressureTotals[i];
+        m_pressureTotals[i] = -1;
+
+        // some avg10=0.00 avg60=0.00 avg300=0.00 total=12345
+        snprintf(path, sizeof(path), "%s/pressure/%s", m_procRoot.constData(), files[i]);
+        if (readFile(path, buffer, sizeof(buffer)) < 0 || strncmp(buffer, "some ", 5) != 0) {
+            continue;
+        }
+        const char *total = strstr(buffer, "total=");
+        const char *lineEnd = strchr(buffer, '\n');
+        if (!total || (lineEnd && total > lineEnd)) {
+            continue;
+        }
+        m_pressureTotals[i] = strtoll(total + 6, nullptr, 10);
+    }
+}
+
+double ProcSampler::usage(const CpuTimes &current, const CpuTimes &previous)
+{
+    if (current.total() <= previous.total() || current.busy() < previous.busy()) {
+        return current.total() == previous.total() ? 0 : -1;
+    }
+    return 100.0 * (current.busy() - previous.busy()) / (current.total() - previous.total());
+}
+
+quint64 ProcSampler::totalJiffiesDelta() const
+{
+    if (!m_hasPrevious) {
+        return 0;
+    }
+    return m_cpuTimes.total() - m_previousCpuTimes.total();
+}
+
+bool ProcSampler::readProcessStat(const QString &processName, ProcessStat &stat)
+{
+    // names in /proc/<pid>/comm are trimmed to 15 characters...
+    QByteArray name = processName.left(15).toUtf8();
+
+    // Reading the stat file of the cached pid is the liveness check. The comm field in
+    // it also catches pids which got reused by a different process meanwhile.
+    qint32 pid = m_pidCache.value(name, -1);
+    if (pid != -1 && readStat(pid, name, stat)) {
+        return true;
+    }
+    m_pidCache.remove(name);
+
+    pid = findPid(name);
+    if (pid == -1 || !readStat(pid, name, stat)) {
+        return false;
+    }
+    m_pidCache.insert(name, pid);
+    return true;
+}
+
+bool ProcSampler::readProcessMemory(qint32 pid, quint64 &totalKb, quint64 &rssKb, quint64 &sharedKb)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/statm", m_procRoot.constData(), pid);
+    char buffer[256];
+    if (readFile(path, buffer, sizeof(buffer)) < 0) {
+        qCWarning(dcSystemMonitor()).nospace() << "Unable to open " << path << ". Cannot read memory usage.";
+        return false;
+    }
+
+    // size resident shared text lib data dt, in pages
+    quint64 values[3];
+    if (parseNumbers(buffer, values, 3) < 3) {
+        qCWarning(dcSystemMonitor()) << path << "not in expected format";
+        return false;
+    }
+
+    static const quint64 pageSizeKb = sysconf(_SC_PAGE_SIZE) / 1024;
+    totalKb = values[0] * pageSizeKb;
+    rssKb = values[1] * pageSizeKb;
+    sharedKb = values[2] * pageSizeKb;
+    return true;
+}
+
+qint32 ProcSampler::findPid(const QByteArray &name)
+{
+    // Several process monitors may miss in the same cycle, scan /proc at most once for all of them
+    if (!m_scannedThisCycle) {
+        scanProcesses();
+        m_scannedThisCycle = true;
+    }
+    return m_scanResult.value(name, -1);
+}
+
+void ProcSampler::scanProcesses()
+{
+    DIR *proc = opendir(m_procRoot.constData());
+    if (!proc) {
+        qCWarning(dcSystemMonitor()).nospace() << "Unable to open " << m_procRoot << ". Cannot look up processes.";
+        return;
+    }
+
+    char path[PATH_MAX];
+    char buffer[64];
+    struct dirent *entry;
+    while ((entry = readdir(proc)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s/comm", m_procRoot.constData(), entry->d_name);
+        int length = readFile(path, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+        if (buffer[length - 1] == '\n') {
+            buffer[--length] = '\0';
+        }
+        QByteArray comm(buffer, length);
+        // Keep the first match, like the lookup always did
+        if (!m_scanResult.contains(comm)) {
+            m_scanResult.insert(comm, atoi(entry->d_name));
+        }
+    }
+    closedir(proc);
+}
+
+bool ProcSampler::readStat(qint32 pid, const QByteArray &name, ProcessStat &stat)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/stat", m_procRoot.constData(), pid);
+    char buffer[1024];
+    if (readFile(path, buffer, sizeof(buffer)) < 0) {
+        return false;
+    }
+
+    // pid (comm) state ppid ... The comm may contain spaces and parenthesis, so look for the last ')'
+    char *commStart = strchr(buffer, '(');
+    char *commEnd = strrchr(buffer, ')');
+    if (!commStart || !commEnd || commEnd < commStart) {
+        qCWarning(dcSystemMonitor()) << path << "not in expected format";
+        return false;
+    }
+    if (QByteArray::fromRawData(commStart + 1, commEnd - commStart - 1) != name) {
+        return false;
+    }
+
+    // Skip " state" to get to ppid (field 4). utime, stime, cutime and cstime are fields 14 to 17.
+    const char *pos = commEnd + 1;
+    while (*pos == ' ') {
+        pos++;
+    }
+    while (*pos && *pos != ' ') {
+        pos++;
+    }
+    quint64 values[14];
+    if (parseNumbers(pos, values, 14) < 14) {
+        qCWarning(dcSystemMonitor()) << path << "not in expected format";
+        return false;
+    }
+
+    stat.pid = pid;
+    stat.workJiffies = values[10] + values[11] + values[12] + values[13];
+    return true;
+}
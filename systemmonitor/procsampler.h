@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef PROCSAMPLER_H
+#define PROCSAMPLER_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+// Reads the /proc counters the system monitor needs once per refresh cycle and
+// shares them between all things. /proc/stat is read into a buffer which grows to
+// its size and is kept for the next cycle, the other files fit fixed size buffers.
+class ProcSampler
+{
+public:
+    class CpuTimes {
+    public:
+        quint64 user = 0;
+        quint64 nice = 0;
+        quint64 system = 0;
+        quint64 idle = 0;
+        quint64 iowait = 0;
+        quint64 irq = 0;
+        quint64 softirq = 0;
+        quint64 steal = 0;
+
+        quint64 total() const;
+        quint64 busy() const;
+    };
+
+    class ProcessStat {
+    public:
+        qint32 pid = -1;
+        // utime + stime + cutime + cstime
+        quint64 workJiffies = 0;
+    };
+
+    enum PressureResource {
+        PressureCpu,
+        PressureIo,
+        PressureMemory
+    };
+
+    // procRoot allows reading a copy of /proc, e.g. a synthetic one for testing
+    explicit ProcSampler(const QByteArray &procRoot = "/proc");
+
+    // Reads /proc/stat and /proc/pressure/*. To be called once per refresh cycle before querying anything else.
+    bool sample();
+
+    // Percentage of non idle CPU time since the previous sample, -1 if not available yet
+    double cpuUsage() const;
+    // Same for the single cores, -1 if not available yet
+    int coreCount() const;
+    double coreUsage(int core) const;
+    // Percentage of CPU time spent waiting for IO since the previous sample, -1 if not available yet
+    double ioWait() const;
+    // Percentage of wall time in which some tasks were stalled on the given resource since the
+    // previous sample, -1 if not available (yet or because the kernel has no PSI support)
+    double pressure(PressureResource resource) const;
+    // Jiffies elapsed on all CPUs since the previous sample, 0 if not available yet
+    quint64 totalJiffiesDelta() const;
+
+    // Looks up the process by name (as in /proc/<pid>/comm) and reads its stat.
+    // Returns false if no such process is running.
+    bool readProcessStat(const QString &processName, ProcessStat &stat);
+    bool readProcessMemory(qint32 pid, quint64 &totalKb, quint64 &rssKb, quint64 &sharedKb);
+
+private:
+    QByteArray m_procRoot;
+    QByteArray m_statBuffer;
+
+    CpuTimes m_cpuTimes;
+    CpuTimes m_previousCpuTimes;
+    bool m_hasPrevious = false;
+    bool m_valid = false;
+
+    QVector<CpuTimes> m_coreTimes;
+    QVector<CpuTimes> m_previousCoreTimes;
+
+    // "some" total stall time counters in microseconds, -1 if not readable
+    qint64 m_pressureTotals[3] = {-1, -1, -1};
+    qint64 m_previousPressureTotals[3] = {-1, -1, -1};
+    QElapsedTimer m_pressureTimer;
+    qint64 m_pressureInterval = 0;
+
+    // Process name -> pid, verified on each use by reading /proc/<pid>/stat
+    QHash<QByteArray, qint32> m_pidCache;
+    // Result of the last full /proc scan, reused for all lookups within one cycle
+    QHash<QByteArray, qint32> m_scanResult;
+    bool m_scannedThisCycle = false;
+
+    bool readCpuTimes();
+    void readPressure();
+    static double usage(const CpuTimes &current, const CpuTimes &previous);
+
+    qint32 findPid(const QByteArray &name);
+    void scanProcesses();
+    bool readStat(qint32 pid, const QByteArray &name, ProcessStat &stat);
+};
+
+#endif // PROCSAMPLER_H
@@ -4,6 +4,8 @@ TARGET = $$qtLibraryTarget(nymea_integrationpluginsystemmonitor)
 
 SOURCES += \
     integrationpluginsystemmonitor.cpp \
+    procsampler.cpp \
 
 HEADERS += \
     integrationpluginsystemmonitor.h \
+    procsampler.h \
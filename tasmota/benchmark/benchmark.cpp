@@ -0,0 +1,470 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Replays the MQTT traffic of 100 Tasmota devices publishing 10 topics per second each against the
+// publish handling of the plugin, comparing the former dispatch (QHash::key() lookup of the thing,
+// topic prefix strings built per message, myThings() searched for the children) with the channel
+// index, the topic suffix table and the per parent children table.
+//
+// Each device is a 4 channel Sonoff with a legacy switch on POWER1, a legacy light on POWER2 and,
+// for 80 of them, a power meter child. Per second it publishes POWER1 to POWER4, STATE, SENSOR with
+// ENERGY and RESULT, LWT, UPTIME and INFO1 which the plugin doesn't handle. Both sides update their
+// own copy of the things, which have to be identical afterwards.
+//
+// Usage: benchmark [devices] [seconds]
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonDocument>
+#include <QPair>
+#include <QStringList>
+#include <QUuid>
+#include <QVariantMap>
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+// Stand-in for Thing, states which the thing class doesn't have are ignored like in nymea
+struct Thing {
+    QUuid id = QUuid::createUuid();
+    QUuid parentId;
+    QString thingClass;
+    QString name;
+    QVariantMap params;
+    QHash<QString, QVariant> states;
+    int events = 0;
+
+    bool hasState(const QString &name) const { return states.contains(name); }
+    void setStateValue(const QString &name, const QVariant &value)
+    {
+        QHash<QString, QVariant>::iterator it = states.find(name);
+        if (it != states.end())
+            it.value() = value;
+    }
+};
+typedef QList<Thing *> Things;
+
+// Stand-in for MqttChannel
+struct Channel {
+    QStringList topicPrefixList;
+};
+
+struct Message {
+    Channel *channel;
+    QString topic;
+    QByteArray payload;
+};
+
+static const QHash<QString, QHash<QString, QString>> stateMaps = {
+    {"sonoff_quad", {{"POWER1", "powerCH1"}, {"POWER2", "powerCH2"}, {"POWER3", "powerCH3"}, {"POWER4", "powerCH4"}}}
+};
+static const QHash<QString, QString> channelParamMap = {
+    {"tasmotaSwitch", "channelName"},
+    {"tasmotaLight", "channelName"}
+};
+
+class Setup
+{
+public:
+    Setup(int deviceCount)
+    {
+        for (int i = 0; i < deviceCount; i++) {
+            Thing *parent = addThing("sonoff_quad", QUuid(), QVariantMap(), {"connected", "signalStrength", "powerCH1", "powerCH2", "powerCH3", "powerCH4"});
+            parent->name = QString("Sonoff %1").arg(i);
+            addThing("tasmotaSwitch", parent->id, {{"channelName", "POWER1"}}, {"connected", "signalStrength", "power"});
+            addThing("tasmotaLight", parent->id, {{"channelName", "POWER2"}}, {"connected", "signalStrength", "power"});
+            if (i % 5 != 4)
+                addThing("powerMeterChannel", parent->id, {{"channelName", "SENSOR"}}, {"connected", "currentPower", "totalEnergyConsumed"});
+
+            Channel *channel = new Channel;
+            channel->topicPrefixList.append(QUuid::createUuid().toString().remove('{').remove('}'));
+            mqttChannels.insert(parent, channel);
+            parents.append(parent);
+        }
+    }
+
+    ~Setup()
+    {
+        qDeleteAll(things);
+        qDeleteAll(mqttChannels);
+    }
+
+    Things things;
+    Things parents;
+    QHash<Thing *, Channel *> mqttChannels;
+    int appeared = 0;
+
+private:
+    Thing *addThing(const QString &thingClass, const QUuid &parentId, const QVariantMap &params, const QStringList &states)
+    {
+        Thing *thing = new Thing;
+        thing->thingClass = thingClass;
+        thing->parentId = parentId;
+        thing->params = params;
+        foreach (const QString &state, states) {
+            thing->states.insert(state, QVariant());
+        }
+        things.append(thing);
+        return thing;
+    }
+};
+
+static Things filterByParentId(const Things &things, const QUuid &parentId)
+{
+    Things result;
+    foreach (Thing *thing, things) {
+        if (thing->parentId == parentId)
+            result.append(thing);
+    }
+    return result;
+}
+
+// Former IntegrationPluginTasmota::onPublishReceived()
+static void dispatchScan(Setup &setup, Channel *channel, const QString &topic, const QByteArray &payload)
+{
+    Thing *thing = setup.mqttChannels.key(channel);
+    if (topic.startsWith(channel->topicPrefixList.first() + "/sonoff/POWER")) {
+        QString channelName = topic.split("/").last();
+
+        thing->setStateValue(stateMaps.value(thing->thingClass).value(channelName), payload == "ON");
+
+        foreach (Thing *child, filterByParentId(setup.things, thing->id)) {
+            if (child->params.value(channelParamMap.value(child->thingClass)).toString() != channelName) {
+                continue;
+            }
+            if (child->hasState("power")) {
+                child->setStateValue("power", payload == "ON");
+            }
+            if (child->thingClass == "tasmotaSwitch") {
+                child->events++;
+            }
+        }
+    }
+    if (topic.startsWith(channel->topicPrefixList.first() + "/sonoff/STATE")) {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            return;
+        }
+        QVariantMap dataMap = jsonDoc.toVariant().toMap();
+        thing->setStateValue("signalStrength", dataMap.value("Wifi").toMap().value("RSSI").toInt());
+
+        if (thing->hasState("brightness")) {
+            thing->setStateValue("brightness", dataMap.value("Dimmer").toInt());
+        }
+
+        foreach (Thing *child, filterByParentId(setup.things, thing->id)) {
+            if (child->hasState("power")) {
+                QString childChannel = child->params.value(channelParamMap.value(child->thingClass)).toString();
+                QString valueString = jsonDoc.toVariant().toMap().value(childChannel).toString();
+                child->setStateValue("power", valueString == "ON");
+            }
+            child->setStateValue("signalStrength", dataMap.value("Wifi").toMap().value("RSSI").toInt());
+        }
+    }
+    if (topic.startsWith(channel->topicPrefixList.first() + "/sonoff/SENSOR")) {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            return;
+        }
+        QVariantMap dataMap = jsonDoc.toVariant().toMap();
+
+        if (dataMap.contains("ENERGY")) {
+            QVariantMap energyMap = dataMap.value("ENERGY").toMap();
+            QString channelName = topic.split("/").last();
+
+            // filterByParentId().filterByInterface("smartmeterconsumer").findByParams()
+            Thing *meter = nullptr;
+            Things meters;
+            foreach (Thing *child, filterByParentId(setup.things, thing->id)) {
+                if (child->thingClass == "powerMeterChannel")
+                    meters.append(child);
+            }
+            foreach (Thing *child, meters) {
+                if (child->params.value("channelName") == channelName) {
+                    meter = child;
+                    break;
+                }
+            }
+            if (!meter) {
+                setup.appeared++;
+                return;
+            }
+            meter->setStateValue("currentPower", energyMap.value("Power").toDouble());
+            meter->setStateValue("totalEnergyConsumed", energyMap.value("Total").toDouble());
+        }
+    }
+}
+
+// Current IntegrationPluginTasmota::onPublishReceived() and the topic handlers
+class IndexDispatcher
+{
+public:
+    explicit IndexDispatcher(Setup &setup) : m_setup(setup)
+    {
+        foreach (Thing *thing, setup.mqttChannels.keys()) {
+            m_channelThings.insert(setup.mqttChannels.value(thing), thing);
+        }
+    }
+
+    void dispatch(Channel *channel, const QString &topic, const QByteArray &payload)
+    {
+        static const QList<QPair<QString, TopicHandler>> topicHandlers = {
+            {"POWER", &IndexDispatcher::handlePowerTopic},
+            {"STATE", &IndexDispatcher::handleStateTopic},
+            {"SENSOR", &IndexDispatcher::handleSensorTopic}
+        };
+
+        Thing *thing = m_channelThings.value(channel);
+        if (!thing)
+            return;
+
+        const QString &prefix = channel->topicPrefixList.first();
+        static const QString topicName = QStringLiteral("/sonoff/");
+        if (!topic.startsWith(prefix) || topic.midRef(prefix.length(), topicName.length()) != topicName)
+            return;
+
+        QStringRef suffix = topic.midRef(prefix.length() + topicName.length());
+        for (int i = 0; i < topicHandlers.count(); i++) {
+            if (suffix.startsWith(topicHandlers.at(i).first)) {
+                QString channelName = topic.mid(topic.lastIndexOf('/') + 1);
+                (this->*topicHandlers.at(i).second)(thing, channelName, payload);
+                return;
+            }
+        }
+    }
+
+private:
+    typedef void (IndexDispatcher::*TopicHandler)(Thing *thing, const QString &channelName, const QByteArray &payload);
+
+    struct Children {
+        Things all;
+        QHash<QString, Things> byChannel;
+        QHash<QString, Thing *> meters;
+    };
+
+    const Children &children(Thing *parent)
+    {
+        QHash<Thing *, Children>::iterator it = m_children.find(parent);
+        if (it == m_children.end()) {
+            Children children;
+            foreach (Thing *child, filterByParentId(m_setup.things, parent->id)) {
+                children.all.append(child);
+                if (channelParamMap.contains(child->thingClass)) {
+                    children.byChannel[child->params.value(channelParamMap.value(child->thingClass)).toString()].append(child);
+                }
+                if (child->thingClass == "powerMeterChannel") {
+                    children.meters.insert(child->params.value("channelName").toString(), child);
+                }
+            }
+            it = m_children.insert(parent, children);
+        }
+        return it.value();
+    }
+
+    void handlePowerTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+    {
+        thing->setStateValue(stateMaps.value(thing->thingClass).value(channelName), payload == "ON");
+
+        foreach (Thing *child, children(thing).byChannel.value(channelName)) {
+            if (child->hasState("power")) {
+                child->setStateValue("power", payload == "ON");
+            }
+            if (child->thingClass == "tasmotaSwitch") {
+                child->events++;
+            }
+        }
+    }
+
+    void handleStateTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+    {
+        Q_UNUSED(channelName)
+
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            return;
+        }
+        QVariantMap dataMap = jsonDoc.toVariant().toMap();
+        int signalStrength = dataMap.value("Wifi").toMap().value("RSSI").toInt();
+        thing->setStateValue("signalStrength", signalStrength);
+
+        if (thing->hasState("brightness")) {
+            thing->setStateValue("brightness", dataMap.value("Dimmer").toInt());
+        }
+
+        const Children &tasmotaChildren = children(thing);
+        foreach (const QString &childChannel, tasmotaChildren.byChannel.keys()) {
+            QString valueString = dataMap.value(childChannel).toString();
+            foreach (Thing *child, tasmotaChildren.byChannel.value(childChannel)) {
+                if (child->hasState("power")) {
+                    child->setStateValue("power", valueString == "ON");
+                }
+            }
+        }
+        foreach (Thing *child, tasmotaChildren.all) {
+            child->setStateValue("signalStrength", signalStrength);
+        }
+    }
+
+    void handleSensorTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+    {
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+        if (error.error != QJsonParseError::NoError) {
+            return;
+        }
+        QVariantMap dataMap = jsonDoc.toVariant().toMap();
+
+        if (dataMap.contains("ENERGY")) {
+            QVariantMap energyMap = dataMap.value("ENERGY").toMap();
+
+            Thing *meter = children(thing).meters.value(channelName);
+            if (!meter) {
+                m_setup.appeared++;
+                return;
+            }
+            meter->setStateValue("currentPower", energyMap.value("Power").toDouble());
+            meter->setStateValue("totalEnergyConsumed", energyMap.value("Total").toDouble());
+        }
+    }
+
+    Setup &m_setup;
+    QHash<Channel *, Thing *> m_channelThings;
+    QHash<Thing *, Children> m_children;
+};
+
+// One second of traffic: every device publishes its 10 topics, interleaved like on the broker
+static QList<Message> trafficSecond(Setup &setup, int second)
+{
+    static const QStringList suffixes = {"POWER1", "POWER2", "POWER3", "POWER4", "STATE", "SENSOR", "RESULT", "LWT", "UPTIME", "INFO1"};
+
+    QList<Message> messages;
+    for (int topic = 0; topic < suffixes.count(); topic++) {
+        for (int device = 0; device < setup.parents.count(); device++) {
+            Channel *channel = setup.mqttChannels.value(setup.parents.at(device));
+            const QString &suffix = suffixes.at(topic);
+            bool on = (device + second + topic) % 3 == 0;
+            QByteArray payload;
+            if (suffix.startsWith("POWER")) {
+                payload = on ? "ON" : "OFF";
+            } else if (suffix == "STATE") {
+                payload = QString("{\"Time\":\"2026-10-16T12:00:%1\",\"Uptime\":\"0T01:00:00\",\"Heap\":25,\"POWER1\":\"%2\",\"POWER2\":\"%3\",\"POWER3\":\"OFF\",\"POWER4\":\"ON\","
+                                  "\"Wifi\":{\"AP\":1,\"SSId\":\"nymea\",\"RSSI\":%4,\"Signal\":-60,\"LinkCount\":1}}")
+                        .arg(second % 60, 2, 10, QChar('0')).arg(on ? "ON" : "OFF").arg(on ? "OFF" : "ON").arg(40 + (device + second) % 60).toUtf8();
+            } else if (suffix == "SENSOR") {
+                payload = QString("{\"Time\":\"2026-10-16T12:00:%1\",\"ENERGY\":{\"TotalStartTime\":\"2026-01-01T00:00:00\",\"Total\":%2,\"Yesterday\":1.2,\"Today\":0.4,"
+                                  "\"Power\":%3,\"ApparentPower\":120,\"ReactivePower\":20,\"Factor\":0.95,\"Voltage\":230,\"Current\":0.52}}")
+                        .arg(second % 60, 2, 10, QChar('0')).arg(100 + device * 0.5 + second * 0.001).arg((device * 7 + second) % 2300).toUtf8();
+            } else if (suffix == "LWT") {
+                payload = "Online";
+            } else {
+                payload = "{\"" + suffix.toUtf8() + "\":\"" + QByteArray::number(second) + "\"}";
+            }
+            messages.append({channel, channel->topicPrefixList.first() + "/sonoff/" + suffix, payload});
+        }
+    }
+    return messages;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QStringList arguments = application.arguments();
+    int deviceCount = qMax(1, arguments.value(1, "100").toInt());
+    int seconds = qMax(1, arguments.value(2, "60").toInt());
+
+    Setup scanSetup(deviceCount);
+    Setup indexSetup(deviceCount);
+    IndexDispatcher indexDispatcher(indexSetup);
+
+    // Both setups get the same traffic, only the channel pointers differ
+    QList<QList<Message>> scanTraffic;
+    QList<QList<Message>> indexTraffic;
+    for (int second = 0; second < seconds; second++) {
+        scanTraffic.append(trafficSecond(scanSetup, second));
+        QList<Message> messages = scanTraffic.last();
+        for (int i = 0; i < messages.count(); i++) {
+            Thing *parent = scanSetup.mqttChannels.key(messages.at(i).channel);
+            Channel *channel = indexSetup.mqttChannels.value(indexSetup.parents.at(scanSetup.parents.indexOf(parent)));
+            messages[i].topic.replace(0, messages.at(i).channel->topicPrefixList.first().length(), channel->topicPrefixList.first());
+            messages[i].channel = channel;
+        }
+        indexTraffic.append(messages);
+    }
+    int messageCount = deviceCount * 10 * seconds;
+    qInfo().noquote() << QString("Replaying %1 s of %2 devices with 10 topics/s each, %3 messages").arg(seconds).arg(deviceCount).arg(messageCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach (const QList<Message> &messages, scanTraffic) {
+        foreach (const Message &message, messages) {
+            dispatchScan(scanSetup, message.channel, message.topic, message.payload);
+        }
+    }
+    qint64 scanTime = timer.nsecsElapsed();
+
+    timer.restart();
+    foreach (const QList<Message> &messages, indexTraffic) {
+        foreach (const Message &message, messages) {
+            indexDispatcher.dispatch(message.channel, message.topic, message.payload);
+        }
+    }
+    qint64 indexTime = timer.nsecsElapsed();
+
+    // CPU time needed for one second of traffic, in percent of one core
+    qInfo().noquote() << QString("former dispatch: %1 us/message, %2 % CPU at %3 messages/s")
+                         .arg(scanTime / 1000.0 / messageCount, 0, 'f', 3).arg(scanTime / 10000000.0 / seconds, 0, 'f', 2).arg(deviceCount * 10);
+    qInfo().noquote() << QString("index dispatch:  %1 us/message, %2 % CPU at %3 messages/s")
+                         .arg(indexTime / 1000.0 / messageCount, 0, 'f', 3).arg(indexTime / 10000000.0 / seconds, 0, 'f', 2).arg(deviceCount * 10);
+    qInfo().noquote() << QString("speedup:         %1x").arg(static_cast<double>(scanTime) / indexTime, 0, 'f', 2);
+
+    bool statesEqual = true;
+    bool eventsEqual = true;
+    for (int i = 0; i < scanSetup.things.count(); i++) {
+        statesEqual &= scanSetup.things.at(i)->states == indexSetup.things.at(i)->states;
+        eventsEqual &= scanSetup.things.at(i)->events == indexSetup.things.at(i)->events;
+    }
+    check(statesEqual, "All things end up with the same states");
+    check(eventsEqual, "All switches emitted the same pressed events");
+    check(scanSetup.appeared == indexSetup.appeared, QString("Both request the same missing power meters (%1)").arg(scanSetup.appeared));
+
+    return s_failures > 0 ? 1 : 0;
+}
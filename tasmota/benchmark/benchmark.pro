@@ -0,0 +1,6 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT -= gui
+
+SOURCES += benchmark.cpp
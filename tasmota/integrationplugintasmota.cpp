@@ -165,6 +165,7 @@ void IntegrationPluginTasmota::setupThing(ThingSetupInfo *info)
                 return;
             }
             m_mqttChannels.insert(info->thing(), channel);
+            m_channelThings.insert(channel, info->thing());
             connect(channel, &MqttChannel::clientConnected, this, &IntegrationPluginTasmota::onClientConnected);
             connect(channel, &MqttChannel::clientDisconnected, this, &IntegrationPluginTasmota::onClientDisconnected);
             connect(channel, &MqttChannel::publishReceived, this, &IntegrationPluginTasmota::onPublishReceived);
@@ -267,14 +268,28 @@ void IntegrationPluginTasmota::setupThing(ThingSetupInfo *info)
     qCWarning(dcTasmota) << "Unhandled ThingClass in setupDevice" << thing->thingClassId();
 }
 
+void IntegrationPluginTasmota::postSetupThing(Thing *thing)
+{
+    // The child is part of myThings() only now, rebuild the channel index of its parent
+    if (!thing->parentId().isNull()) {
+        m_children.remove(myThings().findById(thing->parentId()));
+    }
+}
+
 void IntegrationPluginTasmota::thingRemoved(Thing *thing)
 {
     qCDebug(dcTasmota) << "Device removed" << thing->name();
     if (m_mqttChannels.contains(thing)) {
         qCDebug(dcTasmota) << "Releasing MQTT channel";
         MqttChannel* channel = m_mqttChannels.take(thing);
+        m_channelThings.remove(channel);
         hardwareManager()->mqttProvider()->releaseChannel(channel);
     }
+
+    m_children.remove(thing);
+    if (!thing->parentId().isNull()) {
+        m_children.remove(myThings().findById(thing->parentId()));
+    }
 }
 
 void IntegrationPluginTasmota::executeAction(ThingActionInfo *info)
@@ -365,7 +380,7 @@ void IntegrationPluginTasmota::executeAction(ThingActionInfo *info)
 void IntegrationPluginTasmota::onClientConnected(MqttChannel *channel)
 {
     qCDebug(dcTasmota) << "Sonoff thing connected!";
-    Thing *dev = m_mqttChannels.key(channel);
+    Thing *dev = m_channelThings.value(channel);
     dev->setStateValue("connected", true);
 
     foreach (Thing *child, myThings()) {
@@ -378,7 +393,7 @@ void IntegrationPluginTasmota::onClientConnected(MqttChannel *channel)
 void IntegrationPluginTasmota::onClientDisconnected(MqttChannel *channel)
 {
     qCDebug(dcTasmota) << "Sonoff thing disconnected!";
-    Thing *dev = m_mqttChannels.key(channel);
+    Thing *dev = m_channelThings.value(channel);
     dev->setStateValue("connected", false);
 
     foreach (Thing *child, myThings()) {
@@ -390,75 +405,123 @@ void IntegrationPluginTasmota::onClientDisconnected(MqttChannel *channel)
 
 void IntegrationPluginTasmota::onPublishReceived(MqttChannel *channel, const QString &topic, const QByteArray &payload)
 {
+    // Topic suffixes after "<prefix>/sonoff/", matched by prefix
+    static const QList<QPair<QString, TopicHandler>> topicHandlers = {
+        {"POWER", &IntegrationPluginTasmota::handlePowerTopic},
+        {"STATE", &IntegrationPluginTasmota::handleStateTopic},
+        {"SENSOR", &IntegrationPluginTasmota::handleSensorTopic}
+    };
+
     qCDebug(dcTasmota) << "Publish received from Sonoff thing:" << topic << qUtf8Printable(payload);
-    Thing *thing = m_mqttChannels.key(channel);
-    if (topic.startsWith(channel->topicPrefixList().first() + "/sonoff/POWER")) {
-        QString channelName = topic.split("/").last();
+    Thing *thing = m_channelThings.value(channel);
+    if (!thing)
+        return;
 
-        thing->setStateValue(stateMaps.value(thing->thingClassId()).value(channelName), payload == "ON");
+    const QString &prefix = channel->topicPrefixList().first();
+    static const QString topicName = QStringLiteral("/sonoff/");
+    if (!topic.startsWith(prefix) || topic.midRef(prefix.length(), topicName.length()) != topicName)
+        return;
 
-        // Legacy (deprecated) connected things via params
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            if (child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString() != channelName) {
-                continue;
-            }
-            if (child->hasState("power")) {
-                child->setStateValue("power", payload == "ON");
+    QStringRef suffix = topic.midRef(prefix.length() + topicName.length());
+    for (int i = 0; i < topicHandlers.count(); i++) {
+        if (suffix.startsWith(topicHandlers.at(i).first)) {
+            QString channelName = topic.mid(topic.lastIndexOf('/') + 1);
+            (this->*topicHandlers.at(i).second)(thing, channelName, payload);
+            return;
+        }
+    }
+}
+
+const IntegrationPluginTasmota::TasmotaChildren &IntegrationPluginTasmota::children(Thing *parent)
+{
+    QHash<Thing *, TasmotaChildren>::iterator it = m_children.find(parent);
+    if (it == m_children.end()) {
+        TasmotaChildren children;
+        foreach (Thing *child, myThings().filterByParentId(parent->id())) {
+            children.all.append(child);
+            if (m_channelParamTypeMap.contains(child->thingClassId())) {
+                children.byChannel[child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString()].append(child);
             }
-            if (child->thingClassId() == tasmotaSwitchThingClassId) {
-                Event event(tasmotaSwitchPressedEventTypeId, child->id());
-                emit emitEvent(event);
+            if (child->thingClassId() == powerMeterChannelThingClassId) {
+                children.meters.insert(child->paramValue(powerMeterChannelThingChannelNameParamTypeId).toString(), child);
             }
         }
+        it = m_children.insert(parent, children);
     }
-    if (topic.startsWith(channel->topicPrefixList().first() + "/sonoff/STATE")) {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
-            return;
-        }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-        thing->setStateValue("signalStrength", dataMap.value("Wifi").toMap().value("RSSI").toInt());
+    return it.value();
+}
+
+void IntegrationPluginTasmota::handlePowerTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+{
+    thing->setStateValue(stateMaps.value(thing->thingClassId()).value(channelName), payload == "ON");
 
-        if (thing->hasState("brightness")) {
-            thing->setStateValue("brightness", dataMap.value("Dimmer").toInt());
+    // Legacy (deprecated) connected things via params
+    foreach (Thing *child, children(thing).byChannel.value(channelName)) {
+        if (child->hasState("power")) {
+            child->setStateValue("power", payload == "ON");
         }
+        if (child->thingClassId() == tasmotaSwitchThingClassId) {
+            Event event(tasmotaSwitchPressedEventTypeId, child->id());
+            emit emitEvent(event);
+        }
+    }
+}
 
-        // Legacy (deprecated) connected things by params
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+void IntegrationPluginTasmota::handleStateTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+{
+    Q_UNUSED(channelName)
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
+        return;
+    }
+    QVariantMap dataMap = jsonDoc.toVariant().toMap();
+    int signalStrength = dataMap.value("Wifi").toMap().value("RSSI").toInt();
+    thing->setStateValue("signalStrength", signalStrength);
+
+    if (thing->hasState("brightness")) {
+        thing->setStateValue("brightness", dataMap.value("Dimmer").toInt());
+    }
+
+    // Legacy (deprecated) connected things by params
+    const TasmotaChildren &tasmotaChildren = children(thing);
+    foreach (const QString &childChannel, tasmotaChildren.byChannel.keys()) {
+        QString valueString = dataMap.value(childChannel).toString();
+        foreach (Thing *child, tasmotaChildren.byChannel.value(childChannel)) {
             if (child->hasState("power")) {
-                QString childChannel = child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString();
-                QString valueString = jsonDoc.toVariant().toMap().value(childChannel).toString();
                 child->setStateValue("power", valueString == "ON");
             }
-            child->setStateValue("signalStrength", dataMap.value("Wifi").toMap().value("RSSI").toInt());
         }
     }
-    if (topic.startsWith(channel->topicPrefixList().first() + "/sonoff/SENSOR")) {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
+    foreach (Thing *child, tasmotaChildren.all) {
+        child->setStateValue("signalStrength", signalStrength);
+    }
+}
+
+void IntegrationPluginTasmota::handleSensorTopic(Thing *thing, const QString &channelName, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
+        return;
+    }
+    QVariantMap dataMap = jsonDoc.toVariant().toMap();
+
+    if (dataMap.contains("ENERGY")) {
+        QVariantMap energyMap = dataMap.value("ENERGY").toMap();
+
+        // If we received energy meter values but don't have a power meter child yet, create one
+        Thing *meter = children(thing).meters.value(channelName);
+        if (!meter) {
+            ThingDescriptor descriptor(powerMeterChannelThingClassId, thing->name(), QString(), thing->id());
+            descriptor.setParams({Param(powerMeterChannelThingChannelNameParamTypeId, channelName)});
+            emit autoThingsAppeared({descriptor});
             return;
         }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-
-        if (dataMap.contains("ENERGY")) {
-            QVariantMap energyMap = dataMap.value("ENERGY").toMap();
-            QString channelName = topic.split("/").last();
-
-            // If we received energy meter values but don't have a power meter child yet, create one
-            Thing *meter = myThings().filterByParentId(thing->id()).filterByInterface("smartmeterconsumer").findByParams({Param(powerMeterChannelThingChannelNameParamTypeId, channelName)});
-            if (!meter) {
-                ThingDescriptor descriptor(powerMeterChannelThingClassId, thing->name(), QString(), thing->id());
-                descriptor.setParams({Param(powerMeterChannelThingChannelNameParamTypeId, channelName)});
-                emit autoThingsAppeared({descriptor});
-                return;
-            }
-            meter->setStateValue("currentPower", energyMap.value("Power").toDouble());
-            meter->setStateValue("totalEnergyConsumed", energyMap.value("Total").toDouble());
-        }
+        meter->setStateValue("currentPower", energyMap.value("Power").toDouble());
+        meter->setStateValue("totalEnergyConsumed", energyMap.value("Total").toDouble());
     }
 }
-
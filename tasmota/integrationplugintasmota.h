@@ -51,6 +51,7 @@ public:
 
     void init() override;
     void setupThing(ThingSetupInfo *info) override;
+    void postSetupThing(Thing *thing) override;
     void thingRemoved(Thing *thing) override;
     void executeAction(ThingActionInfo *info) override;
 
@@ -61,6 +62,27 @@ private slots:
 
 private:
     QHash<Thing*, MqttChannel*> m_mqttChannels;
+    // Reverse index of m_mqttChannels
+    QHash<MqttChannel*, Thing*> m_channelThings;
+
+    // MQTT publishes are routed through these tables instead of building topic strings and
+    // searching myThings() for every message. The children are collected on demand and reset
+    // whenever a child thing gets added or removed.
+    class TasmotaChildren {
+    public:
+        Things all;
+        // channel name (POWER, POWER1...) -> legacy children connected to this channel
+        QHash<QString, Things> byChannel;
+        // channel name -> power meter child
+        QHash<QString, Thing *> meters;
+    };
+    const TasmotaChildren &children(Thing *parent);
+    QHash<Thing *, TasmotaChildren> m_children;
+
+    typedef void (IntegrationPluginTasmota::*TopicHandler)(Thing *thing, const QString &channelName, const QByteArray &payload);
+    void handlePowerTopic(Thing *thing, const QString &channelName, const QByteArray &payload);
+    void handleStateTopic(Thing *thing, const QString &channelName, const QByteArray &payload);
+    void handleSensorTopic(Thing *thing, const QString &channelName, const QByteArray &payload);
 
     // Helpers for parent devices (the ones starting with sonoff)
     QHash<ThingClassId, ParamTypeId> m_ipAddressParamTypeMap;
@@ -88,12 +88,18 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
 
         tcpServer = new TcpServer(port, this);
         tcpServer->setConfirmCommands(thing->setting(tcpServerSettingsConfirmCommandParamTypeId).toBool());
+        tcpServer->setFraming(framingFromString(thing->setting(tcpServerSettingsFramingParamTypeId).toString()));
+        tcpServer->setFrameSize(thing->setting(tcpServerSettingsFrameSizeParamTypeId).toInt());
 
         if (tcpServer->isValid()) {
             m_tcpServers.insert(thing, tcpServer);
             connect(thing, &Thing::settingChanged, tcpServer, [=](const ParamTypeId &paramTypeId, const QVariant &value){
                 if (paramTypeId == tcpServerSettingsConfirmCommandParamTypeId) {
                     tcpServer->setConfirmCommands(value.toBool());
+                } else if (paramTypeId == tcpServerSettingsFramingParamTypeId) {
+                    tcpServer->setFraming(framingFromString(value.toString()));
+                } else if (paramTypeId == tcpServerSettingsFrameSizeParamTypeId) {
+                    tcpServer->setFrameSize(value.toInt());
                 }
             });
 
@@ -188,3 +194,15 @@ void IntegrationPluginTcpCommander::onTcpServerCommandReceived(const QString &cl
     params.append(Param(tcpServerTriggeredEventClientIpParamTypeId, clientIp));
     emit emitEvent(Event(tcpServerTriggeredEventTypeId, thing->id(), params));
 }
+
+TcpServer::Framing IntegrationPluginTcpCommander::framingFromString(const QString &framing)
+{
+    if (framing == "Newline") {
+        return TcpServer::FramingNewline;
+    } else if (framing == "Length prefixed") {
+        return TcpServer::FramingLengthPrefixed;
+    } else if (framing == "Fixed size") {
+        return TcpServer::FramingFixedSize;
+    }
+    return TcpServer::FramingNone;
+}
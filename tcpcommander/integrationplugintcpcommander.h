@@ -54,6 +54,8 @@ private:
     QHash<Thing*, QTcpSocket*> m_tcpSockets;
     QHash<Thing*, TcpServer*> m_tcpServers;
 
+    static TcpServer::Framing framingFromString(const QString &framing);
+
 private slots:
     void onTcpSocketConnectionChanged(bool connected);
 
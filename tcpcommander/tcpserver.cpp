@@ -31,6 +31,7 @@
 #include "tcpserver.h"
 #include "extern-plugininfo.h"
 #include <QNetworkInterface>
+#include <QtEndian>
 
 
 TcpServer::TcpServer(const QHostAddress address, const quint16 &port, QObject *parent) :
@@ -86,6 +87,44 @@ int TcpServer::serverPort()
     return m_tcpServer->serverPort();
 }
 
+TcpServer::Framing TcpServer::framing() const
+{
+    return m_framing;
+}
+
+void TcpServer::setFraming(Framing framing)
+{
+    if (m_framing == framing) {
+        return;
+    }
+    // Partial data buffered for the old framing doesn't make sense anymore
+    m_framing = framing;
+    m_buffers.clear();
+}
+
+int TcpServer::frameSize() const
+{
+    return m_frameSize;
+}
+
+void TcpServer::setFrameSize(int frameSize)
+{
+    m_frameSize = qMax(1, frameSize);
+}
+
+int TcpServer::maxQueuedBytes() const
+{
+    return m_maxQueuedBytes;
+}
+
+void TcpServer::setMaxQueuedBytes(int maxQueuedBytes)
+{
+    m_maxQueuedBytes = maxQueuedBytes;
+    foreach (QTcpSocket *client, m_clients) {
+        client->setReadBufferSize(m_maxQueuedBytes);
+    }
+}
+
 int TcpServer::connectionCount() const
 {
     return m_clients.count();
@@ -99,10 +138,16 @@ bool TcpServer::sendCommand(const QString &clientIp, const QByteArray &data)
     if (address == QHostAddress(QHostAddress::AnyIPv4) || address == QHostAddress(QHostAddress::Broadcast))
         broadcast = true;
 
+    QByteArray message = frameMessage(data);
     foreach (QTcpSocket *client, m_clients) {
         if (broadcast || client->peerAddress() == address) {
-            qint64 len = client->write(data);
-            if (len == data.length()) {
+            // Don't pile up data for clients which don't read it
+            if (client->bytesToWrite() + message.length() > m_maxQueuedBytes) {
+                qCWarning(dcTCPCommander()) << "Client" << client->peerAddress().toString() << "is not reading its data. Dropping message.";
+                continue;
+            }
+            qint64 len = client->write(message);
+            if (len == message.length()) {
                 success = true;
             }
         }
@@ -116,6 +161,8 @@ void TcpServer::newConnection()
     qDebug(dcTCPCommander()) << "TCP Server new Connection request";
     QTcpSocket *socket = m_tcpServer->nextPendingConnection();
     socket->flush();
+    // Once this is full the kernel buffers fill up and the client is throttled by TCP flow control
+    socket->setReadBufferSize(m_maxQueuedBytes);
 
     m_clients.append(socket);
     emit connectionCountChanged(m_clients.count());
@@ -130,19 +177,141 @@ void TcpServer::onDisconnected()
     QTcpSocket *client = qobject_cast<QTcpSocket*>(sender());
     qDebug(dcTCPCommander()) << "TCP client disconnected";
     m_clients.removeAll(client);
+    m_buffers.remove(client);
+    client->deleteLater();
     emit connectionCountChanged(m_clients.count());
 }
 
 void TcpServer::readData()
 {
     QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
-    QByteArray data = socket->readAll();
-    qDebug(dcTCPCommander()) << "TCP Server data received: " << data;
-    if (m_confirmCommands) {
-        socket->write("OK\n");
+    QString clientIp = socket->peerAddress().toString();
+
+    if (m_framing == FramingNone) {
+        QByteArray data = socket->readAll();
+        qDebug(dcTCPCommander()) << "TCP Server data received: " << data;
+        if (m_confirmCommands) {
+            socket->write("OK\n");
+        }
+
+        emit commandReceived(clientIp, data);
+        return;
+    }
+
+    // Read at most until the reassembly buffer is full, cut out all complete messages and
+    // continue with what's left in the socket. Data beyond that stays in the socket (and kernel) buffers.
+    QByteArray buffer = m_buffers.take(socket);
+    QList<QByteArray> messages;
+    bool error = false;
+    while (!error) {
+        qint64 space = m_maxQueuedBytes - buffer.size();
+        if (space <= 0) {
+            qCWarning(dcTCPCommander()) << "Message from" << clientIp << "exceeds" << m_maxQueuedBytes << "bytes.";
+            error = true;
+            break;
+        }
+        QByteArray data = socket->read(space);
+        if (data.isEmpty()) {
+            break;
+        }
+        buffer.append(data);
+
+        int offset = 0;
+        QByteArray message;
+        while (takeMessage(buffer, offset, message, error)) {
+            if (!message.isEmpty()) {
+                messages.append(message);
+            }
+        }
+        buffer.remove(0, offset);
+    }
+
+    if (error) {
+        qCWarning(dcTCPCommander()) << "Invalid data received from" << clientIp << "Closing connection.";
+        socket->disconnectFromHost();
+    } else if (!buffer.isEmpty()) {
+        m_buffers.insert(socket, buffer);
+    }
+
+    if (messages.isEmpty()) {
+        return;
+    }
+
+    qDebug(dcTCPCommander()) << "TCP Server received" << messages.count() << "messages from" << clientIp;
+    if (m_confirmCommands && socket->state() == QAbstractSocket::ConnectedState) {
+        socket->write(QByteArray("OK\n").repeated(messages.count()));
+    }
+
+    foreach (const QByteArray &message, messages) {
+        emit commandReceived(clientIp, message);
+    }
+}
+
+bool TcpServer::takeMessage(const QByteArray &buffer, int &offset, QByteArray &message, bool &error) const
+{
+    switch (m_framing) {
+    case FramingNewline: {
+        int end = buffer.indexOf('\n', offset);
+        if (end < 0) {
+            return false;
+        }
+        int length = end - offset;
+        if (length > 0 && buffer.at(end - 1) == '\r') {
+            length--;
+        }
+        message = buffer.mid(offset, length);
+        offset = end + 1;
+        return true;
+    }
+    case FramingLengthPrefixed: {
+        if (buffer.size() - offset < 4) {
+            return false;
+        }
+        quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData() + offset));
+        if (length > static_cast<quint32>(m_maxQueuedBytes - 4)) {
+            qCWarning(dcTCPCommander()) << "Announced message length" << length << "exceeds" << m_maxQueuedBytes << "bytes.";
+            error = true;
+            return false;
+        }
+        if (static_cast<quint32>(buffer.size() - offset - 4) < length) {
+            return false;
+        }
+        message = buffer.mid(offset + 4, length);
+        offset += 4 + length;
+        return true;
     }
+    case FramingFixedSize:
+        if (m_frameSize > m_maxQueuedBytes) {
+            error = true;
+            return false;
+        }
+        if (buffer.size() - offset < m_frameSize) {
+            return false;
+        }
+        message = buffer.mid(offset, m_frameSize);
+        offset += m_frameSize;
+        return true;
+    case FramingNone:
+        break;
+    }
+    return false;
+}
 
-    emit commandReceived(socket->peerAddress().toString(), data);
+QByteArray TcpServer::frameMessage(const QByteArray &data) const
+{
+    switch (m_framing) {
+    case FramingNewline:
+        return data.endsWith('\n') ? data : data + '\n';
+    case FramingLengthPrefixed: {
+        uchar prefix[4];
+        qToBigEndian<quint32>(data.length(), prefix);
+        return QByteArray(reinterpret_cast<const char *>(prefix), 4) + data;
+    }
+    case FramingNone:
+    case FramingFixedSize:
+        break;
+    }
+    return data;
 }
 
 void TcpServer::onError(QAbstractSocket::SocketError error)
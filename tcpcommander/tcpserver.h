@@ -34,11 +34,20 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QTcpServer>
+#include <QHash>
 
 class TcpServer : public QObject
 {
     Q_OBJECT
 public:
+    enum Framing {
+        FramingNone,            // Every read is one message
+        FramingNewline,         // Messages end with \n (a preceding \r is stripped)
+        FramingLengthPrefixed,  // Messages start with their length as 32 bit big endian
+        FramingFixedSize        // Messages have frameSize() bytes
+    };
+    Q_ENUM(Framing)
+
     explicit TcpServer(const QHostAddress address, const quint16 &port, QObject *parent = nullptr);
     explicit TcpServer(const quint16 &port, QObject *parent = nullptr);
     ~TcpServer();
@@ -52,6 +61,17 @@ public:
     bool confirmCommands() const;
     void setConfirmCommands(bool confirmCommands);
 
+    Framing framing() const;
+    void setFraming(Framing framing);
+
+    int frameSize() const;
+    void setFrameSize(int frameSize);
+
+    // Limit for buffered data per client and direction. Reading from a client pauses
+    // while its buffer is full and sending fails for clients not reading their data.
+    int maxQueuedBytes() const;
+    void setMaxQueuedBytes(int maxQueuedBytes);
+
     int connectionCount() const;
 
     bool sendCommand(const QString &clientIp, const QByteArray &data);
@@ -72,6 +92,15 @@ private:
     bool m_confirmCommands = false;
     QList<QTcpSocket*> m_clients;
 
+    Framing m_framing = FramingNone;
+    int m_frameSize = 64;
+    int m_maxQueuedBytes = 65536;
+    // Reassembly buffers for partially received messages
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+
+    bool takeMessage(const QByteArray &buffer, int &offset, QByteArray &message, bool &error) const;
+    QByteArray frameMessage(const QByteArray &data) const;
+
 };
 
 #endif // TCPSERVER_H
@@ -0,0 +1,324 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Compares the sliding window filters of the SensorTag with the former implementation, which
+// filtered the whole window again for every sample (O(window) per sample, plus the reallocation
+// of the window), against the ring buffer with incremental filter state (O(1) per sample).
+//
+// For window sizes from 20 to 1000 it prints the time per sample of both and verifies that low
+// pass, high pass and moving average produce the same values within float tolerance, also after
+// changing the window size or the alpha values, where the window is filtered again.
+//
+// Usage: benchmark [samples]
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtMath>
+
+#include "sensorfilter.h"
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    if (!condition)
+        s_failures++;
+
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+}
+
+// SensorFilter before the ring buffer, without the QObject parts
+class LegacySensorFilter
+{
+public:
+    explicit LegacySensorFilter(SensorFilter::Type filterType) : m_filterType(filterType) { }
+
+    float filterValue(float value)
+    {
+        switch (m_filterType) {
+        case SensorFilter::TypeLowPass:
+            return lowPassFilterValue(value);
+        case SensorFilter::TypeHighPass:
+            return highPassFilterValue(value);
+        case SensorFilter::TypeAverage:
+            return averageFilterValue(value);
+        }
+        return value;
+    }
+
+    void setFilterWindowSize(uint windowSize) { m_filterWindowSize = windowSize; }
+    void setLowPassAlpha(float alpha) { m_lowPassAlpha = alpha; }
+    void setHighPassAlpha(float alpha) { m_highPassAlpha = alpha; }
+
+private:
+    SensorFilter::Type m_filterType = SensorFilter::TypeLowPass;
+    uint m_filterWindowSize = 20;
+    float m_lowPassAlpha = 0.2f;
+    float m_highPassAlpha = 0.2f;
+
+    float m_averageSum = 0;
+
+    QVector<float> m_inputData;
+    QVector<float> m_outputData;
+
+    void addInputValue(float value)
+    {
+        m_inputData.append(value);
+        if (static_cast<uint>(m_inputData.size()) > m_filterWindowSize) {
+            m_inputData.removeFirst();
+        }
+    }
+
+    float lowPassFilterValue(float value)
+    {
+        addInputValue(value);
+        if (m_inputData.size() < 2) {
+            return value;
+        }
+
+        QVector<float> outputData;
+        outputData.append(m_inputData.at(0));
+        for (int i = 1; i < m_inputData.size(); i++) {
+            outputData.append(outputData.at(i - 1) + m_lowPassAlpha * (m_inputData.at(i) - outputData.at(i - 1)));
+        }
+        m_outputData = outputData;
+        return m_outputData.last();
+    }
+
+    float highPassFilterValue(float value)
+    {
+        addInputValue(value);
+        if (m_inputData.size() < 2) {
+            return value;
+        }
+
+        QVector<float> outputData;
+        outputData.append(m_inputData.at(0));
+        for (int i = 1; i < m_inputData.size(); i++) {
+            outputData.append(m_highPassAlpha * outputData.at(i - 1) + m_highPassAlpha * (m_inputData.at(i) - m_inputData.at(i - 1)));
+        }
+        m_outputData = outputData;
+        return m_outputData.last();
+    }
+
+    float averageFilterValue(float value)
+    {
+        if (m_inputData.isEmpty()) {
+            addInputValue(value);
+            m_averageSum = value;
+            return value;
+        }
+
+        if (static_cast<uint>(m_inputData.size()) >= m_filterWindowSize) {
+            m_averageSum -= m_inputData.takeFirst();
+        }
+
+        addInputValue(value);
+        m_averageSum += value;
+        return m_averageSum / m_inputData.size();
+    }
+};
+
+struct Configuration {
+    uint windowSize = 20;
+    float lowPassAlpha = 0.2f;
+    float highPassAlpha = 0.2f;
+};
+
+static const char *typeName(SensorFilter::Type type)
+{
+    switch (type) {
+    case SensorFilter::TypeLowPass:
+        return "low pass";
+    case SensorFilter::TypeHighPass:
+        return "high pass";
+    case SensorFilter::TypeAverage:
+        return "average";
+    }
+    return "";
+}
+
+// Temperature like signal: slow drift with sensor noise and a few spikes
+static QVector<float> sampleSignal(int count)
+{
+    QRandomGenerator generator(42);
+    QVector<float> values;
+    values.reserve(count);
+    for (int i = 0; i < count; i++) {
+        float value = 21.5f + 3.0f * static_cast<float>(qSin(i * 0.002)) + static_cast<float>(generator.bounded(0.25) - 0.125);
+        if (i % 997 == 0)
+            value += 4;
+        values.append(value);
+    }
+    return values;
+}
+
+static bool matches(float value, float expected)
+{
+    return qAbs(value - expected) <= 1e-3f * qMax(1.0f, qAbs(expected));
+}
+
+static LegacySensorFilter *legacyFilter(SensorFilter::Type type, const Configuration &configuration)
+{
+    LegacySensorFilter *filter = new LegacySensorFilter(type);
+    filter->setFilterWindowSize(configuration.windowSize);
+    filter->setLowPassAlpha(configuration.lowPassAlpha);
+    filter->setHighPassAlpha(configuration.highPassAlpha);
+    return filter;
+}
+
+// Feeds values to both filters and returns the number of differing results
+static int compare(SensorFilter *filter, LegacySensorFilter *legacy, const float *values, int count)
+{
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        float expected = legacy->filterValue(values[i]);
+        if (!matches(filter->filterValue(values[i]), expected))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+static void checkEquivalence(SensorFilter::Type type, const QVector<float> &values)
+{
+    foreach (uint windowSize, QList<uint>({1, 20, 100, 1000})) {
+        Configuration configuration;
+        configuration.windowSize = windowSize;
+        SensorFilter filter(type);
+        filter.setFilterWindowSize(windowSize);
+        LegacySensorFilter *legacy = legacyFilter(type, configuration);
+        int count = qMin(values.count(), static_cast<int>(windowSize) * 3 + 500);
+        int mismatches = compare(&filter, legacy, values.constData(), count);
+        delete legacy;
+        check(mismatches == 0, QString("%1, window %2: %3 samples match the former filter (%4 differ)").arg(typeName(type)).arg(windowSize).arg(count).arg(mismatches));
+    }
+
+    // Reconfiguring filters the values within the window again with the new settings, which is
+    // what the former filter computed with these settings and only the window values as history.
+    QList<QPair<QString, Configuration>> changes;
+    Configuration configuration;
+    configuration.windowSize = 40;
+    changes.append(qMakePair(QString("window 100 -> 40"), configuration));
+    configuration.windowSize = 250;
+    changes.append(qMakePair(QString("window 40 -> 250"), configuration));
+    configuration.lowPassAlpha = 0.6f;
+    changes.append(qMakePair(QString("low pass alpha 0.2 -> 0.6"), configuration));
+    configuration.highPassAlpha = 0.7f;
+    changes.append(qMakePair(QString("high pass alpha 0.2 -> 0.7"), configuration));
+
+    SensorFilter filter(type);
+    filter.setFilterWindowSize(100);
+    int position = 0;
+    filter.filterBlock(values.constData(), 600);
+    position += 600;
+
+    for (int i = 0; i < changes.count(); i++) {
+        const Configuration &target = changes.at(i).second;
+        QVector<float> window = filter.inputData();
+        filter.setFilterWindowSize(target.windowSize);
+        filter.setLowPassAlpha(target.lowPassAlpha);
+        filter.setHighPassAlpha(target.highPassAlpha);
+
+        LegacySensorFilter *legacy = legacyFilter(type, target);
+        float expected = 0;
+        foreach (float value, window) {
+            expected = legacy->filterValue(value);
+        }
+        bool replayed = !filter.outputData().isEmpty() && matches(filter.outputData().last(), expected);
+
+        int count = static_cast<int>(target.windowSize) * 2 + 100;
+        int mismatches = compare(&filter, legacy, values.constData() + position, count);
+        position += count;
+        delete legacy;
+        check(replayed && mismatches == 0, QString("%1, %2: window filtered again and %3 following samples match (%4 differ)")
+              .arg(typeName(type)).arg(changes.at(i).first).arg(count).arg(mismatches));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    int sampleCount = qMax(5000, application.arguments().value(1, "20000").toInt());
+
+    QVector<float> values = sampleSignal(sampleCount);
+    QList<SensorFilter::Type> types = {SensorFilter::TypeLowPass, SensorFilter::TypeHighPass, SensorFilter::TypeAverage};
+
+    foreach (SensorFilter::Type type, types) {
+        checkEquivalence(type, values);
+    }
+
+    qInfo().noquote() << QString("%1 samples per run, ns/sample").arg(sampleCount);
+    qInfo().noquote() << "filter     window     former   filterValue filterBlock";
+    foreach (SensorFilter::Type type, types) {
+        foreach (uint windowSize, QList<uint>({20, 50, 100, 200, 500, 1000})) {
+            Configuration configuration;
+            configuration.windowSize = windowSize;
+            LegacySensorFilter *legacy = legacyFilter(type, configuration);
+            SensorFilter filter(type);
+            filter.setFilterWindowSize(windowSize);
+            SensorFilter blockFilter(type);
+            blockFilter.setFilterWindowSize(windowSize);
+
+            // The checksums keep the compiler from dropping the loops
+            double legacySum = 0;
+            double sum = 0;
+
+            QElapsedTimer timer;
+            timer.start();
+            foreach (float value, values) {
+                legacySum += legacy->filterValue(value);
+            }
+            qint64 legacyTime = timer.nsecsElapsed();
+
+            timer.restart();
+            foreach (float value, values) {
+                sum += filter.filterValue(value);
+            }
+            qint64 time = timer.nsecsElapsed();
+
+            timer.restart();
+            sum += blockFilter.filterBlock(values.constData(), static_cast<size_t>(values.count()));
+            qint64 blockTime = timer.nsecsElapsed();
+            delete legacy;
+
+            qInfo().noquote() << QString("%1 %2 %3 %4 %5").arg(typeName(type), -9).arg(windowSize, 7)
+                                 .arg(static_cast<double>(legacyTime) / sampleCount, 10, 'f', 1)
+                                 .arg(static_cast<double>(time) / sampleCount, 13, 'f', 1)
+                                 .arg(static_cast<double>(blockTime) / sampleCount, 11, 'f', 1);
+            if (qIsNaN(legacySum + sum))
+                qInfo() << "NaN in filter output";
+        }
+    }
+
+    return s_failures > 0 ? 1 : 0;
+}
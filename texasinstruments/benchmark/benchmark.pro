@@ -0,0 +1,13 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT -= gui
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    benchmark.cpp \
+    ../sensorfilter.cpp \
+
+HEADERS += \
+    ../sensorfilter.h \
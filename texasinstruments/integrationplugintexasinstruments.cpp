@@ -36,6 +36,7 @@
 #include "plugintimer.h"
 
 #include <QBluetoothDeviceInfo>
+#include <QTimer>
 
 IntegrationPluginTexasInstruments::IntegrationPluginTexasInstruments(QObject *parent) : IntegrationPlugin(parent)
 {
@@ -107,6 +108,12 @@ void IntegrationPluginTexasInstruments::setupThing(ThingSetupInfo *info)
     SensorTag *sensorTag = new SensorTag(thing, bluetoothDevice, this);
     m_sensorTags.insert(thing, sensorTag);
 
+    connect(thing, &Thing::settingChanged, sensorTag, [sensorTag](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == sensorTagSettingsRecordSensorDataParamTypeId) {
+            sensorTag->setSensorDataRecordingEnabled(value.toBool());
+        }
+    });
+
     if (!m_reconnectTimer) {
         m_reconnectTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
         connect(m_reconnectTimer, &PluginTimer::timeout, this, [this](){
@@ -136,6 +143,7 @@ void IntegrationPluginTexasInstruments::postSetupThing(Thing *thing)
     sensorTag->setMagnetometerEnabled(thing->stateValue(sensorTagMagnetometerEnabledStateTypeId).toBool());
     sensorTag->setMeasurementPeriod(thing->stateValue(sensorTagMeasurementPeriodStateTypeId).toInt());
     sensorTag->setMeasurementPeriodMovement(thing->stateValue(sensorTagMeasurementPeriodMovementStateTypeId).toInt());
+    sensorTag->setSensorDataRecordingEnabled(thing->setting(sensorTagSettingsRecordSensorDataParamTypeId).toBool());
 
     // Connect to the sensor
     sensorTag->bluetoothDevice()->connectDevice();
@@ -148,9 +156,19 @@ void IntegrationPluginTexasInstruments::thingRemoved(Thing *thing)
     }
 
     SensorTag *sensorTag = m_sensorTags.take(thing);
+    // Stop recording right away, this flushes the pending records before the files get removed
+    sensorTag->setSensorDataRecordingEnabled(false);
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(sensorTag->bluetoothDevice());
     sensorTag->deleteLater();
 
+    // This is also called when the thing gets reconfigured, keep the recordings unless the thing is gone for good
+    ThingId thingId = thing->id();
+    QTimer::singleShot(0, this, [this, thingId](){
+        if (!myThings().findById(thingId)) {
+            SensorDataRecorder::removeFiles(SensorDataProcessor::recordFileName(thingId));
+        }
+    });
+
     if (myThings().isEmpty()) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_reconnectTimer);
         m_reconnectTimer = nullptr;
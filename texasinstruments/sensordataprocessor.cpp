@@ -30,12 +30,13 @@
 
 #include "sensordataprocessor.h"
 #include "extern-plugininfo.h"
+#include "nymeasettings.h"
 #include "math.h"
 
+#include <QDir>
 #include <QVector3D>
 #include <QByteArray>
 #include <QDataStream>
-#include <QDateTime>
 
 SensorDataProcessor::SensorDataProcessor(Thing *thing, QObject *parent) :
     QObject(parent),
@@ -65,23 +66,11 @@ SensorDataProcessor::SensorDataProcessor(Thing *thing, QObject *parent) :
     m_accelerometerFilter = new SensorFilter(SensorFilter::TypeLowPass, this);
     m_accelerometerFilter->setLowPassAlpha(0.6);
     m_accelerometerFilter->setFilterWindowSize(40);
-
-    // Check if the data should be logged
-    if (m_filterDebug) {
-        m_logFile = new QFile("/tmp/multisensor.log", this);
-        if (!m_logFile->open(QIODevice::Append | QIODevice::Text)) {
-            qCWarning(dcTexasInstruments()) << "Could not open log file" << m_logFile->fileName();
-            delete m_logFile;
-            m_logFile = nullptr;
-        }
-    }
 }
 
 SensorDataProcessor::~SensorDataProcessor()
 {
-    if (m_logFile) {
-        m_logFile->close();
-    }
+
 }
 
 void SensorDataProcessor::setAccelerometerRange(int accelerometerRange)
@@ -109,6 +98,9 @@ void SensorDataProcessor::processTemperatureData(const QByteArray &data)
 {
     Q_ASSERT(data.count() == 4);
 
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypeTemperature, data);
+
     quint16 rawObjectTemperature = 0;
     quint16 rawAmbientTemperature = 0;
 
@@ -129,12 +121,12 @@ void SensorDataProcessor::processTemperatureData(const QByteArray &data)
     float ambientTemperatureFiltered = m_temperatureFilter->filterValue(ambientTemperature);
 
     if (m_objectTemperatureFilter->isReady()) {
-        m_thing->setStateValue(sensorTagObjectTemperatureStateTypeId, roundValue(objectTemperatureFiltered));
+        setStateValue(sensorTagObjectTemperatureStateTypeId, roundValue(objectTemperatureFiltered));
     }
 
     // Note: only change the state once the filter has collected enough data
     if (m_temperatureFilter->isReady()) {
-        m_thing->setStateValue(sensorTagTemperatureStateTypeId, roundValue(ambientTemperatureFiltered));
+        setStateValue(sensorTagTemperatureStateTypeId, roundValue(ambientTemperatureFiltered));
     }
 
 }
@@ -142,6 +134,10 @@ void SensorDataProcessor::processTemperatureData(const QByteArray &data)
 void SensorDataProcessor::processKeyData(const QByteArray &data)
 {
     Q_ASSERT(data.count() == 1);
+
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypeKey, data);
+
     quint8 flags = static_cast<quint8>(data.at(0));
     setLeftButtonPressed(testBitUint8(flags, 0));
     setRightButtonPressed(testBitUint8(flags, 1));
@@ -151,6 +147,10 @@ void SensorDataProcessor::processKeyData(const QByteArray &data)
 void SensorDataProcessor::processHumidityData(const QByteArray &data)
 {
     Q_ASSERT(data.count() == 4);
+
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypeHumidity, data);
+
     quint16 rawHumidityTemperature = 0;
     quint16 rawHumidity = 0;
 
@@ -165,7 +165,7 @@ void SensorDataProcessor::processHumidityData(const QByteArray &data)
     double humidityFiltered = m_humidityFilter->filterValue(humidity);
 
     if (m_humidityFilter->isReady()) {
-        m_thing->setStateValue(sensorTagHumidityStateTypeId, roundValue(humidityFiltered));
+        setStateValue(sensorTagHumidityStateTypeId, roundValue(humidityFiltered));
     }
 }
 
@@ -173,6 +173,9 @@ void SensorDataProcessor::processPressureData(const QByteArray &data)
 {
     Q_ASSERT(data.count() == 6);
 
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypePressure, data);
+
     QByteArray temperatureData(data.left(3));
     quint32 rawTemperature = static_cast<quint8>(temperatureData.at(2));
     rawTemperature <<= 8;
@@ -193,7 +196,7 @@ void SensorDataProcessor::processPressureData(const QByteArray &data)
 
     double pressureFiltered = m_pressureFilter->filterValue(rawPressure / 100.0);
     if (m_pressureFilter->isReady()) {
-        m_thing->setStateValue(sensorTagPressureStateTypeId, roundValue(pressureFiltered));
+        setStateValue(sensorTagPressureStateTypeId, roundValue(pressureFiltered));
     }
 }
 
@@ -201,6 +204,9 @@ void SensorDataProcessor::processOpticalData(const QByteArray &data)
 {
     Q_ASSERT(data.count() == 2);
 
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypeOptical, data);
+
     quint16 rawOptical = 0;
     QByteArray payload(data);
     QDataStream stream(&payload, QIODevice::ReadOnly);
@@ -216,14 +222,15 @@ void SensorDataProcessor::processOpticalData(const QByteArray &data)
 
     double luxFiltered = m_opticalFilter->filterValue(lux);
     if (m_opticalFilter->isReady()) {
-        m_thing->setStateValue(sensorTagLightIntensityStateTypeId, qRound(luxFiltered));
+        setStateValue(sensorTagLightIntensityStateTypeId, qRound(luxFiltered));
     }
-
-    logSensorValue(lux, qRound(luxFiltered));
 }
 
 void SensorDataProcessor::processMovementData(const QByteArray &data)
 {
+    if (m_recorder)
+        m_recorder->record(SensorDataRecorder::SensorTypeMovement, data);
+
     //qCDebug(dcTexasInstruments()) << "--> Movement value" << data.toHex();
 
     QByteArray payload(data);
@@ -277,7 +284,7 @@ void SensorDataProcessor::processMovementData(const QByteArray &data)
 
     double delta = qAbs(qAbs(m_lastAccelerometerVectorLenght) - qAbs(filteredVectorLength));
     bool motionDetected = (delta >= m_movementSensitivity);
-    m_thing->setStateValue(sensorTagMovingStateTypeId, motionDetected);
+    setStateValue(sensorTagMovingStateTypeId, motionDetected);
     m_lastAccelerometerVectorLenght = filteredVectorLength;
 }
 
@@ -294,6 +301,72 @@ void SensorDataProcessor::reset()
     m_accelerometerFilter->reset();
 }
 
+bool SensorDataProcessor::recordingEnabled() const
+{
+    return m_recorder != nullptr;
+}
+
+void SensorDataProcessor::setRecordingEnabled(bool enabled)
+{
+    if (!m_thing || recordingEnabled() == enabled)
+        return;
+
+    if (!enabled) {
+        qCDebug(dcTexasInstruments()) << "Stop recording sensor data of" << m_thing->name();
+        delete m_recorder;
+        m_recorder = nullptr;
+        return;
+    }
+
+    QDir().mkpath(NymeaSettings::cachePath());
+    m_recorder = new SensorDataRecorder(recordFileName(m_thing->id()), 1024 * 1024, 3, this);
+}
+
+void SensorDataProcessor::replayRecords(const QList<SensorDataRecorder::Record> &records)
+{
+    // Replayed values must not end up in the states of a live thing
+    if (m_thing) {
+        qCWarning(dcTexasInstruments()) << "Not replaying sensor data into the states of" << m_thing->name();
+        return;
+    }
+
+    foreach (const SensorDataRecorder::Record &record, records) {
+        switch (record.sensorType) {
+        case SensorDataRecorder::SensorTypeTemperature:
+            processTemperatureData(record.data);
+            break;
+        case SensorDataRecorder::SensorTypeHumidity:
+            processHumidityData(record.data);
+            break;
+        case SensorDataRecorder::SensorTypePressure:
+            processPressureData(record.data);
+            break;
+        case SensorDataRecorder::SensorTypeOptical:
+            processOpticalData(record.data);
+            break;
+        case SensorDataRecorder::SensorTypeKey:
+            processKeyData(record.data);
+            break;
+        case SensorDataRecorder::SensorTypeMovement:
+            processMovementData(record.data);
+            break;
+        }
+    }
+}
+
+QString SensorDataProcessor::recordFileName(const ThingId &thingId)
+{
+    return NymeaSettings::cachePath() + "/sensortag-" + thingId.toString().remove(QRegExp("[{}]")) + ".rec";
+}
+
+void SensorDataProcessor::setStateValue(const StateTypeId &stateTypeId, const QVariant &value)
+{
+    if (m_thing)
+        m_thing->setStateValue(stateTypeId, value);
+
+    emit stateValueChanged(stateTypeId, value);
+}
+
 void SensorDataProcessor::setLeftButtonPressed(bool pressed)
 {
     if (m_leftButtonPressed == pressed)
@@ -301,7 +374,7 @@ void SensorDataProcessor::setLeftButtonPressed(bool pressed)
 
     qCDebug(dcTexasInstruments()) << "Left button" << (pressed ? "pressed" : "released");
     m_leftButtonPressed = pressed;
-    m_thing->setStateValue(sensorTagLeftButtonPressedStateTypeId, m_leftButtonPressed);
+    setStateValue(sensorTagLeftButtonPressedStateTypeId, m_leftButtonPressed);
 }
 
 void SensorDataProcessor::setRightButtonPressed(bool pressed)
@@ -311,7 +384,7 @@ void SensorDataProcessor::setRightButtonPressed(bool pressed)
 
     qCDebug(dcTexasInstruments()) << "Right button" << (pressed ? "pressed" : "released");
     m_rightButtonPressed = pressed;
-    m_thing->setStateValue(sensorTagRightButtonPressedStateTypeId, m_rightButtonPressed);
+    setStateValue(sensorTagRightButtonPressedStateTypeId, m_rightButtonPressed);
 }
 
 void SensorDataProcessor::setMagnetDetected(bool detected)
@@ -321,17 +394,5 @@ void SensorDataProcessor::setMagnetDetected(bool detected)
 
     qCDebug(dcTexasInstruments()) << "Magnet detector" << (detected ? "active" : "inactive");
     m_magnetDetected = detected;
-    m_thing->setStateValue(sensorTagMagnetDetectedStateTypeId, m_magnetDetected);
-}
-
-void SensorDataProcessor::logSensorValue(double originalValue, double filteredValue)
-{
-    if (!m_filterDebug || !m_logFile)
-        return;
-
-    QString logLine = QString("%1 %2 %3\n").arg(QDateTime::currentDateTime().toTime_t()).arg(originalValue).arg(filteredValue);
-
-    QTextStream logStream(m_logFile);
-    logStream.setCodec("UTF-8");
-    logStream << logLine;
+    setStateValue(sensorTagMagnetDetectedStateTypeId, m_magnetDetected);
 }
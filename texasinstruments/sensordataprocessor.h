@@ -31,18 +31,19 @@
 #ifndef SENSORDATAPROCESSOR_H
 #define SENSORDATAPROCESSOR_H
 
-#include <QFile>
 #include <QObject>
 
 #include "integrations/thing.h"
 #include "extern-plugininfo.h"
 
 #include "sensorfilter.h"
+#include "sensordatarecorder.h"
 
 class SensorDataProcessor : public QObject
 {
     Q_OBJECT
 public:
+    // Without a thing the processed values are only emitted, e.g. for replaying recorded data
     explicit SensorDataProcessor(Thing *thing, QObject *parent = nullptr);
     ~SensorDataProcessor();
 
@@ -61,6 +62,15 @@ public:
 
     void reset();
 
+    // Record the raw sensor data for offline filter tuning
+    bool recordingEnabled() const;
+    void setRecordingEnabled(bool enabled);
+    static QString recordFileName(const ThingId &thingId);
+
+    // Feeds records read with SensorDataRecorder::readRecords() through the filters of a processor
+    // without thing, e.g. for offline filter tuning. The results are emitted with stateValueChanged().
+    void replayRecords(const QList<SensorDataRecorder::Record> &records);
+
 private:
     Thing *m_thing = nullptr;
     double m_lastAccelerometerVectorLenght = -99999;
@@ -72,10 +82,7 @@ private:
     bool m_rightButtonPressed = false;
     bool m_magnetDetected = false;
 
-    // Log sensor data for debugging filters
-    // Note: set this to true for enable sensor filter logging
-    bool m_filterDebug = true;
-    QFile *m_logFile = nullptr;
+    SensorDataRecorder *m_recorder = nullptr;
 
     SensorFilter *m_temperatureFilter = nullptr;
     SensorFilter *m_objectTemperatureFilter = nullptr;
@@ -85,14 +92,14 @@ private:
     SensorFilter *m_accelerometerFilter = nullptr;
 
     // Set methods
+    void setStateValue(const StateTypeId &stateTypeId, const QVariant &value);
     void setLeftButtonPressed(bool pressed);
     void setRightButtonPressed(bool pressed);
     void setMagnetDetected(bool detected);
 
-    void logSensorValue(double originalValue, double filteredValue);
-
 
 signals:
+    void stateValueChanged(const StateTypeId &stateTypeId, const QVariant &value);
 
 private slots:
 
@@ -0,0 +1,209 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sensordatarecorder.h"
+#include "extern-plugininfo.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <QDateTime>
+
+static const QByteArray fileMagic("STR1");
+static const int recordHeaderSize = 10;
+
+// Flush once this amount of data is buffered, and drop records beyond the buffer limit
+static const int flushThreshold = 4096;
+static const int maxBufferSize = 64 * 1024;
+static const int flushInterval = 5000;
+
+SensorDataRecorder::SensorDataRecorder(const QString &fileName, qint64 maxFileSize, int maxFiles, QObject *parent) :
+    QObject(parent),
+    m_fileName(fileName)
+{
+    m_writer = new SensorDataRecordWriter(fileName, maxFileSize, maxFiles);
+    m_writer->moveToThread(&m_writerThread);
+    connect(&m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+    connect(m_writer, &SensorDataRecordWriter::recordsWritten, this, [this](int size){
+        m_pendingBytes -= size;
+    });
+    m_writerThread.start(QThread::LowPriority);
+
+    m_flushTimer.setInterval(flushInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &SensorDataRecorder::flush);
+    m_flushTimer.start();
+
+    qCDebug(dcTexasInstruments()) << "Recording sensor data to" << m_fileName;
+}
+
+SensorDataRecorder::~SensorDataRecorder()
+{
+    flush();
+    m_writerThread.quit();
+    m_writerThread.wait();
+}
+
+QString SensorDataRecorder::fileName() const
+{
+    return m_fileName;
+}
+
+void SensorDataRecorder::record(SensorType sensorType, const QByteArray &data)
+{
+    if (data.size() > 255) {
+        qCWarning(dcTexasInstruments()) << "Sensor data payload too large for recording:" << data.size() << "bytes";
+        return;
+    }
+
+    int size = recordHeaderSize + data.size();
+    if (m_buffer.size() + m_pendingBytes + size > maxBufferSize) {
+        // The writer can not keep up. Never block the caller for recording.
+        if (m_droppedRecords++ == 0) {
+            qCWarning(dcTexasInstruments()) << "Recording buffer full. Dropping sensor data records for" << m_fileName;
+        }
+        return;
+    }
+
+    if (m_droppedRecords > 0) {
+        qCDebug(dcTexasInstruments()) << "Dropped" << m_droppedRecords << "sensor data records for" << m_fileName;
+        m_droppedRecords = 0;
+    }
+
+    char header[recordHeaderSize];
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header);
+    header[8] = static_cast<char>(sensorType);
+    header[9] = static_cast<char>(data.size());
+    m_buffer.append(header, recordHeaderSize);
+    m_buffer.append(data);
+
+    if (m_buffer.size() >= flushThreshold) {
+        flush();
+    }
+}
+
+void SensorDataRecorder::flush()
+{
+    if (m_buffer.isEmpty())
+        return;
+
+    m_pendingBytes += m_buffer.size();
+    QMetaObject::invokeMethod(m_writer, "writeRecords", Qt::QueuedConnection, Q_ARG(QByteArray, m_buffer));
+    m_buffer.clear();
+}
+
+QList<SensorDataRecorder::Record> SensorDataRecorder::readRecords(const QString &fileName)
+{
+    QList<Record> records;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(dcTexasInstruments()) << "Could not open sensor data recording" << fileName << file.errorString();
+        return records;
+    }
+
+    QByteArray data = file.readAll();
+    if (!data.startsWith(fileMagic)) {
+        qCWarning(dcTexasInstruments()) << "File" << fileName << "is not a sensor data recording";
+        return records;
+    }
+
+    int offset = fileMagic.size();
+    while (offset + recordHeaderSize <= data.size()) {
+        int length = static_cast<quint8>(data.at(offset + 9));
+        if (offset + recordHeaderSize + length > data.size())
+            break;
+
+        Record record;
+        record.timestamp = qFromLittleEndian<qint64>(data.constData() + offset);
+        record.sensorType = static_cast<SensorType>(data.at(offset + 8));
+        record.data = data.mid(offset + recordHeaderSize, length);
+        records.append(record);
+        offset += recordHeaderSize + length;
+    }
+
+    if (offset != data.size()) {
+        qCWarning(dcTexasInstruments()) << "Sensor data recording" << fileName << "ends with an incomplete record";
+    }
+
+    return records;
+}
+
+void SensorDataRecorder::removeFiles(const QString &fileName, int maxFiles)
+{
+    QFile::remove(fileName);
+    for (int i = 1; i < maxFiles; i++) {
+        QFile::remove(QString("%1.%2").arg(fileName).arg(i));
+    }
+}
+
+SensorDataRecordWriter::SensorDataRecordWriter(const QString &fileName, qint64 maxFileSize, int maxFiles) :
+    m_fileName(fileName),
+    m_maxFileSize(maxFileSize),
+    m_maxFiles(maxFiles)
+{
+
+}
+
+void SensorDataRecordWriter::writeRecords(const QByteArray &records)
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::Append)) {
+        qCWarning(dcTexasInstruments()) << "Could not open sensor data recording" << m_fileName << file.errorString();
+        emit recordsWritten(records.size());
+        return;
+    }
+
+    if (file.size() == 0) {
+        file.write(fileMagic);
+    }
+    file.write(records);
+    qint64 fileSize = file.size();
+    file.close();
+
+    if (fileSize >= m_maxFileSize) {
+        rotate();
+    }
+
+    emit recordsWritten(records.size());
+}
+
+void SensorDataRecordWriter::rotate()
+{
+    // file -> file.1 -> ... -> file.<maxFiles - 1>, the oldest one gets removed
+    QFile::remove(QString("%1.%2").arg(m_fileName).arg(m_maxFiles - 1));
+    for (int i = m_maxFiles - 2; i >= 1; i--) {
+        QFile::rename(QString("%1.%2").arg(m_fileName).arg(i), QString("%1.%2").arg(m_fileName).arg(i + 1));
+    }
+
+    if (m_maxFiles > 1) {
+        QFile::rename(m_fileName, m_fileName + ".1");
+    } else {
+        QFile::remove(m_fileName);
+    }
+}
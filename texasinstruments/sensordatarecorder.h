@@ -0,0 +1,110 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SENSORDATARECORDER_H
+#define SENSORDATARECORDER_H
+
+#include <QTimer>
+#include <QObject>
+#include <QThread>
+
+// Records raw sensor payloads for offline filter tuning. Records are collected in a bounded
+// buffer and written by a worker thread into a rotating set of files:
+//   file header: "STR1"
+//   record:      qint64 timestamp [ms], quint8 sensor type, quint8 length, payload (little endian)
+
+class SensorDataRecordWriter;
+
+class SensorDataRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    enum SensorType {
+        SensorTypeTemperature = 0,
+        SensorTypeHumidity = 1,
+        SensorTypePressure = 2,
+        SensorTypeOptical = 3,
+        SensorTypeKey = 4,
+        SensorTypeMovement = 5
+    };
+    Q_ENUM(SensorType)
+
+    struct Record {
+        qint64 timestamp = 0;
+        SensorType sensorType = SensorTypeTemperature;
+        QByteArray data;
+    };
+
+    explicit SensorDataRecorder(const QString &fileName, qint64 maxFileSize = 1024 * 1024, int maxFiles = 3, QObject *parent = nullptr);
+    ~SensorDataRecorder() override;
+
+    QString fileName() const;
+
+    void record(SensorType sensorType, const QByteArray &data);
+    void flush();
+
+    // Reads all records from the given file for offline analysis
+    static QList<Record> readRecords(const QString &fileName);
+
+    // Removes the given file and all its rotated copies
+    static void removeFiles(const QString &fileName, int maxFiles = 3);
+
+private:
+    QString m_fileName;
+    QThread m_writerThread;
+    SensorDataRecordWriter *m_writer = nullptr;
+    QTimer m_flushTimer;
+
+    QByteArray m_buffer;
+    int m_pendingBytes = 0;
+    int m_droppedRecords = 0;
+};
+
+class SensorDataRecordWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SensorDataRecordWriter(const QString &fileName, qint64 maxFileSize, int maxFiles);
+
+public slots:
+    void writeRecords(const QByteArray &records);
+
+signals:
+    void recordsWritten(int size);
+
+private:
+    QString m_fileName;
+    qint64 m_maxFileSize = 0;
+    int m_maxFiles = 0;
+
+    void rotate();
+};
+
+#endif // SENSORDATARECORDER_H
@@ -30,13 +30,15 @@
 
 #include "sensorfilter.h"
 
-#include <QDebug>
+#include <QtMath>
 
 SensorFilter::SensorFilter(Type filterType, QObject *parent) :
     QObject(parent),
     m_filterType(filterType)
 {
-
+    m_inputData.resize(static_cast<int>(m_filterWindowSize));
+    m_outputData.resize(static_cast<int>(m_filterWindowSize));
+    reset();
 }
 
 float SensorFilter::filterValue(float value)
@@ -59,16 +61,54 @@ float SensorFilter::filterValue(float value)
     return resultValue;
 }
 
+float SensorFilter::filterBlock(const float *values, size_t count)
+{
+    float resultValue = m_count > 0 ? m_outputData.at((m_head + m_count - 1) % m_outputData.size()) : 0;
+    switch (m_filterType) {
+    case TypeLowPass:
+        for (size_t i = 0; i < count; i++)
+            resultValue = lowPassFilterValue(values[i]);
+        break;
+    case TypeHighPass:
+        for (size_t i = 0; i < count; i++)
+            resultValue = highPassFilterValue(values[i]);
+        break;
+    case TypeAverage:
+        for (size_t i = 0; i < count; i++)
+            resultValue = averageFilterValue(values[i]);
+        break;
+    default:
+        break;
+    }
+
+    return resultValue;
+}
+
 bool SensorFilter::isReady() const
 {
     // Note: filter is ready once 10% of window filled
-    return m_inputData.size() >= m_filterWindowSize * 0.1;
+    return m_count >= m_filterWindowSize * 0.1;
 }
 
 void SensorFilter::reset()
 {
-    m_averageSum = 0;
-    m_inputData.clear();
+    m_head = 0;
+    m_count = 0;
+    m_sum = 0;
+    m_firstWeight = 1;
+
+    // Weight of the value leaving a full window
+    switch (m_filterType) {
+    case TypeLowPass:
+        m_windowDecay = qPow(1.0 - m_lowPassAlpha, m_filterWindowSize);
+        break;
+    case TypeHighPass:
+        m_windowDecay = qPow(m_highPassAlpha, m_filterWindowSize);
+        break;
+    default:
+        m_windowDecay = 0;
+        break;
+    }
 }
 
 SensorFilter::Type SensorFilter::filterType() const
@@ -78,12 +118,22 @@ SensorFilter::Type SensorFilter::filterType() const
 
 QVector<float> SensorFilter::inputData() const
 {
-    return m_inputData;
+    QVector<float> values;
+    values.reserve(m_count);
+    for (int i = 0; i < m_count; i++) {
+        values.append(m_inputData.at((m_head + i) % m_inputData.size()));
+    }
+    return values;
 }
 
 QVector<float> SensorFilter::outputData() const
 {
-    return m_outputData;
+    QVector<float> values;
+    values.reserve(m_count);
+    for (int i = 0; i < m_count; i++) {
+        values.append(m_outputData.at((m_head + i) % m_outputData.size()));
+    }
+    return values;
 }
 
 uint SensorFilter::windowSize() const
@@ -94,7 +144,11 @@ uint SensorFilter::windowSize() const
 void SensorFilter::setFilterWindowSize(uint windowSize)
 {
     Q_ASSERT_X(windowSize > 0, "value out of range", "The filter window size must be bigger than 0");
+    QVector<float> values = inputData();
     m_filterWindowSize = windowSize;
+    m_inputData = QVector<float>(static_cast<int>(windowSize));
+    m_outputData = QVector<float>(static_cast<int>(windowSize));
+    replay(values);
 }
 
 float SensorFilter::lowPassAlpha() const
@@ -106,6 +160,7 @@ void SensorFilter::setLowPassAlpha(float alpha)
 {
     Q_ASSERT_X(alpha > 0 && alpha <= 1, "value out of range", "The alpha low pass filter value must be [ 0 < alpha <= 1 ]");
     m_lowPassAlpha = alpha;
+    replay(inputData());
 }
 
 float SensorFilter::highPassAlpha() const
@@ -117,70 +172,110 @@ void SensorFilter::setHighPassAlpha(float alpha)
 {
     Q_ASSERT_X(alpha > 0 && alpha <= 1, "value out of range", "The alpha high pass filter value must be [ 0 < alpha <= 1 ]");
     m_highPassAlpha = alpha;
+    replay(inputData());
 }
 
-void SensorFilter::addInputValue(float value)
+float SensorFilter::firstValue() const
 {
-    m_inputData.append(value);
-    if (static_cast<uint>(m_inputData.size()) > m_filterWindowSize) {
-        m_inputData.removeFirst();
-    }
+    return m_inputData.at(m_head);
 }
 
-float SensorFilter::lowPassFilterValue(float value)
+float SensorFilter::lastValue() const
 {
-    addInputValue(value);
+    return m_inputData.at((m_head + m_count - 1) % m_inputData.size());
+}
 
-    // Check if we have enough data for filtering
-    if (m_inputData.size() < 2) {
-        return value;
+float SensorFilter::addInputValue(float value)
+{
+    // Returns the value which dropped out of the window, if the window was full
+    int capacity = m_inputData.size();
+    if (m_count < capacity) {
+        m_inputData[(m_head + m_count) % capacity] = value;
+        m_count++;
+        return 0;
     }
 
-    QVector<float> outputData;
-    outputData.append(m_inputData.at(0));
-    for (int i = 1; i < m_inputData.size(); i++) {
-        // y[i] := y[i-1] + α * (x[i] - y[i-1])
-        outputData.append(outputData.at(i - 1) + m_lowPassAlpha * (m_inputData.at(i) - outputData.at(i - 1)));
-    }
+    float droppedValue = m_inputData.at(m_head);
+    m_inputData[m_head] = value;
+    m_head = (m_head + 1) % capacity;
+    return droppedValue;
+}
 
-    m_outputData = outputData;
+void SensorFilter::storeOutputValue(float value)
+{
+    m_outputData[(m_head + m_count - 1) % m_outputData.size()] = value;
+}
 
-    return m_outputData.last();
+void SensorFilter::replay(const QVector<float> &values)
+{
+    // Rebuild the filter state from the given values after a configuration change
+    reset();
+    int offset = qMax(0, values.count() - static_cast<int>(m_filterWindowSize));
+    filterBlock(values.constData() + offset, static_cast<size_t>(values.count() - offset));
 }
 
-float SensorFilter::highPassFilterValue(float value)
+float SensorFilter::lowPassFilterValue(float value)
 {
-    addInputValue(value);
+    // The window is filtered starting at its first value:
+    //   y[0] := x[0], y[i] := y[i-1] + α * (x[i] - y[i-1])
+    // which expands to y[n-1] = β^n * x[0] + α * Σ β^(n-1-i) * x[i] with β = 1 - α.
+    // m_sum holds the weighted sum, m_firstWeight holds β^n.
+    double beta = 1.0 - m_lowPassAlpha;
+    bool windowFull = m_count == m_inputData.size();
+    float droppedValue = addInputValue(value);
+
+    m_sum = beta * m_sum + value;
+    if (windowFull) {
+        m_sum -= m_windowDecay * droppedValue;
+    } else {
+        m_firstWeight *= beta;
+    }
+
+    float resultValue = static_cast<float>(m_lowPassAlpha * m_sum + m_firstWeight * firstValue());
+    storeOutputValue(resultValue);
+    return resultValue;
+}
 
-    // Check if we have enough data for filtering
-    if (m_inputData.size() < 2) {
+float SensorFilter::highPassFilterValue(float value)
+{
+    // The window is filtered starting at its first value:
+    //   y[0] := x[0], y[i] := α * y[i-1] + α * (x[i] - x[i-1])
+    // which expands to y[n-1] = α^(n-1) * x[0] + Σ α^(n-i) * (x[i] - x[i-1]).
+    // m_sum holds the weighted sum of differences, m_firstWeight holds α^(n-1).
+    if (m_count == 0) {
+        addInputValue(value);
+        storeOutputValue(value);
         return value;
     }
 
-    QVector<float> outputData;
-    outputData.append(m_inputData.at(0));
-    for (int i = 1; i < m_inputData.size(); i++) {
-        // y[i] := α * y[i-1] + α * (x[i] - x[i-1])
-        outputData.append(m_highPassAlpha * outputData.at(i - 1) + m_highPassAlpha * (m_inputData.at(i) - m_inputData.at(i - 1)));
+    double alpha = m_highPassAlpha;
+    float previousValue = lastValue();
+    bool windowFull = m_count == m_inputData.size();
+    float droppedValue = addInputValue(value);
+
+    m_sum = alpha * (m_sum + value - previousValue);
+    if (windowFull) {
+        m_sum -= m_windowDecay * (firstValue() - droppedValue);
+    } else {
+        m_firstWeight *= alpha;
     }
 
-    m_outputData = outputData;
-    return m_outputData.last();
+    float resultValue = static_cast<float>(m_firstWeight * firstValue() + m_sum);
+    storeOutputValue(resultValue);
+    return resultValue;
 }
 
 float SensorFilter::averageFilterValue(float value)
 {
-    if (m_inputData.isEmpty()) {
-        addInputValue(value);
-        m_averageSum = value;
-        return value;
-    }
+    bool windowFull = m_count == m_inputData.size();
+    float droppedValue = addInputValue(value);
 
-    if (static_cast<uint>(m_inputData.size()) >= m_filterWindowSize) {
-        m_averageSum -= m_inputData.takeFirst();
+    m_sum += value;
+    if (windowFull) {
+        m_sum -= droppedValue;
     }
 
-    addInputValue(value);
-    m_averageSum += value;
-    return m_averageSum / m_inputData.size();
+    float resultValue = static_cast<float>(m_sum / m_count);
+    storeOutputValue(resultValue);
+    return resultValue;
 }
@@ -34,6 +34,10 @@
 #include <QObject>
 #include <QVector>
 
+// Filters a stream of sensor values over a sliding window. The window is kept in a
+// ring buffer and all filters are updated incrementally, so each sample costs O(1)
+// regardless of the window size.
+
 class SensorFilter : public QObject
 {
     Q_OBJECT
@@ -49,11 +53,15 @@ public:
 
     float filterValue(float value);
 
+    // Filters count values at once, e.g. for replaying recorded data. Returns the last filtered value.
+    float filterBlock(const float *values, size_t count);
+
     bool isReady() const;
     void reset();
 
     Type filterType() const;
 
+    // Input values and filter results within the current window, oldest first
     QVector<float> inputData() const;
     QVector<float> outputData() const;
 
@@ -73,12 +81,22 @@ private:
     float m_lowPassAlpha = 0.2f;
     float m_highPassAlpha = 0.2f;
 
-    float m_averageSum = 0;
-
+    // Ring buffer
     QVector<float> m_inputData;
     QVector<float> m_outputData;
-
-    void addInputValue(float value);
+    int m_head = 0;
+    int m_count = 0;
+
+    // Incremental filter state
+    double m_sum = 0;
+    double m_firstWeight = 1;
+    double m_windowDecay = 0;
+
+    float firstValue() const;
+    float lastValue() const;
+    float addInputValue(float value);
+    void storeOutputValue(float value);
+    void replay(const QVector<float> &values);
 
     // Filter methods
     float lowPassFilterValue(float value);
@@ -193,6 +193,11 @@ void SensorTag::setMovementSensitivity(int percentage)
     m_movementSensitivity = static_cast<double>(percentage) / 100.0;
 }
 
+void SensorTag::setSensorDataRecordingEnabled(bool enabled)
+{
+    m_dataProcessor->setRecordingEnabled(enabled);
+}
+
 void SensorTag::setGreenLedPower(bool power)
 {
     m_greenLedEnabled = power;
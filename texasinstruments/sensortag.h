@@ -111,6 +111,7 @@ public:
     void setMeasurementPeriod(int period);
     void setMeasurementPeriodMovement(int period);
     void setMovementSensitivity(int percentage);
+    void setSensorDataRecordingEnabled(bool enabled);
 
     // Actions
     void setGreenLedPower(bool power);
@@ -8,12 +8,14 @@ HEADERS += \
     integrationplugintexasinstruments.h \
     sensortag.h \
     sensordataprocessor.h \
+    sensordatarecorder.h \
     sensorfilter.h
 
 SOURCES += \
     integrationplugintexasinstruments.cpp \
     sensortag.cpp \
     sensordataprocessor.cpp \
+    sensordatarecorder.cpp \
     sensorfilter.cpp
 
 
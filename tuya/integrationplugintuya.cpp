@@ -66,6 +66,24 @@ QHash<ActionTypeId, ThingClassId> powerStateTypeIdsMap = {
     {tuyaLightThingClassId, tuyaLightPowerStateTypeId}
 };
 
+QHash<ThingClassId, ParamTypeId> localAddressSettingTypeIdsMap = {
+    {tuyaClosableThingClassId, tuyaClosableSettingsLocalAddressParamTypeId},
+    {tuyaSwitchThingClassId, tuyaSwitchSettingsLocalAddressParamTypeId},
+    {tuyaLightThingClassId, tuyaLightSettingsLocalAddressParamTypeId}
+};
+
+QHash<ThingClassId, ParamTypeId> localKeySettingTypeIdsMap = {
+    {tuyaClosableThingClassId, tuyaClosableSettingsLocalKeyParamTypeId},
+    {tuyaSwitchThingClassId, tuyaSwitchSettingsLocalKeyParamTypeId},
+    {tuyaLightThingClassId, tuyaLightSettingsLocalKeyParamTypeId}
+};
+
+QHash<ThingClassId, ParamTypeId> protocolVersionSettingTypeIdsMap = {
+    {tuyaClosableThingClassId, tuyaClosableSettingsProtocolVersionParamTypeId},
+    {tuyaSwitchThingClassId, tuyaSwitchSettingsProtocolVersionParamTypeId},
+    {tuyaLightThingClassId, tuyaLightSettingsProtocolVersionParamTypeId}
+};
+
 IntegrationPluginTuya::IntegrationPluginTuya(QObject *parent): IntegrationPlugin(parent)
 {
 }
@@ -120,6 +138,16 @@ void IntegrationPluginTuya::setupThing(ThingSetupInfo *info)
         return ;
     }
 
+    // setupThing() runs again on reconfigure, make sure the connection exists only once
+    disconnect(thing, &Thing::settingChanged, this, nullptr);
+    connect(thing, &Thing::settingChanged, this, [this, thing](const ParamTypeId &paramTypeId){
+        if (paramTypeId == localAddressSettingTypeIdsMap.value(thing->thingClassId())
+                || paramTypeId == localKeySettingTypeIdsMap.value(thing->thingClassId())
+                || paramTypeId == protocolVersionSettingTypeIdsMap.value(thing->thingClassId())) {
+            scheduleLocalConnectionSetup(thing);
+        }
+    });
+
     info->finish(Thing::ThingErrorNoError);
 }
 
@@ -128,7 +156,8 @@ void IntegrationPluginTuya::postSetupThing(Thing *thing)
     if (thing->thingClassId() == tuyaCloudThingClassId) {
         updateChildDevices(thing);        
     } else {
-        queryDevice(thing);
+        provisionLocalKey(thing);
+        scheduleLocalConnectionSetup(thing);
     }
 
 
@@ -137,7 +166,12 @@ void IntegrationPluginTuya::postSetupThing(Thing *thing)
         connect(m_pluginTimerQuery, &PluginTimer::timeout, this, [this](){
             foreach (Thing *d, myThings().filterByThingClassId(tuyaCloudThingClassId)) {
                 if (m_pollQueue.value(d).isEmpty()) {
-                    m_pollQueue[d] = myThings().filterByParentId(d->id());
+                    foreach (Thing *child, myThings().filterByParentId(d->id())) {
+                        // Things with a local connection get their states pushed by the device
+                        if (!m_localConnections.contains(child)) {
+                            m_pollQueue[d].append(child);
+                        }
+                    }
                 }
                 if (m_pollQueue[d].count() > 0) {
                     queryDevice(m_pollQueue[d].takeFirst());
@@ -161,6 +195,16 @@ void IntegrationPluginTuya::thingRemoved(Thing *thing)
     if (thing->thingClassId() == tuyaCloudThingClassId) {
         m_pollQueue.remove(thing);
         m_tokenExpiryTimers.take(thing->id())->deleteLater();
+    } else {
+        Thing *parentThing = myThings().findById(thing->parentId());
+        if (parentThing) {
+            m_pollQueue[parentThing].removeAll(thing);
+        }
+    }
+
+    m_pendingLocalSetups.remove(thing);
+    if (m_localConnections.contains(thing)) {
+        m_localConnections.take(thing)->deleteLater();
     }
 
     if (myThings().isEmpty()) {
@@ -246,6 +290,10 @@ void IntegrationPluginTuya::confirmPairing(ThingPairingInfo *info, const QString
 
 void IntegrationPluginTuya::executeAction(ThingActionInfo *info)
 {
+    if (executeLocalAction(info)) {
+        return;
+    }
+
     QString devId = info->thing()->paramValue(idParamTypeIdsMap.value(info->thing()->thingClassId())).toString();
 
     if (powerStateTypeIdsMap.values().contains(info->action().actionTypeId())) {
@@ -461,7 +509,7 @@ void IntegrationPluginTuya::updateChildDevices(Thing *thing)
                     ThingDescriptor descriptor(tuyaSwitchThingClassId, name, QString(), thing->id());
                     descriptor.setParams(ParamList() << Param(tuyaSwitchThingIdParamTypeId, id));
                     unknownDevices.append(descriptor);
-                } else {
+                } else if (!m_localConnections.contains(d)) {
                     bool online = deviceMap.value("data").toMap().value("online").toBool();
                     bool state = deviceMap.value("data").toMap().value("state").toBool();
                     qCDebug(dcTuya()) << "Found existing Tuya switch" << d->name() << id << name << (online ? "online:" : "offline") << (state ? "on": "off");
@@ -476,7 +524,7 @@ void IntegrationPluginTuya::updateChildDevices(Thing *thing)
                     ThingDescriptor descriptor(tuyaClosableThingClassId, name, QString(), thing->id());
                     descriptor.setParams(ParamList() << Param(tuyaClosableThingIdParamTypeId, id));
                     unknownDevices.append(descriptor);
-                } else {
+                } else if (!m_localConnections.contains(d)) {
                     bool online = deviceMap.value("data").toMap().value("online").toBool();
                     qCDebug(dcTuya()) << "Found existing Tuya cover" << d->name() << id << name << (online ? "online" : "offline");
                     d->setStateValue(tuyaClosableConnectedStateTypeId, online);
@@ -489,7 +537,7 @@ void IntegrationPluginTuya::updateChildDevices(Thing *thing)
                     ThingDescriptor descriptor(tuyaLightThingClassId, name, QString(), thing->id());
                     descriptor.setParams(ParamList() << Param(tuyaLightThingIdParamTypeId, id));
                     unknownDevices.append(descriptor);
-                } else {
+                } else if (!m_localConnections.contains(d)) {
                     bool online = deviceMap.value("data").toMap().value("online").toBool();
                     bool state = deviceMap.value("data").toMap().value("state").toBool();
                     qCDebug(dcTuya()) << "Found existing Tuya color light" << d->name() << id << name << (online ? "online" : "offline");
@@ -506,6 +554,10 @@ void IntegrationPluginTuya::updateChildDevices(Thing *thing)
             }
         }
 
+        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+            provisionLocalKey(child);
+        }
+
         if (!unknownDevices.isEmpty()) {
             emit autoThingsAppeared(unknownDevices);
         }
@@ -649,3 +701,168 @@ void IntegrationPluginTuya::controlTuyaSwitch(const QString &devId, const QStrin
     });
 }
 
+void IntegrationPluginTuya::provisionLocalKey(Thing *thing)
+{
+    ParamTypeId localKeySettingTypeId = localKeySettingTypeIdsMap.value(thing->thingClassId());
+    if (!thing->setting(localKeySettingTypeId).toString().isEmpty())
+        return;
+
+    // Only some cloud accounts report the local key along with the discovery data
+    pluginStorage()->beginGroup(thing->parentId().toString());
+    QByteArray discoveryCache = pluginStorage()->value("DiscoveryCache").toByteArray();
+    pluginStorage()->endGroup();
+
+    QString devId = thing->paramValue(idParamTypeIdsMap.value(thing->thingClassId())).toString();
+    QVariantList devices = QJsonDocument::fromJson(discoveryCache).toVariant().toMap().value("payload").toMap().value("devices").toList();
+    foreach (const QVariant &deviceVariant, devices) {
+        QVariantMap deviceMap = deviceVariant.toMap();
+        if (deviceMap.value("id").toString() != devId)
+            continue;
+
+        QString localKey = deviceMap.value("local_key").toString();
+        if (!localKey.isEmpty()) {
+            qCDebug(dcTuya()) << "Provisioning local key from Tuya cloud for" << thing->name();
+            thing->setSettingValue(localKeySettingTypeId, localKey);
+        }
+        return;
+    }
+}
+
+void IntegrationPluginTuya::scheduleLocalConnectionSetup(Thing *thing)
+{
+    // Provisioning the local key and the initial setup may change several settings at once,
+    // only open one session with the device for all of them.
+    if (m_pendingLocalSetups.contains(thing)) {
+        return;
+    }
+    m_pendingLocalSetups.insert(thing);
+
+    QTimer::singleShot(0, thing, [this, thing](){
+        if (!m_pendingLocalSetups.remove(thing)) {
+            return;
+        }
+        setupLocalConnection(thing);
+        if (!m_localConnections.contains(thing)) {
+            queryDevice(thing);
+        }
+    });
+}
+
+void IntegrationPluginTuya::setupLocalConnection(Thing *thing)
+{
+    if (m_localConnections.contains(thing)) {
+        m_localConnections.take(thing)->deleteLater();
+    }
+
+    QHostAddress address(thing->setting(localAddressSettingTypeIdsMap.value(thing->thingClassId())).toString());
+    QByteArray localKey = thing->setting(localKeySettingTypeIdsMap.value(thing->thingClassId())).toString().toUtf8();
+    if (address.isNull() || localKey.isEmpty()) {
+        qCDebug(dcTuya()) << "No local address or key configured for" << thing->name() << ". Using the Tuya cloud.";
+        return;
+    }
+
+    TuyaLocalConnection::Version version = TuyaLocalConnection::Version33;
+    if (thing->setting(protocolVersionSettingTypeIdsMap.value(thing->thingClassId())).toString() == "3.4") {
+        version = TuyaLocalConnection::Version34;
+    }
+
+    QString devId = thing->paramValue(idParamTypeIdsMap.value(thing->thingClassId())).toString();
+    TuyaLocalConnection *connection = new TuyaLocalConnection(address, devId, localKey, version, this);
+    m_localConnections.insert(thing, connection);
+
+    connect(connection, &TuyaLocalConnection::connectedChanged, thing, [thing](bool connected){
+        thing->setStateValue(connectedStateTypeIdsMap.value(thing->thingClassId()), connected);
+    });
+    connect(connection, &TuyaLocalConnection::dataPointsReceived, thing, [this, thing](const QVariantMap &dataPoints){
+        updateLocalStates(thing, dataPoints);
+    });
+
+    connection->connectToDevice();
+}
+
+void IntegrationPluginTuya::updateLocalStates(Thing *thing, const QVariantMap &dataPoints)
+{
+    if (thing->thingClassId() == tuyaSwitchThingClassId) {
+        if (dataPoints.contains("1")) {
+            thing->setStateValue(tuyaSwitchPowerStateTypeId, dataPoints.value("1").toBool());
+        }
+        return;
+    }
+
+    if (thing->thingClassId() == tuyaLightThingClassId) {
+        // Newer lights use the data points 20 - 24, older ones only report power on data point 1
+        if (dataPoints.contains("20")) {
+            thing->setStateValue(tuyaLightPowerStateTypeId, dataPoints.value("20").toBool());
+        } else if (dataPoints.contains("1")) {
+            thing->setStateValue(tuyaLightPowerStateTypeId, dataPoints.value("1").toBool());
+        }
+        if (dataPoints.contains("22")) {
+            thing->setStateValue(tuyaLightBrightnessStateTypeId, dataPoints.value("22").toInt() / 10);
+        }
+        if (dataPoints.contains("23")) {
+            thing->setStateValue(tuyaLightColorTemperatureStateTypeId, dataPoints.value("23").toInt() / 10);
+        }
+        // Color is encoded as hex string "hhhhssssvvvv" with hue 0 - 360 and saturation/value 0 - 1000
+        QString hsv = dataPoints.value("24").toString();
+        if (hsv.length() == 12) {
+            int hue = hsv.mid(0, 4).toInt(nullptr, 16);
+            int saturation = hsv.mid(4, 4).toInt(nullptr, 16) * 255 / 1000;
+            int value = hsv.mid(8, 4).toInt(nullptr, 16) * 255 / 1000;
+            thing->setStateValue(tuyaLightColorStateTypeId, QColor::fromHsv(hue, saturation, value));
+        }
+    }
+}
+
+bool IntegrationPluginTuya::executeLocalAction(ThingActionInfo *info)
+{
+    Thing *thing = info->thing();
+    TuyaLocalConnection *connection = m_localConnections.value(thing);
+    if (!connection || !connection->connected())
+        return false;
+
+    ActionTypeId actionTypeId = info->action().actionTypeId();
+    bool newLight = connection->dataPoints().contains("20");
+
+    QVariantMap dataPoints;
+    if (actionTypeId == tuyaSwitchPowerActionTypeId) {
+        dataPoints.insert("1", info->action().paramValue(tuyaSwitchPowerActionPowerParamTypeId).toBool());
+    } else if (actionTypeId == tuyaClosableOpenActionTypeId) {
+        dataPoints.insert("1", "open");
+    } else if (actionTypeId == tuyaClosableCloseActionTypeId) {
+        dataPoints.insert("1", "close");
+    } else if (actionTypeId == tuyaClosableStopActionTypeId) {
+        dataPoints.insert("1", "stop");
+    } else if (actionTypeId == tuyaLightPowerActionTypeId) {
+        dataPoints.insert(newLight ? "20" : "1", info->action().paramValue(tuyaLightPowerActionPowerParamTypeId).toBool());
+    } else if (newLight && actionTypeId == tuyaLightBrightnessActionTypeId) {
+        dataPoints.insert("22", qMax(10, info->action().paramValue(tuyaLightBrightnessActionBrightnessParamTypeId).toInt() * 10));
+    } else if (newLight && actionTypeId == tuyaLightColorTemperatureActionTypeId) {
+        dataPoints.insert("21", "white");
+        dataPoints.insert("23", info->action().paramValue(tuyaLightColorTemperatureActionColorTemperatureParamTypeId).toInt() * 10);
+    } else if (newLight && actionTypeId == tuyaLightColorActionTypeId) {
+        QColor color = info->action().paramValue(tuyaLightColorActionColorParamTypeId).value<QColor>();
+        int brightness = qMax(10, thing->stateValue(tuyaLightBrightnessStateTypeId).toInt() * 10);
+        dataPoints.insert("21", "colour");
+        dataPoints.insert("24", QString("%1%2%3").arg(qMax(0, color.hsvHue()), 4, 16, QChar('0'))
+                          .arg(color.hsvSaturation() * 1000 / 255, 4, 16, QChar('0'))
+                          .arg(brightness, 4, 16, QChar('0')));
+    } else {
+        // Not supported by the local protocol of this device. Use the cloud.
+        return false;
+    }
+
+    qCDebug(dcTuya()) << "Controlling Tuya device" << thing->name() << "locally:" << dataPoints;
+    int commandId = connection->setDataPoints(dataPoints);
+    connect(connection, &TuyaLocalConnection::commandFinished, info, [info, commandId](int id, bool success){
+        if (id != commandId)
+            return;
+
+        if (!success) {
+            info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Error communicating with the Tuya device."));
+            return;
+        }
+        // States are updated by the status the device pushes after the change
+        info->finish(Thing::ThingErrorNoError);
+    });
+    return true;
+}
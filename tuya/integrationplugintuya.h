@@ -32,9 +32,12 @@
 #define INTEGRATIONPLUGINTUYA_H
 
 #include <QTimer>
+#include <QSet>
 
 #include "integrations/integrationplugin.h"
 
+#include "tuyalocalconnection.h"
+
 class PluginTimer;
 
 class IntegrationPluginTuya: public IntegrationPlugin
@@ -66,11 +69,19 @@ private:
 
     void controlTuyaSwitch(const QString &devId, const QString &command, const QVariant &value, ThingActionInfo *info);
 
+    void provisionLocalKey(Thing *thing);
+    void scheduleLocalConnectionSetup(Thing *thing);
+    void setupLocalConnection(Thing *thing);
+    void updateLocalStates(Thing *thing, const QVariantMap &dataPoints);
+    bool executeLocalAction(ThingActionInfo *info);
+
     QHash<ThingId, QTimer*> m_tokenExpiryTimers;
     PluginTimer *m_pluginTimerQuery = nullptr;
     PluginTimer *m_pluginTimerDiscovery = nullptr;
 
     QHash<Thing*, QList<Thing*>> m_pollQueue;
+    QHash<Thing*, TuyaLocalConnection*> m_localConnections;
+    QSet<Thing*> m_pendingLocalSetups;
 };
 
 #endif // INTEGRATIONPLUGINTUYA_H
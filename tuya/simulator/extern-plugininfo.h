@@ -0,0 +1,9 @@
+#ifndef EXTERNPLUGININFO_H
+#define EXTERNPLUGININFO_H
+
+#include <QLoggingCategory>
+
+// Stand-in for the header generated by the plugin build, so the simulator can link tuyalocalconnection.cpp
+Q_DECLARE_LOGGING_CATEGORY(dcTuya)
+
+#endif // EXTERNPLUGININFO_H
@@ -0,0 +1,576 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Simulates a Tuya device speaking the local protocol 3.3 or 3.4 on TCP port 6668.
+//
+// The framing and crypto of the simulated device are implemented independently of
+// TuyaLocalConnection and checked against known-good vectors. "--self-test" runs those
+// checks and then drives the plugin's TuyaLocalConnection against the simulated device.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QtEndian>
+
+#include <functional>
+
+#include <openssl/evp.h>
+
+#include "tuyalocalconnection.h"
+
+Q_LOGGING_CATEGORY(dcTuya, "Tuya")
+
+static const quint16 devicePort = 6668;
+
+struct Frame {
+    quint32 sequence = 0;
+    quint32 command = 0;
+    QByteArray payload;
+};
+
+static quint32 readUInt32(const QByteArray &data, int offset)
+{
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    char buffer[4];
+    qToBigEndian<quint32>(value, buffer);
+    data.append(buffer, 4);
+}
+
+// Bitwise CRC-32 (IEEE 802.3), deliberately not the table driven one of the plugin
+static quint32 crc32(const QByteArray &data)
+{
+    quint32 crc = 0xFFFFFFFF;
+    foreach (char byte, data) {
+        crc ^= static_cast<quint8>(byte);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
+
+static QByteArray hmacSha256(const QByteArray &data, const QByteArray &key)
+{
+    return QMessageAuthenticationCode::hash(data, key, QCryptographicHash::Sha256);
+}
+
+// AES-128-ECB, PKCS#7 padded unless padding is false. Returns an empty array on errors.
+static QByteArray aes128Ecb(const QByteArray &data, const QByteArray &key, bool encrypt, bool padding = true)
+{
+    if (key.size() != 16 || data.isEmpty())
+        return QByteArray();
+
+    QByteArray result(data.size() + 16, '\0');
+    int length = 0;
+    int finalLength = 0;
+    unsigned char *output = reinterpret_cast<unsigned char *>(result.data());
+
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    bool success = EVP_CipherInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const unsigned char *>(key.constData()), nullptr, encrypt ? 1 : 0) == 1;
+    success = success && EVP_CIPHER_CTX_set_padding(context, padding ? 1 : 0) == 1;
+    success = success && EVP_CipherUpdate(context, output, &length, reinterpret_cast<const unsigned char *>(data.constData()), data.size()) == 1;
+    success = success && EVP_CipherFinal_ex(context, output + length, &finalLength) == 1;
+    EVP_CIPHER_CTX_free(context);
+
+    if (!success)
+        return QByteArray();
+
+    result.truncate(length + finalLength);
+    return result;
+}
+
+static int footerSize(bool version34)
+{
+    return (version34 ? 32 : 4) + 4;
+}
+
+static QByteArray packFrame(bool version34, const Frame &frame, const QByteArray &key)
+{
+    QByteArray message;
+    appendUInt32(message, 0x000055AA);
+    appendUInt32(message, frame.sequence);
+    appendUInt32(message, frame.command);
+    appendUInt32(message, static_cast<quint32>(frame.payload.size() + footerSize(version34)));
+    message.append(frame.payload);
+    if (version34) {
+        message.append(hmacSha256(message, key));
+    } else {
+        appendUInt32(message, crc32(message));
+    }
+    appendUInt32(message, 0x0000AA55);
+    return message;
+}
+
+// Returns the number of bytes consumed, 0 if the frame is incomplete or -1 if it is invalid
+static int unpackFrame(bool version34, const QByteArray &buffer, const QByteArray &key, Frame *frame)
+{
+    if (buffer.size() < 16)
+        return 0;
+
+    if (readUInt32(buffer, 0) != 0x000055AA)
+        return -1;
+
+    quint32 length = readUInt32(buffer, 12);
+    if (length < static_cast<quint32>(footerSize(version34)) || length > 0x10000)
+        return -1;
+
+    int size = 16 + static_cast<int>(length);
+    if (buffer.size() < size)
+        return 0;
+
+    if (readUInt32(buffer, size - 4) != 0x0000AA55)
+        return -1;
+
+    QByteArray signedData = buffer.left(size - footerSize(version34));
+    if (version34) {
+        if (buffer.mid(signedData.size(), 32) != hmacSha256(signedData, key))
+            return -1;
+    } else if (readUInt32(buffer, signedData.size()) != crc32(signedData)) {
+        return -1;
+    }
+
+    frame->sequence = readUInt32(buffer, 4);
+    frame->command = readUInt32(buffer, 8);
+    frame->payload = signedData.mid(16);
+    return size;
+}
+
+static QByteArray protocolHeader(bool version34)
+{
+    return QByteArray(version34 ? "3.4" : "3.3") + QByteArray(12, '\0');
+}
+
+static QByteArray returnCode(quint32 code)
+{
+    QByteArray data;
+    appendUInt32(data, code);
+    return data;
+}
+
+// Decodes the payload of a request sent by a client
+static QByteArray decodeRequest(bool version34, const QByteArray &payload, const QByteArray &key)
+{
+    QByteArray encrypted = payload;
+    if (!version34 && encrypted.startsWith("3.3")) {
+        encrypted.remove(0, 15);
+    }
+
+    QByteArray data = aes128Ecb(encrypted, key, false);
+    if (version34 && data.startsWith("3.4")) {
+        data.remove(0, 15);
+    }
+    return data;
+}
+
+static bool sameDataPoints(const QVariantMap &first, const QVariantMap &second)
+{
+    // Compare through JSON, numbers arrive as doubles from the wire
+    return QJsonObject::fromVariantMap(first) == QJsonObject::fromVariantMap(second);
+}
+
+class FakeDevice
+{
+public:
+    FakeDevice(bool version34, const QString &deviceId, const QByteArray &localKey, const QVariantMap &dataPoints) :
+        m_version34(version34),
+        m_deviceId(deviceId),
+        m_localKey(localKey),
+        m_dataPoints(dataPoints)
+    {
+        m_server = new QTcpServer();
+        QObject::connect(m_server, &QTcpServer::newConnection, m_server, [this](){
+            while (m_server->hasPendingConnections()) {
+                QTcpSocket *socket = m_server->nextPendingConnection();
+                qInfo() << "Device: client connected from" << socket->peerAddress().toString();
+                m_sessions.insert(socket, Session(m_localKey));
+                QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket](){ onReadyRead(socket); });
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket](){
+                    qInfo() << "Device: client disconnected";
+                    m_sessions.remove(socket);
+                    socket->deleteLater();
+                });
+            }
+        });
+    }
+
+    ~FakeDevice()
+    {
+        m_sessions.clear();
+        delete m_server;
+    }
+
+    bool listen(const QHostAddress &address)
+    {
+        if (!m_server->listen(address, devicePort)) {
+            qWarning() << "Device: cannot listen on port" << devicePort << m_server->errorString();
+            return false;
+        }
+        qInfo() << "Device:" << m_deviceId << "speaking protocol" << (m_version34 ? "3.4" : "3.3") << "on" << address.toString() << devicePort;
+        return true;
+    }
+
+    QVariantMap dataPoints() const
+    {
+        return m_dataPoints;
+    }
+
+private:
+    struct Session {
+        Session(const QByteArray &localKey = QByteArray()) : key(localKey) {}
+        QByteArray buffer;
+        QByteArray key;
+        QByteArray clientNonce;
+        QByteArray deviceNonce;
+        bool established = false;
+    };
+
+    bool m_version34 = false;
+    QString m_deviceId;
+    QByteArray m_localKey;
+    QVariantMap m_dataPoints;
+    quint32 m_sequence = 0;
+
+    QTcpServer *m_server = nullptr;
+    QHash<QTcpSocket *, Session> m_sessions;
+
+    void onReadyRead(QTcpSocket *socket)
+    {
+        m_sessions[socket].buffer.append(socket->readAll());
+
+        forever {
+            Frame frame;
+            int consumed = unpackFrame(m_version34, m_sessions[socket].buffer, m_sessions[socket].key, &frame);
+            if (consumed == 0)
+                return;
+
+            if (consumed < 0) {
+                qWarning() << "Device: invalid frame or checksum, closing connection";
+                socket->abort();
+                return;
+            }
+
+            m_sessions[socket].buffer.remove(0, consumed);
+            if (!processFrame(socket, frame))
+                return;
+        }
+    }
+
+    // Returns false if the connection has been closed
+    bool processFrame(QTcpSocket *socket, const Frame &frame)
+    {
+        Session &session = m_sessions[socket];
+        QByteArray data = decodeRequest(m_version34, frame.payload, session.key);
+        if (data.isEmpty()) {
+            qWarning() << "Device: cannot decrypt command" << frame.command << ". Is the local key correct?";
+            return true;
+        }
+
+        switch (frame.command) {
+        case TuyaLocalConnection::CommandSessionKeyNegotiationStart:
+            if (!m_version34 || data.size() != 16) {
+                qWarning() << "Device: unexpected session key negotiation, closing connection";
+                socket->abort();
+                return false;
+            }
+            session.clientNonce = data;
+            session.deviceNonce.clear();
+            for (int i = 0; i < 16; i++) {
+                session.deviceNonce.append(static_cast<char>(QRandomGenerator::global()->bounded(256)));
+            }
+            send(socket, frame.sequence, TuyaLocalConnection::CommandSessionKeyNegotiationResponse,
+                 returnCode(0) + aes128Ecb(session.deviceNonce + hmacSha256(session.clientNonce, m_localKey), session.key, true));
+            return true;
+
+        case TuyaLocalConnection::CommandSessionKeyNegotiationFinish: {
+            if (session.deviceNonce.isEmpty() || data != hmacSha256(session.deviceNonce, m_localKey)) {
+                qWarning() << "Device: session key negotiation failed, closing connection";
+                socket->abort();
+                return false;
+            }
+            QByteArray nonce(16, '\0');
+            for (int i = 0; i < 16; i++) {
+                nonce[i] = session.clientNonce.at(i) ^ session.deviceNonce.at(i);
+            }
+            session.key = aes128Ecb(nonce, m_localKey, true, false);
+            session.established = true;
+            qInfo() << "Device: session key negotiated";
+            return true;
+        }
+
+        case TuyaLocalConnection::CommandHeartbeat:
+            send(socket, frame.sequence, frame.command, returnCode(0));
+            return true;
+
+        case TuyaLocalConnection::CommandDataPointQuery:
+        case TuyaLocalConnection::CommandDataPointQueryNew: {
+            QVariantMap status;
+            status.insert("devId", m_deviceId);
+            status.insert("dps", m_dataPoints);
+            QByteArray json = QJsonDocument::fromVariant(status).toJson(QJsonDocument::Compact);
+            qInfo() << "Device: query" << json;
+            send(socket, frame.sequence, frame.command, returnCode(0) + aes128Ecb(json, session.key, true));
+            return true;
+        }
+
+        case TuyaLocalConnection::CommandControl:
+        case TuyaLocalConnection::CommandControlNew: {
+            QVariantMap request = QJsonDocument::fromJson(data).toVariant().toMap();
+            QVariantMap dataPoints = m_version34 ? request.value("data").toMap().value("dps").toMap() : request.value("dps").toMap();
+            if (dataPoints.isEmpty() || (!m_version34 && request.value("devId").toString() != m_deviceId)) {
+                qWarning() << "Device: rejecting control request" << data;
+                send(socket, frame.sequence, frame.command, returnCode(1));
+                return true;
+            }
+            qInfo() << "Device: control" << dataPoints;
+            for (QVariantMap::const_iterator it = dataPoints.constBegin(); it != dataPoints.constEnd(); ++it) {
+                m_dataPoints.insert(it.key(), it.value());
+            }
+            send(socket, frame.sequence, frame.command, returnCode(0));
+            pushStatus(dataPoints);
+            return true;
+        }
+
+        default:
+            qWarning() << "Device: unhandled command" << frame.command << data;
+            return true;
+        }
+    }
+
+    void pushStatus(const QVariantMap &dataPoints)
+    {
+        QVariantMap status;
+        if (m_version34) {
+            QVariantMap data;
+            data.insert("dps", dataPoints);
+            status.insert("protocol", 4);
+            status.insert("t", QDateTime::currentSecsSinceEpoch());
+            status.insert("data", data);
+        } else {
+            status.insert("devId", m_deviceId);
+            status.insert("dps", dataPoints);
+            status.insert("t", QDateTime::currentSecsSinceEpoch());
+        }
+        QByteArray json = QJsonDocument::fromVariant(status).toJson(QJsonDocument::Compact);
+
+        foreach (QTcpSocket *socket, m_sessions.keys()) {
+            const Session &session = m_sessions[socket];
+            if (m_version34 && !session.established)
+                continue;
+
+            QByteArray payload = m_version34
+                    ? aes128Ecb(protocolHeader(true) + json, session.key, true)
+                    : protocolHeader(false) + aes128Ecb(json, session.key, true);
+            send(socket, ++m_sequence, TuyaLocalConnection::CommandStatus, payload);
+        }
+    }
+
+    void send(QTcpSocket *socket, quint32 sequence, quint32 command, const QByteArray &payload)
+    {
+        Frame frame;
+        frame.sequence = sequence;
+        frame.command = command;
+        frame.payload = payload;
+        socket->write(packFrame(m_version34, frame, m_sessions[socket].key));
+    }
+};
+
+static int s_failures = 0;
+
+static void check(bool condition, const QString &description)
+{
+    qInfo().noquote() << (condition ? "PASS" : "FAIL") << description;
+    if (!condition) {
+        s_failures++;
+    }
+}
+
+static bool waitFor(const std::function<bool()> &condition, int timeout = 10000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.hasExpired(timeout))
+            return false;
+
+        QEventLoop loop;
+        QTimer::singleShot(20, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return true;
+}
+
+static void checkVectors()
+{
+    // CRC-32 check value
+    check(crc32("123456789") == 0xCBF43926, "CRC-32 check value");
+
+    // FIPS-197 appendix C.1
+    QByteArray aesKey = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f");
+    QByteArray aesPlain = QByteArray::fromHex("00112233445566778899aabbccddeeff");
+    QByteArray aesCipher = QByteArray::fromHex("69c4e0d86a7b0430d8cdb78070b4c55a");
+    check(aes128Ecb(aesPlain, aesKey, true, false) == aesCipher, "AES-128 encryption (FIPS-197 C.1)");
+    check(aes128Ecb(aesCipher, aesKey, false, false) == aesPlain, "AES-128 decryption (FIPS-197 C.1)");
+
+    // RFC 4231 test case 2
+    check(hmacSha256("what do ya want for nothing?", "Jefe").toHex() == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", "HMAC-SHA256 (RFC 4231 case 2)");
+
+    // Complete frames, computed with the openssl command line tool and zlib
+    struct FrameVector {
+        bool version34;
+        quint32 sequence;
+        quint32 command;
+        QByteArray data;
+        QByteArray frame;
+    };
+    QByteArray key = "0123456789abcdef";
+    QList<FrameVector> vectors = {
+        { false, 1, TuyaLocalConnection::CommandDataPointQuery,
+          "{\"devId\":\"dev\",\"gwId\":\"dev\",\"t\":\"0\",\"uid\":\"dev\"}",
+          QByteArray::fromHex("000055aa000000010000000a00000048030aef846845f9d8a71c5153978cdbc93e9c2f99a535673389962ffee2155f2e8ed4"
+                              "da8ec6ccd3502c192a120e2f3230377222e061a924c591cd9c27ea163ed4d52795d90000aa55") },
+        { true, 2, TuyaLocalConnection::CommandControlNew,
+          protocolHeader(true) + "{\"data\":{\"dps\":{\"1\":true}},\"protocol\":5,\"t\":0}",
+          QByteArray::fromHex("000055aa000000020000000d000000644490b05d74be9368c24a038cbaeded8ec7d803e191094ebca96b3641d55de830c870"
+                              "a0f94d3c135c4d90e6d4d745f684b45b452afedf402f72642e3dc4dc7250008916678b49f4d65b22392b3c6c964c11d3c67d"
+                              "94bcd4ad0e06ae1337dc8c380000aa55") }
+    };
+
+    foreach (const FrameVector &vector, vectors) {
+        QString name = QString("%1 frame, command %2").arg(vector.version34 ? "3.4" : "3.3").arg(vector.command, 0, 16);
+
+        Frame frame;
+        frame.sequence = vector.sequence;
+        frame.command = vector.command;
+        frame.payload = aes128Ecb(vector.data, key, true);
+        check(packFrame(vector.version34, frame, key) == vector.frame, "pack " + name);
+
+        Frame decoded;
+        bool complete = unpackFrame(vector.version34, vector.frame, key, &decoded) == vector.frame.size();
+        check(complete && decoded.sequence == vector.sequence && decoded.command == vector.command
+              && aes128Ecb(decoded.payload, key, false) == vector.data, "unpack " + name);
+
+        QByteArray corrupted = vector.frame;
+        corrupted[20] = corrupted.at(20) ^ 0x01;
+        check(unpackFrame(vector.version34, corrupted, key, &decoded) < 0, "reject corrupted " + name);
+    }
+}
+
+static void checkConnection(bool version34)
+{
+    QString name = version34 ? "3.4" : "3.3";
+    QString deviceId = "bf0123456789abcdef";
+    QByteArray localKey = "0123456789abcdef";
+
+    FakeDevice device(version34, deviceId, localKey, {{"1", false}, {"9", 0}});
+    if (!device.listen(QHostAddress::LocalHost)) {
+        check(false, name + ": start simulated device");
+        return;
+    }
+
+    TuyaLocalConnection connection(QHostAddress::LocalHost, deviceId, localKey, version34 ? TuyaLocalConnection::Version34 : TuyaLocalConnection::Version33);
+    QHash<int, bool> finishedCommands;
+    QObject::connect(&connection, &TuyaLocalConnection::commandFinished, [&finishedCommands](int commandId, bool success){
+        finishedCommands.insert(commandId, success);
+    });
+
+    connection.connectToDevice();
+    check(waitFor([&](){ return connection.connected(); }), name + ": connect" + (version34 ? " and negotiate the session key" : ""));
+    check(waitFor([&](){ return sameDataPoints(connection.dataPoints(), device.dataPoints()); }), name + ": initial data point query");
+
+    int commandId = connection.setDataPoints({{"1", true}, {"9", 42}});
+    check(commandId >= 0 && waitFor([&](){ return finishedCommands.contains(commandId); }) && finishedCommands.value(commandId), name + ": control acknowledged");
+    check(device.dataPoints().value("1").toBool() && device.dataPoints().value("9").toInt() == 42, name + ": control applied by the device");
+    check(waitFor([&](){ return sameDataPoints(connection.dataPoints(), device.dataPoints()); }), name + ": status pushed by the device");
+
+    commandId = connection.queryDataPoints();
+    check(commandId >= 0 && waitFor([&](){ return finishedCommands.contains(commandId); }) && finishedCommands.value(commandId), name + ": query acknowledged");
+
+    connection.disconnectFromDevice();
+}
+
+static int selfTest()
+{
+    checkVectors();
+    checkConnection(false);
+    checkConnection(true);
+
+    if (s_failures > 0) {
+        qWarning() << s_failures << "checks failed";
+        return 1;
+    }
+    qInfo() << "All checks passed";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates a Tuya device speaking the local protocol on TCP port 6668.");
+    parser.addHelpOption();
+    QCommandLineOption protocolOption("protocol", "The protocol version, 3.3 or 3.4.", "version", "3.3");
+    QCommandLineOption idOption("id", "The device id.", "id", "bf0123456789abcdef");
+    QCommandLineOption keyOption("key", "The local key, 16 characters.", "key", "0123456789abcdef");
+    QCommandLineOption selfTestOption("self-test", "Check the framing and crypto against known-good vectors, run the plugin's local connection against the simulated device and exit.");
+    parser.addOptions({protocolOption, idOption, keyOption, selfTestOption});
+    parser.process(app);
+
+    if (parser.isSet(selfTestOption)) {
+        return selfTest();
+    }
+
+    QByteArray localKey = parser.value(keyOption).toUtf8();
+    if (localKey.size() != 16) {
+        qCritical() << "The local key must have 16 characters";
+        return 1;
+    }
+
+    FakeDevice device(parser.value(protocolOption) == "3.4", parser.value(idOption), localKey, {{"1", false}, {"9", 0}});
+    if (!device.listen(QHostAddress::Any)) {
+        return 1;
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,18 @@
+CONFIG += c++11 console link_pkgconfig
+CONFIG -= app_bundle
+
+QT += network
+QT -= gui
+
+PKGCONFIG += libcrypto
+
+# The stub extern-plugininfo.h in this directory replaces the generated plugin header
+INCLUDEPATH += $$PWD $$PWD/..
+
+SOURCES += \
+    simulator.cpp \
+    ../tuyalocalconnection.cpp \
+
+HEADERS += \
+    extern-plugininfo.h \
+    ../tuyalocalconnection.h \
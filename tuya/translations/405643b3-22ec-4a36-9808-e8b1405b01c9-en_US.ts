@@ -29,6 +29,11 @@
         <source>Error connecting to Tuya switch.</source>
         <translation type="unfinished"></translation>
     </message>
+    <message>
+        <location filename="../integrationplugintuya.cpp" line="861"/>
+        <source>Error communicating with the Tuya device.</source>
+        <translation type="unfinished"></translation>
+    </message>
     <message>
         <location filename="../integrationplugintuya.cpp" line="635"/>
         <source>Received an unexpected reply from the Tuya switch.</source>
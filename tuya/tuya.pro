@@ -2,12 +2,14 @@ include(../plugins.pri)
 
 QT += network
 
-PKGCONFIG += nymea-mqtt
+PKGCONFIG += nymea-mqtt libcrypto
 
 TARGET = $$qtLibraryTarget(nymea_integrationplugintuya)
 
 SOURCES += \
     integrationplugintuya.cpp \
+    tuyalocalconnection.cpp \
 
 HEADERS += \
     integrationplugintuya.h \
+    tuyalocalconnection.h \
@@ -0,0 +1,588 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "tuyalocalconnection.h"
+#include "extern-plugininfo.h"
+
+#include <QtEndian>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QMessageAuthenticationCode>
+
+#include <openssl/evp.h>
+
+const quint16 localPort = 6668;
+const quint32 messagePrefix = 0x000055AA;
+const quint32 messageSuffix = 0x0000AA55;
+const int headerSize = 16;
+const int maxMessageSize = 0x10000;
+
+// Devices close idle connections after ~30 seconds
+const int heartbeatInterval = 10000;
+const int commandTimeout = 5000;
+const int minReconnectInterval = 1000;
+const int maxReconnectInterval = 60000;
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    char buffer[4];
+    qToBigEndian<quint32>(value, buffer);
+    data.append(buffer, 4);
+}
+
+static quint32 readUInt32(const QByteArray &data, int offset)
+{
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+TuyaLocalConnection::TuyaLocalConnection(const QHostAddress &address, const QString &deviceId, const QByteArray &localKey, Version version, QObject *parent) :
+    QObject(parent),
+    m_address(address),
+    m_deviceId(deviceId),
+    m_localKey(localKey),
+    m_version(version),
+    m_reconnectInterval(minReconnectInterval)
+{
+    if (m_localKey.size() != 16) {
+        qCWarning(dcTuya()) << "Local: the local key for" << m_deviceId << "has" << m_localKey.size() << "characters instead of 16. Communication will fail.";
+    }
+
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::connected, this, &TuyaLocalConnection::onSocketConnected);
+    connect(m_socket, &QTcpSocket::stateChanged, this, &TuyaLocalConnection::onSocketStateChanged);
+    connect(m_socket, &QTcpSocket::readyRead, this, &TuyaLocalConnection::onReadyRead);
+
+    m_heartbeatTimer.setInterval(heartbeatInterval);
+    connect(&m_heartbeatTimer, &QTimer::timeout, this, &TuyaLocalConnection::onHeartbeatTimeout);
+
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &TuyaLocalConnection::connectToDevice);
+}
+
+TuyaLocalConnection::~TuyaLocalConnection()
+{
+    m_socket->disconnect(this);
+    m_socket->abort();
+
+    // Actions waiting for a reply would otherwise never be finished
+    QList<quint32> pendingCommands = m_pendingCommands;
+    m_pendingCommands.clear();
+    foreach (quint32 sequence, pendingCommands) {
+        emit commandFinished(static_cast<int>(sequence), false);
+    }
+}
+
+QHostAddress TuyaLocalConnection::address() const
+{
+    return m_address;
+}
+
+QString TuyaLocalConnection::deviceId() const
+{
+    return m_deviceId;
+}
+
+TuyaLocalConnection::Version TuyaLocalConnection::version() const
+{
+    return m_version;
+}
+
+bool TuyaLocalConnection::connected() const
+{
+    return m_connected;
+}
+
+QVariantMap TuyaLocalConnection::dataPoints() const
+{
+    return m_dataPoints;
+}
+
+void TuyaLocalConnection::connectToDevice()
+{
+    m_reconnect = true;
+    if (m_socket->state() != QAbstractSocket::UnconnectedState)
+        return;
+
+    qCDebug(dcTuya()) << "Local: connecting to" << m_deviceId << "on" << m_address.toString();
+    m_socket->connectToHost(m_address, localPort);
+
+    // The heartbeat timer also limits the time for connecting and negotiating the session
+    m_heartbeatTimer.start();
+}
+
+void TuyaLocalConnection::disconnectFromDevice()
+{
+    m_reconnect = false;
+    m_reconnectTimer.stop();
+    m_socket->abort();
+}
+
+int TuyaLocalConnection::queryDataPoints()
+{
+    if (!m_connected)
+        return -1;
+
+    Command command = m_version == Version34 ? CommandDataPointQueryNew : CommandDataPointQuery;
+    quint32 sequence = sendMessage(command, requestData(command));
+    addPendingCommand(sequence);
+    return static_cast<int>(sequence);
+}
+
+int TuyaLocalConnection::setDataPoints(const QVariantMap &dataPoints)
+{
+    if (!m_connected)
+        return -1;
+
+    Command command = m_version == Version34 ? CommandControlNew : CommandControl;
+    quint32 sequence = sendMessage(command, requestData(command, dataPoints));
+    addPendingCommand(sequence);
+    return static_cast<int>(sequence);
+}
+
+void TuyaLocalConnection::onSocketConnected()
+{
+    m_inputBuffer.clear();
+    m_heartbeatPending = false;
+
+    if (m_version == Version33) {
+        setConnected(true);
+        return;
+    }
+
+    // Protocol 3.4 requires a session key, derived from a nonce of each side
+    qCDebug(dcTuya()) << "Local: negotiating session key with" << m_deviceId;
+    m_sessionKey.clear();
+    m_localNonce.clear();
+    for (int i = 0; i < 16; i++) {
+        m_localNonce.append(static_cast<char>(QRandomGenerator::global()->bounded(256)));
+    }
+    sendMessage(CommandSessionKeyNegotiationStart, m_localNonce);
+}
+
+void TuyaLocalConnection::onSocketStateChanged(QAbstractSocket::SocketState state)
+{
+    if (state != QAbstractSocket::UnconnectedState)
+        return;
+
+    m_heartbeatTimer.stop();
+    m_sessionKey.clear();
+    m_inputBuffer.clear();
+    setConnected(false);
+
+    QList<quint32> pendingCommands = m_pendingCommands;
+    m_pendingCommands.clear();
+    foreach (quint32 sequence, pendingCommands) {
+        emit commandFinished(static_cast<int>(sequence), false);
+    }
+
+    if (m_reconnect) {
+        qCDebug(dcTuya()) << "Local: connection to" << m_deviceId << "closed. Reconnecting in" << m_reconnectInterval << "ms";
+        m_reconnectTimer.start(m_reconnectInterval);
+        m_reconnectInterval = qMin(m_reconnectInterval * 2, maxReconnectInterval);
+    }
+}
+
+void TuyaLocalConnection::onReadyRead()
+{
+    m_inputBuffer.append(m_socket->readAll());
+
+    QByteArray prefix;
+    appendUInt32(prefix, messagePrefix);
+
+    forever {
+        int start = m_inputBuffer.indexOf(prefix);
+        if (start < 0) {
+            // Keep a possibly incomplete prefix
+            m_inputBuffer = m_inputBuffer.right(prefix.size() - 1);
+            return;
+        }
+        if (start > 0) {
+            qCWarning(dcTuya()) << "Local: discarding" << start << "bytes of garbage from" << m_deviceId;
+            m_inputBuffer.remove(0, start);
+        }
+
+        if (m_inputBuffer.size() < headerSize)
+            return;
+
+        quint32 sequence = readUInt32(m_inputBuffer, 4);
+        quint32 command = readUInt32(m_inputBuffer, 8);
+        quint32 length = readUInt32(m_inputBuffer, 12);
+        int footerSize = (m_version == Version34 ? 32 : 4) + 4;
+        if (length > maxMessageSize || static_cast<int>(length) < footerSize) {
+            qCWarning(dcTuya()) << "Local: invalid message length" << length << "from" << m_deviceId;
+            m_inputBuffer.remove(0, prefix.size());
+            continue;
+        }
+
+        if (m_inputBuffer.size() < headerSize + static_cast<int>(length))
+            return;
+
+        QByteArray message = m_inputBuffer.left(headerSize + static_cast<int>(length));
+        m_inputBuffer.remove(0, message.size());
+
+        if (readUInt32(message, message.size() - 4) != messageSuffix) {
+            qCWarning(dcTuya()) << "Local: invalid message suffix from" << m_deviceId;
+            continue;
+        }
+
+        QByteArray signedData = message.left(message.size() - footerSize);
+        QByteArray checksum = message.mid(signedData.size(), footerSize - 4);
+        bool valid = false;
+        if (m_version == Version34) {
+            valid = checksum == QMessageAuthenticationCode::hash(signedData, messageKey(), QCryptographicHash::Sha256);
+        } else {
+            valid = readUInt32(checksum, 0) == crc32(signedData);
+        }
+        if (!valid) {
+            qCWarning(dcTuya()) << "Local: checksum mismatch in message from" << m_deviceId;
+            continue;
+        }
+
+        processMessage(sequence, command, signedData.mid(headerSize));
+    }
+}
+
+void TuyaLocalConnection::onHeartbeatTimeout()
+{
+    if (!m_connected) {
+        qCDebug(dcTuya()) << "Local: timeout connecting to" << m_deviceId;
+        m_socket->abort();
+        return;
+    }
+
+    if (m_heartbeatPending) {
+        qCWarning(dcTuya()) << "Local:" << m_deviceId << "did not answer the last heartbeat. Closing connection.";
+        m_socket->abort();
+        return;
+    }
+
+    m_heartbeatPending = true;
+    sendMessage(CommandHeartbeat, requestData(CommandHeartbeat));
+}
+
+void TuyaLocalConnection::setConnected(bool connected)
+{
+    if (m_connected == connected)
+        return;
+
+    qCDebug(dcTuya()) << "Local:" << m_deviceId << (connected ? "connected" : "disconnected");
+    m_connected = connected;
+    emit connectedChanged(m_connected);
+
+    if (m_connected) {
+        m_reconnectInterval = minReconnectInterval;
+        queryDataPoints();
+    }
+}
+
+quint32 TuyaLocalConnection::sendMessage(Command command, const QByteArray &data)
+{
+    QByteArray header = (m_version == Version34 ? QByteArray("3.4") : QByteArray("3.3")) + QByteArray(12, '\0');
+
+    QByteArray payload;
+    if (m_version == Version34) {
+        // 3.4 encrypts the version header along with the data
+        payload = encrypt(hasProtocolHeader(command) ? header + data : data, messageKey());
+    } else {
+        payload = encrypt(data, m_localKey);
+        if (hasProtocolHeader(command)) {
+            payload.prepend(header);
+        }
+    }
+
+    quint32 sequence = ++m_sequence;
+    m_socket->write(packMessage(sequence, command, payload));
+    return sequence;
+}
+
+QByteArray TuyaLocalConnection::packMessage(quint32 sequence, Command command, const QByteArray &payload) const
+{
+    int footerSize = (m_version == Version34 ? 32 : 4) + 4;
+
+    QByteArray message;
+    appendUInt32(message, messagePrefix);
+    appendUInt32(message, sequence);
+    appendUInt32(message, command);
+    appendUInt32(message, static_cast<quint32>(payload.size() + footerSize));
+    message.append(payload);
+
+    if (m_version == Version34) {
+        message.append(QMessageAuthenticationCode::hash(message, messageKey(), QCryptographicHash::Sha256));
+    } else {
+        appendUInt32(message, crc32(message));
+    }
+    appendUInt32(message, messageSuffix);
+    return message;
+}
+
+void TuyaLocalConnection::processMessage(quint32 sequence, quint32 command, const QByteArray &payload)
+{
+    // Any valid message proves the connection is alive
+    m_heartbeatPending = false;
+
+    // Messages from the device usually start with a return code
+    QByteArray encrypted = payload;
+    quint32 returnCode = 0;
+    if (encrypted.size() >= 4 && (readUInt32(encrypted, 0) & 0xFFFFFF00) == 0) {
+        returnCode = readUInt32(encrypted, 0);
+        encrypted.remove(0, 4);
+    }
+
+    QByteArray data;
+    if (!encrypted.isEmpty()) {
+        if (m_version == Version34) {
+            data = decrypt(encrypted, messageKey());
+            if (data.startsWith("3.4")) {
+                data.remove(0, 15);
+            }
+        } else {
+            if (encrypted.startsWith("3.3")) {
+                encrypted.remove(0, 15);
+            }
+            data = encrypted.startsWith('{') ? encrypted : decrypt(encrypted, m_localKey);
+        }
+    }
+
+    switch (command) {
+    case CommandSessionKeyNegotiationResponse:
+        processSessionKeyNegotiation(data);
+        break;
+    case CommandHeartbeat:
+        break;
+    case CommandControl:
+    case CommandControlNew:
+        if (!data.isEmpty()) {
+            processDataPoints(data);
+        }
+        finishPendingCommand(sequence, returnCode == 0);
+        break;
+    case CommandDataPointQuery:
+    case CommandDataPointQueryNew:
+        processDataPoints(data);
+        finishPendingCommand(sequence, returnCode == 0 && !data.isEmpty());
+        break;
+    case CommandStatus:
+        processDataPoints(data);
+        break;
+    default:
+        qCDebug(dcTuya()) << "Local: unhandled command" << command << "from" << m_deviceId << data;
+        break;
+    }
+}
+
+void TuyaLocalConnection::processSessionKeyNegotiation(const QByteArray &data)
+{
+    if (m_version != Version34 || m_connected || data.size() < 48) {
+        qCWarning(dcTuya()) << "Local: unexpected session key negotiation response from" << m_deviceId;
+        return;
+    }
+
+    QByteArray remoteNonce = data.left(16);
+    if (data.mid(16, 32) != QMessageAuthenticationCode::hash(m_localNonce, m_localKey, QCryptographicHash::Sha256)) {
+        qCWarning(dcTuya()) << "Local: session key negotiation with" << m_deviceId << "failed. Is the local key correct?";
+        m_socket->abort();
+        return;
+    }
+
+    sendMessage(CommandSessionKeyNegotiationFinish, QMessageAuthenticationCode::hash(remoteNonce, m_localKey, QCryptographicHash::Sha256));
+
+    QByteArray nonce(16, '\0');
+    for (int i = 0; i < 16; i++) {
+        nonce[i] = m_localNonce.at(i) ^ remoteNonce.at(i);
+    }
+    m_sessionKey = encrypt(nonce, m_localKey, false);
+    setConnected(true);
+}
+
+void TuyaLocalConnection::processDataPoints(const QByteArray &data)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTuya()) << "Local: failed to parse data from" << m_deviceId << data << error.errorString();
+        return;
+    }
+
+    // 3.3 reports the data points on top level, 3.4 wraps them in a data object
+    QVariantMap map = jsonDoc.toVariant().toMap();
+    QVariantMap dataPoints = map.contains("dps") ? map.value("dps").toMap() : map.value("data").toMap().value("dps").toMap();
+    if (dataPoints.isEmpty())
+        return;
+
+    qCDebug(dcTuya()) << "Local: data points from" << m_deviceId << dataPoints;
+    for (QVariantMap::const_iterator it = dataPoints.constBegin(); it != dataPoints.constEnd(); ++it) {
+        m_dataPoints.insert(it.key(), it.value());
+    }
+    emit dataPointsReceived(dataPoints);
+}
+
+void TuyaLocalConnection::addPendingCommand(quint32 sequence)
+{
+    m_pendingCommands.append(sequence);
+    QTimer::singleShot(commandTimeout, this, [this, sequence](){
+        if (m_pendingCommands.removeOne(sequence)) {
+            qCWarning(dcTuya()) << "Local: command" << sequence << "to" << m_deviceId << "timed out";
+            emit commandFinished(static_cast<int>(sequence), false);
+        }
+    });
+}
+
+void TuyaLocalConnection::finishPendingCommand(quint32 sequence, bool success)
+{
+    if (m_pendingCommands.isEmpty())
+        return;
+
+    // Devices reply in order, but not all firmwares echo the sequence number
+    if (!m_pendingCommands.removeOne(sequence)) {
+        sequence = m_pendingCommands.takeFirst();
+    }
+    emit commandFinished(static_cast<int>(sequence), success);
+}
+
+QByteArray TuyaLocalConnection::requestData(Command command, const QVariantMap &dataPoints) const
+{
+    QString timestamp = QString::number(QDateTime::currentSecsSinceEpoch());
+
+    QVariantMap request;
+    switch (command) {
+    case CommandHeartbeat:
+        request.insert("gwId", m_deviceId);
+        request.insert("devId", m_deviceId);
+        break;
+    case CommandDataPointQuery:
+    case CommandDataPointQueryNew:
+        request.insert("gwId", m_deviceId);
+        request.insert("devId", m_deviceId);
+        request.insert("uid", m_deviceId);
+        request.insert("t", timestamp);
+        break;
+    case CommandControl:
+        request.insert("devId", m_deviceId);
+        request.insert("uid", m_deviceId);
+        request.insert("t", timestamp);
+        request.insert("dps", dataPoints);
+        break;
+    case CommandControlNew: {
+        QVariantMap data;
+        data.insert("dps", dataPoints);
+        request.insert("protocol", 5);
+        request.insert("t", QDateTime::currentSecsSinceEpoch());
+        request.insert("data", data);
+        break;
+    }
+    default:
+        break;
+    }
+    return QJsonDocument::fromVariant(request).toJson(QJsonDocument::Compact);
+}
+
+QByteArray TuyaLocalConnection::messageKey() const
+{
+    return m_sessionKey.isEmpty() ? m_localKey : m_sessionKey;
+}
+
+bool TuyaLocalConnection::hasProtocolHeader(Command command)
+{
+    switch (command) {
+    case CommandSessionKeyNegotiationStart:
+    case CommandSessionKeyNegotiationResponse:
+    case CommandSessionKeyNegotiationFinish:
+    case CommandHeartbeat:
+    case CommandDataPointQuery:
+    case CommandDataPointQueryNew:
+        return false;
+    default:
+        return true;
+    }
+}
+
+QByteArray TuyaLocalConnection::encrypt(const QByteArray &data, const QByteArray &key, bool padding)
+{
+    QByteArray result(data.size() + 16, '\0');
+    int length = 0;
+    int finalLength = 0;
+
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    bool success = EVP_EncryptInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const unsigned char *>(key.constData()), nullptr)
+            && EVP_CIPHER_CTX_set_padding(context, padding ? 1 : 0)
+            && EVP_EncryptUpdate(context, reinterpret_cast<unsigned char *>(result.data()), &length, reinterpret_cast<const unsigned char *>(data.constData()), data.size())
+            && EVP_EncryptFinal_ex(context, reinterpret_cast<unsigned char *>(result.data()) + length, &finalLength);
+    EVP_CIPHER_CTX_free(context);
+
+    if (!success) {
+        qCWarning(dcTuya()) << "Local: failed to encrypt data";
+        return QByteArray();
+    }
+    result.resize(length + finalLength);
+    return result;
+}
+
+QByteArray TuyaLocalConnection::decrypt(const QByteArray &data, const QByteArray &key)
+{
+    QByteArray result(data.size() + 16, '\0');
+    int length = 0;
+    int finalLength = 0;
+
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    bool success = EVP_DecryptInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const unsigned char *>(key.constData()), nullptr)
+            && EVP_DecryptUpdate(context, reinterpret_cast<unsigned char *>(result.data()), &length, reinterpret_cast<const unsigned char *>(data.constData()), data.size())
+            && EVP_DecryptFinal_ex(context, reinterpret_cast<unsigned char *>(result.data()) + length, &finalLength);
+    EVP_CIPHER_CTX_free(context);
+
+    if (!success) {
+        qCWarning(dcTuya()) << "Local: failed to decrypt data. Is the local key correct?";
+        return QByteArray();
+    }
+    result.resize(length + finalLength);
+    return result;
+}
+
+quint32 TuyaLocalConnection::crc32(const QByteArray &data)
+{
+    static quint32 table[256];
+    static bool tableInitialized = false;
+    if (!tableInitialized) {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+            }
+            table[i] = value;
+        }
+        tableInitialized = true;
+    }
+
+    quint32 crc = 0xFFFFFFFF;
+    for (int i = 0; i < data.size(); i++) {
+        crc = table[(crc ^ static_cast<quint8>(data.at(i))) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
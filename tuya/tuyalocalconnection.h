@@ -0,0 +1,140 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TUYALOCALCONNECTION_H
+#define TUYALOCALCONNECTION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QVariantMap>
+
+// Persistent connection to a Tuya device speaking the local LAN protocol (TCP port 6668).
+// Messages are framed as 0x55AA prefix, sequence, command, length, payload, CRC32 (3.3)
+// or HMAC-SHA256 (3.4) and 0xAA55 suffix. Payloads are AES-128-ECB encrypted with the
+// local key (3.3) or with a session key negotiated on connect (3.4).
+
+class TuyaLocalConnection : public QObject
+{
+    Q_OBJECT
+public:
+    enum Version {
+        Version33,
+        Version34
+    };
+    Q_ENUM(Version)
+
+    enum Command {
+        CommandSessionKeyNegotiationStart = 0x03,
+        CommandSessionKeyNegotiationResponse = 0x04,
+        CommandSessionKeyNegotiationFinish = 0x05,
+        CommandControl = 0x07,
+        CommandStatus = 0x08,
+        CommandHeartbeat = 0x09,
+        CommandDataPointQuery = 0x0a,
+        CommandControlNew = 0x0d,
+        CommandDataPointQueryNew = 0x10
+    };
+    Q_ENUM(Command)
+
+    explicit TuyaLocalConnection(const QHostAddress &address, const QString &deviceId, const QByteArray &localKey, Version version = Version33, QObject *parent = nullptr);
+    ~TuyaLocalConnection() override;
+
+    QHostAddress address() const;
+    QString deviceId() const;
+    Version version() const;
+
+    bool connected() const;
+
+    // Last known value of all data points reported by the device
+    QVariantMap dataPoints() const;
+
+    void connectToDevice();
+    void disconnectFromDevice();
+
+    // Returns the command id which will be passed to commandFinished(), or -1 if not connected
+    int queryDataPoints();
+    int setDataPoints(const QVariantMap &dataPoints);
+
+signals:
+    void connectedChanged(bool connected);
+    void dataPointsReceived(const QVariantMap &dataPoints);
+    void commandFinished(int commandId, bool success);
+
+private slots:
+    void onSocketConnected();
+    void onSocketStateChanged(QAbstractSocket::SocketState state);
+    void onReadyRead();
+    void onHeartbeatTimeout();
+
+private:
+    QHostAddress m_address;
+    QString m_deviceId;
+    QByteArray m_localKey;
+    Version m_version = Version33;
+
+    QTcpSocket *m_socket = nullptr;
+    QTimer m_heartbeatTimer;
+    QTimer m_reconnectTimer;
+    int m_reconnectInterval = 0;
+    bool m_heartbeatPending = false;
+    bool m_reconnect = false;
+    bool m_connected = false;
+
+    QByteArray m_localNonce;
+    QByteArray m_sessionKey;
+
+    quint32 m_sequence = 0;
+    QByteArray m_inputBuffer;
+    QList<quint32> m_pendingCommands;
+    QVariantMap m_dataPoints;
+
+    void setConnected(bool connected);
+
+    quint32 sendMessage(Command command, const QByteArray &data);
+    QByteArray packMessage(quint32 sequence, Command command, const QByteArray &payload) const;
+    void processMessage(quint32 sequence, quint32 command, const QByteArray &payload);
+    void processSessionKeyNegotiation(const QByteArray &data);
+    void processDataPoints(const QByteArray &data);
+
+    void addPendingCommand(quint32 sequence);
+    void finishPendingCommand(quint32 sequence, bool success);
+
+    QByteArray requestData(Command command, const QVariantMap &dataPoints = QVariantMap()) const;
+    QByteArray messageKey() const;
+
+    static bool hasProtocolHeader(Command command);
+    static QByteArray encrypt(const QByteArray &data, const QByteArray &key, bool padding = true);
+    static QByteArray decrypt(const QByteArray &data, const QByteArray &key);
+    static quint32 crc32(const QByteArray &data);
+};
+
+#endif // TUYALOCALCONNECTION_H
@@ -0,0 +1,336 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Flood sender and receiver for the UDP receiver of the plugin. Every datagram carries a sequence
+// number ("flood <sequence>", padded to the requested size), the receiver counts the packets per
+// second and the drops from the gaps in the sequence. The receiver drains its socket like the plugin
+// does: one reused 64 kB buffer, all pending datagrams per wakeup and a 1 MB kernel receive buffer.
+//
+// Usage:
+//   flood send <host> <port> [packets/s] [seconds] [size]   flood a running nymea (or a flood receive)
+//   flood receive <port> [--ack]                            receive until the sender is done
+//   flood local [packets/s] [seconds] [size]                both in one process on localhost
+// A rate of 0 sends as fast as possible. The sender reports the "OK" replies it got back, the
+// receiver stops on the end marker of the sender.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QUdpSocket>
+
+static QByteArray floodDatagram(quint64 sequence, int size)
+{
+    QByteArray datagram = "flood " + QByteArray::number(sequence) + "\n";
+    if (datagram.size() < size)
+        datagram.append(QByteArray(size - datagram.size(), '.'));
+
+    return datagram;
+}
+
+class Sender : public QThread
+{
+public:
+    Sender(const QHostAddress &address, quint16 port, int rate, int seconds, int size) :
+        m_address(address),
+        m_port(port),
+        m_rate(rate),
+        m_seconds(seconds),
+        m_size(size)
+    {
+    }
+
+    quint64 sent = 0;
+    quint64 sendErrors = 0;
+    quint64 replies = 0;
+    qint64 elapsedNs = 0;
+
+protected:
+    void run() override
+    {
+        QUdpSocket socket;
+        // Bind so replies of the receiver can be read back
+        socket.bind(QHostAddress::Any, 0);
+
+        qint64 durationNs = m_seconds * 1000000000LL;
+        qint64 intervalNs = m_rate > 0 ? 1000000000LL / m_rate : 0;
+        char reply[64];
+
+        QElapsedTimer clock;
+        clock.start();
+        for (quint64 sequence = 0; ; sequence++) {
+            qint64 due = sequence * intervalNs;
+            qint64 now = clock.nsecsElapsed();
+            if (now >= durationNs || (m_rate > 0 && due >= durationNs))
+                break;
+
+            // Sleeping below ~100 us is not precise, send in small bursts instead
+            if (due > now + 100000)
+                QThread::usleep((due - now) / 1000);
+
+            if (socket.writeDatagram(floodDatagram(sequence, m_size), m_address, m_port) < 0) {
+                sendErrors++;
+            } else {
+                sent++;
+            }
+
+            while (socket.hasPendingDatagrams() && socket.readDatagram(reply, sizeof(reply)) >= 0) {
+                replies++;
+            }
+        }
+        elapsedNs = clock.nsecsElapsed();
+
+        // Tell the receiver where the sequence ended, so drops at the end are counted as well
+        for (int i = 0; i < 3; i++) {
+            socket.writeDatagram("flood end " + QByteArray::number(sent + sendErrors), m_address, m_port);
+            QThread::msleep(100);
+            while (socket.hasPendingDatagrams() && socket.readDatagram(reply, sizeof(reply)) >= 0) {
+                replies++;
+            }
+        }
+    }
+
+private:
+    QHostAddress m_address;
+    quint16 m_port = 0;
+    int m_rate = 0;
+    int m_seconds = 0;
+    int m_size = 0;
+};
+
+class Receiver
+{
+public:
+    Receiver(quint16 port, bool acknowledge) :
+        m_acknowledge(acknowledge)
+    {
+        m_buffer.resize(65536);
+        if (!m_socket.bind(QHostAddress::Any, port, QUdpSocket::ShareAddress)) {
+            qWarning() << "Cannot bind to port" << port << m_socket.errorString();
+            return;
+        }
+        m_socket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1024 * 1024);
+        QObject::connect(&m_socket, &QUdpSocket::readyRead, [this](){ readPendingDatagrams(); });
+
+        m_reportTimer.setInterval(1000);
+        QObject::connect(&m_reportTimer, &QTimer::timeout, [this](){ report(); });
+        m_reportTimer.start();
+        m_clock.start();
+    }
+
+    bool isBound() const { return m_socket.state() == QAbstractSocket::BoundState; }
+    quint16 port() const { return m_socket.localPort(); }
+    bool finished() const { return m_finished; }
+
+    quint64 received = 0;
+    quint64 drops = 0;
+    quint64 reordered = 0;
+    quint64 duplicates = 0;
+    quint64 wakeups = 0;
+    qint64 firstNs = -1;
+    qint64 lastNs = 0;
+
+    void report()
+    {
+        qint64 now = m_clock.nsecsElapsed();
+        quint64 packets = received - m_reportedReceived;
+        qInfo().noquote() << QString("%1 packets/s, %2 datagrams per wakeup, %3 dropped so far")
+                             .arg(packets * 1000000000.0 / qMax<qint64>(1, now - m_reportedNs), 0, 'f', 0)
+                             .arg(wakeups > 0 ? static_cast<double>(received) / wakeups : 0, 0, 'f', 1)
+                             .arg(drops);
+        m_reportedReceived = received;
+        m_reportedNs = now;
+    }
+
+private:
+    void readPendingDatagrams()
+    {
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        wakeups++;
+
+        while (m_socket.hasPendingDatagrams()) {
+            qint64 size = m_socket.readDatagram(m_buffer.data(), m_buffer.size(), &sender, &senderPort);
+            if (size < 0) {
+                break;
+            }
+            QByteArray datagram = QByteArray::fromRawData(m_buffer.constData(), size);
+            if (datagram.startsWith("flood end ")) {
+                finish(datagram.mid(10).trimmed().toULongLong());
+                continue;
+            }
+            if (!datagram.startsWith("flood ")) {
+                continue;
+            }
+
+            lastNs = m_clock.nsecsElapsed();
+            if (firstNs < 0)
+                firstNs = lastNs;
+
+            received++;
+            count(datagram.mid(6, datagram.indexOf('\n') - 6).toULongLong());
+
+            if (m_acknowledge) {
+                m_socket.writeDatagram("OK\n", sender, senderPort);
+            }
+        }
+    }
+
+    // A gap counts as dropped, a late packet out of such a gap is taken back as reordered
+    void count(quint64 sequence)
+    {
+        if (sequence == m_expected) {
+            m_expected++;
+        } else if (sequence > m_expected) {
+            drops += sequence - m_expected;
+            for (quint64 missing = m_expected; missing < sequence && m_missing.count() < 100000; missing++)
+                m_missing.insert(missing);
+            m_expected = sequence + 1;
+        } else if (m_missing.remove(sequence)) {
+            drops--;
+            reordered++;
+        } else {
+            duplicates++;
+        }
+    }
+
+    void finish(quint64 total)
+    {
+        if (m_finished)
+            return;
+
+        if (total > m_expected) {
+            drops += total - m_expected;
+            m_expected = total;
+        }
+        m_finished = true;
+        m_reportTimer.stop();
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+    }
+
+    QUdpSocket m_socket;
+    QByteArray m_buffer;
+    bool m_acknowledge = false;
+    bool m_finished = false;
+    quint64 m_expected = 0;
+    QSet<quint64> m_missing;
+
+    QTimer m_reportTimer;
+    QElapsedTimer m_clock;
+    quint64 m_reportedReceived = 0;
+    qint64 m_reportedNs = 0;
+};
+
+static void printSender(const Sender &sender)
+{
+    qInfo().noquote() << QString("sent:     %1 datagrams in %2 s, %3 packets/s, %4 send errors, %5 replies")
+                         .arg(sender.sent).arg(sender.elapsedNs / 1000000000.0, 0, 'f', 2)
+                         .arg(sender.sent * 1000000000.0 / qMax<qint64>(1, sender.elapsedNs), 0, 'f', 0)
+                         .arg(sender.sendErrors).arg(sender.replies);
+}
+
+static void printReceiver(const Receiver &receiver)
+{
+    qint64 span = receiver.lastNs - receiver.firstNs;
+    qInfo().noquote() << QString("received: %1 datagrams, %2 packets/s, %3 datagrams per wakeup")
+                         .arg(receiver.received)
+                         .arg(span > 0 ? receiver.received * 1000000000.0 / span : 0, 0, 'f', 0)
+                         .arg(receiver.wakeups > 0 ? static_cast<double>(receiver.received) / receiver.wakeups : 0, 0, 'f', 1);
+    qInfo().noquote() << QString("dropped:  %1 (%2 %), %3 reordered, %4 duplicates")
+                         .arg(receiver.drops)
+                         .arg(receiver.received + receiver.drops > 0 ? 100.0 * receiver.drops / (receiver.received + receiver.drops) : 0, 0, 'f', 3)
+                         .arg(receiver.reordered).arg(receiver.duplicates);
+}
+
+static int usage()
+{
+    qWarning().noquote() << "Usage: flood send <host> <port> [packets/s] [seconds] [size]";
+    qWarning().noquote() << "       flood receive <port> [--ack]";
+    qWarning().noquote() << "       flood local [packets/s] [seconds] [size]";
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QStringList arguments = application.arguments();
+    QString mode = arguments.value(1);
+
+    if (mode == "send") {
+        QHostAddress address(arguments.value(2));
+        quint16 port = arguments.value(3).toUShort();
+        if (address.isNull() || port == 0)
+            return usage();
+
+        Sender sender(address, port, arguments.value(4, "10000").toInt(), arguments.value(5, "10").toInt(), arguments.value(6, "64").toInt());
+        sender.start();
+        sender.wait();
+        printSender(sender);
+        return 0;
+    }
+
+    if (mode == "receive") {
+        quint16 port = arguments.value(2).toUShort();
+        if (port == 0)
+            return usage();
+
+        Receiver receiver(port, arguments.contains("--ack"));
+        if (!receiver.isBound())
+            return 1;
+
+        qInfo() << "Waiting for datagrams on port" << port;
+        application.exec();
+        printReceiver(receiver);
+        return 0;
+    }
+
+    if (mode == "local") {
+        Receiver receiver(0, true);
+        if (!receiver.isBound())
+            return 1;
+
+        Sender sender(QHostAddress::LocalHost, receiver.port(), arguments.value(2, "10000").toInt(), arguments.value(3, "10").toInt(), arguments.value(4, "64").toInt());
+        // Stop even if all end markers got lost
+        QObject::connect(&sender, &QThread::finished, &application, [](){
+            QTimer::singleShot(2000, qApp, &QCoreApplication::quit);
+        });
+        sender.start();
+        application.exec();
+        sender.wait();
+        printSender(sender);
+        printReceiver(receiver);
+        return 0;
+    }
+
+    return usage();
+}
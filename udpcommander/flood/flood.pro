@@ -0,0 +1,7 @@
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+QT += network
+QT -= gui
+
+SOURCES += flood.cpp
@@ -34,7 +34,7 @@
 
 IntegrationPluginUdpCommander::IntegrationPluginUdpCommander()
 {
-
+    m_datagramBuffer.resize(65536);
 }
 
 void IntegrationPluginUdpCommander::setupThing(ThingSetupInfo *info)
@@ -44,17 +44,28 @@ void IntegrationPluginUdpCommander::setupThing(ThingSetupInfo *info)
     qCDebug(dcUdpCommander()) << "Setup thing" << thing->name() << thing->params();
 
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *udpSocket = new QUdpSocket(this);
-        int port = thing->paramValue(udpReceiverThingPortParamTypeId).toInt();
-        if (!udpSocket->bind(QHostAddress::Any, port, QUdpSocket::ShareAddress)) {
-            qCWarning(dcUdpCommander()) << thing->name() << "cannot bind to port" << port;
-            delete udpSocket;
-            return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Error opening UDP port."));
+        // In case of a reconfigure the port might have changed
+        removeReceiver(thing);
+
+        quint16 port = thing->paramValue(udpReceiverThingPortParamTypeId).toUInt();
+        QUdpSocket *udpSocket = m_receiverSockets.value(port);
+        if (!udpSocket) {
+            udpSocket = new QUdpSocket(this);
+            if (!udpSocket->bind(QHostAddress::Any, port, QUdpSocket::ShareAddress)) {
+                qCWarning(dcUdpCommander()) << thing->name() << "cannot bind to port" << port;
+                delete udpSocket;
+                return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Error opening UDP port."));
+            }
+            // A larger kernel buffer bridges bursts of datagrams while the event loop is busy
+            udpSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1024 * 1024);
+            qCDebug(dcUdpCommander()) << "Listening on port" << port;
+
+            connect(udpSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
+            m_receiverSockets.insert(port, udpSocket);
+        } else {
+            qCDebug(dcUdpCommander()) << "Sharing socket on port" << port << "with" << m_receivers.value(udpSocket).count() << "other receivers";
         }
-        qCDebug(dcUdpCommander()) << "Listening on port" << port;
-
-        connect(udpSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
-        m_receiverList.insert(udpSocket, thing);
+        m_receivers[udpSocket].append(thing);
 
         return info->finish(Thing::ThingErrorNoError);
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
@@ -85,10 +96,7 @@ void IntegrationPluginUdpCommander::executeAction(ThingActionInfo *info)
 void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
 {
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *socket = m_receiverList.key(thing);
-        m_receiverList.remove(socket);
-        socket->close();
-        socket->deleteLater();
+        removeReceiver(thing);
 
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
         QUdpSocket *socket = m_commanderList.key(thing);
@@ -98,34 +106,63 @@ void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
     }
 }
 
+void IntegrationPluginUdpCommander::removeReceiver(Thing *thing)
+{
+    foreach (QUdpSocket *socket, m_receivers.keys()) {
+        QList<Thing *> &things = m_receivers[socket];
+        if (!things.removeAll(thing)) {
+            continue;
+        }
+        if (things.isEmpty()) {
+            m_receivers.remove(socket);
+            m_receiverSockets.remove(m_receiverSockets.key(socket));
+            socket->close();
+            socket->deleteLater();
+        }
+        return;
+    }
+}
+
 void IntegrationPluginUdpCommander::readPendingDatagrams()
 {
-    qCDebug(dcUdpCommander()) << "UDP datagram received";
     QUdpSocket *socket= static_cast<QUdpSocket *>(sender());
-    Thing *thing = m_receiverList.value(socket);
+    QList<Thing *> things = m_receivers.value(socket);
 
-    if (!thing) {
+    if (things.isEmpty()) {
         qCWarning(dcUdpCommander()) << "Received a datagram from a socket we don't know";
         return;
     }
 
-    QByteArray datagram;
+    bool acknowledge = false;
+    foreach (Thing *thing, things) {
+        acknowledge |= thing->setting(udpReceiverSettingsAcknowledgeParamTypeId).toBool();
+    }
+
     QHostAddress sender;
     quint16 senderPort = 0;
+    int count = 0;
 
+    // Drain everything which arrived since the last wakeup in one go
     while (socket->hasPendingDatagrams()) {
-        datagram.resize(socket->pendingDatagramSize());
-        socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        qCDebug(dcUdpCommander()) << "Incoming datatram" << datagram << "on" << thing->name() << "from" << sender.toString() << senderPort;
-
-        Event ev = Event(udpReceiverTriggeredEventTypeId, thing->id());
-        ParamList params;
-        params.append(Param(udpReceiverTriggeredEventDataParamTypeId, datagram));
-        ev.setParams(params);
-        emit emitEvent(ev);
+        qint64 size = socket->readDatagram(m_datagramBuffer.data(), m_datagramBuffer.size(), &sender, &senderPort);
+        if (size < 0) {
+            break;
+        }
+        count++;
+        QByteArray datagram(m_datagramBuffer.constData(), size);
+
+        foreach (Thing *thing, things) {
+            Event ev = Event(udpReceiverTriggeredEventTypeId, thing->id());
+            ParamList params;
+            params.append(Param(udpReceiverTriggeredEventDataParamTypeId, datagram));
+            ev.setParams(params);
+            emit emitEvent(ev);
+        }
 
         // Send response for verification
-        socket->writeDatagram("OK\n", sender, senderPort);
+        if (acknowledge) {
+            socket->writeDatagram("OK\n", sender, senderPort);
+        }
     }
-
+    qCDebug(dcUdpCommander()) << "Received" << count << "datagrams on port" << socket->localPort();
 }
@@ -52,9 +52,16 @@ public:
     void executeAction(ThingActionInfo *info) override;
 
 private:
-    QHash<QUdpSocket *, Thing *> m_receiverList;
+    // Receivers listening on the same port share one socket
+    QHash<quint16, QUdpSocket *> m_receiverSockets;
+    QHash<QUdpSocket *, QList<Thing *>> m_receivers;
     QHash<QUdpSocket *, Thing *> m_commanderList;
 
+    // Reused for all datagrams, big enough for the largest possible one
+    QByteArray m_datagramBuffer;
+
+    void removeReceiver(Thing *thing);
+
 private slots:
     void readPendingDatagrams();
 